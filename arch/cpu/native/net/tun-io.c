@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Batched packet I/O on a tun device.
+ *
+ *         A tun device keeps packet boundaries: each read() returns one
+ *         packet and each write() or writev() sends one. Batching
+ *         therefore saves main loop iterations rather than system calls.
+ *         All waiting packets are read back to back, handed to uIP, and
+ *         the replies are written in one flush at the end of the batch.
+ */
+
+#include "contiki.h"
+#include "tun-io.h"
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "Tun6"
+#define LOG_LEVEL LOG_LEVEL_WARN
+
+#if TUN_IO_STATS
+#define TUN_IO_STATS_ADD(t, field, n) (t)->stats.field += (n)
+#else
+#define TUN_IO_STATS_ADD(t, field, n)
+#endif /* TUN_IO_STATS */
+
+/*---------------------------------------------------------------------------*/
+#if TUN_IO_STATS
+/* Close the per-second counters of a second that has passed */
+static void
+stats_tick(struct tun_io *t)
+{
+  unsigned long now;
+
+  now = clock_seconds();
+  if(now != t->second) {
+    /* Nothing was counted in the seconds in between */
+    t->stats.rx_pps = now == t->second + 1 ? t->rx_second : 0;
+    t->stats.tx_pps = now == t->second + 1 ? t->tx_second : 0;
+    t->rx_second = 0;
+    t->tx_second = 0;
+    t->second = now;
+  }
+}
+/*---------------------------------------------------------------------------*/
+const tun_io_stats_t *
+tun_io_stats(struct tun_io *t)
+{
+  stats_tick(t);
+  return &t->stats;
+}
+#endif /* TUN_IO_STATS */
+/*---------------------------------------------------------------------------*/
+static void
+count_rx(struct tun_io *t, int n)
+{
+#if TUN_IO_STATS
+  stats_tick(t);
+  t->rx_second += n;
+  t->stats.rx_packets += n;
+  if(n > 0) {
+    t->stats.rx_batches++;
+    if(n > t->stats.rx_batch_max) {
+      t->stats.rx_batch_max = n;
+    }
+  }
+#endif /* TUN_IO_STATS */
+}
+/*---------------------------------------------------------------------------*/
+static void
+count_tx(struct tun_io *t)
+{
+#if TUN_IO_STATS
+  stats_tick(t);
+  t->tx_second++;
+  t->stats.tx_packets++;
+#endif /* TUN_IO_STATS */
+}
+/*---------------------------------------------------------------------------*/
+void
+tun_io_init(struct tun_io *t, int fd)
+{
+  memset(t, 0, sizeof(*t));
+  t->fd = fd;
+
+  if(TUN_IO_RX_BATCH > 1 || TUN_IO_TX_QUEUE > 0) {
+    if(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == -1) {
+      err(1, "tun_io_init: fcntl");
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the packet size, 0 if there was none to read */
+static int
+read_packet(struct tun_io *t, uint8_t *data, int maxlen)
+{
+  int size;
+
+  size = read(t->fd, data, maxlen);
+  if(size == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return 0;
+    }
+    err(1, "tun_input: read");
+  }
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+int
+tun_io_read(struct tun_io *t, int max)
+{
+#if TUN_IO_RX_BATCH > 1
+  int size;
+  int n;
+
+  /* Packets left from the previous batch come first */
+  if(t->rx_count > 0) {
+    return t->rx_count;
+  }
+
+  t->rx_next = 0;
+  if(max > TUN_IO_RX_BATCH) {
+    max = TUN_IO_RX_BATCH;
+  }
+  for(n = 0; n < max; n++) {
+    size = read_packet(t, t->rx[n].data, sizeof(t->rx[n].data));
+    if(size <= 0) {
+      break;
+    }
+    t->rx[n].len = size;
+  }
+  t->rx_count = n;
+  count_rx(t, n);
+  return n;
+#else /* TUN_IO_RX_BATCH > 1 */
+  uip_len = read_packet(t, uip_buf, sizeof(uip_buf));
+  t->rx_count = uip_len > 0;
+  count_rx(t, t->rx_count);
+  return t->rx_count;
+#endif /* TUN_IO_RX_BATCH > 1 */
+}
+/*---------------------------------------------------------------------------*/
+int
+tun_io_next(struct tun_io *t)
+{
+#if TUN_IO_RX_BATCH > 1
+  struct tun_io_packet *p;
+
+  if(t->rx_count == 0) {
+    return 0;
+  }
+  p = &t->rx[t->rx_next++];
+  t->rx_count--;
+  memcpy(uip_buf, p->data, p->len);
+  uip_len = p->len;
+  return 1;
+#else /* TUN_IO_RX_BATCH > 1 */
+  /* tun_io_read() has put the packet in uip_buf already */
+  if(t->rx_count == 0) {
+    return 0;
+  }
+  t->rx_count = 0;
+  return 1;
+#endif /* TUN_IO_RX_BATCH > 1 */
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if the packet was written, 0 if the device would block */
+static int
+write_packet(struct tun_io *t, const uint8_t *data, int len)
+{
+  int size;
+
+  size = write(t->fd, data, len);
+  if(size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    return 0;
+  }
+  if(size != len) {
+    err(1, "serial_to_tun: write");
+  }
+  count_tx(t);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+tun_io_flush(struct tun_io *t)
+{
+#if TUN_IO_TX_QUEUE > 0
+  struct tun_io_packet *p;
+
+  if(t->tx_count > 0) {
+    TUN_IO_STATS_ADD(t, tx_flushes, 1);
+  }
+  while(t->tx_count > 0) {
+    p = &t->tx[t->tx_next];
+    if(!write_packet(t, p->data, p->len)) {
+      break;
+    }
+    t->tx_next = (t->tx_next + 1) % TUN_IO_TX_QUEUE;
+    t->tx_count--;
+  }
+#endif /* TUN_IO_TX_QUEUE > 0 */
+}
+/*---------------------------------------------------------------------------*/
+int
+tun_io_write(struct tun_io *t, const uint8_t *data, int len)
+{
+#if TUN_IO_TX_QUEUE > 0
+  struct tun_io_packet *p;
+
+  if(len > (int)sizeof(p->data)) {
+    TUN_IO_STATS_ADD(t, tx_dropped, 1);
+    return -1;
+  }
+  if(t->tx_count == TUN_IO_TX_QUEUE) {
+    tun_io_flush(t);
+    if(t->tx_count == TUN_IO_TX_QUEUE) {
+      LOG_WARN("tx queue full, dropping a packet of %d bytes\n", len);
+      TUN_IO_STATS_ADD(t, tx_dropped, 1);
+      return -1;
+    }
+  }
+
+  p = &t->tx[(t->tx_next + t->tx_count) % TUN_IO_TX_QUEUE];
+  memcpy(p->data, data, len);
+  p->len = len;
+  t->tx_count++;
+#if TUN_IO_STATS
+  if(t->tx_count > t->stats.tx_queue_max) {
+    t->stats.tx_queue_max = t->tx_count;
+  }
+#endif /* TUN_IO_STATS */
+  return 0;
+#else /* TUN_IO_TX_QUEUE > 0 */
+  if(!write_packet(t, data, len)) {
+    /* Only a batching, non-blocking device gets here */
+    TUN_IO_STATS_ADD(t, tx_dropped, 1);
+    return -1;
+  }
+  return 0;
+#endif /* TUN_IO_TX_QUEUE > 0 */
+}
+/*---------------------------------------------------------------------------*/
+int
+tun_io_pending(struct tun_io *t)
+{
+#if TUN_IO_TX_QUEUE > 0
+  return t->tx_count;
+#else /* TUN_IO_TX_QUEUE > 0 */
+  return 0;
+#endif /* TUN_IO_TX_QUEUE > 0 */
+}
+/*---------------------------------------------------------------------------*/
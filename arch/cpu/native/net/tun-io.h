@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Batched packet I/O on a tun device.
+ *
+ *         Receives up to TUN_IO_RX_BATCH packets per wakeup into a ring
+ *         and hands them to uIP one by one, and queues outgoing packets
+ *         to write them when the main loop runs the tun select callback.
+ *         With the defaults every packet is read and written directly,
+ *         as before.
+ */
+
+#ifndef TUN_IO_H_
+#define TUN_IO_H_
+
+#include "contiki.h"
+#include "net/ipv6/uip.h"
+
+/* Packets read from the tun device per wakeup */
+#ifdef TUN_IO_CONF_RX_BATCH
+#define TUN_IO_RX_BATCH TUN_IO_CONF_RX_BATCH
+#else
+#define TUN_IO_RX_BATCH 1
+#endif
+
+/* Outgoing packets queued until the tun device is writable, 0 to write
+   each packet at once */
+#ifdef TUN_IO_CONF_TX_QUEUE
+#define TUN_IO_TX_QUEUE TUN_IO_CONF_TX_QUEUE
+#else
+#define TUN_IO_TX_QUEUE 0
+#endif
+
+/* Count packets, batches and packets per second */
+#ifdef TUN_IO_CONF_STATS
+#define TUN_IO_STATS TUN_IO_CONF_STATS
+#else
+#define TUN_IO_STATS 0
+#endif
+
+#if TUN_IO_STATS
+typedef struct tun_io_stats {
+  unsigned long rx_packets;
+  unsigned long tx_packets;
+  unsigned long rx_batches;
+  unsigned long rx_batch_max;
+  unsigned long tx_flushes;
+  unsigned long tx_queue_max;
+  unsigned long tx_dropped;
+  /* Packets in the last full second */
+  unsigned long rx_pps;
+  unsigned long tx_pps;
+} tun_io_stats_t;
+#endif /* TUN_IO_STATS */
+
+struct tun_io_packet {
+  uint16_t len;
+  uint8_t data[UIP_BUFSIZE];
+};
+
+struct tun_io {
+  int fd;
+  /* Received packets not yet taken by tun_io_next() */
+  uint8_t rx_count;
+#if TUN_IO_RX_BATCH > 1
+  struct tun_io_packet rx[TUN_IO_RX_BATCH];
+  uint8_t rx_next;
+#endif /* TUN_IO_RX_BATCH > 1 */
+#if TUN_IO_TX_QUEUE > 0
+  struct tun_io_packet tx[TUN_IO_TX_QUEUE];
+  uint8_t tx_next;
+  uint8_t tx_count;
+#endif /* TUN_IO_TX_QUEUE > 0 */
+#if TUN_IO_STATS
+  tun_io_stats_t stats;
+  unsigned long second;
+  unsigned long rx_second;
+  unsigned long tx_second;
+#endif /* TUN_IO_STATS */
+};
+
+/**
+ * \brief Start doing I/O on an open tun device
+ *
+ * The device is made non-blocking when packets are batched or queued.
+ */
+void tun_io_init(struct tun_io *t, int fd);
+
+/**
+ * \brief Read the packets waiting on the tun device
+ * \param max Read at most this many packets, up to TUN_IO_RX_BATCH
+ * \return The number of packets read
+ *
+ * Call this when the select callback finds the device readable, then
+ * take the packets with tun_io_next().
+ */
+int tun_io_read(struct tun_io *t, int max);
+
+/**
+ * \brief Move the next received packet into uip_buf
+ * \return Nonzero if uip_buf holds a packet
+ */
+int tun_io_next(struct tun_io *t);
+
+/**
+ * \brief Send a packet on the tun device
+ * \return 0 on success, -1 if the packet was dropped
+ *
+ * The packet is queued if TUN_IO_TX_QUEUE is set, and written by
+ * tun_io_flush().
+ */
+int tun_io_write(struct tun_io *t, const uint8_t *data, int len);
+
+/**
+ * \brief Write the queued packets until the device would block
+ */
+void tun_io_flush(struct tun_io *t);
+
+/**
+ * \brief The number of queued outgoing packets
+ *
+ * The select callback should wait for the device to become writable
+ * while packets are queued.
+ */
+int tun_io_pending(struct tun_io *t);
+
+#if TUN_IO_STATS
+const tun_io_stats_t *tun_io_stats(struct tun_io *t);
+#endif /* TUN_IO_STATS */
+
+#endif /* TUN_IO_H_ */
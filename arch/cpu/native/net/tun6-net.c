@@ -64,6 +64,7 @@
 #include <err.h>
 #include "net/netstack.h"
 #include "net/packetbuf.h"
+#include "tun-io.h"
 
 static const char *config_ipaddr = "fd00::1/64";
 /* Allocate some bytes in RAM and copy the string */
@@ -72,6 +73,7 @@ static char config_tundev[IFNAMSIZ + 1] = "tun0";
 
 #ifndef __CYGWIN__
 static int tunfd = -1;
+static struct tun_io tun_io;
 
 static int set_fd(fd_set *rset, fd_set *wset);
 static void handle_fd(fd_set *rset, fd_set *wset);
@@ -221,6 +223,8 @@ tun_init()
 
   LOG_INFO("Tun open:%d\n", tunfd);
 
+  tun_io_init(&tun_io, tunfd);
+
   select_set_callback(tunfd, &tun_select_callback);
 
   fprintf(stderr, "opened %s device ``/dev/%s''\n",
@@ -238,27 +242,10 @@ static int
 tun_output(uint8_t *data, int len)
 {
   /* fprintf(stderr, "*** Writing to tun...%d\n", len); */
-  if(tunfd != -1 && write(tunfd, data, len) != len) {
-    err(1, "serial_to_tun: write");
-    return -1;
-  }
-  return 0;
-}
-/*---------------------------------------------------------------------------*/
-static int
-tun_input(unsigned char *data, int maxlen)
-{
-  int size;
-
   if(tunfd == -1) {
-    /* tun is not open */
     return 0;
   }
-
-  if((size = read(tunfd, data, maxlen)) == -1) {
-    err(1, "tun_input: read");
-  }
-  return size;
+  return tun_io_write(&tun_io, data, len);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -283,7 +270,10 @@ set_fd(fd_set *rset, fd_set *wset)
   }
 
   FD_SET(tunfd, rset);
-  return 1;
+  if(tun_io_pending(&tun_io)) {
+    FD_SET(tunfd, wset);
+  }
+  return tunfd;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -291,8 +281,6 @@ set_fd(fd_set *rset, fd_set *wset)
 static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
-  int size;
-
   if(tunfd == -1) {
     /* tun is not open */
     return;
@@ -301,11 +289,15 @@ handle_fd(fd_set *rset, fd_set *wset)
   LOG_INFO("Tun6-handle FD\n");
 
   if(FD_ISSET(tunfd, rset)) {
-    size = tun_input(uip_buf, sizeof(uip_buf));
-    LOG_DBG("TUN data incoming read:%d\n", size);
-    uip_len = size;
-    tcpip_input();
+    tun_io_read(&tun_io, TUN_IO_RX_BATCH);
+    while(tun_io_next(&tun_io)) {
+      LOG_DBG("TUN data incoming read:%d\n", uip_len);
+      tcpip_input();
+    }
   }
+
+  /* Replies to the whole batch go out together */
+  tun_io_flush(&tun_io);
 }
 #endif /*  __CYGWIN_ */
 
@@ -118,6 +118,13 @@ typedef unsigned long clock_time_t;
 /* Not part of C99 but actually present */
 int strcasecmp(const char*, const char*);
 
+#if SELECT_EPOLL
+/* Wake the sleeping main loop on polls from signal handlers and threads */
+#ifndef PROCESS_CONF_POLL_NOTIFY
+#define PROCESS_CONF_POLL_NOTIFY() select_wakeup()
+#endif /* PROCESS_CONF_POLL_NOTIFY */
+#endif /* SELECT_EPOLL */
+
 #define PLATFORM_CONF_PROVIDES_MAIN_LOOP 1
 #define PLATFORM_CONF_MAIN_ACCEPTS_ARGS  1
 #define PLATFORM_CONF_SUPPORTS_STACK_CHECK 0
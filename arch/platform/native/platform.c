@@ -47,6 +47,7 @@
 #include <unistd.h>
 #include <sys/select.h>
 #include <errno.h>
+#include <time.h>
 
 #ifdef __CYGWIN__
 #include "net/wpcap-drv.h"
@@ -66,6 +67,11 @@
 
 #include "platform.h"
 
+#if SELECT_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif /* SELECT_EPOLL */
+
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip-ds6.h"
 #endif /* NETSTACK_CONF_WITH_IPV6 */
@@ -130,6 +136,28 @@
 static const struct select_callback *select_callback[SELECT_MAX];
 static int select_max = 0;
 
+#if SELECT_STATS
+select_stats_t select_stats;
+#define SELECT_STATS_ADD(field, n) select_stats.field += (n)
+#else
+#define SELECT_STATS_ADD(field, n)
+#endif /* SELECT_STATS */
+
+#if SELECT_EPOLL
+/* Events an fd is registered for in the epoll set */
+#define EPOLL_IN          0x01
+#define EPOLL_OUT         0x02
+/* epoll refused the fd, e.g. a regular file; it is reported ready on
+   every wakeup, as select would do */
+#define EPOLL_UNPOLLABLE  0x04
+
+static int epoll_fd = -1;
+static int wakeup_fd = -1;
+static int epoll_maxfd = -1;
+static uint8_t epoll_registered[FD_SETSIZE];
+static int loop_sleeping;
+#endif /* SELECT_EPOLL */
+
 #ifdef PLATFORM_CONF_MAC_ADDR
 static uint8_t mac_addr[] = PLATFORM_CONF_MAC_ADDR;
 #else /* PLATFORM_CONF_MAC_ADDR */
@@ -171,6 +199,19 @@ select_set_callback(int fd, const struct select_callback *callback)
       return 1;
   }
 
+#if SELECT_EPOLL
+  /* The fd may have been closed and reopened under the same number, which
+     drops it from the epoll set: have the loop add it again */
+  if(fd < FD_SETSIZE) {
+    epoll_registered[fd] = 0;
+  }
+#endif /* SELECT_EPOLL */
+
+  for(i = select_max; i >= 0; --i) {
+    if(select_callback[i] == callback) {
+        return 1;
+    }
+  }
   for(i = select_max; i >= 0; --i) {
     if(select_callback[i] == NULL) {
         select_callback[i] = callback;
@@ -331,6 +372,278 @@ platform_init_stage_three()
   setvbuf(stdout, (char *)NULL, _IONBF, 0);
 }
 /*---------------------------------------------------------------------------*/
+#if SELECT_STATS
+static uint64_t
+monotonic_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif /* SELECT_STATS */
+/*---------------------------------------------------------------------------*/
+/* Milliseconds until the next etimer expires, 0 if it has expired */
+static long
+etimer_timeout(void)
+{
+  long ticks;
+
+  if(!etimer_pending()) {
+    return SELECT_TIMEOUT;
+  }
+
+  ticks = (long)(etimer_next_expiration_time() - clock_time());
+  if(ticks <= 0) {
+    return 0;
+  }
+  ticks = (ticks * 1000 + CLOCK_SECOND - 1) / CLOCK_SECOND;
+  return ticks < SELECT_TIMEOUT ? ticks : SELECT_TIMEOUT;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Poll the etimer process if the next etimer has expired, or on every
+ * call if always is set. Returns nonzero if an etimer has expired.
+ */
+static int
+poll_etimers(int always)
+{
+  int expired;
+
+  expired = etimer_pending() && etimer_timeout() == 0;
+#if SELECT_STATS
+  if(expired) {
+    uint64_t deadline_us;
+    uint64_t now_us;
+
+    deadline_us = (uint64_t)etimer_next_expiration_time() *
+      (1000000 / CLOCK_SECOND);
+    now_us = monotonic_us();
+    if(now_us > deadline_us) {
+      select_stats.timer_late_us += now_us - deadline_us;
+      if(now_us - deadline_us > select_stats.timer_late_max_us) {
+        select_stats.timer_late_max_us = now_us - deadline_us;
+      }
+    }
+  }
+#endif /* SELECT_STATS */
+
+  if(expired || always) {
+    SELECT_STATS_ADD(etimer_polls, 1);
+    etimer_request_poll();
+  }
+  return expired;
+}
+/*---------------------------------------------------------------------------*/
+#if SELECT_EPOLL
+void
+select_wakeup(void)
+{
+  uint64_t one = 1;
+
+  /* Pairs with the fence in epoll_main_loop(): either the loop sees the
+     poll before it sleeps, or the poller sees that the loop sleeps. */
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&loop_sleeping, __ATOMIC_RELAXED) && wakeup_fd >= 0) {
+    if(write(wakeup_fd, &one, sizeof(one)) < 0) {
+      /* The counter is already set, the loop will wake up anyway. */
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Bring the epoll set in line with the fds the callbacks asked for */
+static void
+epoll_update(fd_set *fdr, fd_set *fdw, int maxfd)
+{
+  struct epoll_event ev;
+  uint8_t want;
+  uint8_t have;
+  int last;
+  int fd;
+
+  if(maxfd >= FD_SETSIZE) {
+    maxfd = FD_SETSIZE - 1;
+  }
+  last = maxfd > epoll_maxfd ? maxfd : epoll_maxfd;
+  epoll_maxfd = -1;
+
+  for(fd = 0; fd <= last; fd++) {
+    want = 0;
+    if(fd <= maxfd) {
+      want = (FD_ISSET(fd, fdr) ? EPOLL_IN : 0) |
+             (FD_ISSET(fd, fdw) ? EPOLL_OUT : 0);
+    }
+    have = epoll_registered[fd];
+
+    if(want != 0) {
+      epoll_maxfd = fd;
+    }
+    if(have & EPOLL_UNPOLLABLE) {
+      epoll_registered[fd] = want ? (want | EPOLL_UNPOLLABLE) : 0;
+      continue;
+    }
+    if(want == have) {
+      continue;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ((want & EPOLL_IN) ? EPOLLIN : 0) |
+                ((want & EPOLL_OUT) ? EPOLLOUT : 0);
+    ev.data.fd = fd;
+
+    if(want == 0) {
+      /* A closed fd has already left the set */
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    } else if(have == 0 ||
+              (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0 &&
+               errno == ENOENT)) {
+      /* The fd is new, or was closed and reopened under the same number */
+      if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        if(errno == EEXIST) {
+          /* Registered again while still in the set */
+          if(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+            LOG_ERR("epoll_ctl(%d): %s\n", fd, strerror(errno));
+            want = 0;
+          }
+        } else if(errno == EPERM) {
+          want |= EPOLL_UNPOLLABLE;
+        } else {
+          LOG_ERR("epoll_ctl(%d): %s\n", fd, strerror(errno));
+          want = 0;
+        }
+      }
+    }
+    epoll_registered[fd] = want;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns only if epoll is not available */
+static void
+epoll_main_loop(void)
+{
+  struct epoll_event ev;
+  struct epoll_event events[SELECT_MAX + 1];
+  fd_set fdr;
+  fd_set fdw;
+  int maxfd;
+  int ready;
+  int timeout;
+  int i;
+  int n;
+  uint64_t count;
+#if SELECT_STATS
+  uint64_t start_us;
+#endif /* SELECT_STATS */
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = wakeup_fd;
+  if(epoll_fd < 0 || wakeup_fd < 0 ||
+     epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &ev) < 0) {
+    LOG_ERR("epoll is not available, falling back to select: %s\n",
+            strerror(errno));
+    if(epoll_fd >= 0) {
+      close(epoll_fd);
+    }
+    if(wakeup_fd >= 0) {
+      close(wakeup_fd);
+    }
+    wakeup_fd = -1;
+    return;
+  }
+
+  while(1) {
+    SELECT_STATS_ADD(iterations, 1);
+    process_run();
+
+    FD_ZERO(&fdr);
+    FD_ZERO(&fdw);
+    maxfd = -1;
+    for(i = 0; i < SELECT_MAX; i++) {
+      if(select_callback[i] != NULL) {
+        n = select_callback[i]->set_fd(&fdr, &fdw);
+        if(maxfd < n) {
+          maxfd = n;
+        }
+      }
+    }
+    epoll_update(&fdr, &fdw, maxfd);
+
+    __atomic_store_n(&loop_sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    timeout = process_nevents() > 0 ? 0 : etimer_timeout();
+
+#if SELECT_STATS
+    start_us = monotonic_us();
+#endif /* SELECT_STATS */
+    n = epoll_wait(epoll_fd, events, SELECT_MAX + 1, timeout);
+    __atomic_store_n(&loop_sleeping, 0, __ATOMIC_RELAXED);
+#if SELECT_STATS
+    select_stats.sleep_us += monotonic_us() - start_us;
+#endif /* SELECT_STATS */
+    if(n < 0) {
+      if(errno != EINTR) {
+        perror("epoll_wait");
+      }
+      n = 0;
+    }
+
+    FD_ZERO(&fdr);
+    FD_ZERO(&fdw);
+    ready = 0;
+    for(i = 0; i < n; i++) {
+      if(events[i].data.fd == wakeup_fd) {
+        if(read(wakeup_fd, &count, sizeof(count)) < 0) {
+          /* Already reset */
+        }
+        SELECT_STATS_ADD(poll_wakeups, 1);
+        continue;
+      }
+      /* select reports errors and hangups as readiness */
+      if(events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        if(epoll_registered[events[i].data.fd] & EPOLL_IN) {
+          FD_SET(events[i].data.fd, &fdr);
+        }
+      }
+      if(events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+        if(epoll_registered[events[i].data.fd] & EPOLL_OUT) {
+          FD_SET(events[i].data.fd, &fdw);
+        }
+      }
+      ready = 1;
+    }
+    SELECT_STATS_ADD(fd_wakeups, ready);
+    for(i = 0; i <= epoll_maxfd; i++) {
+      if(epoll_registered[i] & EPOLL_UNPOLLABLE) {
+        if(epoll_registered[i] & EPOLL_IN) {
+          FD_SET(i, &fdr);
+        }
+        if(epoll_registered[i] & EPOLL_OUT) {
+          FD_SET(i, &fdw);
+        }
+        ready = 1;
+      }
+    }
+
+    if(ready) {
+      for(i = 0; i < SELECT_MAX; i++) {
+        if(select_callback[i] != NULL) {
+          select_callback[i]->handle_fd(&fdr, &fdw);
+        }
+      }
+    }
+
+    if(poll_etimers(0)) {
+      SELECT_STATS_ADD(timer_wakeups, n == 0);
+    } else {
+      SELECT_STATS_ADD(timeouts, n == 0);
+    }
+  }
+}
+#endif /* SELECT_EPOLL */
+/*---------------------------------------------------------------------------*/
 void
 platform_main_loop()
 {
@@ -338,6 +651,9 @@ platform_main_loop()
   select_set_callback(STDIN_FILENO, &stdin_fd);
 #endif /* SELECT_STDIN */
   board_init();
+#if SELECT_EPOLL
+  epoll_main_loop();
+#endif /* SELECT_EPOLL */
   while(1) {
     fd_set fdr;
     fd_set fdw;
@@ -346,6 +662,7 @@ platform_main_loop()
     int retval;
     struct timeval tv;
 
+    SELECT_STATS_ADD(iterations, 1);
     retval = process_run();
 
     tv.tv_sec = retval ? 0 : SELECT_TIMEOUT / 1000;
@@ -363,21 +680,34 @@ platform_main_loop()
       }
     }
 
+#if SELECT_STATS
+    {
+      uint64_t start_us = monotonic_us();
+      retval = select(maxfd+1, &fdr, &fdw, NULL, &tv);
+      select_stats.sleep_us += monotonic_us() - start_us;
+    }
+#else /* SELECT_STATS */
     retval = select(maxfd+1, &fdr, &fdw, NULL, &tv);
+#endif /* SELECT_STATS */
     if(retval < 0) {
       if(errno != EINTR) {
         perror("select");
       }
     } else if(retval > 0) {
       /* timeout => retval == 0 */
-      for(i = 0; i <= maxfd; i++) {
+      for(i = 0; i <= select_max; i++) {
         if(select_callback[i] != NULL) {
           select_callback[i]->handle_fd(&fdr, &fdw);
         }
       }
     }
 
-    etimer_request_poll();
+    if(poll_etimers(1)) {
+      SELECT_STATS_ADD(timer_wakeups, retval <= 0);
+    } else {
+      SELECT_STATS_ADD(timeouts, retval <= 0);
+    }
+    SELECT_STATS_ADD(fd_wakeups, retval > 0);
   }
 
   return;
@@ -8,6 +8,7 @@
 #ifndef ARCH_PLATFORM_NATIVE_PLATFORM_NATIVE_H_
 #define ARCH_PLATFORM_NATIVE_PLATFORM_NATIVE_H_
 
+#include <stdint.h>
 #include <unistd.h>
 #include <sys/types.h>
 
@@ -32,9 +33,61 @@ struct select_callback {
  *
  *  @param fd >= 0 append callback for mainloop monitoring
  *            < 0  - remove callback handling
+ *
+ *  a callback that closes fd and reopens it under the same number must
+ *  call this again with the new fd, so that the epoll loop watches it.
  */
 int select_set_callback(int fd, const struct select_callback *callback);
 
+/*
+ * Run the main loop on epoll (Linux only) instead of select. The loop
+ * then sleeps until the next etimer expires or a monitored file
+ * descriptor becomes ready, and is woken through an eventfd when a
+ * process is polled from a signal handler or another thread.
+ */
+#ifdef SELECT_CONF_EPOLL
+#define SELECT_EPOLL SELECT_CONF_EPOLL
+#else
+#define SELECT_EPOLL 0
+#endif
+
+/*
+ * Count main loop iterations and wakeups, the time slept and how late
+ * etimers are handed to the etimer process.
+ */
+#ifdef SELECT_CONF_STATS
+#define SELECT_STATS SELECT_CONF_STATS
+#else
+#define SELECT_STATS 0
+#endif
+
+#if SELECT_STATS
+typedef struct select_stats {
+  unsigned long iterations;
+  /* Wakeups by ready file descriptors, the eventfd, an etimer deadline,
+     or none of these. */
+  unsigned long fd_wakeups;
+  unsigned long poll_wakeups;
+  unsigned long timer_wakeups;
+  unsigned long timeouts;
+  unsigned long etimer_polls;
+  uint64_t sleep_us;
+  /* Delay from an etimer deadline until the etimer process is polled. */
+  uint64_t timer_late_us;
+  uint64_t timer_late_max_us;
+} select_stats_t;
+
+extern select_stats_t select_stats;
+#endif /* SELECT_STATS */
+
+#if SELECT_EPOLL
+/**
+ *  @brief - wake the main loop if it sleeps. Safe to call from signal
+ *  handlers and other threads; process_poll() calls it.
+ */
+void select_wakeup(void);
+#endif /* SELECT_EPOLL */
+
 
 
 #ifndef __NOINLINE
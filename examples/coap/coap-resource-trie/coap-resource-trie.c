@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         CoAP resource dispatch benchmark.
+ *
+ *         Activates a growing number of resources with LwM2M style
+ *         paths and reports how many URI path lookups per second the
+ *         engine resolves, with and without the resource path trie
+ *         (COAP_CONF_RESOURCE_TRIE_NODES).
+ */
+/*---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "lib/random.h"
+/*---------------------------------------------------------------------------*/
+PROCESS(coap_resource_trie_process, "CoAP resource dispatch benchmark");
+AUTOSTART_PROCESSES(&coap_resource_trie_process);
+/*---------------------------------------------------------------------------*/
+#ifndef NUM_RESOURCES
+#define NUM_RESOURCES  400
+#endif
+#ifndef NUM_LOOKUPS
+#define NUM_LOOKUPS    1000000
+#endif
+#define PATH_LEN       20
+/*---------------------------------------------------------------------------*/
+static void
+res_get_handler(coap_message_t *request, coap_message_t *response,
+                uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+}
+/*---------------------------------------------------------------------------*/
+PARENT_RESOURCE(res_parent, "title=\"Parent\"", res_get_handler,
+                NULL, NULL, NULL);
+
+static coap_resource_t resources[NUM_RESOURCES];
+static char paths[NUM_RESOURCES][PATH_LEN];
+static const int steps[] = { 10, 50, 100, 200, NUM_RESOURCES };
+/*---------------------------------------------------------------------------*/
+/* object/instance/resource, 20 resources per object */
+static void
+resource_path(char *path, int n)
+{
+  snprintf(path, PATH_LEN, "%u/%u/%u", 3300 + n / 20, (n / 5) % 4,
+           5700 + n % 5);
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_path(const char *path, coap_resource_t *expected)
+{
+  return coap_get_resource_by_path(path, strlen(path)) == expected;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_resource_trie_process, ev, data)
+{
+  static int errors;
+  static int active;
+  static int step;
+  clock_time_t start;
+  clock_time_t elapsed;
+  unsigned long i;
+  int n;
+
+  PROCESS_BEGIN();
+
+  printf("CoAP resource trie: %u nodes\n",
+         (unsigned)COAP_RESOURCE_TRIE_NODES);
+
+  errors = 0;
+  coap_activate_resource(&res_parent, "parent");
+
+  active = 0;
+  for(step = 0; step < sizeof(steps) / sizeof(steps[0]); step++) {
+    for(; active < steps[step] && active < NUM_RESOURCES; active++) {
+      resource_path(paths[active], active);
+      resources[active].get_handler = res_get_handler;
+      coap_activate_resource(&resources[active], paths[active]);
+    }
+
+    start = clock_time();
+    for(i = 0; i < NUM_LOOKUPS; i++) {
+      n = random_rand() % active;
+      if(coap_get_resource_by_path(paths[n], strlen(paths[n]))
+         != &resources[n]) {
+        errors++;
+      }
+    }
+    elapsed = clock_time() - start;
+    printf("%4d resources: %lu ms, %lu lookups/s\n", active,
+           (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+           (unsigned long)(elapsed > 0 ?
+                           (uint64_t)NUM_LOOKUPS * CLOCK_SECOND / elapsed : 0));
+  }
+
+  /* Sub-resources, partial and unknown paths */
+  errors += !check_path("parent", &res_parent);
+  errors += !check_path("parent/", &res_parent);
+  errors += !check_path("parent/1/2", &res_parent);
+  errors += !check_path("parentx", NULL);
+  errors += !check_path("3300/0/5700/1", NULL);
+  errors += !check_path("3300/0", NULL);
+  errors += !check_path("3300/0/570", NULL);
+  errors += !check_path("9999/0/5700", NULL);
+  errors += !check_path(".well-known/core", coap_get_first_resource());
+  errors += !check_path("", NULL);
+
+  printf("%s, %d errors\n", errors == 0 ? "OK" : "FAILED", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -41,6 +41,7 @@
 #include <string.h>
 #include "net/netstack.h"
 #include "net/packetbuf.h"
+#include "net/queuebuf.h"
 
 #include "cmd.h"
 #include "slip-radio.h"
@@ -57,9 +58,21 @@ extern const struct slip_radio_sensors SLIP_RADIO_CONF_SENSORS;
 #endif
 
 /* max 16 packets at the same time??? */
-uint8_t packet_ids[16];
+#define MAX_PACKET_IDS 16
+uint8_t packet_ids[MAX_PACKET_IDS];
 int packet_pos;
 
+/* Frames the host may have outstanding, told on a "?W" request. The MAC
+   queue must hold them, and their ids must not be overwritten before
+   they are reported. */
+#ifdef SLIP_RADIO_CONF_TX_WINDOW
+#define SLIP_RADIO_TX_WINDOW SLIP_RADIO_CONF_TX_WINDOW
+#elif QUEUEBUF_NUM < MAX_PACKET_IDS
+#define SLIP_RADIO_TX_WINDOW QUEUEBUF_NUM
+#else
+#define SLIP_RADIO_TX_WINDOW MAX_PACKET_IDS
+#endif
+
 static int slip_radio_cmd_handler(const uint8_t *data, int len);
 
 int cmd_handler_cc2420(const uint8_t *data, int len);
@@ -199,6 +212,13 @@ slip_radio_cmd_handler(const uint8_t *data, int len)
       uip_len = 10;
       cmd_send(uip_buf, uip_len);
       return 1;
+    } else if(data[1] == 'W') {
+      uip_buf[0] = '!';
+      uip_buf[1] = 'W';
+      uip_buf[2] = SLIP_RADIO_TX_WINDOW;
+      uip_len = 3;
+      cmd_send(uip_buf, uip_len);
+      return 1;
     } else if(data[1] == 'V') {
       /* ask the radio about the specific parameter and send it back... */
       int type = ((uint16_t)data[2] << 8) | data[3];
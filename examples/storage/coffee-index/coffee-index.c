@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Coffee name index benchmark.
+ *
+ *         Creates a number of small files, then opens, reads and closes
+ *         random files and reports the time taken, with and without
+ *         the RAM name index (COFFEE_CONF_NAME_INDEX_SIZE).
+ */
+/*---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs/cfs-coffee.h"
+#include "lib/random.h"
+/*---------------------------------------------------------------------------*/
+PROCESS(coffee_index_process, "Coffee name index benchmark");
+AUTOSTART_PROCESSES(&coffee_index_process);
+/*---------------------------------------------------------------------------*/
+#ifndef NUM_FILES
+#define NUM_FILES      200
+#endif
+#ifndef NUM_OPENS
+#define NUM_OPENS      20000
+#endif
+#define FILE_SIZE      300
+/*---------------------------------------------------------------------------*/
+static void
+file_name(char *name, int n)
+{
+  snprintf(name, 16, "log%03d", n);
+}
+/*---------------------------------------------------------------------------*/
+static int
+create_file(int n)
+{
+  char name[16];
+  char buf[FILE_SIZE];
+  int fd;
+  int len;
+
+  file_name(name, n);
+  if(cfs_coffee_reserve(name, FILE_SIZE) < 0) {
+    return -1;
+  }
+  fd = cfs_open(name, CFS_WRITE);
+  if(fd < 0) {
+    return -1;
+  }
+  /* Varying lengths, the last byte is never zero */
+  len = FILE_SIZE / 2 + n % (FILE_SIZE / 2);
+  memset(buf, 'a' + n % 26, len);
+  len = cfs_write(fd, buf, len);
+  cfs_close(fd);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_file(int n)
+{
+  char name[16];
+  char c;
+  int fd;
+  cfs_offset_t end;
+
+  file_name(name, n);
+  fd = cfs_open(name, CFS_READ);
+  if(fd < 0) {
+    return -1;
+  }
+  end = cfs_seek(fd, 0, CFS_SEEK_END);
+  cfs_seek(fd, 0, CFS_SEEK_SET);
+  if(cfs_read(fd, &c, 1) != 1 || c != 'a' + n % 26 ||
+     end != FILE_SIZE / 2 + n % (FILE_SIZE / 2)) {
+    end = -1;
+  }
+  cfs_close(fd);
+  return end;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coffee_index_process, ev, data)
+{
+  static int i;
+  static int errors;
+  clock_time_t start;
+  clock_time_t elapsed;
+  char name[16];
+
+  PROCESS_BEGIN();
+
+  printf("Coffee name index: %u entries, %u files\n",
+         (unsigned)COFFEE_CONF_NAME_INDEX_SIZE, (unsigned)NUM_FILES);
+
+  cfs_coffee_format();
+
+  errors = 0;
+  start = clock_time();
+  for(i = 0; i < NUM_FILES; i++) {
+    if(create_file(i) < 0) {
+      errors++;
+    }
+  }
+  elapsed = clock_time() - start;
+  printf("create: %lu ms\n",
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND));
+
+  start = clock_time();
+  for(i = 0; i < NUM_OPENS; i++) {
+    if(check_file(random_rand() % NUM_FILES) < 0) {
+      errors++;
+    }
+  }
+  elapsed = clock_time() - start;
+  printf("open/read/close: %lu ms for %u opens\n",
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND), (unsigned)NUM_OPENS);
+
+  /* Removed files must not be found, recreated ones must */
+  for(i = 0; i < NUM_FILES; i += 2) {
+    file_name(name, i);
+    if(cfs_remove(name) < 0) {
+      errors++;
+    }
+  }
+  for(i = 0; i < NUM_FILES; i++) {
+    if((check_file(i) < 0) != (i % 2 == 0)) {
+      errors++;
+    }
+  }
+  for(i = 0; i < NUM_FILES; i += 4) {
+    if(create_file(i) < 0 || check_file(i) < 0) {
+      errors++;
+    }
+  }
+
+  printf("%s, %d errors\n", errors == 0 ? "OK" : "FAILED", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
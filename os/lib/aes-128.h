@@ -45,6 +45,27 @@
 #define AES_128_BLOCK_SIZE 16
 #define AES_128_KEY_LENGTH 16
 
+/*
+ * Number of expanded keys the software AES keeps. Switching back to one
+ * of them in set_key() then skips the key expansion. With 0 every
+ * set_key() expands the key.
+ */
+#ifdef AES_128_CONF_KEY_CACHE_SIZE
+#define AES_128_KEY_CACHE_SIZE AES_128_CONF_KEY_CACHE_SIZE
+#else /* AES_128_CONF_KEY_CACHE_SIZE */
+#define AES_128_KEY_CACHE_SIZE 0
+#endif /* AES_128_CONF_KEY_CACHE_SIZE */
+
+/*
+ * Encrypt a column per table lookup in the software AES. Costs a 1 KB
+ * table in ROM and 32-bit round keys.
+ */
+#ifdef AES_128_CONF_TTABLES
+#define AES_128_TTABLES AES_128_CONF_TTABLES
+#else /* AES_128_CONF_TTABLES */
+#define AES_128_TTABLES 0
+#endif /* AES_128_CONF_TTABLES */
+
 #ifdef AES_128_CONF
 #define AES_128            AES_128_CONF
 #else /* AES_128_CONF */
@@ -83,15 +83,15 @@ ctr_step(const uint8_t *nonce,
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Starts the CBC-MAC in x with B_0 and the additional authenticated data */
 static void
-mic(const uint8_t *nonce,
-    const uint8_t *m, uint16_t m_len,
+mic_start(const uint8_t *nonce,
+    uint16_t m_len,
     const uint8_t *a, uint16_t a_len,
-    uint8_t *result,
+    uint8_t *x,
     uint8_t mic_len)
 {
-  uint8_t x[AES_128_BLOCK_SIZE];
-  uint32_t pos; /* 32-bits as can need to exceed m_len to reach end of loop */
+  uint32_t pos; /* 32-bits as can need to exceed a_len to reach end of loop */
   uint8_t i;
 
   set_iv(x, CCM_STAR_AUTH_FLAGS(a_len > 0, mic_len), nonce, m_len);
@@ -115,34 +115,50 @@ mic(const uint8_t *nonce,
       AES_128.encrypt(x);
     }
   }
-
-  if(m_len) {
-    pos = 0;
-    while(pos < m_len) {
-      for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-        x[i] ^= m[pos + i];
-      }
-      pos += AES_128_BLOCK_SIZE;
-      AES_128.encrypt(x);
-    }
-  }
-
-  ctr_step(nonce, 0, x, AES_128_BLOCK_SIZE, 0);
-
-  memcpy(result, x, mic_len);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Runs the CTR encryption and the CBC-MAC over m in one pass: the MAC
+ * takes each plaintext block right before it is encrypted, or right
+ * after it is decrypted.
+ */
 static void
-ctr(const uint8_t *nonce, uint8_t *m, uint16_t m_len)
+ctr_and_mic(const uint8_t *nonce,
+    uint8_t *m, uint16_t m_len,
+    uint8_t *x,
+    int forward)
 {
+  uint8_t a[AES_128_BLOCK_SIZE];
+  uint8_t k[AES_128_BLOCK_SIZE];
   uint32_t pos; /* 32-bits as can need to exceed m_len to reach end of loop */
-  uint16_t counter;
+  uint8_t len;
+  uint8_t i;
+
+  set_iv(a, CCM_STAR_ENCRYPTION_FLAGS, nonce, 1);
+  for(pos = 0; pos < m_len; pos += AES_128_BLOCK_SIZE) {
+    len = m_len - pos < AES_128_BLOCK_SIZE ? m_len - pos : AES_128_BLOCK_SIZE;
+
+    /* K_{counter} */
+    memcpy(k, a, AES_128_BLOCK_SIZE);
+    AES_128.encrypt(k);
+    if(++a[15] == 0) {
+      a[14]++;
+    }
 
-  pos = 0;
-  counter = 1;
-  while(pos < m_len) {
-    ctr_step(nonce, pos, m, m_len, counter++);
-    pos += AES_128_BLOCK_SIZE;
+    if(!forward) {
+      for(i = 0; i < len; i++) {
+        m[pos + i] ^= k[i];
+      }
+    }
+    for(i = 0; i < len; i++) {
+      x[i] ^= m[pos + i];
+    }
+    AES_128.encrypt(x);
+    if(forward) {
+      for(i = 0; i < len; i++) {
+        m[pos + i] ^= k[i];
+      }
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -159,25 +175,19 @@ aead(const uint8_t* nonce,
     uint8_t *result, uint8_t mic_len,
     int forward)
 {
+  uint8_t x[AES_128_BLOCK_SIZE];
+
   if(a_len > MAX_A_LEN || !MIC_LEN_VALID(mic_len)) {
     return;
   }
 
-  if(!forward) {
-    /* decrypt */
-    ctr(nonce, m, m_len);
-  }
+  mic_start(nonce, m_len, a, a_len, x, mic_len);
+  ctr_and_mic(nonce, m, m_len, x, forward);
 
-  mic(nonce,
-    m, m_len,
-    a, a_len,
-    result,
-    mic_len);
+  /* the MIC is encrypted with K_0 */
+  ctr_step(nonce, 0, x, AES_128_BLOCK_SIZE, 0);
 
-  if(forward) {
-    /* encrypt */
-    ctr(nonce, m, m_len);
-  }
+  memcpy(result, x, mic_len);
 }
 /*---------------------------------------------------------------------------*/
 const struct ccm_star_driver ccm_star_driver = {
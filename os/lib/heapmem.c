@@ -106,6 +106,16 @@
 #define ALIGN(size)						\
   (((size) + (HEAPMEM_ALIGNMENT - 1)) & ~(HEAPMEM_ALIGNMENT - 1))
 
+#if HEAPMEM_SIZE_CLASSES
+/* Macros for the segregated-fit mode. */
+#define CLASS_STEP		ALIGN(HEAPMEM_SIZE_CLASS_STEP)
+#define CLASS_MAX_SIZE		(HEAPMEM_SIZE_CLASSES * CLASS_STEP)
+#define CLASS_SIZE(size)					\
+  ((size) == 0 ? CLASS_STEP :					\
+   ((size) + CLASS_STEP - 1) / CLASS_STEP * CLASS_STEP)
+#define CLASS_OF(size)		((size) / CLASS_STEP - 1)
+#endif /* HEAPMEM_SIZE_CLASSES */
+
 /* Macros for chunk iteration. */
 #define NEXT_CHUNK(chunk)						\
   ((chunk_t *)((char *)(chunk) + sizeof(chunk_t) + (chunk)->size))
@@ -121,11 +131,19 @@
 
 /* Macros for determining the status of a chunk. */
 #define CHUNK_FLAG_ALLOCATED		0x1
+/* The chunk has the size of a size class, and goes back to the
+   free list of its class when freed. */
+#define CHUNK_FLAG_CLASS		0x2
+/* The chunk is on the free list of its size class. It keeps
+   CHUNK_FLAG_ALLOCATED so that it is not coalesced. */
+#define CHUNK_FLAG_CACHED		0x4
 
 #define CHUNK_ALLOCATED(chunk)			\
   ((chunk)->flags & CHUNK_FLAG_ALLOCATED)
 #define CHUNK_FREE(chunk)			\
   (~(chunk)->flags & CHUNK_FLAG_ALLOCATED)
+#define CHUNK_CACHED(chunk)			\
+  ((chunk)->flags & CHUNK_FLAG_CACHED)
 
 /*
  * We use a double-linked list of chunks, with a slight space overhead compared
@@ -151,6 +169,13 @@ static size_t heap_usage;
 static chunk_t *first_chunk = (chunk_t *)heap_base;
 static chunk_t *free_list;
 
+#if HEAPMEM_SIZE_CLASSES
+/* Single-linked free lists of the size classes, through chunk->next. */
+static chunk_t *class_lists[HEAPMEM_SIZE_CLASSES];
+static size_t class_allocated[HEAPMEM_SIZE_CLASSES];
+static size_t class_max_allocated[HEAPMEM_SIZE_CLASSES];
+#endif /* HEAPMEM_SIZE_CLASSES */
+
 /* extend_space: Increases the current footprint used in the heap, and
    returns a pointer to the old end. */
 static void *
@@ -265,20 +290,17 @@ defrag_chunks(void)
   }
 }
 
-/* get_free_chunk: Search the free list for the most suitable chunk, as
-   determined by its size, to satisfy an allocation request. */
+/* find_free_chunk: Search at most max chunks on the free list for the
+   most suitable chunk, as determined by its size. */
 static chunk_t *
-get_free_chunk(const size_t size)
+find_free_chunk(const size_t size, int max)
 {
   int i;
   chunk_t *chunk, *best;
 
-  /* Defragment chunks only right before they are needed for allocation. */
-  defrag_chunks();
-
   best = NULL;
   /* Limit the time we spend on searching the free list. */
-  i = CHUNK_SEARCH_MAX;
+  i = max;
   for(chunk = free_list; chunk != NULL; chunk = chunk->next) {
     if(i-- == 0) {
       break;
@@ -299,6 +321,29 @@ get_free_chunk(const size_t size)
     }
   }
 
+  return best;
+}
+
+/* get_free_chunk: Take the most suitable chunk off the free list to
+   satisfy an allocation request. */
+static chunk_t *
+get_free_chunk(const size_t size)
+{
+  chunk_t *best;
+
+#if HEAPMEM_SIZE_CLASSES
+  /* Coalesce chunks only when none of them fits as it is. */
+  best = find_free_chunk(size, CHUNK_SEARCH_MAX);
+  if(best == NULL) {
+    defrag_chunks();
+    best = find_free_chunk(size, CHUNK_SEARCH_MAX);
+  }
+#else
+  /* Defragment chunks only right before they are needed for allocation. */
+  defrag_chunks();
+  best = find_free_chunk(size, CHUNK_SEARCH_MAX);
+#endif /* HEAPMEM_SIZE_CLASSES */
+
   if(best != NULL) {
     /* We found a chunk for the allocation. Split it if necessary. */
     allocate_chunk(best);
@@ -308,6 +353,114 @@ get_free_chunk(const size_t size)
   return best;
 }
 
+/* alloc_chunk: Allocate a chunk from the free list, or else from the
+   unused space at the end of the heap. */
+static chunk_t *
+alloc_chunk(const size_t size)
+{
+  chunk_t *chunk;
+
+  chunk = get_free_chunk(size);
+  if(chunk == NULL) {
+    chunk = extend_space(sizeof(chunk_t) + size);
+    if(chunk != NULL) {
+      chunk->size = size;
+    }
+  }
+  return chunk;
+}
+
+#if HEAPMEM_SIZE_CLASSES
+/* class_alloc: Take a chunk off the free list of its size class. */
+static chunk_t *
+class_alloc(const size_t size)
+{
+  chunk_t *chunk;
+
+  chunk = class_lists[CLASS_OF(size)];
+  if(chunk != NULL) {
+    class_lists[CLASS_OF(size)] = chunk->next;
+  }
+  return chunk;
+}
+
+/* class_free: Put a chunk on the free list of its size class, unless
+   it can be released back into the wilderness. */
+static void
+class_free(chunk_t * const chunk)
+{
+  class_allocated[CLASS_OF(chunk->size)]--;
+
+  if(IS_LAST_CHUNK(chunk)) {
+    free_chunk(chunk);
+    return;
+  }
+
+  chunk->flags = CHUNK_FLAG_ALLOCATED | CHUNK_FLAG_CACHED;
+  chunk->next = class_lists[CLASS_OF(chunk->size)];
+  class_lists[CLASS_OF(chunk->size)] = chunk;
+}
+
+/*
+ * reclaim_chunks: Move the chunks on the size class lists to the
+ * common free list and coalesce all free chunks. This is the last
+ * resort before an allocation fails.
+ */
+static void
+reclaim_chunks(void)
+{
+  int i;
+  chunk_t *chunk;
+
+  for(i = 0; i < HEAPMEM_SIZE_CLASSES; i++) {
+    while(class_lists[i] != NULL) {
+      chunk = class_lists[i];
+      class_lists[i] = chunk->next;
+      chunk->flags = 0;
+      free_chunk(chunk);
+    }
+  }
+
+  for(chunk = first_chunk;
+      (char *)chunk < &heap_base[heap_usage];
+      chunk = NEXT_CHUNK(chunk)) {
+    if(CHUNK_FREE(chunk)) {
+      coalesce_chunks(chunk);
+    }
+  }
+}
+
+/* reclaim_free_chunk: Reclaim all free memory, and search all of the
+   free list for the most suitable chunk. */
+static chunk_t *
+reclaim_free_chunk(const size_t size)
+{
+  chunk_t *chunk;
+
+  reclaim_chunks();
+  chunk = find_free_chunk(size, HEAPMEM_ARENA_SIZE);
+  if(chunk != NULL) {
+    allocate_chunk(chunk);
+    split_chunk(chunk, size);
+  }
+  return chunk;
+}
+#endif /* HEAPMEM_SIZE_CLASSES */
+
+/* release_chunk: Return an allocated chunk to the free list that it
+   belongs to. */
+static void
+release_chunk(chunk_t * const chunk)
+{
+#if HEAPMEM_SIZE_CLASSES
+  if(chunk->flags & CHUNK_FLAG_CLASS) {
+    class_free(chunk);
+    return;
+  }
+#endif /* HEAPMEM_SIZE_CLASSES */
+  free_chunk(chunk);
+}
+
 /*
  * heapmem_alloc: Allocate an object of the specified size, returning
  * a pointer to it in case of success, and NULL in case of failure.
@@ -321,6 +474,9 @@ get_free_chunk(const size_t size)
  *
  * As a last resort, heapmem_alloc() will try to extend the heap
  * space, and thereby create a new chunk available for use.
+ *
+ * In the segregated-fit mode, small requests are rounded up to their
+ * size class and served from the free list of that class first.
  */
 void *
 #if HEAPMEM_DEBUG
@@ -338,17 +494,49 @@ heapmem_alloc(size_t size)
 
   size = ALIGN(size);
 
-  chunk = get_free_chunk(size);
-  if(chunk == NULL) {
-    chunk = extend_space(sizeof(chunk_t) + size);
+#if HEAPMEM_SIZE_CLASSES
+  if(size <= CLASS_MAX_SIZE) {
+    size = CLASS_SIZE(size);
+    chunk = class_alloc(size);
     if(chunk == NULL) {
-      return NULL;
+      chunk = alloc_chunk(size);
     }
-    chunk->size = size;
+    if(chunk == NULL) {
+      chunk = reclaim_free_chunk(size);
+    }
+  } else {
+    /* Large chunks are placed in coalesced free memory, else the heap
+       grows. The class caches are only reclaimed when it cannot. */
+    chunk = get_free_chunk(size);
+    if(chunk == NULL) {
+      chunk = extend_space(sizeof(chunk_t) + size);
+      if(chunk != NULL) {
+        chunk->size = size;
+      }
+    }
+    if(chunk == NULL) {
+      chunk = reclaim_free_chunk(size);
+    }
+  }
+#else
+  chunk = alloc_chunk(size);
+#endif /* HEAPMEM_SIZE_CLASSES */
+  if(chunk == NULL) {
+    return NULL;
   }
 
   chunk->flags = CHUNK_FLAG_ALLOCATED;
 
+#if HEAPMEM_SIZE_CLASSES
+  if(size <= CLASS_MAX_SIZE && chunk->size == size) {
+    chunk->flags |= CHUNK_FLAG_CLASS;
+    if(++class_allocated[CLASS_OF(size)] >
+       class_max_allocated[CLASS_OF(size)]) {
+      class_max_allocated[CLASS_OF(size)] = class_allocated[CLASS_OF(size)];
+    }
+  }
+#endif /* HEAPMEM_SIZE_CLASSES */
+
 #if HEAPMEM_DEBUG
   chunk->file = file;
   chunk->line = line;
@@ -386,11 +574,29 @@ heapmem_free(void *ptr)
     PRINTF("%s ptr %p, allocated at %s:%u\n", __func__, ptr,
            chunk->file, chunk->line);
 
-    free_chunk(chunk);
+    release_chunk(chunk);
   }
 }
 
 #if HEAPMEM_REALLOC
+/* move_chunk: Allocate a new chunk of the specified size, copy the
+   contents of an allocated chunk to it and free the old chunk. */
+static void *
+move_chunk(chunk_t * const chunk, size_t size)
+{
+  void *newptr;
+
+  newptr = heapmem_alloc(size);
+  if(newptr == NULL) {
+    return NULL;
+  }
+
+  memcpy(newptr, GET_PTR(chunk), chunk->size);
+  release_chunk(chunk);
+
+  return newptr;
+}
+
 /*
  * heapmem_realloc: Reallocate an object with a different size,
  * possibly moving it in memory. In case of success, the function
@@ -415,7 +621,6 @@ heapmem_realloc_debug(void *ptr, size_t size,
 heapmem_realloc(void *ptr, size_t size)
 #endif
 {
-  void *newptr;
   chunk_t *chunk;
   int size_adj;
 
@@ -444,6 +649,17 @@ heapmem_realloc(void *ptr, size_t size)
   size = ALIGN(size);
   size_adj = size - chunk->size;
 
+#if HEAPMEM_SIZE_CLASSES
+  if(chunk->flags & CHUNK_FLAG_CLASS) {
+    /* Chunks of a size class keep their size, so that they can go
+       back to the free list of their class. */
+    if(size_adj <= 0) {
+      return ptr;
+    }
+    return move_chunk(chunk, size);
+  }
+#endif /* HEAPMEM_SIZE_CLASSES */
+
   if(size_adj <= 0) {
     /* Request to make the object smaller or to keep its size.
        In the former case, the chunk will be split if possible. */
@@ -483,15 +699,7 @@ heapmem_realloc(void *ptr, size_t size)
    * object elsewhere in the heap, and remove the old chunk that was
    * holding it.
    */
-  newptr = heapmem_alloc(size);
-  if(newptr == NULL) {
-    return NULL;
-  }
-
-  memcpy(newptr, ptr, chunk->size);
-  free_chunk(chunk);
-
-  return newptr;
+  return move_chunk(chunk, size);
 }
 #endif /* HEAPMEM_REALLOC */
 
@@ -500,21 +708,47 @@ void
 heapmem_stats(heapmem_stats_t *stats)
 {
   chunk_t *chunk;
+#if HEAPMEM_SIZE_CLASSES
+  int i;
+#endif /* HEAPMEM_SIZE_CLASSES */
 
   memset(stats, 0, sizeof(*stats));
 
   for(chunk = first_chunk;
       (char *)chunk < &heap_base[heap_usage];
       chunk = NEXT_CHUNK(chunk)) {
-    if(CHUNK_ALLOCATED(chunk)) {
+    if(CHUNK_CACHED(chunk)) {
+      stats->available += chunk->size;
+#if HEAPMEM_SIZE_CLASSES
+      stats->classes[CLASS_OF(chunk->size)].cached++;
+#endif /* HEAPMEM_SIZE_CLASSES */
+    } else if(CHUNK_ALLOCATED(chunk)) {
       stats->allocated += chunk->size;
     } else {
       coalesce_chunks(chunk);
       stats->available += chunk->size;
+      if(chunk->size > stats->largest_free) {
+        stats->largest_free = chunk->size;
+      }
     }
     stats->overhead += sizeof(chunk_t);
   }
   stats->available += HEAPMEM_ARENA_SIZE - heap_usage;
+  if(HEAPMEM_ARENA_SIZE - heap_usage > stats->largest_free) {
+    stats->largest_free = HEAPMEM_ARENA_SIZE - heap_usage;
+  }
   stats->footprint = heap_usage;
   stats->chunks = stats->overhead / sizeof(chunk_t);
+
+  if(stats->available > 0) {
+    stats->fragmentation = (stats->available - stats->largest_free) * 100 /
+      stats->available;
+  }
+
+#if HEAPMEM_SIZE_CLASSES
+  for(i = 0; i < HEAPMEM_SIZE_CLASSES; i++) {
+    stats->classes[i].allocated = class_allocated[i];
+    stats->classes[i].max_allocated = class_max_allocated[i];
+  }
+#endif /* HEAPMEM_SIZE_CLASSES */
 }
@@ -76,12 +76,52 @@
 
 #include <stdlib.h>
 
+#include "contiki-conf.h"
+
+/*
+ * The HEAPMEM_CONF_SIZE_CLASSES parameter enables the segregated-fit
+ * mode when set to a non-zero value. Requests up to
+ * HEAPMEM_SIZE_CLASSES * HEAPMEM_SIZE_CLASS_STEP bytes are rounded up
+ * to a multiple of HEAPMEM_SIZE_CLASS_STEP, and freed chunks of such a
+ * size are kept on a free list of their own size class. Allocating
+ * and freeing them then takes constant time. Larger chunks are only
+ * coalesced when an allocation cannot be satisfied otherwise.
+ */
+#ifdef HEAPMEM_CONF_SIZE_CLASSES
+#define HEAPMEM_SIZE_CLASSES HEAPMEM_CONF_SIZE_CLASSES
+#else
+#define HEAPMEM_SIZE_CLASSES 0
+#endif /* HEAPMEM_CONF_SIZE_CLASSES */
+
+/* The size difference between two adjacent size classes. */
+#ifdef HEAPMEM_CONF_SIZE_CLASS_STEP
+#define HEAPMEM_SIZE_CLASS_STEP HEAPMEM_CONF_SIZE_CLASS_STEP
+#else
+#define HEAPMEM_SIZE_CLASS_STEP 8
+#endif /* HEAPMEM_CONF_SIZE_CLASS_STEP */
+
+#if HEAPMEM_SIZE_CLASSES
+typedef struct heapmem_class_stats {
+  size_t allocated;     /* Chunks of this class currently allocated. */
+  size_t max_allocated; /* High-water mark of allocated chunks. */
+  size_t cached;        /* Free chunks on the list of this class. */
+} heapmem_class_stats_t;
+#endif /* HEAPMEM_SIZE_CLASSES */
+
 typedef struct heapmem_stats {
   size_t allocated;
   size_t overhead;
   size_t available;
   size_t footprint;
   size_t chunks;
+  /* The largest free chunk, or the unused end of the arena. */
+  size_t largest_free;
+  /* Percentage of the available memory outside of the largest free
+     block, from 0 (none) to 100. */
+  unsigned fragmentation;
+#if HEAPMEM_SIZE_CLASSES
+  heapmem_class_stats_t classes[HEAPMEM_SIZE_CLASSES];
+#endif /* HEAPMEM_SIZE_CLASSES */
 } heapmem_stats_t;
 
 #if HEAPMEM_DEBUG
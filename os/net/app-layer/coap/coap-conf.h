@@ -78,6 +78,19 @@
 #define COAP_SERVER_PORT               COAP_DEFAULT_PORT
 #endif /* COAP_SERVER_PORT */
 
+/* Seconds to wait for the ACK of a CON message, before the random factor */
+#ifdef COAP_CONF_RESPONSE_TIMEOUT
+#define COAP_RESPONSE_TIMEOUT COAP_CONF_RESPONSE_TIMEOUT
+#else
+#define COAP_RESPONSE_TIMEOUT 3
+#endif /* COAP_CONF_RESPONSE_TIMEOUT */
+
+#ifdef COAP_CONF_MAX_RETRANSMIT
+#define COAP_MAX_RETRANSMIT COAP_CONF_MAX_RETRANSMIT
+#else
+#define COAP_MAX_RETRANSMIT 4
+#endif /* COAP_CONF_MAX_RETRANSMIT */
+
 /* The number of concurrent messages that can be stored for retransmission in the transaction layer. */
 #ifndef COAP_MAX_OPEN_TRANSACTIONS
 #define COAP_MAX_OPEN_TRANSACTIONS     4
@@ -93,6 +106,52 @@
 #define COAP_MAX_HEADER_SIZE           (4 + COAP_TOKEN_LEN + 3 + 1 + COAP_ETAG_LEN + 4 + 4 + 30)  /* 65 */
 #endif /* COAP_MAX_HEADER_SIZE */
 
+/*
+ * Number of nodes of the resource path trie, one per distinct path
+ * segment of the activated resources. With 0 the resources are searched
+ * linearly.
+ */
+#ifdef COAP_CONF_RESOURCE_TRIE_NODES
+#define COAP_RESOURCE_TRIE_NODES COAP_CONF_RESOURCE_TRIE_NODES
+#else
+#define COAP_RESOURCE_TRIE_NODES 0
+#endif /* COAP_CONF_RESOURCE_TRIE_NODES */
+
+/*
+ * Number of hash buckets of the transaction index by MID and of the
+ * observer indexes by MID and token. With 0 the lists are searched.
+ */
+#ifdef COAP_CONF_INDEX_HASH_SIZE
+#define COAP_INDEX_HASH_SIZE COAP_CONF_INDEX_HASH_SIZE
+#else
+#define COAP_INDEX_HASH_SIZE 0
+#endif /* COAP_CONF_INDEX_HASH_SIZE */
+
+/*
+ * Number of slots of the retransmission timer wheel. All the CON
+ * transactions then share one timer that ticks every
+ * COAP_RETRANSMIT_WHEEL_TICK msec while messages are in flight, instead
+ * of a timer each. With 0 every transaction has its own timer.
+ */
+#ifdef COAP_CONF_RETRANSMIT_WHEEL_SLOTS
+#define COAP_RETRANSMIT_WHEEL_SLOTS COAP_CONF_RETRANSMIT_WHEEL_SLOTS
+#else
+#define COAP_RETRANSMIT_WHEEL_SLOTS 0
+#endif /* COAP_CONF_RETRANSMIT_WHEEL_SLOTS */
+
+#ifdef COAP_CONF_RETRANSMIT_WHEEL_TICK
+#define COAP_RETRANSMIT_WHEEL_TICK COAP_CONF_RETRANSMIT_WHEEL_TICK
+#else
+#define COAP_RETRANSMIT_WHEEL_TICK 100
+#endif /* COAP_CONF_RETRANSMIT_WHEEL_TICK */
+
+/* Count the CON messages in flight, retransmissions and timeouts */
+#ifdef COAP_CONF_TRANSACTION_STATS
+#define COAP_TRANSACTION_STATS COAP_CONF_TRANSACTION_STATS
+#else
+#define COAP_TRANSACTION_STATS 0
+#endif /* COAP_CONF_TRANSACTION_STATS */
+
 /* Number of observer slots (each takes abot xxx bytes) */
 #ifndef COAP_MAX_OBSERVERS
 #define COAP_MAX_OBSERVERS    COAP_MAX_OPEN_TRANSACTIONS - 1
@@ -105,6 +164,32 @@
 #define COAP_OBSERVE_REFRESH_INTERVAL  20
 #endif /* COAP_OBSERVE_REFRESH_INTERVAL */
 
+/*
+ * Render an observe notification once and share the payload among the
+ * observers, instead of calling the resource handler for every observer.
+ * CON notifications are then kept in transactions that hold the message
+ * header only.
+ */
+#ifdef COAP_CONF_OBSERVE_RENDER_ONCE
+#define COAP_OBSERVE_RENDER_ONCE COAP_CONF_OBSERVE_RENDER_ONCE
+#else
+#define COAP_OBSERVE_RENDER_ONCE 0
+#endif /* COAP_CONF_OBSERVE_RENDER_ONCE */
+
+/* The number of CON notifications with a shared payload that can wait for an ACK */
+#ifdef COAP_CONF_MAX_SHARED_TRANSACTIONS
+#define COAP_MAX_SHARED_TRANSACTIONS COAP_CONF_MAX_SHARED_TRANSACTIONS
+#else
+#define COAP_MAX_SHARED_TRANSACTIONS (COAP_MAX_OBSERVERS)
+#endif /* COAP_CONF_MAX_SHARED_TRANSACTIONS */
+
+/* The number of rendered notification payloads that can be in use */
+#ifdef COAP_CONF_MAX_SHARED_PAYLOADS
+#define COAP_MAX_SHARED_PAYLOADS COAP_CONF_MAX_SHARED_PAYLOADS
+#else
+#define COAP_MAX_SHARED_PAYLOADS 2
+#endif /* COAP_CONF_MAX_SHARED_PAYLOADS */
+
 /* Maximal length of observable URL */
 #ifdef COAP_CONF_OBSERVER_URL_LEN
 #define COAP_OBSERVER_URL_LEN COAP_CONF_OBSERVER_URL_LEN
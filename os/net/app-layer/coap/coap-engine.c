@@ -44,6 +44,7 @@
 #include "coap-engine.h"
 #include "sys/cc.h"
 #include "lib/list.h"
+#include "lib/memb.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
@@ -72,6 +73,27 @@ LIST(coap_handlers);
 LIST(coap_resource_services);
 static uint8_t is_initialized = 0;
 
+#if COAP_RESOURCE_TRIE_NODES
+/*
+ * The activated resources by URI path, one node per path segment. The
+ * segments point into the resource URLs.
+ */
+struct resource_node {
+  struct resource_node *child;
+  struct resource_node *sibling;
+  const char *segment;
+  uint16_t segment_len;
+  uint16_t order;                   /* activation order of the resource */
+  coap_resource_t *resource;
+};
+
+MEMB(resource_nodes, struct resource_node, COAP_RESOURCE_TRIE_NODES);
+static struct resource_node resource_root;
+static uint16_t resource_order;
+/* out of nodes, search the resource list */
+static uint8_t resource_trie_full;
+#endif /* COAP_RESOURCE_TRIE_NODES */
+
 /*---------------------------------------------------------------------------*/
 /*- CoAP service handlers---------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -379,6 +401,12 @@ coap_engine_init(void)
 
   list_init(coap_handlers);
   list_init(coap_resource_services);
+#if COAP_RESOURCE_TRIE_NODES
+  memb_init(&resource_nodes);
+  memset(&resource_root, 0, sizeof(resource_root));
+  resource_order = 0;
+  resource_trie_full = 0;
+#endif /* COAP_RESOURCE_TRIE_NODES */
 
   coap_activate_resource(&res_well_known_core, ".well-known/core");
 
@@ -386,6 +414,104 @@ coap_engine_init(void)
   coap_init_connection();
 }
 /*---------------------------------------------------------------------------*/
+#if COAP_RESOURCE_TRIE_NODES
+/* Length of the path segment at seg, sets *next past the '/' or to NULL */
+static uint16_t
+path_segment(const char *seg, const char *end, const char **next)
+{
+  const char *sep = memchr(seg, '/', end - seg);
+
+  if(sep == NULL) {
+    *next = NULL;
+    return end - seg;
+  }
+  *next = sep + 1;
+  return sep - seg;
+}
+/*---------------------------------------------------------------------------*/
+static struct resource_node *
+find_child(const struct resource_node *node, const char *seg, uint16_t len)
+{
+  struct resource_node *child;
+
+  for(child = node->child; child != NULL; child = child->sibling) {
+    if(child->segment_len == len && memcmp(child->segment, seg, len) == 0) {
+      return child;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+trie_add(coap_resource_t *resource)
+{
+  struct resource_node *node = &resource_root;
+  struct resource_node *child;
+  const char *seg = resource->url;
+  const char *end = seg + resource->url_len;
+  const char *next;
+  uint16_t len;
+
+  while(seg != NULL) {
+    len = path_segment(seg, end, &next);
+    child = find_child(node, seg, len);
+    if(child == NULL) {
+      child = memb_alloc(&resource_nodes);
+      if(child == NULL) {
+        LOG_WARN("No trie node for /%s, using the resource list\n",
+                 resource->url);
+        resource_trie_full = 1;
+        return;
+      }
+      child->child = NULL;
+      child->segment = seg;
+      child->segment_len = len;
+      child->resource = NULL;
+      child->sibling = node->child;
+      node->child = child;
+    }
+    node = child;
+    seg = next;
+  }
+
+  /* the first activated resource of a path handles it */
+  if(node->resource == NULL) {
+    node->resource = resource;
+    node->order = resource_order;
+  }
+  resource_order++;
+}
+/*---------------------------------------------------------------------------*/
+static coap_resource_t *
+trie_find(const char *url, int url_len)
+{
+  const struct resource_node *node = &resource_root;
+  coap_resource_t *found = NULL;
+  uint16_t found_order = 0;
+  const char *seg = url;
+  const char *end = url + url_len;
+  const char *next;
+  uint16_t len;
+
+  while(seg != NULL) {
+    len = path_segment(seg, end, &next);
+    node = find_child(node, seg, len);
+    if(node == NULL) {
+      break;
+    }
+    /* a match on the whole path, or on a parent of sub-resources */
+    if(node->resource != NULL
+       && (next == NULL || (node->resource->flags & HAS_SUB_RESOURCES))
+       && (found == NULL || node->order < found_order)) {
+      found = node->resource;
+      found_order = node->order;
+    }
+    seg = next;
+  }
+  return found;
+}
+#endif /* COAP_RESOURCE_TRIE_NODES */
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Makes a resource available under the given URI path
  * \param resource A pointer to a resource implementation
@@ -400,7 +526,13 @@ coap_activate_resource(coap_resource_t *resource, const char *path)
 {
   coap_periodic_resource_t *periodic;
   resource->url = path;
+  resource->url_len = strlen(path);
   list_add(coap_resource_services, resource);
+#if COAP_RESOURCE_TRIE_NODES
+  if(!resource_trie_full) {
+    trie_add(resource);
+  }
+#endif /* COAP_RESOURCE_TRIE_NODES */
 
   LOG_INFO("Activating: %s\n", resource->url);
 
@@ -432,6 +564,36 @@ coap_get_next_resource(coap_resource_t *resource)
   return list_item_next(resource);
 }
 /*---------------------------------------------------------------------------*/
+coap_resource_t *
+coap_get_resource_by_path(const char *url, int url_len)
+{
+  coap_resource_t *resource;
+
+  if(url == NULL) {
+    url = "";
+    url_len = 0;
+  }
+
+#if COAP_RESOURCE_TRIE_NODES
+  if(!resource_trie_full) {
+    return trie_find(url, url_len);
+  }
+#endif /* COAP_RESOURCE_TRIE_NODES */
+
+  for(resource = list_head(coap_resource_services);
+      resource; resource = resource->next) {
+    /* if the web service handles that kind of requests and urls matches */
+    if((url_len == resource->url_len
+        || (url_len > resource->url_len
+            && (resource->flags & HAS_SUB_RESOURCES)
+            && url[resource->url_len] == '/'))
+       && strncmp(resource->url, url, resource->url_len) == 0) {
+      return resource;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 static int
 invoke_coap_resource_service(coap_message_t *request, coap_message_t *response,
                              uint8_t *buffer, uint16_t buffer_size,
@@ -442,44 +604,34 @@ invoke_coap_resource_service(coap_message_t *request, coap_message_t *response,
 
   coap_resource_t *resource = NULL;
   const char *url = NULL;
-  int url_len, res_url_len;
+  int url_len;
 
   url_len = coap_get_header_uri_path(request, &url);
-  for(resource = list_head(coap_resource_services);
-      resource; resource = resource->next) {
-
-    /* if the web service handles that kind of requests and urls matches */
-    res_url_len = strlen(resource->url);
-    if((url_len == res_url_len
-        || (url_len > res_url_len
-            && (resource->flags & HAS_SUB_RESOURCES)
-            && url[res_url_len] == '/'))
-       && strncmp(resource->url, url, res_url_len) == 0) {
-      coap_resource_flags_t method = coap_get_method_type(request);
-      found = 1;
-
-      LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
-               (uint16_t)method, resource->flags);
-
-      if((method & METHOD_GET) && resource->get_handler != NULL) {
-        /* call handler function */
-        resource->get_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_POST) && resource->post_handler != NULL) {
-        /* call handler function */
-        resource->post_handler(request, response, buffer, buffer_size,
+  resource = coap_get_resource_by_path(url, url_len);
+  if(resource != NULL) {
+    coap_resource_flags_t method = coap_get_method_type(request);
+    found = 1;
+
+    LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
+             (uint16_t)method, resource->flags);
+
+    if((method & METHOD_GET) && resource->get_handler != NULL) {
+      /* call handler function */
+      resource->get_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_POST) && resource->post_handler != NULL) {
+      /* call handler function */
+      resource->post_handler(request, response, buffer, buffer_size,
+                             offset);
+    } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
+      /* call handler function */
+      resource->put_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
+      /* call handler function */
+      resource->delete_handler(request, response, buffer, buffer_size,
                                offset);
-      } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
-        /* call handler function */
-        resource->put_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
-        /* call handler function */
-        resource->delete_handler(request, response, buffer, buffer_size,
-                                 offset);
-      } else {
-        allowed = 0;
-        coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
-      }
-      break;
+    } else {
+      allowed = 0;
+      coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
     }
   }
   if(!found) {
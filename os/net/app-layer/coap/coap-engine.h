@@ -111,6 +111,7 @@ struct coap_resource_s {
     coap_resource_trigger_handler_t trigger;
     coap_resource_trigger_handler_t resume;
   };
+  uint16_t url_len;                 /* set on activation */
 };
 
 struct coap_periodic_resource_s {
@@ -167,6 +168,15 @@ coap_resource_t *coap_get_first_resource(void);
  */
 coap_resource_t *coap_get_next_resource(coap_resource_t *resource);
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief      Finds the resource that handles a URI path.
+ * \param url  The URI path, without leading '/'
+ * \param url_len The length of the URI path
+ * \return     The first activated resource with this path, or with a
+ *             parent path and HAS_SUB_RESOURCES set, or NULL.
+ */
+coap_resource_t *coap_get_resource_by_path(const char *url, int url_len);
+/*---------------------------------------------------------------------------*/
 
 #include "coap-transactions.h"
 #include "coap-observe.h"
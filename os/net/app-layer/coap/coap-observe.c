@@ -56,9 +56,76 @@
 /*---------------------------------------------------------------------------*/
 MEMB(observers_memb, coap_observer_t, COAP_MAX_OBSERVERS);
 LIST(observers_list);
+
+#if COAP_INDEX_HASH_SIZE
+/* the observers by the MID of their last notification, and by token */
+static coap_observer_t *mid_index[COAP_INDEX_HASH_SIZE];
+static coap_observer_t *token_index[COAP_INDEX_HASH_SIZE];
+#endif /* COAP_INDEX_HASH_SIZE */
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+#if COAP_INDEX_HASH_SIZE
+static coap_observer_t **
+mid_bucket(uint16_t mid)
+{
+  return &mid_index[mid % COAP_INDEX_HASH_SIZE];
+}
+/*---------------------------------------------------------------------------*/
+static coap_observer_t **
+token_bucket(const uint8_t *token, size_t token_len)
+{
+  uint16_t hash = 0;
+
+  while(token_len-- > 0) {
+    hash = (hash << 3) + (hash >> 13) + *token++;
+  }
+  return &token_index[hash % COAP_INDEX_HASH_SIZE];
+}
+/*---------------------------------------------------------------------------*/
+static void
+unlink_mid(coap_observer_t *o)
+{
+  coap_observer_t **p;
+
+  for(p = mid_bucket(o->last_mid); *p != NULL; p = &(*p)->mid_next) {
+    if(*p == o) {
+      *p = o->mid_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+unlink_token(coap_observer_t *o)
+{
+  coap_observer_t **p;
+
+  for(p = token_bucket(o->token, o->token_len); *p != NULL;
+      p = &(*p)->token_next) {
+    if(*p == o) {
+      *p = o->token_next;
+      return;
+    }
+  }
+}
+#endif /* COAP_INDEX_HASH_SIZE */
+/*---------------------------------------------------------------------------*/
+/* The MID of the last notification, for RST matching */
+static void
+set_last_mid(coap_observer_t *o, uint16_t mid)
+{
+#if COAP_INDEX_HASH_SIZE
+  coap_observer_t **bucket;
+
+  unlink_mid(o);
+  bucket = mid_bucket(mid);
+  o->mid_next = *bucket;
+  *bucket = o;
+#endif /* COAP_INDEX_HASH_SIZE */
+  o->last_mid = mid;
+}
+/*---------------------------------------------------------------------------*/
 static coap_observer_t *
 add_observer(const coap_endpoint_t *endpoint, const uint8_t *token,
              size_t token_len, const char *uri, int uri_len)
@@ -75,10 +142,17 @@ add_observer(const coap_endpoint_t *endpoint, const uint8_t *token,
     }
     memcpy(o->url, uri, max);
     o->url[max] = 0;
+    o->url_len = max;
     coap_endpoint_copy(&o->endpoint, endpoint);
     o->token_len = token_len;
     memcpy(o->token, token, token_len);
     o->last_mid = 0;
+#if COAP_INDEX_HASH_SIZE
+    o->mid_next = *mid_bucket(0);
+    *mid_bucket(0) = o;
+    o->token_next = *token_bucket(o->token, o->token_len);
+    *token_bucket(o->token, o->token_len) = o;
+#endif /* COAP_INDEX_HASH_SIZE */
 
     LOG_INFO("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
              list_length(observers_list) + 1, COAP_MAX_OBSERVERS,
@@ -97,6 +171,10 @@ coap_remove_observer(coap_observer_t *o)
   LOG_INFO("Removing observer for /%s [0x%02X%02X]\n", o->url, o->token[0],
            o->token[1]);
 
+#if COAP_INDEX_HASH_SIZE
+  unlink_mid(o);
+  unlink_token(o);
+#endif /* COAP_INDEX_HASH_SIZE */
   memb_free(&observers_memb, o);
   list_remove(observers_list, o);
 }
@@ -127,8 +205,15 @@ coap_remove_observer_by_token(const coap_endpoint_t *endpoint,
   int removed = 0;
   coap_observer_t *obs = NULL;
 
+#if COAP_INDEX_HASH_SIZE
+  coap_observer_t *next;
+
+  for(obs = *token_bucket(token, token_len); obs; obs = next) {
+    next = obs->token_next;
+#else /* COAP_INDEX_HASH_SIZE */
   for(obs = (coap_observer_t *)list_head(observers_list); obs;
       obs = obs->next) {
+#endif /* COAP_INDEX_HASH_SIZE */
     LOG_DBG("Remove check Token 0x%02X%02X\n", token[0], token[1]);
     if(coap_endpoint_cmp(&obs->endpoint, endpoint)
        && obs->token_len == token_len
@@ -152,7 +237,7 @@ coap_remove_observer_by_uri(const coap_endpoint_t *endpoint,
     LOG_DBG("Remove check URL %p\n", uri);
     if((endpoint == NULL
         || (coap_endpoint_cmp(&obs->endpoint, endpoint)))
-       && (obs->url == uri || memcmp(obs->url, uri, strlen(obs->url)) == 0)) {
+       && (obs->url == uri || memcmp(obs->url, uri, obs->url_len) == 0)) {
       coap_remove_observer(obs);
       removed++;
     }
@@ -166,8 +251,15 @@ coap_remove_observer_by_mid(const coap_endpoint_t *endpoint, uint16_t mid)
   int removed = 0;
   coap_observer_t *obs = NULL;
 
+#if COAP_INDEX_HASH_SIZE
+  coap_observer_t *next;
+
+  for(obs = *mid_bucket(mid); obs; obs = next) {
+    next = obs->mid_next;
+#else /* COAP_INDEX_HASH_SIZE */
   for(obs = (coap_observer_t *)list_head(observers_list); obs;
       obs = obs->next) {
+#endif /* COAP_INDEX_HASH_SIZE */
     LOG_DBG("Remove check MID %u\n", mid);
     if(coap_endpoint_cmp(&obs->endpoint, endpoint)
        && obs->last_mid == mid) {
@@ -180,6 +272,117 @@ coap_remove_observer_by_mid(const coap_endpoint_t *endpoint, uint16_t mid)
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+#if COAP_OBSERVE_RENDER_ONCE
+/* The header of a notification is serialized here before it is stored or
+   sent. The serializer checks the header size only after it wrote all
+   options, so this buffer is as large as a whole message. */
+static uint8_t notification_header[COAP_MAX_PACKET_SIZE + 1];
+/*---------------------------------------------------------------------------*/
+/* Call the resource handler once, for all the observers of the URL */
+static coap_shared_payload_t *
+render_notification(coap_resource_t *resource, coap_message_t *request,
+                    coap_message_t *notification)
+{
+  coap_shared_payload_t *payload;
+  int32_t new_offset = 0;
+  uint16_t len;
+
+  payload = coap_shared_payload_new();
+  if(payload == NULL) {
+    LOG_WARN("No buffer for the notification payload\n");
+    return NULL;
+  }
+
+  /* Either old style get_handler or the full handler */
+  if(coap_call_handlers(request, notification, payload->data,
+                        COAP_MAX_CHUNK_SIZE, &new_offset) > 0) {
+    LOG_DBG("Notification on new handlers\n");
+  } else {
+    if(resource != NULL) {
+      resource->get_handler(request, notification, payload->data,
+                            COAP_MAX_CHUNK_SIZE, &new_offset);
+    } else {
+      /* What to do here? */
+      notification->code = BAD_REQUEST_4_00;
+    }
+  }
+
+  len = notification->payload != NULL ? notification->payload_len : 0;
+  if(new_offset != 0) {
+    coap_set_header_block2(notification, 0, new_offset != -1,
+                           COAP_MAX_BLOCK_SIZE);
+    len = MIN(len, COAP_MAX_BLOCK_SIZE);
+  }
+
+  /* the handler may have set a payload from its own buffer */
+  if(len > 0 && notification->payload != payload->data) {
+    memmove(payload->data, notification->payload, len);
+  }
+  payload->len = len;
+
+  /* only the header is serialized per observer */
+  notification->payload = NULL;
+  notification->payload_len = 0;
+
+  return payload;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_notification(coap_observer_t *obs, coap_message_t *notification,
+                  coap_shared_payload_t *payload)
+{
+  coap_transaction_t *transaction;
+  uint16_t header_len;
+
+  /* if COAP_OBSERVE_REFRESH_INTERVAL is zero, never send observations as confirmable messages */
+  if(COAP_OBSERVE_REFRESH_INTERVAL != 0
+     && (obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0)) {
+    LOG_DBG("           Force Confirmable for\n");
+    notification->type = COAP_TYPE_CON;
+  } else {
+    notification->type = COAP_TYPE_NON;
+  }
+
+  LOG_DBG("           Observer ");
+  LOG_DBG_COAP_EP(&obs->endpoint);
+  LOG_DBG_("\n");
+
+  /* update last MID for RST matching */
+  notification->mid = coap_get_mid();
+  set_last_mid(obs, notification->mid);
+
+  if(notification->code < BAD_REQUEST_4_00) {
+    coap_set_header_observe(notification, (obs->obs_counter)++);
+    /* mask out to keep the CoAP observe option length <= 3 bytes */
+    obs->obs_counter &= 0xffffff;
+  }
+  coap_set_token(notification, obs->token, obs->token_len);
+
+  /* at most COAP_MAX_HEADER_SIZE bytes when it succeeds */
+  header_len = coap_serialize_message(notification, notification_header);
+  if(header_len == 0) {
+    LOG_WARN("Notification not serialized: %s\n", coap_error_message);
+    return;
+  }
+
+  if(notification->type == COAP_TYPE_CON) {
+    /* kept for retransmission until the observer acknowledges it */
+    transaction = coap_new_shared_transaction(notification->mid,
+                                              &obs->endpoint, payload);
+    if(transaction == NULL) {
+      LOG_WARN("No transaction for the notification\n");
+      return;
+    }
+    memcpy(transaction->message, notification_header, header_len);
+    transaction->message_len = header_len;
+    coap_send_transaction(transaction);
+  } else {
+    coap_sendto_shared(&obs->endpoint, notification_header, header_len,
+                       payload);
+  }
+}
+#endif /* COAP_OBSERVE_RENDER_ONCE */
+/*---------------------------------------------------------------------------*/
 void
 coap_notify_observers(coap_resource_t *resource)
 {
@@ -194,12 +397,15 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
   coap_message_t notification[1]; /* this way the message can be treated as pointer as usual */
   coap_message_t request[1]; /* this way the message can be treated as pointer as usual */
   coap_observer_t *obs = NULL;
-  int url_len, obs_url_len;
+  int url_len;
   char url[COAP_OBSERVER_URL_LEN];
   uint8_t sub_ok = 0;
+#if COAP_OBSERVE_RENDER_ONCE
+  coap_shared_payload_t *payload = NULL;
+#endif /* COAP_OBSERVE_RENDER_ONCE */
 
   if(resource != NULL) {
-    url_len = strlen(resource->url);
+    url_len = resource->url_len;
     strncpy(url, resource->url, COAP_OBSERVER_URL_LEN - 1);
     if(url_len < COAP_OBSERVER_URL_LEN - 1 && subpath != NULL) {
       strncpy(&url[url_len], subpath, COAP_OBSERVER_URL_LEN - url_len - 1);
@@ -227,21 +433,28 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
   sub_ok = (resource == NULL) || (resource->flags & HAS_SUB_RESOURCES);
   for(obs = (coap_observer_t *)list_head(observers_list); obs;
       obs = obs->next) {
-    obs_url_len = strlen(obs->url);
-
     /* Do a match based on the parent/sub-resource match so that it is
        possible to do parent-node observe */
 
     /***** TODO fix here so that we handle the notofication correctly ******/
     /* All the new-style ... is assuming that the URL might be within */
-    if((obs_url_len == url_len
-        || (obs_url_len > url_len
+    if((obs->url_len == url_len
+        || (obs->url_len > url_len
             && sub_ok
             && obs->url[url_len] == '/'))
        && strncmp(url, obs->url, url_len) == 0) {
+#if COAP_OBSERVE_RENDER_ONCE
+      if(payload == NULL) {
+        payload = render_notification(resource, request, notification);
+        if(payload == NULL) {
+          return;
+        }
+      }
+      send_notification(obs, notification, payload);
+#else /* COAP_OBSERVE_RENDER_ONCE */
       coap_transaction_t *transaction = NULL;
 
-      /*TODO implement special transaction for CON, sharing the same buffer to allow for more observers */
+      /* see COAP_OBSERVE_RENDER_ONCE for CON transactions sharing one payload */
 
       if((transaction = coap_new_transaction(coap_get_mid(), &obs->endpoint))) {
         /* if COAP_OBSERVE_REFRESH_INTERVAL is zero, never send observations as confirmable messages */
@@ -256,7 +469,7 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
         LOG_DBG_("\n");
 
         /* update last MID for RST matching */
-        obs->last_mid = transaction->mid;
+        set_last_mid(obs, transaction->mid);
 
         /* prepare response */
         notification->mid = transaction->mid;
@@ -302,8 +515,13 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
 
         coap_send_transaction(transaction);
       }
+#endif /* COAP_OBSERVE_RENDER_ONCE */
     }
   }
+#if COAP_OBSERVE_RENDER_ONCE
+  /* the pending CON notifications keep their own references */
+  coap_shared_payload_release(payload);
+#endif /* COAP_OBSERVE_RENDER_ONCE */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -52,10 +52,15 @@ typedef struct coap_observer {
   struct coap_observer *next;   /* for LIST */
 
   char url[COAP_OBSERVER_URL_LEN];
+  uint16_t url_len;
   coap_endpoint_t endpoint;
   uint8_t token_len;
   uint8_t token[COAP_TOKEN_LEN];
   uint16_t last_mid;
+#if COAP_INDEX_HASH_SIZE
+  struct coap_observer *mid_next;       /* in the index by last_mid */
+  struct coap_observer *token_next;     /* in the index by token */
+#endif /* COAP_INDEX_HASH_SIZE */
 
   int32_t obs_counter;
 
@@ -47,6 +47,7 @@
 #include "lib/memb.h"
 #include "lib/list.h"
 #include <stdlib.h>
+#include <string.h>
 
 /* Log configuration */
 #include "coap-log.h"
@@ -54,11 +55,140 @@
 #define LOG_LEVEL  LOG_LEVEL_COAP
 
 /*---------------------------------------------------------------------------*/
+#if COAP_OBSERVE_RENDER_ONCE
+struct transaction_buffer {
+  uint8_t data[COAP_MAX_PACKET_SIZE + 1];
+};
+struct transaction_header {
+  uint8_t data[COAP_MAX_HEADER_SIZE + 1];       /* +1 as for the message buffer */
+};
+
+MEMB(transactions_memb, coap_transaction_t,
+     COAP_MAX_OPEN_TRANSACTIONS + COAP_MAX_SHARED_TRANSACTIONS);
+MEMB(buffers_memb, struct transaction_buffer, COAP_MAX_OPEN_TRANSACTIONS);
+MEMB(headers_memb, struct transaction_header, COAP_MAX_SHARED_TRANSACTIONS);
+MEMB(payloads_memb, coap_shared_payload_t, COAP_MAX_SHARED_PAYLOADS);
+
+/* a message with a shared payload is put together here for sending,
+   +1 for the payload marker between the header and a full chunk */
+static uint8_t shared_message[COAP_MAX_PACKET_SIZE + 1];
+#else /* COAP_OBSERVE_RENDER_ONCE */
 MEMB(transactions_memb, coap_transaction_t, COAP_MAX_OPEN_TRANSACTIONS);
+#endif /* COAP_OBSERVE_RENDER_ONCE */
 LIST(transactions_list);
 
+#if COAP_INDEX_HASH_SIZE
+/* the transactions by MID */
+static coap_transaction_t *mid_index[COAP_INDEX_HASH_SIZE];
+#endif /* COAP_INDEX_HASH_SIZE */
+
+#if COAP_RETRANSMIT_WHEEL_SLOTS
+/* the waiting transactions by the tick of their retransmission time */
+static coap_transaction_t *wheel[COAP_RETRANSMIT_WHEEL_SLOTS];
+static coap_timer_t wheel_timer;
+static uint64_t wheel_tick;             /* the last tick that was run */
+static uint16_t wheel_count;
+#endif /* COAP_RETRANSMIT_WHEEL_SLOTS */
+
+#if COAP_TRANSACTION_STATS
+coap_transaction_stats_t coap_transaction_stats;
+#endif /* COAP_TRANSACTION_STATS */
+
+/*---------------------------------------------------------------------------*/
+static void
+retransmit(coap_transaction_t *t)
+{
+  ++(t->retrans_counter);
+  LOG_DBG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
+  coap_send_transaction(t);
+}
+/*---------------------------------------------------------------------------*/
+#if COAP_RETRANSMIT_WHEEL_SLOTS
+static uint16_t
+wheel_slot(uint64_t time)
+{
+  /* run on the first tick at or after the time */
+  return ((time + COAP_RETRANSMIT_WHEEL_TICK - 1) / COAP_RETRANSMIT_WHEEL_TICK)
+    % COAP_RETRANSMIT_WHEEL_SLOTS;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_remove(coap_transaction_t *t)
+{
+  coap_transaction_t **p;
+
+  if(t->retrans_time == 0) {
+    return;
+  }
+  for(p = &wheel[wheel_slot(t->retrans_time)]; *p != NULL;
+      p = &(*p)->wheel_next) {
+    if(*p == t) {
+      *p = t->wheel_next;
+      break;
+    }
+  }
+  t->retrans_time = 0;
+  if(--wheel_count == 0) {
+    coap_timer_stop(&wheel_timer);
+  }
+}
 /*---------------------------------------------------------------------------*/
 static void
+wheel_run(coap_timer_t *timer)
+{
+  uint64_t now = coap_timer_uptime();
+  uint64_t tick = now / COAP_RETRANSMIT_WHEEL_TICK;
+  uint64_t last = wheel_tick;
+  uint16_t slot;
+  coap_transaction_t *t;
+
+  /* one turn visits every slot */
+  if(tick - last > COAP_RETRANSMIT_WHEEL_SLOTS) {
+    last = tick - COAP_RETRANSMIT_WHEEL_SLOTS;
+  }
+  wheel_tick = tick;
+
+  while(last++ < tick) {
+    slot = last % COAP_RETRANSMIT_WHEEL_SLOTS;
+    /* start over after a retransmission, a timeout may clear others */
+    for(t = wheel[slot]; t != NULL;) {
+      if(t->retrans_time <= now) {
+        wheel_remove(t);
+        retransmit(t);
+        t = wheel[slot];
+      } else {
+        t = t->wheel_next;
+      }
+    }
+  }
+
+  if(wheel_count > 0) {
+    coap_timer_set(&wheel_timer, COAP_RETRANSMIT_WHEEL_TICK
+                   - now % COAP_RETRANSMIT_WHEEL_TICK);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_add(coap_transaction_t *t, uint32_t interval)
+{
+  uint64_t now = coap_timer_uptime();
+  uint16_t slot;
+
+  wheel_remove(t);
+  t->retrans_time = now + interval;
+  slot = wheel_slot(t->retrans_time);
+  t->wheel_next = wheel[slot];
+  wheel[slot] = t;
+
+  if(wheel_count++ == 0) {
+    wheel_tick = now / COAP_RETRANSMIT_WHEEL_TICK;
+    coap_timer_set_callback(&wheel_timer, wheel_run);
+    coap_timer_set(&wheel_timer, COAP_RETRANSMIT_WHEEL_TICK
+                   - now % COAP_RETRANSMIT_WHEEL_TICK);
+  }
+}
+#else /* COAP_RETRANSMIT_WHEEL_SLOTS */
+static void
 coap_retransmit_transaction(coap_timer_t *nt)
 {
   coap_transaction_t *t = coap_timer_get_user_data(nt);
@@ -66,9 +196,52 @@ coap_retransmit_transaction(coap_timer_t *nt)
     LOG_DBG("No retransmission data in coap_timer!\n");
     return;
   }
-  ++(t->retrans_counter);
-  LOG_DBG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
-  coap_send_transaction(t);
+  retransmit(t);
+}
+#endif /* COAP_RETRANSMIT_WHEEL_SLOTS */
+/*---------------------------------------------------------------------------*/
+#if COAP_INDEX_HASH_SIZE
+static void
+index_add(coap_transaction_t *t)
+{
+  coap_transaction_t **p = &mid_index[t->mid % COAP_INDEX_HASH_SIZE];
+
+  /* at the tail, the oldest transaction of a MID is found first */
+  while(*p != NULL) {
+    p = &(*p)->hash_next;
+  }
+  t->hash_next = NULL;
+  *p = t;
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_remove(coap_transaction_t *t)
+{
+  coap_transaction_t **p;
+
+  for(p = &mid_index[t->mid % COAP_INDEX_HASH_SIZE]; *p != NULL;
+      p = &(*p)->hash_next) {
+    if(*p == t) {
+      *p = t->hash_next;
+      return;
+    }
+  }
+}
+#endif /* COAP_INDEX_HASH_SIZE */
+/*---------------------------------------------------------------------------*/
+static void
+add_transaction(coap_transaction_t *t)
+{
+#if COAP_RETRANSMIT_WHEEL_SLOTS
+  t->retrans_time = 0;
+#endif /* COAP_RETRANSMIT_WHEEL_SLOTS */
+#if COAP_TRANSACTION_STATS
+  t->in_flight = 0;
+#endif /* COAP_TRANSACTION_STATS */
+#if COAP_INDEX_HASH_SIZE
+  index_add(t);
+#endif /* COAP_INDEX_HASH_SIZE */
+  list_add(transactions_list, t); /* list itself makes sure same element is not added twice */
 }
 /*---------------------------------------------------------------------------*/
 
@@ -80,6 +253,17 @@ coap_new_transaction(uint16_t mid, const coap_endpoint_t *endpoint)
 {
   coap_transaction_t *t = memb_alloc(&transactions_memb);
 
+#if COAP_OBSERVE_RENDER_ONCE
+  if(t) {
+    t->shared = NULL;
+    t->message = memb_alloc(&buffers_memb);
+    if(t->message == NULL) {
+      memb_free(&transactions_memb, t);
+      t = NULL;
+    }
+  }
+#endif /* COAP_OBSERVE_RENDER_ONCE */
+
   if(t) {
     t->mid = mid;
     t->retrans_counter = 0;
@@ -87,7 +271,7 @@ coap_new_transaction(uint16_t mid, const coap_endpoint_t *endpoint)
     /* save client address */
     coap_endpoint_copy(&t->endpoint, endpoint);
 
-    list_add(transactions_list, t); /* list itself makes sure same element is not added twice */
+    add_transaction(t);
   }
 
   return t;
@@ -102,12 +286,32 @@ coap_send_transaction(coap_transaction_t *t)
      ((COAP_HEADER_TYPE_MASK & t->message[0]) >> COAP_HEADER_TYPE_POSITION)) {
     if(t->retrans_counter <= COAP_MAX_RETRANSMIT) {
       /* not timed out yet */
+#if COAP_TRANSACTION_STATS
+      if(t->retrans_counter > 0) {
+        coap_transaction_stats.retransmitted++;
+      } else if(!t->in_flight) {
+        t->in_flight = 1;
+        coap_transaction_stats.sent++;
+        if(++coap_transaction_stats.in_flight
+           > coap_transaction_stats.max_in_flight) {
+          coap_transaction_stats.max_in_flight =
+            coap_transaction_stats.in_flight;
+        }
+      }
+#endif /* COAP_TRANSACTION_STATS */
+#if COAP_OBSERVE_RENDER_ONCE
+      if(t->shared) {
+        coap_sendto_shared(&t->endpoint, t->message, t->message_len, t->shared);
+      } else
+#endif /* COAP_OBSERVE_RENDER_ONCE */
       coap_sendto(&t->endpoint, t->message, t->message_len);
       LOG_DBG("Keeping transaction %u\n", t->mid);
 
       if(t->retrans_counter == 0) {
+#if !COAP_RETRANSMIT_WHEEL_SLOTS
         coap_timer_set_callback(&t->retrans_timer, coap_retransmit_transaction);
         coap_timer_set_user_data(&t->retrans_timer, t);
+#endif /* !COAP_RETRANSMIT_WHEEL_SLOTS */
         t->retrans_interval =
           COAP_RESPONSE_TIMEOUT_TICKS + (rand() %
                                          COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
@@ -120,10 +324,17 @@ coap_send_transaction(coap_transaction_t *t)
       }
 
       /* interval updated above */
+#if COAP_RETRANSMIT_WHEEL_SLOTS
+      wheel_add(t, t->retrans_interval);
+#else /* COAP_RETRANSMIT_WHEEL_SLOTS */
       coap_timer_set(&t->retrans_timer, t->retrans_interval);
+#endif /* COAP_RETRANSMIT_WHEEL_SLOTS */
     } else {
       /* timed out */
       LOG_DBG("Timeout\n");
+#if COAP_TRANSACTION_STATS
+      coap_transaction_stats.timed_out++;
+#endif /* COAP_TRANSACTION_STATS */
       coap_resource_response_handler_t callback = t->callback;
       void *callback_data = t->callback_data;
 
@@ -148,8 +359,28 @@ coap_clear_transaction(coap_transaction_t *t)
   if(t) {
     LOG_DBG("Freeing transaction %u: %p\n", t->mid, t);
 
+#if COAP_RETRANSMIT_WHEEL_SLOTS
+    wheel_remove(t);
+#else /* COAP_RETRANSMIT_WHEEL_SLOTS */
     coap_timer_stop(&t->retrans_timer);
+#endif /* COAP_RETRANSMIT_WHEEL_SLOTS */
+#if COAP_TRANSACTION_STATS
+    if(t->in_flight) {
+      coap_transaction_stats.in_flight--;
+    }
+#endif /* COAP_TRANSACTION_STATS */
+#if COAP_INDEX_HASH_SIZE
+    index_remove(t);
+#endif /* COAP_INDEX_HASH_SIZE */
     list_remove(transactions_list, t);
+#if COAP_OBSERVE_RENDER_ONCE
+    if(t->shared) {
+      memb_free(&headers_memb, t->message);
+      coap_shared_payload_release(t->shared);
+    } else {
+      memb_free(&buffers_memb, t->message);
+    }
+#endif /* COAP_OBSERVE_RENDER_ONCE */
     memb_free(&transactions_memb, t);
   }
 }
@@ -159,7 +390,11 @@ coap_get_transaction_by_mid(uint16_t mid)
 {
   coap_transaction_t *t = NULL;
 
+#if COAP_INDEX_HASH_SIZE
+  for(t = mid_index[mid % COAP_INDEX_HASH_SIZE]; t; t = t->hash_next) {
+#else /* COAP_INDEX_HASH_SIZE */
   for(t = (coap_transaction_t *)list_head(transactions_list); t; t = t->next) {
+#endif /* COAP_INDEX_HASH_SIZE */
     if(t->mid == mid) {
       LOG_DBG("Found transaction for MID %u: %p\n", t->mid, t);
       return t;
@@ -168,4 +403,76 @@ coap_get_transaction_by_mid(uint16_t mid)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+#if COAP_OBSERVE_RENDER_ONCE
+coap_shared_payload_t *
+coap_shared_payload_new(void)
+{
+  coap_shared_payload_t *payload = memb_alloc(&payloads_memb);
+
+  if(payload) {
+    payload->refs = 1;
+    payload->len = 0;
+  }
+  return payload;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_shared_payload_release(coap_shared_payload_t *payload)
+{
+  if(payload && --payload->refs == 0) {
+    memb_free(&payloads_memb, payload);
+  }
+}
+/*---------------------------------------------------------------------------*/
+coap_transaction_t *
+coap_new_shared_transaction(uint16_t mid, const coap_endpoint_t *endpoint,
+                            coap_shared_payload_t *payload)
+{
+  coap_transaction_t *t = memb_alloc(&transactions_memb);
+
+  if(t) {
+    t->message = memb_alloc(&headers_memb);
+    if(t->message == NULL) {
+      memb_free(&transactions_memb, t);
+      return NULL;
+    }
+    t->shared = payload;
+    payload->refs++;
+
+    t->mid = mid;
+    t->retrans_counter = 0;
+    t->callback = NULL;
+    t->callback_data = NULL;
+
+    /* save client address */
+    coap_endpoint_copy(&t->endpoint, endpoint);
+
+    add_transaction(t);
+  }
+
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_sendto_shared(const coap_endpoint_t *endpoint, const uint8_t *header,
+                   uint16_t header_len, const coap_shared_payload_t *payload)
+{
+  uint16_t len = header_len;
+
+  if(header_len + 1 + payload->len > sizeof(shared_message)) {
+    LOG_WARN("Shared message too long, not sent\n");
+    return;
+  }
+
+  memcpy(shared_message, header, header_len);
+  if(payload->len > 0) {
+    /* payload marker */
+    shared_message[len++] = 0xFF;
+    memcpy(&shared_message[len], payload->data, payload->len);
+    len += payload->len;
+  }
+  coap_sendto(endpoint, shared_message, len);
+}
+#endif /* COAP_OBSERVE_RENDER_ONCE */
+/*---------------------------------------------------------------------------*/
 /** @} */
@@ -55,14 +55,34 @@
 #define COAP_RESPONSE_TIMEOUT_TICKS         (1000 * COAP_RESPONSE_TIMEOUT)
 #define COAP_RESPONSE_TIMEOUT_BACKOFF_MASK  (uint32_t)(((1000 * COAP_RESPONSE_TIMEOUT * ((float)COAP_RESPONSE_RANDOM_FACTOR - 1.0)) + 0.5) + 1)
 
+#if COAP_OBSERVE_RENDER_ONCE
+/* a payload shared by the messages that reference it */
+typedef struct coap_shared_payload {
+  uint16_t refs;
+  uint16_t len;
+  uint8_t data[COAP_MAX_CHUNK_SIZE + 1];         /* +1 as for the message buffer */
+} coap_shared_payload_t;
+#endif /* COAP_OBSERVE_RENDER_ONCE */
+
 /* container for transactions with message buffer and retransmission info */
 typedef struct coap_transaction {
   struct coap_transaction *next;        /* for LIST */
 
   uint16_t mid;
+#if COAP_RETRANSMIT_WHEEL_SLOTS
+  struct coap_transaction *wheel_next;  /* in the slot of retrans_time */
+  uint64_t retrans_time;                /* 0 when not waiting */
+#else /* COAP_RETRANSMIT_WHEEL_SLOTS */
   coap_timer_t retrans_timer;
+#endif /* COAP_RETRANSMIT_WHEEL_SLOTS */
   uint32_t retrans_interval;
   uint8_t retrans_counter;
+#if COAP_TRANSACTION_STATS
+  uint8_t in_flight;
+#endif /* COAP_TRANSACTION_STATS */
+#if COAP_INDEX_HASH_SIZE
+  struct coap_transaction *hash_next;   /* in the MID index */
+#endif /* COAP_INDEX_HASH_SIZE */
 
   coap_endpoint_t endpoint;
 
@@ -70,14 +90,50 @@ typedef struct coap_transaction {
   void *callback_data;
 
   uint16_t message_len;
+#if COAP_OBSERVE_RENDER_ONCE
+  uint8_t *message;                             /* COAP_MAX_PACKET_SIZE + 1 bytes, or the header
+                                                 * of a message with a shared payload */
+  coap_shared_payload_t *shared;
+#else /* COAP_OBSERVE_RENDER_ONCE */
   uint8_t message[COAP_MAX_PACKET_SIZE + 1];     /* +1 for the terminating '\0' which will not be sent
                                                  * Use snprintf(buf, len+1, "", ...) to completely fill payload */
+#endif /* COAP_OBSERVE_RENDER_ONCE */
 } coap_transaction_t;
 
+#if COAP_TRANSACTION_STATS
+typedef struct coap_transaction_stats {
+  uint16_t in_flight;           /* CON messages waiting for an ACK */
+  uint16_t max_in_flight;
+  uint32_t sent;                /* CON messages, without retransmissions */
+  uint32_t retransmitted;
+  uint32_t timed_out;
+} coap_transaction_stats_t;
+
+extern coap_transaction_stats_t coap_transaction_stats;
+#endif /* COAP_TRANSACTION_STATS */
+
 coap_transaction_t *coap_new_transaction(uint16_t mid, const coap_endpoint_t *ep);
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
 
+#if COAP_OBSERVE_RENDER_ONCE
+coap_shared_payload_t *coap_shared_payload_new(void);
+void coap_shared_payload_release(coap_shared_payload_t *payload);
+
+/*
+ * A transaction for a message with a shared payload. Its message buffer
+ * takes the serialized header (COAP_MAX_HEADER_SIZE) without payload.
+ */
+coap_transaction_t *coap_new_shared_transaction(uint16_t mid,
+                                                const coap_endpoint_t *ep,
+                                                coap_shared_payload_t *payload);
+
+/* Send a serialized header followed by a shared payload */
+void coap_sendto_shared(const coap_endpoint_t *ep, const uint8_t *header,
+                        uint16_t header_len,
+                        const coap_shared_payload_t *payload);
+#endif /* COAP_OBSERVE_RENDER_ONCE */
+
 #endif /* COAP_TRANSACTIONS_H_ */
 /** @} */
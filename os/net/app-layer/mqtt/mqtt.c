@@ -891,11 +891,34 @@ PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn))
 #endif
 
   /* Write Payload */
-  PT_MQTT_WRITE_BYTES(conn,
-                      conn->out_packet.payload,
-                      conn->out_packet.payload_size);
+#if MQTT_STREAMING_PUBLISH
+  if(conn->out_packet.payload_iov != NULL) {
+    /*
+     * Queue the header from the out buffer and the payload segments in
+     * place behind it. The segments are read again on retransmission, so
+     * hold the transaction until the socket has drained.
+     */
+    send_out_buffer(conn);
+    conn->out_buffer_sent = 0;
+    if(tcp_socket_send_iov(&conn->socket, conn->out_packet.payload_iov,
+                           conn->out_packet.payload_iov_cnt) < 0) {
+      /* The header is already queued, the stream cannot be recovered */
+      PRINTF("MQTT - Error, could not queue the publish payload\n");
+      call_event(conn, MQTT_EVENT_ERROR, NULL);
+      abort_connection(conn);
+      PT_EXIT(pt);
+    }
+    PT_WAIT_UNTIL(pt, conn->out_buffer_sent);
+    conn->out_packet.payload_iov = NULL;
+  } else
+#endif
+  {
+    PT_MQTT_WRITE_BYTES(conn,
+                        conn->out_packet.payload,
+                        conn->out_packet.payload_size);
 
-  send_out_buffer(conn);
+    send_out_buffer(conn);
+  }
   timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
   /*
@@ -1605,7 +1628,7 @@ tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
   case TCP_SOCKET_DATA_SENT: {
     DBG("MQTT - Got TCP_DATA_SENT\n");
 
-    if(conn->socket.output_data_len == 0) {
+    if(tcp_socket_queuelen(&conn->socket) == 0) {
       conn->out_buffer_sent = 1;
       conn->out_buffer_ptr = conn->out_buffer;
     }
@@ -2022,6 +2045,9 @@ mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
 #endif
   conn->out_packet.payload = payload;
   conn->out_packet.payload_size = payload_size;
+#if MQTT_STREAMING_PUBLISH
+  conn->out_packet.payload_iov = NULL;
+#endif
   conn->out_packet.qos = qos_level;
   conn->out_packet.qos_state = MQTT_QOS_STATE_NO_ACK;
 
@@ -2037,6 +2063,45 @@ mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
+#if MQTT_STREAMING_PUBLISH
+mqtt_status_t
+mqtt_publish_iov(struct mqtt_connection *conn, uint16_t *mid, char *topic,
+                 const struct tcp_socket_iov *payload, uint8_t payload_cnt,
+                 mqtt_qos_level_t qos_level,
+#if MQTT_5
+                 mqtt_retain_t retain,
+                 uint8_t topic_alias, mqtt_topic_alias_en_t topic_alias_en,
+                 struct mqtt_prop_list *prop_list)
+#else
+                 mqtt_retain_t retain)
+#endif
+{
+  mqtt_status_t status;
+  uint32_t payload_size;
+  uint8_t i;
+
+  payload_size = 0;
+  for(i = 0; i < payload_cnt; i++) {
+    payload_size += payload[i].len;
+  }
+
+  status = mqtt_publish(conn, mid, topic, NULL, payload_size, qos_level,
+#if MQTT_5
+                        retain, topic_alias, topic_alias_en, prop_list);
+#else
+                        retain);
+#endif
+
+  /* mqtt_publish() only queues the packet, so the segments can still be
+     attached before publish_pt() runs */
+  if(status == MQTT_STATUS_OK && payload_size > 0) {
+    conn->out_packet.payload_iov = payload;
+    conn->out_packet.payload_iov_cnt = payload_cnt;
+  }
+  return status;
+}
+#endif /* MQTT_STREAMING_PUBLISH */
+/*----------------------------------------------------------------------------*/
 void
 mqtt_set_username_password(struct mqtt_connection *conn, char *username,
                            char *password)
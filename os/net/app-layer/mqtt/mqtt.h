@@ -125,6 +125,20 @@
 #define MQTT_TCP_INPUT_BUFF_SIZE 512
 #define MQTT_TCP_OUTPUT_BUFF_SIZE 512
 
+/*
+ * Streaming publish: mqtt_publish_iov() hands the payload segments to the
+ * TCP socket by reference instead of staging them through the output buffer.
+ */
+#ifdef MQTT_CONF_STREAMING_PUBLISH
+#define MQTT_STREAMING_PUBLISH MQTT_CONF_STREAMING_PUBLISH
+#else /* MQTT_CONF_STREAMING_PUBLISH */
+#define MQTT_STREAMING_PUBLISH 0
+#endif /* MQTT_CONF_STREAMING_PUBLISH */
+
+#if MQTT_STREAMING_PUBLISH && !TCP_SOCKET_WITH_IOV
+#error "MQTT_CONF_STREAMING_PUBLISH requires TCP_SOCKET_CONF_WITH_IOV"
+#endif
+
 #define MQTT_INPUT_BUFF_SIZE 512
 #define MQTT_MAX_TOPIC_LENGTH 64
 #define MQTT_MAX_TOPICS_PER_SUBSCRIBE 1
@@ -475,6 +489,10 @@ struct mqtt_out_packet {
   uint16_t topic_length;
   uint8_t *payload;
   uint32_t payload_size;
+#if MQTT_STREAMING_PUBLISH
+  const struct tcp_socket_iov *payload_iov;
+  uint8_t payload_iov_cnt;
+#endif
   mqtt_qos_level_t qos;
   mqtt_qos_state_t qos_state;
   mqtt_retain_t retain;
@@ -714,6 +732,52 @@ mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            mqtt_retain_t retain);
 #endif
 /*---------------------------------------------------------------------------*/
+#if MQTT_STREAMING_PUBLISH
+/**
+ * \brief Publish to a MQTT topic with a payload made of several segments.
+ * \param conn A pointer to the MQTT connection.
+ * \param mid A pointer to message ID.
+ * \param topic A pointer to the topic to subscribe to.
+ * \param payload An array of payload segments, sent in order.
+ * \param payload_cnt The number of payload segments (at most 255).
+ * \param qos_level Quality Of Service level to use. Currently supports 0, 1.
+ * \param retain If the RETAIN flag is set to 1, in a PUBLISH Packet sent by a
+ *        Client to a Server, the Server MUST store the Application Message
+ *        and its QoS, so that it can be delivered to future subscribers whose
+ *        subscriptions match its topic name
+ * \param topic_alias Topic alias to send (MQTTv5-only).
+ * \param topic_alias_en Control whether or not to discard topic and only send
+ *        topic alias s(MQTTv5-only).
+ * \param prop_list Output properties (MQTTv5-only).
+ * \return MQTT_STATUS_OK or some error status
+ *
+ * This function works like mqtt_publish(), but only the PUBLISH header goes
+ * through the connection's output buffer. The payload segments are handed to
+ * the TCP socket by reference and gathered straight into the outgoing TCP
+ * segments, so payloads larger than MQTT_TCP_OUTPUT_BUFF_SIZE are sent
+ * without being chunked through the buffer.
+ *
+ * The segment array and the memory it points to must stay untouched until
+ * mqtt_ready() is true again, which happens once the broker has
+ * acknowledged the whole payload at the TCP level (and, for QoS 1, sent
+ * its PUBACK).
+ */
+mqtt_status_t mqtt_publish_iov(struct mqtt_connection *conn,
+                               uint16_t *mid,
+                               char *topic,
+                               const struct tcp_socket_iov *payload,
+                               uint8_t payload_cnt,
+                               mqtt_qos_level_t qos_level,
+#if MQTT_5
+                               mqtt_retain_t retain,
+                               uint8_t topic_alias,
+                               mqtt_topic_alias_en_t topic_alias_en,
+                               struct mqtt_prop_list *prop_list);
+#else
+                               mqtt_retain_t retain);
+#endif
+#endif /* MQTT_STREAMING_PUBLISH */
+/*---------------------------------------------------------------------------*/
 /**
  * \brief Set the user name and password for a MQTT client.
  * \param conn A pointer to the MQTT connection.
@@ -56,11 +56,78 @@ call_event(struct tcp_socket *s, tcp_socket_event_t event)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if TCP_SOCKET_WITH_IOV
+static void
+senddata_iov(struct tcp_socket *s, int len)
+{
+  const struct tcp_socket_iov *iov;
+  uint8_t *segment;
+  uint16_t off, copylen;
+  uint8_t cnt;
+  int total;
+
+  /* Build the segment in place where uip_send() would put it, so the
+     queued buffers are copied once, directly into the uIP buffer. Any
+     data from the output buffer goes first; the iov list is only
+     appended once all of it fits in this segment. */
+  segment = &uip_buf[UIP_IPTCPH_LEN];
+  total = MIN(s->output_senddata_len, len);
+  if(total > 0) {
+    memcpy(segment, s->output_data_ptr, total);
+  }
+  s->output_data_send_nxt = total;
+  s->output_iov_send_nxt = 0;
+
+  if(total == s->output_data_len) {
+    iov = s->output_iov;
+    cnt = s->output_iov_cnt;
+    off = s->output_iov_off;
+    while(cnt > 0 && total < len) {
+      copylen = MIN(iov->len - off, len - total);
+      memcpy(&segment[total], &iov->data[off], copylen);
+      total += copylen;
+      off = 0;
+      iov++;
+      cnt--;
+    }
+    s->output_iov_send_nxt = total - s->output_data_send_nxt;
+  }
+
+  if(total > 0) {
+    uip_send(segment, total);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+iov_consume(struct tcp_socket *s, uint16_t len)
+{
+  s->output_iov_len -= len;
+  len += s->output_iov_off;
+  while(s->output_iov_cnt > 0 && len >= s->output_iov->len) {
+    len -= s->output_iov->len;
+    s->output_iov++;
+    s->output_iov_cnt--;
+  }
+  s->output_iov_off = len;
+  if(s->output_iov_cnt == 0) {
+    s->output_iov = NULL;
+    s->output_iov_off = 0;
+  }
+}
+#endif /* TCP_SOCKET_WITH_IOV */
+/*---------------------------------------------------------------------------*/
 static void
 senddata(struct tcp_socket *s)
 {
   int len = MIN(s->output_data_max_seg, uip_mss());
 
+#if TCP_SOCKET_WITH_IOV
+  if(s->output_iov_len > 0) {
+    senddata_iov(s, len);
+    return;
+  }
+#endif /* TCP_SOCKET_WITH_IOV */
+
   if(s->output_senddata_len > 0) {
     len = MIN(s->output_senddata_len, len);
     s->output_data_send_nxt = len;
@@ -71,15 +138,18 @@ senddata(struct tcp_socket *s)
 static void
 acked(struct tcp_socket *s)
 {
-  if(s->output_senddata_len > 0) {
-    /* Copy the data in the outputbuf down and update outputbufptr and
-       outputbuf_lastsent */
-
-    if(s->output_data_send_nxt > 0) {
-      memmove(&s->output_data_ptr[0],
-              &s->output_data_ptr[s->output_data_send_nxt],
-              s->output_data_maxlen - s->output_data_send_nxt);
+#if TCP_SOCKET_WITH_IOV
+  if(s->output_iov_send_nxt > 0) {
+    iov_consume(s, s->output_iov_send_nxt);
+    s->output_iov_send_nxt = 0;
+    if(s->output_senddata_len == 0) {
+      call_event(s, TCP_SOCKET_DATA_SENT);
+      return;
     }
+  }
+#endif /* TCP_SOCKET_WITH_IOV */
+
+  if(s->output_senddata_len > 0) {
     if(s->output_data_len < s->output_data_send_nxt) {
       PRINTF("tcp: acked assertion failed s->output_data_len (%d) < s->output_data_send_nxt (%d)\n",
              s->output_data_len,
@@ -90,6 +160,15 @@ acked(struct tcp_socket *s)
       relisten(s);
       return;
     }
+
+    /* Copy the data in the outputbuf down and update outputbufptr and
+       outputbuf_lastsent. Only the bytes still queued need to move. */
+    if(s->output_data_send_nxt > 0 &&
+       s->output_data_len > s->output_data_send_nxt) {
+      memmove(&s->output_data_ptr[0],
+              &s->output_data_ptr[s->output_data_send_nxt],
+              s->output_data_len - s->output_data_send_nxt);
+    }
     s->output_data_len -= s->output_data_send_nxt;
     s->output_senddata_len = s->output_data_len;
     s->output_data_send_nxt = 0;
@@ -216,7 +295,7 @@ appcall(void *state)
     senddata(s);
   }
 
-  if(s->output_data_len == 0 && s->flags & TCP_SOCKET_FLAGS_CLOSING) {
+  if(tcp_socket_queuelen(s) == 0 && s->flags & TCP_SOCKET_FLAGS_CLOSING) {
     s->flags &= ~TCP_SOCKET_FLAGS_CLOSING;
     uip_close();
     s->c = NULL;
@@ -277,6 +356,13 @@ tcp_socket_register(struct tcp_socket *s, void *ptr,
   s->output_data_len = 0;
   s->output_data_ptr = output_databuf;
   s->output_data_maxlen = output_databuf_len;
+#if TCP_SOCKET_WITH_IOV
+  s->output_iov = NULL;
+  s->output_iov_len = 0;
+  s->output_iov_off = 0;
+  s->output_iov_send_nxt = 0;
+  s->output_iov_cnt = 0;
+#endif /* TCP_SOCKET_WITH_IOV */
   s->input_callback = input_callback;
   s->event_callback = event_callback;
   list_add(socketlist, s);
@@ -348,9 +434,18 @@ tcp_socket_send(struct tcp_socket *s,
     return -1;
   }
 
+#if TCP_SOCKET_WITH_IOV
+  if(s->output_iov_len > 0) {
+    /* Keep the byte order: nothing may be added behind a queued list */
+    return 0;
+  }
+#endif /* TCP_SOCKET_WITH_IOV */
+
   len = MIN(datalen, s->output_data_maxlen - s->output_data_len);
 
-  memmove(&s->output_data_ptr[s->output_data_len], data, len);
+  if(data != &s->output_data_ptr[s->output_data_len]) {
+    memmove(&s->output_data_ptr[s->output_data_len], data, len);
+  }
   s->output_data_len += len;
 
   if(s->output_senddata_len == 0) {
@@ -362,6 +457,38 @@ tcp_socket_send(struct tcp_socket *s,
   return len;
 }
 /*---------------------------------------------------------------------------*/
+#if TCP_SOCKET_WITH_IOV
+int
+tcp_socket_send_iov(struct tcp_socket *s,
+                    const struct tcp_socket_iov *iov, int iovcnt)
+{
+  uint32_t len;
+  int i;
+
+  if(s == NULL || iovcnt < 0 || iovcnt > 0xff || s->output_iov_len > 0) {
+    return -1;
+  }
+
+  len = 0;
+  for(i = 0; i < iovcnt; i++) {
+    len += iov[i].len;
+  }
+  if(len == 0) {
+    return 0;
+  }
+
+  s->output_iov = iov;
+  s->output_iov_cnt = iovcnt;
+  s->output_iov_off = 0;
+  s->output_iov_send_nxt = 0;
+  s->output_iov_len = len;
+
+  tcpip_poll_tcp(s->c);
+
+  return len;
+}
+#endif /* TCP_SOCKET_WITH_IOV */
+/*---------------------------------------------------------------------------*/
 int
 tcp_socket_send_str(struct tcp_socket *s,
              const char *str)
@@ -398,12 +525,21 @@ tcp_socket_unregister(struct tcp_socket *s)
 int
 tcp_socket_max_sendlen(struct tcp_socket *s)
 {
+#if TCP_SOCKET_WITH_IOV
+  if(s->output_iov_len > 0) {
+    return 0;
+  }
+#endif /* TCP_SOCKET_WITH_IOV */
   return s->output_data_maxlen - s->output_data_len;
 }
 /*---------------------------------------------------------------------------*/
 int
 tcp_socket_queuelen(struct tcp_socket *s)
 {
+#if TCP_SOCKET_WITH_IOV
+  return s->output_data_len + s->output_iov_len;
+#else /* TCP_SOCKET_WITH_IOV */
   return s->output_data_len;
+#endif /* TCP_SOCKET_WITH_IOV */
 }
 /*---------------------------------------------------------------------------*/
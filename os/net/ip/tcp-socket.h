@@ -34,6 +34,20 @@
 
 #include "uip.h"
 
+/**
+ * \brief Enable scatter-gather output on TCP sockets.
+ *
+ * With this enabled, tcp_socket_send_iov() queues a list of caller owned
+ * buffers that are gathered straight into the outgoing segments, after any
+ * data already in the socket's output buffer, instead of being copied into
+ * the output buffer first.
+ */
+#ifdef TCP_SOCKET_CONF_WITH_IOV
+#define TCP_SOCKET_WITH_IOV TCP_SOCKET_CONF_WITH_IOV
+#else /* TCP_SOCKET_CONF_WITH_IOV */
+#define TCP_SOCKET_WITH_IOV 0
+#endif /* TCP_SOCKET_CONF_WITH_IOV */
+
 struct tcp_socket;
 
 typedef enum {
@@ -80,6 +94,14 @@ typedef void (* tcp_socket_event_callback_t)(struct tcp_socket *s,
                                              void *ptr,
                                              tcp_socket_event_t event);
 
+#if TCP_SOCKET_WITH_IOV
+/** A caller owned buffer queued with tcp_socket_send_iov() */
+struct tcp_socket_iov {
+  const uint8_t *data;
+  uint16_t len;
+};
+#endif /* TCP_SOCKET_WITH_IOV */
+
 struct tcp_socket {
   struct tcp_socket *next;
 
@@ -100,6 +122,14 @@ struct tcp_socket {
   uint16_t output_senddata_len;
   uint16_t output_data_max_seg;
 
+#if TCP_SOCKET_WITH_IOV
+  const struct tcp_socket_iov *output_iov;
+  uint32_t output_iov_len;
+  uint16_t output_iov_off;
+  uint16_t output_iov_send_nxt;
+  uint8_t output_iov_cnt;
+#endif /* TCP_SOCKET_WITH_IOV */
+
   uint8_t flags;
   uint16_t listen_port;
   struct uip_conn *c;
@@ -229,6 +259,31 @@ int tcp_socket_send(struct tcp_socket *s,
                     const uint8_t *dataptr,
                     int datalen);
 
+#if TCP_SOCKET_WITH_IOV
+/**
+ * \brief      Send a list of buffers on a connected TCP socket without copying them
+ * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
+ * \param iov  A pointer to an array of buffers to be sent, in order
+ * \param iovcnt The number of entries in the array
+ * \retval -1  If an error occurs, or if a previous list is still queued
+ * \return     The number of bytes that were queued
+ *
+ *             This function queues the buffers behind any data
+ *             already in the output buffer. The buffers are not
+ *             copied: each segment is gathered directly from them
+ *             into the uIP buffer, also on retransmission. The array
+ *             and the memory it points to must therefore stay
+ *             untouched until tcp_socket_queuelen() has dropped to
+ *             zero, which is signalled by the TCP_SOCKET_DATA_SENT
+ *             event. Only one list can be queued at a time, and
+ *             tcp_socket_send() does not accept more data until the
+ *             list has been sent.
+ */
+int tcp_socket_send_iov(struct tcp_socket *s,
+                        const struct tcp_socket_iov *iov,
+                        int iovcnt);
+#endif /* TCP_SOCKET_WITH_IOV */
+
 /**
  * \brief      Send a string on a connected TCP socket
  * \param s    A pointer to a TCP socket that must have been previously registered with tcp_socket_register()
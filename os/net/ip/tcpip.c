@@ -66,6 +66,10 @@
 extern struct uip_fallback_interface UIP_FALLBACK_INTERFACE;
 #endif
 
+#if NETSTACK_CONF_WITH_IPV6 && TCPIP_NEXTHOP_CACHE && !UIP_DS6_NOTIFICATIONS
+#error "TCPIP_CONF_NEXTHOP_CACHE needs UIP_CONF_UIP_DS6_NOTIFICATIONS"
+#endif
+
 process_event_t tcpip_event;
 #if UIP_CONF_ICMP6
 process_event_t tcpip_icmp6_event;
@@ -163,7 +167,7 @@ tcpip_set_outputfunc(uint8_t (*f)(void))
 unsigned char tcpip_is_forwarding; /* Forwarding right now? */
 #endif /* UIP_CONF_IP_FORWARD */
 
-PROCESS(tcpip_process, "TCP/IP stack");
+PROCESS_PRIO(tcpip_process, "TCP/IP stack", PROCESS_PRIO_HIGH);
 
 /*---------------------------------------------------------------------------*/
 #if UIP_TCP || UIP_CONF_IP_FORWARD
@@ -562,8 +566,82 @@ annotate_transmission(const uip_ipaddr_t *nexthop)
 #endif /* TCPIP_CONF_ANNOTATE_TRANSMISSIONS */
 }
 /*---------------------------------------------------------------------------*/
+#if TCPIP_NEXTHOP_CACHE
+/* Destination cache (RFC 4861, 5.1) for destinations reached through the
+   routing table or a default route: the neighbor entry that packets to
+   the destination were last sent to. The next hop is the neighbor's own
+   address, and the link-layer address comes from the entry. */
+struct nexthop_cache_entry {
+  uip_ipaddr_t dest;
+  uip_ds6_nbr_t *nbr;
+};
+
+static struct nexthop_cache_entry nexthop_cache[TCPIP_NEXTHOP_CACHE];
+static uint8_t nexthop_cache_next;
+static struct uip_ds6_notification nexthop_cache_notification;
+
+#if TCPIP_NEXTHOP_CACHE_STATS
+tcpip_nexthop_cache_stats_t tcpip_nexthop_cache_stats;
+#define NEXTHOP_CACHE_STATS_ADD(field, n) tcpip_nexthop_cache_stats.field += (n)
+#else
+#define NEXTHOP_CACHE_STATS_ADD(field, n)
+#endif /* TCPIP_NEXTHOP_CACHE_STATS */
+/*---------------------------------------------------------------------------*/
+void
+tcpip_nexthop_cache_flush(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < TCPIP_NEXTHOP_CACHE; i++) {
+    nexthop_cache[i].nbr = NULL;
+  }
+  NEXTHOP_CACHE_STATS_ADD(flushes, 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+nexthop_cache_route_callback(int event, const uip_ipaddr_t *route,
+                             const uip_ipaddr_t *nexthop, int num_routes)
+{
+  /* Any route or default route change may select another next hop for
+     a cached destination */
+  tcpip_nexthop_cache_flush();
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_nbr_t *
+nexthop_cache_lookup(const uip_ipaddr_t *dest)
+{
+  uint8_t i;
+
+  for(i = 0; i < TCPIP_NEXTHOP_CACHE; i++) {
+    if(nexthop_cache[i].nbr != NULL &&
+       uip_ipaddr_cmp(&nexthop_cache[i].dest, dest)) {
+      if(nexthop_cache[i].nbr->state == NBR_INCOMPLETE) {
+        /* Let address resolution run on the full path */
+        nexthop_cache[i].nbr = NULL;
+        break;
+      }
+      NEXTHOP_CACHE_STATS_ADD(hits, 1);
+      return nexthop_cache[i].nbr;
+    }
+  }
+  NEXTHOP_CACHE_STATS_ADD(misses, 1);
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+nexthop_cache_add(const uip_ipaddr_t *dest, uip_ds6_nbr_t *nbr)
+{
+  if(nbr == NULL || nbr->state == NBR_INCOMPLETE) {
+    return;
+  }
+  uip_ipaddr_copy(&nexthop_cache[nexthop_cache_next].dest, dest);
+  nexthop_cache[nexthop_cache_next].nbr = nbr;
+  nexthop_cache_next = (nexthop_cache_next + 1) % TCPIP_NEXTHOP_CACHE;
+}
+#endif /* TCPIP_NEXTHOP_CACHE */
+/*---------------------------------------------------------------------------*/
 static const uip_ipaddr_t*
-get_nexthop(uip_ipaddr_t *addr)
+get_nexthop(uip_ipaddr_t *addr, uip_ds6_nbr_t **nbr)
 {
   const uip_ipaddr_t *nexthop;
   uip_ds6_route_t *route;
@@ -589,6 +667,15 @@ get_nexthop(uip_ipaddr_t *addr)
     return &UIP_IP_BUF->destipaddr;
   }
 
+#if TCPIP_NEXTHOP_CACHE
+  if((*nbr = nexthop_cache_lookup(&UIP_IP_BUF->destipaddr)) != NULL) {
+    LOG_INFO("output: found next hop in destination cache: ");
+    LOG_INFO_6ADDR(&(*nbr)->ipaddr);
+    LOG_INFO_("\n");
+    return &(*nbr)->ipaddr;
+  }
+#endif /* TCPIP_NEXTHOP_CACHE */
+
   /* Check if we have a route to the destination address. */
   route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
 
@@ -624,6 +711,13 @@ get_nexthop(uip_ipaddr_t *addr)
     }
   }
 
+#if TCPIP_NEXTHOP_CACHE
+  if(nexthop != NULL) {
+    *nbr = uip_ds6_nbr_lookup(nexthop);
+    nexthop_cache_add(&UIP_IP_BUF->destipaddr, *nbr);
+  }
+#endif /* TCPIP_NEXTHOP_CACHE */
+
   return nexthop;
 }
 /*---------------------------------------------------------------------------*/
@@ -743,12 +837,14 @@ tcpip_ipv6_output(void)
   }
 
   /* Look for a next hop */
-  if((nexthop = get_nexthop(&ipaddr)) == NULL) {
+  if((nexthop = get_nexthop(&ipaddr, &nbr)) == NULL) {
     goto exit;
   }
   annotate_transmission(nexthop);
 
-  nbr = uip_ds6_nbr_lookup(nexthop);
+  if(nbr == NULL) {
+    nbr = uip_ds6_nbr_lookup(nexthop);
+  }
 
 #if UIP_ND6_AUTOFILL_NBR_CACHE
   if(nbr == NULL) {
@@ -883,6 +979,9 @@ PROCESS_THREAD(tcpip_process, ev, data)
 {
   PROCESS_BEGIN();
 
+  /* Only handles events posted to it, skip broadcasts */
+  process_filter_broadcasts(PROCESS_CURRENT());
+
 #if UIP_TCP
   memset(s.listenports, 0, UIP_LISTENPORTS*sizeof(*(s.listenports)));
   s.p = PROCESS_CURRENT();
@@ -895,6 +994,10 @@ PROCESS_THREAD(tcpip_process, ev, data)
   etimer_set(&periodic, CLOCK_SECOND / 2);
 
   uip_init();
+#if NETSTACK_CONF_WITH_IPV6 && TCPIP_NEXTHOP_CACHE
+  uip_ds6_notification_add(&nexthop_cache_notification,
+                           nexthop_cache_route_callback);
+#endif /* NETSTACK_CONF_WITH_IPV6 && TCPIP_NEXTHOP_CACHE */
 #ifdef UIP_FALLBACK_INTERFACE
   UIP_FALLBACK_INTERFACE.init();
 #endif
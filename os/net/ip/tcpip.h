@@ -349,6 +349,44 @@ uint8_t tcpip_output(const uip_lladdr_t *);
 void tcpip_ipv6_output(void);
 #endif
 
+/**
+ * \brief Number of destinations for which tcpip_ipv6_output remembers
+ * the next-hop neighbor, so that packets of the same flow skip the route
+ * and neighbor lookups. 0 disables the cache. Entries are dropped on
+ * route, default route and neighbor removal notifications, so this
+ * turns on UIP_DS6_NOTIFICATIONS unless it is configured off.
+ */
+#ifdef TCPIP_CONF_NEXTHOP_CACHE
+#define TCPIP_NEXTHOP_CACHE TCPIP_CONF_NEXTHOP_CACHE
+#else
+#define TCPIP_NEXTHOP_CACHE 0
+#endif
+
+/* Count hits and misses of the next-hop cache */
+#ifdef TCPIP_CONF_NEXTHOP_CACHE_STATS
+#define TCPIP_NEXTHOP_CACHE_STATS TCPIP_CONF_NEXTHOP_CACHE_STATS
+#else
+#define TCPIP_NEXTHOP_CACHE_STATS 0
+#endif
+
+#if TCPIP_NEXTHOP_CACHE
+/**
+ * \brief Forget all cached next hops
+ */
+void tcpip_nexthop_cache_flush(void);
+
+#if TCPIP_NEXTHOP_CACHE_STATS
+typedef struct tcpip_nexthop_cache_stats {
+  unsigned long hits;
+  unsigned long misses;
+  /* Flushes caused by routing or neighbor table changes */
+  unsigned long flushes;
+} tcpip_nexthop_cache_stats_t;
+
+extern tcpip_nexthop_cache_stats_t tcpip_nexthop_cache_stats;
+#endif /* TCPIP_NEXTHOP_CACHE_STATS */
+#endif /* TCPIP_NEXTHOP_CACHE */
+
 /**
  * \brief Is forwarding generally enabled?
  */
@@ -58,6 +58,19 @@ static int num_nodes;
 LIST(nodelist);
 MEMB(nodememb, uip_sr_node_t, UIP_SR_LINK_NUM);
 
+#if UIP_SR_HASH_INDEX
+/* Nodes chained by the hash of their link identifier */
+static uip_sr_node_t *node_hash[UIP_SR_HASH_SIZE];
+#endif /* UIP_SR_HASH_INDEX */
+
+#if UIP_SR_PATH_CACHE
+/* Bumped on every graph change, cached paths of older versions are stale */
+static uint32_t path_version;
+#define invalidate_paths() path_version++
+#else /* UIP_SR_PATH_CACHE */
+#define invalidate_paths()
+#endif /* UIP_SR_PATH_CACHE */
+
 /*---------------------------------------------------------------------------*/
 int
 uip_sr_num_nodes(void)
@@ -77,11 +90,71 @@ node_matches_address(void *graph, const uip_sr_node_t *node, const uip_ipaddr_t
   }
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_SR_HASH_INDEX
+static unsigned
+hash_link_identifier(const unsigned char *link_identifier)
+{
+  /* FNV-1a */
+  uint32_t h = 2166136261u;
+  int i;
+
+  for(i = 0; i < 8; i++) {
+    h = (h ^ link_identifier[i]) * 16777619u;
+  }
+  return h % UIP_SR_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_add(uip_sr_node_t *node)
+{
+  unsigned bucket = hash_link_identifier(node->link_identifier);
+
+  node->hash_next = node_hash[bucket];
+  node_hash[bucket] = node;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(uip_sr_node_t *node)
+{
+  uip_sr_node_t **np = &node_hash[hash_link_identifier(node->link_identifier)];
+
+  for(; *np != NULL; np = &(*np)->hash_next) {
+    if(*np == node) {
+      *np = node->hash_next;
+      return;
+    }
+  }
+}
+#else /* UIP_SR_HASH_INDEX */
+#define hash_add(node)
+#define hash_remove(node)
+#endif /* UIP_SR_HASH_INDEX */
+/*---------------------------------------------------------------------------*/
+static void
+remove_node(uip_sr_node_t *node)
+{
+  hash_remove(node);
+  list_remove(nodelist, node);
+  memb_free(&nodememb, node);
+  num_nodes--;
+  invalidate_paths();
+}
+/*---------------------------------------------------------------------------*/
 uip_sr_node_t *
 uip_sr_get_node(void *graph, const uip_ipaddr_t *addr)
 {
   uip_sr_node_t *l;
+#if UIP_SR_HASH_INDEX
+  if(addr == NULL) {
+    return NULL;
+  }
+  /* Only nodes with the same link identifier can match, the full
+     address is still compared as the prefix comes from the graph */
+  l = node_hash[hash_link_identifier(((const unsigned char *)addr) + 8)];
+  for(; l != NULL; l = l->hash_next) {
+#else /* UIP_SR_HASH_INDEX */
   for(l = list_head(nodelist); l != NULL; l = list_item_next(l)) {
+#endif /* UIP_SR_HASH_INDEX */
     /* Compare prefix and node identifier */
     if(node_matches_address(graph, l, addr)) {
       return l;
@@ -90,23 +163,87 @@ uip_sr_get_node(void *graph, const uip_ipaddr_t *addr)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Utility function for SRH. Counts the number of bytes in common between
+ * two addresses at p1 and p2. */
+static int
+count_matching_bytes(const void *p1, const void *p2, size_t n)
+{
+  int i = 0;
+  for(i = 0; i < n; i++) {
+    if(((uint8_t *)p1)[i] != ((uint8_t *)p2)[i]) {
+      return i;
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
 int
-uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr)
+uip_sr_get_path(uip_sr_node_t *node, const uip_sr_node_t *root_node,
+                uint8_t *path_len, uint8_t *cmpr)
 {
   int max_depth = UIP_SR_LINK_NUM;
+  const uip_sr_node_t *hop;
+  uip_ipaddr_t node_addr;
+  uip_ipaddr_t hop_addr;
+  uint8_t len;
+  uint8_t common;
+
+  if(node == NULL || root_node == NULL) {
+    return 0;
+  }
+
+#if UIP_SR_PATH_CACHE
+  if(node->path_version == path_version) {
+    *path_len = node->path_len;
+    *cmpr = node->path_cmpr;
+    /* An unreachable node is cached with an impossible compression */
+    return node->path_cmpr < 16;
+  }
+#endif /* UIP_SR_PATH_CACHE */
+
+  NETSTACK_ROUTING.get_sr_node_ipaddr(&node_addr, node);
+  len = 0;
+  common = 15;
+  hop = node;
+  while(hop != NULL && hop != root_node && max_depth > 0) {
+    hop = hop->parent;
+    max_depth--;
+    if(hop != NULL && hop != root_node) {
+      /* How many bytes in common between all nodes in the path? */
+      NETSTACK_ROUTING.get_sr_node_ipaddr(&hop_addr, hop);
+      common = MIN(common, count_matching_bytes(&hop_addr, &node_addr, 16));
+      len++;
+    }
+  }
+  if(hop == NULL || hop != root_node) {
+    common = 0xff;
+  }
+
+#if UIP_SR_PATH_CACHE
+  node->path_version = path_version;
+  node->path_len = len;
+  node->path_cmpr = common;
+#endif /* UIP_SR_PATH_CACHE */
+
+  *path_len = len;
+  *cmpr = common;
+  return common < 16;
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr)
+{
   uip_ipaddr_t root_ipaddr;
   uip_sr_node_t *node;
   uip_sr_node_t *root_node;
+  uint8_t path_len;
+  uint8_t cmpr;
 
   NETSTACK_ROUTING.get_root_ipaddr(&root_ipaddr);
   node = uip_sr_get_node(graph, addr);
   root_node = uip_sr_get_node(graph, &root_ipaddr);
 
-  while(node != NULL && node != root_node && max_depth > 0) {
-    node = node->parent;
-    max_depth--;
-  }
-  return node != NULL && node == root_node;
+  return uip_sr_get_path(node, root_node, &path_len, &cmpr);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -116,6 +253,7 @@ uip_sr_expire_parent(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t
   /* Check if parent matches */
   if(l != NULL && node_matches_address(graph, l->parent, parent)) {
     l->lifetime = UIP_SR_REMOVAL_DELAY;
+    invalidate_paths();
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -147,30 +285,39 @@ uip_sr_update_node(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *p
       LOG_ERR_("\n");
       return NULL;
     }
+    /* Initialize node */
     child_node->parent = NULL;
+    child_node->graph = graph;
+    memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
+#if UIP_SR_PATH_CACHE
+    child_node->path_version = path_version;
+#endif /* UIP_SR_PATH_CACHE */
     list_add(nodelist, child_node);
+    hash_add(child_node);
     num_nodes++;
+    invalidate_paths();
   }
 
-  /* Initialize node */
-  child_node->graph = graph;
   child_node->lifetime = lifetime;
-  memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
 
-  /* Is the node reachable before the update? */
-  if(uip_sr_is_addr_reachable(graph, child)) {
-    old_parent_node = child_node->parent;
-    /* Update node */
-    child_node->parent = parent_node;
-    /* Has the node become unreachable? May happen if we create a loop. */
-    if(!uip_sr_is_addr_reachable(graph, child)) {
-      /* The new parent makes the node unreachable, restore old parent.
-       * We will take the update next time, with chances we know more of
-       * the topology and the loop is gone. */
-      child_node->parent = old_parent_node;
+  old_parent_node = child_node->parent;
+  if(parent_node != old_parent_node) {
+    /* Is the node reachable before the update? */
+    if(uip_sr_is_addr_reachable(graph, child)) {
+      /* Update node */
+      child_node->parent = parent_node;
+      invalidate_paths();
+      /* Has the node become unreachable? May happen if we create a loop. */
+      if(!uip_sr_is_addr_reachable(graph, child)) {
+        /* The new parent makes the node unreachable, restore old parent.
+         * We will take the update next time, with chances we know more of
+         * the topology and the loop is gone. */
+        child_node->parent = old_parent_node;
+      }
+    } else {
+      child_node->parent = parent_node;
     }
-  } else {
-    child_node->parent = parent_node;
+    invalidate_paths();
   }
 
   LOG_INFO("NS: updating link, child ");
@@ -188,6 +335,10 @@ uip_sr_init(void)
   num_nodes = 0;
   memb_init(&nodememb);
   list_init(nodelist);
+#if UIP_SR_HASH_INDEX
+  memset(node_hash, 0, sizeof(node_hash));
+#endif /* UIP_SR_HASH_INDEX */
+  invalidate_paths();
 }
 /*---------------------------------------------------------------------------*/
 uip_sr_node_t *
@@ -226,9 +377,7 @@ uip_sr_periodic(unsigned seconds)
         LOG_INFO_("\n");
       }
       /* No child found, deallocate node */
-      list_remove(nodelist, l);
-      memb_free(&nodememb, l);
-      num_nodes--;
+      remove_node(l);
     } else if(l->lifetime != UIP_SR_INFINITE_LIFETIME) {
       l->lifetime = l->lifetime > seconds ? l->lifetime - seconds : 0;
     }
@@ -242,9 +391,7 @@ uip_sr_free_all(void)
   uip_sr_node_t *next;
   for(l = list_head(nodelist); l != NULL; l = next) {
     next = list_item_next(l);
-    list_remove(nodelist, l);
-    memb_free(&nodememb, l);
-    num_nodes--;
+    remove_node(l);
   }
 }
 /*---------------------------------------------------------------------------*/
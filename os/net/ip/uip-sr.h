@@ -85,6 +85,30 @@
 
 #define UIP_SR_INFINITE_LIFETIME           0xFFFFFFFF
 
+/* Index nodes by a hash of their link identifier, so that node lookups do
+ * not scan the whole node list. Useful at non-storing roots of large
+ * networks. */
+#ifdef UIP_SR_CONF_HASH_INDEX
+#define UIP_SR_HASH_INDEX             UIP_SR_CONF_HASH_INDEX
+#else /* UIP_SR_CONF_HASH_INDEX */
+#define UIP_SR_HASH_INDEX             0
+#endif /* UIP_SR_CONF_HASH_INDEX */
+
+/* Number of hash buckets of the node index */
+#ifdef UIP_SR_CONF_HASH_SIZE
+#define UIP_SR_HASH_SIZE              UIP_SR_CONF_HASH_SIZE
+#else /* UIP_SR_CONF_HASH_SIZE */
+#define UIP_SR_HASH_SIZE              (UIP_SR_LINK_NUM > 0 ? UIP_SR_LINK_NUM : 1)
+#endif /* UIP_SR_CONF_HASH_SIZE */
+
+/* Cache the source route summary (length and address compression) of
+ * every node. The cache is invalidated whenever the graph changes. */
+#ifdef UIP_SR_CONF_PATH_CACHE
+#define UIP_SR_PATH_CACHE             UIP_SR_CONF_PATH_CACHE
+#else /* UIP_SR_CONF_PATH_CACHE */
+#define UIP_SR_PATH_CACHE             0
+#endif /* UIP_SR_CONF_PATH_CACHE */
+
 /********** Data Structures  **********/
 
 /** \brief A node in a source routing graph, stored at the root and representing
@@ -98,6 +122,15 @@ typedef struct uip_sr_node {
   us with the prefix */
   unsigned char link_identifier[8];
   struct uip_sr_node *parent;
+#if UIP_SR_HASH_INDEX
+  struct uip_sr_node *hash_next;
+#endif /* UIP_SR_HASH_INDEX */
+#if UIP_SR_PATH_CACHE
+  /* Cached path to the root, valid while path_version is current */
+  uint32_t path_version;
+  uint8_t path_len;
+  uint8_t path_cmpr;
+#endif /* UIP_SR_PATH_CACHE */
 } uip_sr_node_t;
 
 /********** Public functions **********/
@@ -162,6 +195,20 @@ uip_sr_node_t *uip_sr_get_node(void *graph, const uip_ipaddr_t *addr);
 */
 int uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr);
 
+/**
+ * Gets the source route from the root to a node, as needed to build a
+ * source routing header
+ *
+ * \param node The destination node
+ * \param root_node The root node of the graph
+ * \param path_len Set to the number of nodes between the root and the destination
+ * \param cmpr Set to the number of leading bytes (at most 15) that the
+ * addresses of these nodes have in common with the destination address
+ * \return 1 if the root has a path to the node, 0 otherwise
+*/
+int uip_sr_get_path(uip_sr_node_t *node, const uip_sr_node_t *root_node,
+                    uint8_t *path_len, uint8_t *cmpr);
+
 /**
  * A function called periodically. Used to age the links (decrease lifetime
  * and expire links accordingly)
@@ -77,6 +77,16 @@
 #if MPL_SEED_ID_TYPE == 2 && MPL_SEED_ID_H > 0x00
 #warning MPL Seed ID upper 64 bits set yet not used due to Seed ID type setting
 #endif
+/* Indexes */
+#if MPL_SEED_HASH_SIZE & (MPL_SEED_HASH_SIZE - 1)
+#error MPL_SEED_HASH_SIZE must be a power of two
+#endif
+#if MPL_DOMAIN_HASH_SIZE & (MPL_DOMAIN_HASH_SIZE - 1)
+#error MPL_DOMAIN_HASH_SIZE must be a power of two
+#endif
+#if (MPL_SEED_WINDOW_SIZE & (MPL_SEED_WINDOW_SIZE - 1)) || MPL_SEED_WINDOW_SIZE > 256
+#error MPL_SEED_WINDOW_SIZE must be a power of two, up to 256
+#endif
 /*---------------------------------------------------------------------------*/
 /* Data Representation */
 /*---------------------------------------------------------------------------*/
@@ -206,8 +216,19 @@ struct mpl_seed {
   uint8_t min_seqno; /* Used when the seed set is empty */
   uint8_t lifetime; /* Decrements by one every minute */
   uint8_t count; /* Only used for determining largest msg set during reclaim */
+  uint8_t running; /* Number of msg trickle timers running in this seed's set */
+  uint8_t present; /* Set when a control message lists this seed */
   LIST_STRUCT(min_seq); /* Pointer to the first msg in this seed's set */
+  struct mpl_msg *max_seq; /* Pointer to the last msg in this seed's set */
   struct mpl_domain *domain; /* The domain this seed belongs to */
+  struct mpl_seed *next_in_domain; /* The next seed of the same domain */
+#if MPL_SEED_HASH_SIZE
+  struct mpl_seed *next_hash; /* The next seed in the same hash bucket */
+#endif
+#if MPL_SEED_WINDOW_SIZE
+  uint8_t unindexed; /* Number of msgs that collided in the window */
+  struct mpl_msg *window[MPL_SEED_WINDOW_SIZE]; /* Msgs by seq modulo size */
+#endif
 };
 /**
  * \brief Get the state of the used flag in the buffered message set entry
@@ -226,6 +247,10 @@ struct mpl_domain {
   uip_ip6addr_t ctrl_addr; /* Link-local scoped version of data address */
   struct trickle_timer tt;
   uint8_t e; /* Expiration count for trickle timer */
+  struct mpl_seed *seeds; /* The seeds of this domain */
+#if MPL_DOMAIN_HASH_SIZE
+  struct mpl_domain *next_hash; /* The next domain in the same hash bucket */
+#endif
 };
 /**
  * \brief Get the state of the used flag in the buffered message set entry
@@ -399,6 +424,13 @@ static struct mpl_stats stats;
 static struct mpl_msg buffered_message_set[MPL_BUFFERED_MESSAGE_SET_SIZE];
 static struct mpl_seed seed_set[MPL_SEED_SET_SIZE];
 static struct mpl_domain domain_set[MPL_DOMAIN_SET_SIZE];
+LIST(free_message_set);
+#if MPL_SEED_HASH_SIZE
+static struct mpl_seed *seed_hash[MPL_SEED_HASH_SIZE];
+#endif
+#if MPL_DOMAIN_HASH_SIZE
+static struct mpl_domain *domain_hash[MPL_DOMAIN_HASH_SIZE];
+#endif
 static uint16_t last_seq;
 static seed_id_t local_seed_id;
 #if MPL_SUB_TO_ALL_FORWARDERS
@@ -460,30 +492,177 @@ extern uint16_t uip_slen;
  * a: uip_ip6addr_t address to modify
  */
 #define UIP_ADDR_MAKE_LINK_LOCAL(a) (((uip_ip6addr_t *)a)->u8[1] = UIP_MCAST6_SCOPE_LINK_LOCAL)
+/**
+ * \brief Get the window slot of a sequence number
+ * s: The sequence number
+ */
+#define WINDOW_SLOT(s) ((s) & (MPL_SEED_WINDOW_SIZE - 1))
 /*---------------------------------------------------------------------------*/
 /* Local function prototypes */
 /*---------------------------------------------------------------------------*/
 static void icmp_in(void);
+static void data_message_expiration(void *ptr, uint8_t suppress);
 UIP_ICMP6_HANDLER(mpl_icmp_handler, ICMP6_MPL, 0, icmp_in);
 
+static void
+data_timer_start(struct mpl_msg *msg)
+{
+  /* Keep count of the running timers of a seed, so that the lifetime timer
+   * does not have to check all its messages */
+  if(!trickle_timer_is_running(&msg->tt)) {
+    msg->seed->running++;
+    mpl_data_trickle_timer_start(msg);
+  }
+}
+static void
+data_timer_stop(struct mpl_msg *msg)
+{
+  if(trickle_timer_is_running(&msg->tt)) {
+    trickle_timer_stop(&msg->tt);
+    msg->seed->running--;
+  }
+}
+static void
+data_timer_inconsistency(struct mpl_msg *msg)
+{
+  data_timer_start(msg);
+  mpl_trickle_timer_inconsistency(msg);
+}
+/* Find the message with the given sequence number in the seed's set */
 static struct mpl_msg *
-buffer_allocate(void)
+msg_lookup(struct mpl_seed *seed, uint8_t seq)
 {
-  for(locmmptr = &buffered_message_set[MPL_BUFFERED_MESSAGE_SET_SIZE - 1]; locmmptr >= buffered_message_set; locmmptr--) {
-    if(!MSG_SET_IS_USED(locmmptr)) {
-      memset(locmmptr, 0, sizeof(struct mpl_msg));
-      return locmmptr;
+  struct mpl_msg *msg;
+
+#if MPL_SEED_WINDOW_SIZE
+  msg = seed->window[WINDOW_SLOT(seq)];
+  if(msg != NULL && msg->seq == seq) {
+    return msg;
+  }
+  if(seed->unindexed == 0) {
+    /* Every message of the set is in the window */
+    return NULL;
+  }
+#endif
+  for(msg = list_head(seed->min_seq); msg != NULL; msg = list_item_next(msg)) {
+    if(SEQ_VAL_IS_EQ(seq, msg->seq)) {
+      return msg;
     }
   }
   return NULL;
 }
+/* Place a message in sequence number order in the seed's set */
 static void
-buffer_free(struct mpl_msg *msg)
+msg_insert(struct mpl_seed *seed, struct mpl_msg *msg)
 {
-  if(trickle_timer_is_running(&msg->tt)) {
-    trickle_timer_stop(&msg->tt);
+  struct mpl_msg *prev;
+  struct mpl_msg *iter;
+#if MPL_SEED_WINDOW_SIZE
+  uint8_t span;
+  uint8_t i;
+#endif
+
+  prev = NULL;
+  if(list_head(seed->min_seq) == NULL) {
+    seed->min_seqno = msg->seq;
+  } else if(SEQ_VAL_IS_GT(msg->seq, seed->max_seq->seq)) {
+    /* The usual case: a new message from the seed */
+    prev = seed->max_seq;
+  } else {
+#if MPL_SEED_WINDOW_SIZE
+    if(seed->unindexed == 0) {
+      /* Look back in the window for the closest lower sequence number */
+      span = msg->seq - ((struct mpl_msg *)list_head(seed->min_seq))->seq;
+      for(i = 1; i <= span && i < MPL_SEED_WINDOW_SIZE; i++) {
+        iter = seed->window[WINDOW_SLOT((uint8_t)(msg->seq - i))];
+        if(iter != NULL && iter->seq == (uint8_t)(msg->seq - i)) {
+          prev = iter;
+          break;
+        }
+      }
+    }
+    if(prev == NULL)
+#endif
+    {
+      for(iter = list_head(seed->min_seq);
+          iter != NULL && SEQ_VAL_IS_LT(iter->seq, msg->seq);
+          iter = list_item_next(iter)) {
+        prev = iter;
+      }
+    }
+  }
+
+  if(prev == NULL) {
+    list_push(seed->min_seq, msg);
+  } else {
+    msg->next = prev->next;
+    prev->next = msg;
+  }
+  if(msg->next == NULL) {
+    seed->max_seq = msg;
   }
+  seed->count++;
+
+#if MPL_SEED_WINDOW_SIZE
+  if(seed->window[WINDOW_SLOT(msg->seq)] == NULL) {
+    seed->window[WINDOW_SLOT(msg->seq)] = msg;
+  } else {
+    seed->unindexed++;
+  }
+#endif
+}
+/* Remove the message with the lowest sequence number from the seed's set */
+static struct mpl_msg *
+msg_pop(struct mpl_seed *seed)
+{
+  struct mpl_msg *msg;
+#if MPL_SEED_WINDOW_SIZE
+  struct mpl_msg *iter;
+#endif
+
+  msg = list_pop(seed->min_seq);
+  if(msg == NULL) {
+    return NULL;
+  }
+  if(msg == seed->max_seq) {
+    seed->max_seq = NULL;
+  }
+  seed->count--;
+
+#if MPL_SEED_WINDOW_SIZE
+  if(seed->window[WINDOW_SLOT(msg->seq)] != msg) {
+    seed->unindexed--;
+  } else {
+    seed->window[WINDOW_SLOT(msg->seq)] = NULL;
+    if(seed->unindexed > 0) {
+      /* Move a message that collided with this one into the window */
+      for(iter = list_head(seed->min_seq); iter != NULL; iter = list_item_next(iter)) {
+        if(WINDOW_SLOT(iter->seq) == WINDOW_SLOT(msg->seq)) {
+          seed->window[WINDOW_SLOT(msg->seq)] = iter;
+          seed->unindexed--;
+          break;
+        }
+      }
+    }
+  }
+#endif
+  return msg;
+}
+static struct mpl_msg *
+buffer_allocate(void)
+{
+  locmmptr = list_pop(free_message_set);
+  if(locmmptr != NULL) {
+    memset(locmmptr, 0, sizeof(struct mpl_msg));
+  }
+  return locmmptr;
+}
+static void
+buffer_free(struct mpl_msg *msg)
+{
+  data_timer_stop(msg);
   MSG_SET_CLEAR_USED(msg);
+  list_push(free_message_set, msg);
 }
 static struct mpl_msg *
 buffer_reclaim(void)
@@ -495,8 +674,9 @@ buffer_reclaim(void)
   /* Reclaim the message with min_seq in the largest seed set */
   largest = NULL;
   reclaim = NULL;
-  for(ssptr = &seed_set[MPL_SEED_SET_SIZE]; ssptr >= seed_set; ssptr--) {
-    if(SEED_SET_IS_USED(ssptr) && (largest == NULL || ssptr->count > largest->count)) {
+  for(ssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; ssptr >= seed_set; ssptr--) {
+    if(SEED_SET_IS_USED(ssptr) && ssptr->count > 0
+       && (largest == NULL || ssptr->count > largest->count)) {
       largest = ssptr;
     }
   }
@@ -509,15 +689,29 @@ buffer_reclaim(void)
    * We've already worked out what this new value is.
    */
   if(largest != NULL) {
-    reclaim = list_pop(largest->min_seq);
-    largest->min_seqno = list_item_next(reclaim) == NULL ? reclaim->seq : ((struct mpl_msg *)list_item_next(reclaim))->seq;
-    largest->count--;
-    trickle_timer_stop(&reclaim->tt);
+    reclaim = msg_pop(largest);
+    largest->min_seqno = list_head(largest->min_seq) == NULL ? reclaim->seq : ((struct mpl_msg *)list_head(largest->min_seq))->seq;
+    data_timer_stop(reclaim);
     mpl_trickle_timer_reset(reclaim->seed->domain);
     memset(reclaim, 0, sizeof(struct mpl_msg));
   }
   return reclaim;
 }
+#if MPL_DOMAIN_HASH_SIZE
+/* The data and control addresses of a domain only differ in their scope */
+static uint8_t
+domain_hash_key(uip_ip6addr_t *address)
+{
+  uint16_t h;
+  uint8_t i;
+
+  h = address->u8[0];
+  for(i = 2; i < 16; i++) {
+    h = h * 31 + address->u8[i];
+  }
+  return h & (MPL_DOMAIN_HASH_SIZE - 1);
+}
+#endif
 static struct mpl_domain *
 domain_set_allocate(uip_ip6addr_t *address)
 {
@@ -564,29 +758,63 @@ domain_set_allocate(uip_ip6addr_t *address)
         DOMAIN_SET_CLEAR_USED(locdsptr);
         return NULL;
       }
+#if MPL_DOMAIN_HASH_SIZE
+      locdsptr->next_hash = domain_hash[domain_hash_key(&data_addr)];
+      domain_hash[domain_hash_key(&data_addr)] = locdsptr;
+#endif
       return locdsptr;
     }
   }
   return NULL;
 }
+#if MPL_SEED_HASH_SIZE
+static uint8_t
+seed_hash_key(seed_id_t *seed_id, struct mpl_domain *domain)
+{
+  uint16_t h;
+  uint8_t i;
+
+  h = domain - domain_set;
+  for(i = 0; i < 16; i++) {
+    h = h * 31 + seed_id->id[i];
+  }
+  return h & (MPL_SEED_HASH_SIZE - 1);
+}
+#endif
 /* Lookup the seed id in the seed set */
 static struct mpl_seed *
 seed_set_lookup(seed_id_t *seed_id, struct mpl_domain *domain)
 {
+#if MPL_SEED_HASH_SIZE
+  for(locssptr = seed_hash[seed_hash_key(seed_id, domain)]; locssptr != NULL; locssptr = locssptr->next_hash) {
+    if(locssptr->domain == domain && seed_id_cmp(seed_id, &locssptr->seed_id)) {
+      return locssptr;
+    }
+  }
+#else
   for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
     if(SEED_SET_IS_USED(locssptr) && seed_id_cmp(seed_id, &locssptr->seed_id) && locssptr->domain == domain) {
       return locssptr;
     }
   }
+#endif
   return NULL;
 }
 static struct mpl_seed *
-seed_set_allocate(void)
+seed_set_allocate(seed_id_t *seed_id, struct mpl_domain *domain)
 {
   for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
     if(!SEED_SET_IS_USED(locssptr)) {
-      locssptr->count = 0;
+      memset(locssptr, 0, sizeof(struct mpl_seed));
       LIST_STRUCT_INIT(locssptr, min_seq);
+      seed_id_cpy(&locssptr->seed_id, seed_id);
+      locssptr->domain = domain;
+      locssptr->next_in_domain = domain->seeds;
+      domain->seeds = locssptr;
+#if MPL_SEED_HASH_SIZE
+      locssptr->next_hash = seed_hash[seed_hash_key(seed_id, domain)];
+      seed_hash[seed_hash_key(seed_id, domain)] = locssptr;
+#endif
       return locssptr;
     }
   }
@@ -595,15 +823,35 @@ seed_set_allocate(void)
 static void
 seed_set_free(struct mpl_seed *s)
 {
-  while((locmmptr = list_pop(s->min_seq)) != NULL) {
+  struct mpl_seed **sptr;
+
+  while((locmmptr = msg_pop(s)) != NULL) {
     buffer_free(locmmptr);
   }
+  for(sptr = &s->domain->seeds; *sptr != NULL; sptr = &(*sptr)->next_in_domain) {
+    if(*sptr == s) {
+      *sptr = s->next_in_domain;
+      break;
+    }
+  }
+#if MPL_SEED_HASH_SIZE
+  for(sptr = &seed_hash[seed_hash_key(&s->seed_id, s->domain)]; *sptr != NULL; sptr = &(*sptr)->next_hash) {
+    if(*sptr == s) {
+      *sptr = s->next_hash;
+      break;
+    }
+  }
+#endif
   SEED_SET_CLEAR_USED(s);
 }
 static struct mpl_domain *
 domain_set_lookup(uip_ip6addr_t *domain)
 {
+#if MPL_DOMAIN_HASH_SIZE
+  for(locdsptr = domain_hash[domain_hash_key(domain)]; locdsptr != NULL; locdsptr = locdsptr->next_hash) {
+#else
   for(locdsptr = &domain_set[MPL_DOMAIN_SET_SIZE - 1]; locdsptr >= domain_set; locdsptr--) {
+#endif
     if(DOMAIN_SET_IS_USED(locdsptr)) {
       if(uip_ip6addr_cmp(domain, &locdsptr->data_addr)
          || uip_ip6addr_cmp(domain, &locdsptr->ctrl_addr)) {
@@ -617,11 +865,12 @@ static void
 domain_set_free(struct mpl_domain *domain)
 {
   uip_ds6_maddr_t *addr;
+#if MPL_DOMAIN_HASH_SIZE
+  struct mpl_domain **dptr;
+#endif
   /* Must include freeing seeds otherwise we leak memory */
-  for(locssptr = &seed_set[MPL_SEED_SET_SIZE]; locssptr >= seed_set; locssptr--) {
-    if(SEED_SET_IS_USED(locssptr) && locssptr->domain == domain) {
-      seed_set_free(locssptr);
-    }
+  while(domain->seeds != NULL) {
+    seed_set_free(domain->seeds);
   }
   addr = uip_ds6_maddr_lookup(&domain->data_addr);
   if(addr != NULL) {
@@ -634,6 +883,14 @@ domain_set_free(struct mpl_domain *domain)
   if(trickle_timer_is_running(&domain->tt)) {
     trickle_timer_stop(&domain->tt);
   }
+#if MPL_DOMAIN_HASH_SIZE
+  for(dptr = &domain_hash[domain_hash_key(&domain->data_addr)]; *dptr != NULL; dptr = &(*dptr)->next_hash) {
+    if(*dptr == domain) {
+      *dptr = domain->next_hash;
+      break;
+    }
+  }
+#endif
   DOMAIN_SET_CLEAR_USED(domain);
 }
 static void
@@ -657,8 +914,8 @@ seed_id_net_to_host(seed_id_t *dst, void *src, uint8_t s)
   case 1:
     /* 16 bit seed ID */
     dst->s = 1;
-    for(i = 2; i < 15; i++) {
-      /* Clear the first 13 bytes in the id */
+    for(i = 2; i < 16; i++) {
+      /* Clear the first 14 bytes in the id */
       dst->id[i] = 0;
     }
     dst->id[0] = ptr[1];
@@ -779,103 +1036,101 @@ icmp_out(struct mpl_domain *dom)
   uip_ip6addr_copy(&UIP_IP_BUF->destipaddr, &dom->ctrl_addr);
   uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
 
-  /* Iterate over seed set to create payload */
-  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
-    if(SEED_SET_IS_USED(locssptr) && locssptr->domain == dom) {
-      locsiptr->min_seqno = locssptr->min_seqno;
-      SEED_INFO_CLR_LEN(locsiptr);
-      SEED_INFO_CLR_S(locsiptr);
-
-      /* Try setting our source address to global */
-      addr = uip_ds6_get_global(ADDR_PREFERRED);
-      if(addr) {
-        uip_ip6addr_copy(&UIP_IP_BUF->srcipaddr, &addr->ipaddr);
-      } else {
-        /* Failed setting a global ip address, fallback to link local */
-        uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
-        if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
-          LOG_ERR("icmp out: Cannot set src ip\n");
-          uipbuf_clear();
-          return;
-        }
+  /* Iterate over the seeds of the domain to create payload */
+  for(locssptr = dom->seeds; locssptr != NULL; locssptr = locssptr->next_in_domain) {
+    locsiptr->min_seqno = locssptr->min_seqno;
+    SEED_INFO_CLR_LEN(locsiptr);
+    SEED_INFO_CLR_S(locsiptr);
+
+    /* Try setting our source address to global */
+    addr = uip_ds6_get_global(ADDR_PREFERRED);
+    if(addr) {
+      uip_ip6addr_copy(&UIP_IP_BUF->srcipaddr, &addr->ipaddr);
+    } else {
+      /* Failed setting a global ip address, fallback to link local */
+      uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+      if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+        LOG_ERR("icmp out: Cannot set src ip\n");
+        uipbuf_clear();
+        return;
       }
+    }
 
-      /* Set the Seed ID */
-      switch(locssptr->seed_id.s) {
-      case 0:
-        if(uip_ip6addr_cmp((uip_ip6addr_t *)&locssptr->seed_id.id, &UIP_IP_BUF->srcipaddr)) {
-          /* We can use an S=0 Seed ID */
-          SEED_INFO_SET_LEN(locsiptr, 0);
-          break;
-        } /* Else fall down into the S = 3 case */
-      case 3:
-        seed_id_host_to_net(&((struct seed_info_s3 *)locsiptr)->seed_id, &locssptr->seed_id);
-        SEED_INFO_SET_S(locsiptr, 3);
-        break;
-      case 1:
-        seed_id_host_to_net(&((struct seed_info_s1 *)locsiptr)->seed_id, &locssptr->seed_id);
-        SEED_INFO_SET_S(locsiptr, 1);
-        break;
-      case 2:
-        seed_id_host_to_net(&((struct seed_info_s2 *)locsiptr)->seed_id, &locssptr->seed_id);
-        SEED_INFO_SET_S(locsiptr, 2);
+    /* Set the Seed ID */
+    switch(locssptr->seed_id.s) {
+    case 0:
+      if(uip_ip6addr_cmp((uip_ip6addr_t *)&locssptr->seed_id.id, &UIP_IP_BUF->srcipaddr)) {
+        /* We can use an S=0 Seed ID */
+        SEED_INFO_SET_LEN(locsiptr, 0);
         break;
-      }
+      } /* Else fall down into the S = 3 case */
+    case 3:
+      seed_id_host_to_net(&((struct seed_info_s3 *)locsiptr)->seed_id, &locssptr->seed_id);
+      SEED_INFO_SET_S(locsiptr, 3);
+      break;
+    case 1:
+      seed_id_host_to_net(&((struct seed_info_s1 *)locsiptr)->seed_id, &locssptr->seed_id);
+      SEED_INFO_SET_S(locsiptr, 1);
+      break;
+    case 2:
+      seed_id_host_to_net(&((struct seed_info_s2 *)locsiptr)->seed_id, &locssptr->seed_id);
+      SEED_INFO_SET_S(locsiptr, 2);
+      break;
+    }
 
-      /* Populate the seed info message vector */
-      memset(vector, 0, sizeof(vector));
-      vec_len = 0;
-      cur_seq = 0;
-      LOG_INFO("\nBuffer for seed: ");
-      LOG_INFO_SEED(locssptr->seed_id);
-      LOG_INFO_("\n");
-      for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-        LOG_INFO("%d -- %x\n", locmmptr->seq, locmmptr->data[locmmptr->size - 1]);
-        cur_seq = SEQ_VAL_ADD(locssptr->min_seqno, vec_len);
-        if(locmmptr->seq == SEQ_VAL_ADD(locssptr->min_seqno, vec_len)) {
-          BIT_VECTOR_SET_BIT(vector, vec_len);
-          vec_len++;
-        } else {
-          /* Insert enough zeros to get to the next message */
-          vec_len += locmmptr->seq - cur_seq;
-          BIT_VECTOR_SET_BIT(vector, vec_len);
-          vec_len++;
-        }
+    /* Populate the seed info message vector */
+    memset(vector, 0, sizeof(vector));
+    vec_len = 0;
+    cur_seq = 0;
+    LOG_INFO("\nBuffer for seed: ");
+    LOG_INFO_SEED(locssptr->seed_id);
+    LOG_INFO_("\n");
+    for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
+      LOG_INFO("%d -- %x\n", locmmptr->seq, locmmptr->data[locmmptr->size - 1]);
+      cur_seq = SEQ_VAL_ADD(locssptr->min_seqno, vec_len);
+      if(locmmptr->seq == SEQ_VAL_ADD(locssptr->min_seqno, vec_len)) {
+        BIT_VECTOR_SET_BIT(vector, vec_len);
+        vec_len++;
+      } else {
+        /* Insert enough zeros to get to the next message */
+        vec_len += locmmptr->seq - cur_seq;
+        BIT_VECTOR_SET_BIT(vector, vec_len);
+        vec_len++;
       }
+    }
 
-      /* Convert vector length from bits to bytes */
-      vec_size = (vec_len - 1) / 8 + 1;
+    /* Convert vector length from bits to bytes */
+    vec_size = (vec_len - 1) / 8 + 1;
 
-      SEED_INFO_SET_LEN(locsiptr, vec_size);
+    SEED_INFO_SET_LEN(locsiptr, vec_size);
 
-      LOG_DBG("--- Control Message Entry ---\n");
-      LOG_DBG("Seed ID: ");
-      LOG_DBG_SEED(locssptr->seed_id);
-      LOG_DBG_("\n");
-      LOG_DBG("S=%u\n", locssptr->seed_id.s);
-      LOG_DBG("Min Sequence Number: %u\n", locssptr->min_seqno);
-      LOG_DBG("Size of message set: %u\n", vec_len);
-      LOG_DBG("Vector is %u bytes\n", vec_size);
-
-      /* Copy vector into payload and point ptr to next location */
-      switch(SEED_INFO_GET_S(locsiptr)) {
-      case 0:
-        seed_info_len = sizeof(struct seed_info);
-        break;
-      case 1:
-        seed_info_len = sizeof(struct seed_info_s1);
-        break;
-      case 2:
-        seed_info_len = sizeof(struct seed_info_s2);
-        break;
-      case 3:
-        seed_info_len = sizeof(struct seed_info_s3);
-        break;
-      }
-      memcpy(((void *)locsiptr) + seed_info_len, vector, vec_size);
-      locsiptr = ((void *)locsiptr) + seed_info_len + vec_size;
-      payload_len += seed_info_len + vec_size;
+    LOG_DBG("--- Control Message Entry ---\n");
+    LOG_DBG("Seed ID: ");
+    LOG_DBG_SEED(locssptr->seed_id);
+    LOG_DBG_("\n");
+    LOG_DBG("S=%u\n", locssptr->seed_id.s);
+    LOG_DBG("Min Sequence Number: %u\n", locssptr->min_seqno);
+    LOG_DBG("Size of message set: %u\n", vec_len);
+    LOG_DBG("Vector is %u bytes\n", vec_size);
+
+    /* Copy vector into payload and point ptr to next location */
+    switch(SEED_INFO_GET_S(locsiptr)) {
+    case 0:
+      seed_info_len = sizeof(struct seed_info);
+      break;
+    case 1:
+      seed_info_len = sizeof(struct seed_info_s1);
+      break;
+    case 2:
+      seed_info_len = sizeof(struct seed_info_s2);
+      break;
+    case 3:
+      seed_info_len = sizeof(struct seed_info_s3);
+      break;
     }
+    memcpy(((void *)locsiptr) + seed_info_len, vector, vec_size);
+    locsiptr = ((void *)locsiptr) + seed_info_len + vec_size;
+    payload_len += seed_info_len + vec_size;
     /* Now go to next seed in set */
   }
   LOG_DBG("--- End of Messages --\n");
@@ -908,7 +1163,7 @@ data_message_expiration(void *ptr, uint8_t suppress)
   locmmptr = ((struct mpl_msg *)ptr);
   if(locmmptr->e > MPL_DATA_MESSAGE_TIMER_EXPIRATIONS) {
     /* Terminate the trickle timer here if we've already expired enough times */
-    trickle_timer_stop(&locmmptr->tt);
+    data_timer_stop(locmmptr);
     return;
   }
   if(suppress == TRICKLE_TIMER_TX_OK) { /* Only transmit if not suppressed */
@@ -1036,15 +1291,7 @@ lifetime_timer_expiration(void *ptr)
   for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; seed_set <= locssptr; locssptr--) {
     if(SEED_SET_IS_USED(locssptr) && locssptr->lifetime == 0) {
       /* Check no timers are running */
-      locmmptr = list_head(locssptr->min_seq);
-      while(locmmptr != NULL) {
-        if(trickle_timer_is_running(&locmmptr->tt)) {
-          /* We must keep this seed */
-          break;
-        }
-        locmmptr = list_item_next(locmmptr);
-      }
-      if(locmmptr == NULL) {
+      if(locssptr->running == 0) {
         /* We can now free this seed set */
         LOG_INFO("Seed ");
         LOG_INFO_SEED(locssptr->seed_id);
@@ -1123,65 +1370,9 @@ icmp_in(void)
   l_missing = 0;
   r_missing = 0;
 
-  /* Iterate over our seed set and check all are present in the remote seed sed */
-  locsiptr = (struct seed_info *)UIP_ICMP_PAYLOAD;
-  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
-    if(SEED_SET_IS_USED(locssptr) && locssptr->domain == locdsptr) {
-      LOG_DBG("Checking remote for seed ");
-      LOG_DBG_SEED(locssptr->seed_id);
-      LOG_DBG_("\n");
-      while(locsiptr <
-            (struct seed_info *)((void *)UIP_ICMP_PAYLOAD + uip_len - uip_l3_icmp_hdr_len)) {
-        switch(SEED_INFO_GET_S(locsiptr)) {
-        case 0:
-          seed_id_net_to_host(&seed_id, &UIP_IP_BUF->srcipaddr, 0);
-          locsiptr = ((void *)locsiptr) + sizeof(struct seed_info) + SEED_INFO_GET_LEN(locsiptr);
-          if(seed_id_cmp(&seed_id, &locssptr->seed_id)) {
-            goto seed_present;
-          }
-          break;
-        case 1:
-          seed_id_net_to_host(&seed_id, &((struct seed_info_s1 *)locsiptr)->seed_id, 1);
-          locsiptr = ((void *)locsiptr) + sizeof(struct seed_info_s1) + SEED_INFO_GET_LEN(locsiptr);
-          if(seed_id_cmp(&seed_id, &locssptr->seed_id)) {
-            goto seed_present;
-          }
-          break;
-        case 2:
-          seed_id_net_to_host(&seed_id, &((struct seed_info_s2 *)locsiptr)->seed_id, 2);
-          locsiptr = ((void *)locsiptr) + sizeof(struct seed_info_s2) + SEED_INFO_GET_LEN(locsiptr);
-          if(seed_id_cmp(&seed_id, &locssptr->seed_id)) {
-            goto seed_present;
-          }
-          break;
-        case 3:
-          seed_id_net_to_host(&seed_id, &((struct seed_info_s3 *)locsiptr)->seed_id, 3);
-          locsiptr = ((void *)locsiptr) + sizeof(struct seed_info_s3) + SEED_INFO_GET_LEN(locsiptr);
-          if(seed_id_cmp(&seed_id, &locssptr->seed_id)) {
-            goto seed_present;
-          }
-          break;
-        }
-      }
-      /* If we made it this far, the seed is missing from the remote. Reset all message timers */
-      LOG_DBG("Remote is missing seed ");
-      LOG_DBG_SEED(locssptr->seed_id);
-      LOG_DBG_("\n");
-      r_missing = 1;
-      if(list_head(locssptr->min_seq) != NULL) {
-        for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-          LOG_DBG("Resetting timer for messages\n");
-          if(!trickle_timer_is_running(&locmmptr->tt)) {
-            LOG_DBG("Starting timer for messages\n");
-            mpl_data_trickle_timer_start(locmmptr);
-          }
-          mpl_trickle_timer_inconsistency(locmmptr);
-        }
-      }
-      /* Otherwise we jump here and continute */
-seed_present:
-      continue;
-    }
+  /* The seeds listed in the remote seed info are marked as present below */
+  for(locssptr = locdsptr->seeds; locssptr != NULL; locssptr = locssptr->next_in_domain) {
+    locssptr->present = 0;
   }
 
   /* Iterate over remote seed info and they're present locally. Additionally check messages match */
@@ -1208,6 +1399,7 @@ seed_present:
       l_missing = 1;
       goto next;
     }
+    locssptr->present = 1;
 
     /* Work out where remote bit vector starts */
     vector_len = SEED_INFO_GET_LEN(locsiptr) * 8;
@@ -1271,10 +1463,7 @@ seed_present:
           /* Additionally all data message timers in set if r is behind us */
           if(list_head(locssptr->min_seq) != NULL) {
             for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-              if(!trickle_timer_is_running(&locmmptr->tt)) {
-                mpl_data_trickle_timer_start(locmmptr);
-              }
-              mpl_trickle_timer_inconsistency(locmmptr);
+              data_timer_inconsistency(locmmptr);
             }
           }
         } else {
@@ -1310,10 +1499,7 @@ seed_present:
         /* Local message is missing from remote set. Reset control and data timers */
         LOG_DBG("Remote is missing seq=%u\n", locmmptr->seq);
         r_missing = 1;
-        if(!trickle_timer_is_running(&locmmptr->tt)) {
-          mpl_data_trickle_timer_start(locmmptr);
-        }
-        mpl_trickle_timer_inconsistency(locmmptr);
+        data_timer_inconsistency(locmmptr);
       }
 
       /* Now increment our pointers */
@@ -1342,10 +1528,7 @@ seed_present:
        */
       while(locmmptr != NULL) {
         LOG_DBG("Remote is missing all above seq=%u\n", locmmptr->seq);
-        if(!trickle_timer_is_running(&locmmptr->tt)) {
-          mpl_data_trickle_timer_start(locmmptr);
-        }
-        mpl_trickle_timer_inconsistency(locmmptr);
+        data_timer_inconsistency(locmmptr);
         r_missing = 1;
         locmmptr = list_item_next(locmmptr);
       }
@@ -1368,6 +1551,21 @@ next:
     }
   }
 
+  /* Check all our seeds are present in the remote seed set */
+  for(locssptr = locdsptr->seeds; locssptr != NULL; locssptr = locssptr->next_in_domain) {
+    if(!locssptr->present) {
+      /* The seed is missing from the remote. Reset all message timers */
+      LOG_DBG("Remote is missing seed ");
+      LOG_DBG_SEED(locssptr->seed_id);
+      LOG_DBG_("\n");
+      r_missing = 1;
+      for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
+        LOG_DBG("Resetting timer for messages\n");
+        data_timer_inconsistency(locmmptr);
+      }
+    }
+  }
+
   /* Now sort out control message timers */
   if(l_missing && !trickle_timer_is_running(&locdsptr->tt)) {
     mpl_control_trickle_timer_start(locdsptr);
@@ -1393,7 +1591,6 @@ accept(uint8_t in)
   static seed_id_t seed_id;
   static uint16_t seq_val;
   static uint8_t S;
-  static struct mpl_msg *mmiterptr;
   static struct uip_ext_hdr *hptr;
 
   LOG_INFO("Multicast I/O\n");
@@ -1509,27 +1706,24 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    if(list_head(locssptr->min_seq) != NULL) {
-      for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-        if(SEQ_VAL_IS_EQ(seq_val, locmmptr->seq)) {
-          /* Seen before , drop */
-          LOG_INFO("Seen before\n");
-          if(HBH_GET_M(lochbhmptr) && list_item_next(locmmptr) != NULL) {
-            mpl_trickle_timer_inconsistency(locmmptr);
-          } else {
-            trickle_timer_consistency(&locmmptr->tt);
-          }
-          UIP_MCAST6_STATS_ADD(mcast_dropped);
-          return UIP_MCAST6_DROP;
-        }
+    locmmptr = msg_lookup(locssptr, seq_val);
+    if(locmmptr != NULL) {
+      /* Seen before , drop */
+      LOG_INFO("Seen before\n");
+      if(HBH_GET_M(lochbhmptr) && list_item_next(locmmptr) != NULL) {
+        mpl_trickle_timer_inconsistency(locmmptr);
+      } else {
+        trickle_timer_consistency(&locmmptr->tt);
       }
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
     }
   }
   /* We have not seen this message before */
 
   /* Allocate a seed set if we have to */
   if(!locssptr) {
-    locssptr = seed_set_allocate();
+    locssptr = seed_set_allocate(&seed_id, locdsptr);
     LOG_INFO("New seed\n");
     if(!locssptr) {
       /* Couldn't allocate seed set, drop */
@@ -1537,10 +1731,6 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    memset(locssptr, 0, sizeof(struct mpl_seed));
-    LIST_STRUCT_INIT(locssptr, min_seq);
-    seed_id_cpy(&locssptr->seed_id, &seed_id);
-    locssptr->domain = locdsptr;
   }
 
   /* Allocate a buffer */
@@ -1589,23 +1779,11 @@ accept(uint8_t in)
   }
 
   /* Place the message into the buffered message linked list */
-  if(list_head(locssptr->min_seq) == NULL) {
-    list_push(locssptr->min_seq, locmmptr);
-    locssptr->min_seqno = locmmptr->seq;
-  } else {
-    for(mmiterptr = list_head(locssptr->min_seq); mmiterptr != NULL; mmiterptr = list_item_next(mmiterptr)) {
-      if(list_item_next(mmiterptr) == NULL
-         || (SEQ_VAL_IS_GT(locmmptr->seq, mmiterptr->seq) && SEQ_VAL_IS_LT(locmmptr->seq, ((struct mpl_msg *)list_item_next(mmiterptr))->seq))) {
-        list_insert(locssptr->min_seq, mmiterptr, locmmptr);
-        break;
-      }
-    }
-  }
-  locssptr->count++;
+  msg_insert(locssptr, locmmptr);
 
 #if MPL_PROACTIVE_FORWARDING
   /* Start Forwarding the message */
-  mpl_data_trickle_timer_start(locmmptr);
+  data_timer_start(locmmptr);
 #endif
 
   LOG_INFO("Min Seq Number=%u, %u values\n", locssptr->min_seqno, locssptr->count);
@@ -1772,6 +1950,16 @@ init(void)
   memset(domain_set, 0, sizeof(struct mpl_domain) * MPL_DOMAIN_SET_SIZE);
   memset(seed_set, 0, sizeof(struct mpl_seed) * MPL_SEED_SET_SIZE);
   memset(buffered_message_set, 0, sizeof(struct mpl_msg) * MPL_BUFFERED_MESSAGE_SET_SIZE);
+  list_init(free_message_set);
+  for(locmmptr = buffered_message_set; locmmptr < &buffered_message_set[MPL_BUFFERED_MESSAGE_SET_SIZE]; locmmptr++) {
+    list_add(free_message_set, locmmptr);
+  }
+#if MPL_SEED_HASH_SIZE
+  memset(seed_hash, 0, sizeof(seed_hash));
+#endif
+#if MPL_DOMAIN_HASH_SIZE
+  memset(domain_hash, 0, sizeof(domain_hash));
+#endif
 
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&mpl_icmp_handler);
@@ -216,6 +216,44 @@
 #define MPL_BUFFERED_MESSAGE_SET_SIZE MPL_CONF_BUFFERED_MESSAGE_SET_SIZE
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * Seed Set Hash Size
+ * The number of buckets of the index used to find a seed set entry from a
+ * seed id and domain. Must be a power of two. With 0, the Seed Set is
+ * searched linearly, which is enough for the default Seed Set Size.
+ */
+#ifndef MPL_CONF_SEED_HASH_SIZE
+#define MPL_SEED_HASH_SIZE                  0
+#else
+#define MPL_SEED_HASH_SIZE MPL_CONF_SEED_HASH_SIZE
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Domain Set Hash Size
+ * The number of buckets of the index used to find a domain set entry from
+ * either its data or its control address. Must be a power of two. With 0,
+ * the Domain Set is searched linearly.
+ */
+#ifndef MPL_CONF_DOMAIN_HASH_SIZE
+#define MPL_DOMAIN_HASH_SIZE                0
+#else
+#define MPL_DOMAIN_HASH_SIZE MPL_CONF_DOMAIN_HASH_SIZE
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Seed Message Window Size
+ * Each seed set entry can index its buffered messages by sequence number
+ * in a window of this many slots, so that duplicates are found and new
+ * messages are placed without walking the seed's message list. Must be a
+ * power of two, and should cover the usual spread of sequence numbers
+ * buffered for a seed. With 0, the message list is always walked.
+ */
+#ifndef MPL_CONF_SEED_WINDOW_SIZE
+#define MPL_SEED_WINDOW_SIZE                0
+#else
+#define MPL_SEED_WINDOW_SIZE MPL_CONF_SEED_WINDOW_SIZE
+#endif
+/*---------------------------------------------------------------------------*/
 /**
  * MPL Forwarding Strategy
  * Two forwarding strategies are defined for MPL. With Proactive forwarding
@@ -73,6 +73,7 @@
 #include "net/netstack.h"
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
+#include "lib/memb.h"
 
 #include "net/routing/routing.h"
 
@@ -239,6 +240,35 @@ static uint16_t my_tag;
 /* Assuming that the worst growth for uncompression is 38 bytes */
 #define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
 
+/* The number of reassembly contexts one sender may use at a time */
+#ifdef SICSLOWPAN_CONF_REASS_SENDER_CONTEXTS
+#define SICSLOWPAN_REASS_SENDER_CONTEXTS SICSLOWPAN_CONF_REASS_SENDER_CONTEXTS
+#else
+#define SICSLOWPAN_REASS_SENDER_CONTEXTS SICSLOWPAN_REASS_CONTEXTS
+#endif
+
+/* The number of fragment buffers one sender may hold at a time, so that
+ * a single sender cannot starve the reassembly of the others */
+#ifdef SICSLOWPAN_CONF_REASS_SENDER_BUFFERS
+#define SICSLOWPAN_REASS_SENDER_BUFFERS SICSLOWPAN_CONF_REASS_SENDER_BUFFERS
+#else
+#define SICSLOWPAN_REASS_SENDER_BUFFERS SICSLOWPAN_FRAGMENT_BUFFERS
+#endif
+
+/* Reassembly progress is tracked in units of 8 bytes, the unit of the
+   fragment offset */
+#define SICSLOWPAN_REASS_UNITS ((UIP_BUFSIZE + 7) / 8)
+
+struct sicslowpan_frag_buf {
+  /* The next fragment of the context, by offset */
+  struct sicslowpan_frag_buf *next;
+  /* Fragment offset */
+  uint8_t offset;
+  /* Length of this fragment */
+  uint8_t len;
+  uint8_t data[SICSLOWPAN_FRAGMENT_SIZE];
+};
+
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
   /** When reassembling, the source address of the fragments being merged */
@@ -254,6 +284,15 @@ struct sicslowpan_frag_info {
   /** Reassembly %process %timer. */
   struct timer reass_timer;
 
+  /** The stored N-fragments, sorted by offset */
+  struct sicslowpan_frag_buf *frags;
+  /** The number of stored N-fragments */
+  uint8_t frag_count;
+  /** The number of 8-byte units received */
+  uint16_t units;
+  /** A bit for every 8-byte unit of the packet, set once received */
+  uint8_t received[(SICSLOWPAN_REASS_UNITS + 7) / 8];
+
   /** Fragment size of first fragment */
   uint16_t first_frag_len;
   /** First fragment - needs a larger buffer since the size is uncompressed size
@@ -263,32 +302,27 @@ struct sicslowpan_frag_info {
 
 static struct sicslowpan_frag_info frag_info[SICSLOWPAN_REASS_CONTEXTS];
 
-struct sicslowpan_frag_buf {
-  /* the index of the frag_info */
-  uint8_t index;
-  /* Fragment offset */
-  uint8_t offset;
-  /* Length of this fragment (if zero this buffer is not allocated) */
-  uint8_t len;
-  uint8_t data[SICSLOWPAN_FRAGMENT_SIZE];
-};
-
-static struct sicslowpan_frag_buf frag_buf[SICSLOWPAN_FRAGMENT_BUFFERS];
+MEMB(frag_bufs, struct sicslowpan_frag_buf, SICSLOWPAN_FRAGMENT_BUFFERS);
 
 /*---------------------------------------------------------------------------*/
 static int
 clear_fragments(uint8_t frag_info_index)
 {
-  int i, clear_count;
-  clear_count = 0;
-  frag_info[frag_info_index].len = 0;
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len > 0 && frag_buf[i].index == frag_info_index) {
-      /* deallocate the buffer */
-      frag_buf[i].len = 0;
-      clear_count++;
-    }
+  struct sicslowpan_frag_info *info = &frag_info[frag_info_index];
+  struct sicslowpan_frag_buf *f;
+  int clear_count;
+
+  clear_count = info->frag_count;
+  info->len = 0;
+  while(info->frags != NULL) {
+    /* deallocate the buffer */
+    f = info->frags;
+    info->frags = f->next;
+    memb_free(&frag_bufs, f);
   }
+  info->frag_count = 0;
+  info->units = 0;
+  memset(info->received, 0, sizeof(info->received));
   return clear_count;
 }
 /*---------------------------------------------------------------------------*/
@@ -307,33 +341,89 @@ timeout_fragments(int not_context)
   return count;
 }
 /*---------------------------------------------------------------------------*/
+/* Counts the units in [from, to) that are received already */
+static uint16_t
+count_received(const struct sicslowpan_frag_info *info,
+               uint16_t from, uint16_t to)
+{
+  uint16_t u;
+  uint16_t count = 0;
+
+  for(u = from; u < to; u++) {
+    if(info->received[u >> 3] & (1 << (u & 7))) {
+      count++;
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_received(struct sicslowpan_frag_info *info, uint16_t from, uint16_t to)
+{
+  uint16_t u;
+
+  for(u = from; u < to; u++) {
+    info->received[u >> 3] |= 1 << (u & 7);
+  }
+  info->units += to - from;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+frags_complete(const struct sicslowpan_frag_info *info)
+{
+  return info->units >= (info->len + 7) / 8;
+}
+/*---------------------------------------------------------------------------*/
+/* Counts the contexts and fragment buffers used by a sender */
 static int
-store_fragment(uint8_t index, uint8_t offset)
+sender_usage(const linkaddr_t *sender, int *buffers)
 {
   int i;
-  int len;
+  int contexts = 0;
 
-  len = packetbuf_datalen() - packetbuf_hdr_len;
+  *buffers = 0;
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    if(frag_info[i].len > 0 && linkaddr_cmp(&frag_info[i].sender, sender)) {
+      contexts++;
+      *buffers += frag_info[i].frag_count;
+    }
+  }
+  return contexts;
+}
+/*---------------------------------------------------------------------------*/
+static int
+store_fragment(uint8_t index, uint8_t offset, int len)
+{
+  struct sicslowpan_frag_info *info = &frag_info[index];
+  struct sicslowpan_frag_buf *f;
+  struct sicslowpan_frag_buf **prev;
+  int buffers;
 
-  if(len <= 0 || len > SICSLOWPAN_FRAGMENT_SIZE) {
-    /* Unacceptable fragment size. */
+  sender_usage(&info->sender, &buffers);
+  if(buffers >= SICSLOWPAN_REASS_SENDER_BUFFERS) {
     return -1;
   }
 
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len == 0) {
-      /* copy over the data from packetbuf into the fragment buffer,
-         and store offset and len */
-      frag_buf[i].offset = offset; /* frag offset */
-      frag_buf[i].len = len;
-      frag_buf[i].index = index;
-      memcpy(frag_buf[i].data, packetbuf_ptr + packetbuf_hdr_len, len);
-      /* return the length of the stored fragment */
-      return len;
-    }
+  f = memb_alloc(&frag_bufs);
+  if(f == NULL) {
+    /* failed */
+    return -1;
   }
-  /* failed */
-  return -1;
+  /* copy over the data from packetbuf into the fragment buffer,
+     and store offset and len */
+  f->offset = offset; /* frag offset */
+  f->len = len;
+  memcpy(f->data, packetbuf_ptr + packetbuf_hdr_len, len);
+
+  /* keep the fragments of the context sorted by offset */
+  for(prev = &info->frags; *prev != NULL && (*prev)->offset < offset;
+      prev = &(*prev)->next);
+  f->next = *prev;
+  *prev = f;
+  info->frag_count++;
+
+  /* return the length of the stored fragment */
+  return len;
 }
 /*---------------------------------------------------------------------------*/
 /* add a new fragment to the buffer */
@@ -342,7 +432,11 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
 {
   int i;
   int len;
+  int buffers;
+  uint16_t units;
+  uint16_t received;
   int8_t found = -1;
+  const linkaddr_t *sender = packetbuf_addr(PACKETBUF_ADDR_SENDER);
 
   if(offset == 0) {
     /* This is a first fragment - check if we can add this */
@@ -352,6 +446,12 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
         clear_fragments(i);
       }
 
+      if(frag_info[i].len > 0 && frag_info[i].tag == tag &&
+         linkaddr_cmp(&frag_info[i].sender, sender)) {
+        LOG_WARN("reassembly: duplicate first fragment - tag: %d\n", tag);
+        return -1;
+      }
+
       /* We use len as indication on used or not used */
       if(found < 0 && frag_info[i].len == 0) {
         /* We remember the first free fragment info but must continue
@@ -365,11 +465,20 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
       return -1;
     }
 
+    if(frag_size == 0 || frag_size > SICSLOWPAN_REASS_UNITS * 8) {
+      LOG_WARN("reassembly: invalid packet size %u - tag: %d\n", frag_size, tag);
+      return -1;
+    }
+
+    if(sender_usage(sender, &buffers) >= SICSLOWPAN_REASS_SENDER_CONTEXTS) {
+      LOG_WARN("reassembly: too many sessions from sender - tag: %d\n", tag);
+      return -1;
+    }
+
     /* Found a free fragment info to store data in */
     frag_info[found].len = frag_size;
     frag_info[found].tag = tag;
-    linkaddr_copy(&frag_info[found].sender,
-                  packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    linkaddr_copy(&frag_info[found].sender, sender);
     timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
     /* first fragment can not be stored immediately but is moved into
        the buffer while uncompressing */
@@ -379,7 +488,7 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
   /* This is a N-fragment - should find the info */
   for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
     if(frag_info[i].tag == tag && frag_info[i].len > 0 &&
-       linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+       linkaddr_cmp(&frag_info[i].sender, sender)) {
       /* Tag and Sender match - this must be the correct info to store in */
       found = i;
       break;
@@ -392,12 +501,34 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
     return -1;
   }
 
+  len = packetbuf_datalen() - packetbuf_hdr_len;
+  units = (len + 7) / 8;
+  if(len <= 0 || len > SICSLOWPAN_FRAGMENT_SIZE
+     || offset + units > (frag_info[i].len + 7) / 8) {
+    /* Unacceptable fragment size. */
+    LOG_WARN("reassembly: invalid fragment - tag: %d offset: %d len: %d\n", tag, offset, len);
+    return -1;
+  }
+
+  received = count_received(&frag_info[i], offset, offset + units);
+  if(received == units) {
+    /* Already have it, the context is still valid */
+    LOG_INFO("reassembly: duplicate fragment - tag: %d offset: %d\n", tag, offset);
+    return i;
+  }
+  if(received > 0) {
+    LOG_WARN("reassembly: overlapping fragment - dropping packet tag: %d offset: %d\n", tag, offset);
+    clear_fragments(i);
+    return -1;
+  }
+
   /* i is the index of the reassembly context */
-  len = store_fragment(i, offset);
-  if(len < 0 && timeout_fragments(i) > 0) {
-    len = store_fragment(i, offset);
+  if(store_fragment(i, offset, len) < 0
+     && (timeout_fragments(i) == 0 || store_fragment(i, offset, len) < 0)) {
+    len = -1;
   }
   if(len > 0) {
+    set_received(&frag_info[i], offset, offset + units);
     frag_info[i].reassembled_len += len;
     return i;
   } else {
@@ -413,7 +544,7 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
 static bool
 copy_frags2uip(int context)
 {
-  int i;
+  struct sicslowpan_frag_buf *f;
   struct sicslowpan_frag_info* frag_c = &frag_info[context];
 
   /* Check length fields before proceeding. */
@@ -426,21 +557,16 @@ copy_frags2uip(int context)
   /* Copy from the fragment context info buffer first */
   memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)frag_c->first_frag, frag_c->first_frag_len);
 
-  /* Ensure that no previous data is used for reassembly in case of missing fragments. */
-  memset((uint8_t *)UIP_IP_BUF + frag_c->first_frag_len, 0,
-          frag_c->len - frag_c->first_frag_len);
-
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    /* And also copy all matching fragments */
-    if(frag_buf[i].len > 0 && frag_buf[i].index == context) {
-      if((frag_buf[i].offset << 3) + frag_buf[i].len > sizeof(uip_buf)) {
-        LOG_WARN("input: invalid fragment offset\n");
-        clear_fragments(context);
-        return false;
-      }
-      memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(frag_buf[i].offset << 3),
-             (uint8_t *)frag_buf[i].data, frag_buf[i].len);
+  /* And also copy all the fragments of the context, the received
+     bitmap ensures that they cover the packet without overlapping */
+  for(f = frag_c->frags; f != NULL; f = f->next) {
+    if((f->offset << 3) + f->len > sizeof(uip_buf)) {
+      LOG_WARN("input: invalid fragment offset\n");
+      clear_fragments(context);
+      return false;
     }
+    memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(f->offset << 3),
+           (uint8_t *)f->data, f->len);
   }
   /* deallocate all the fragments for this context */
   clear_fragments(context);
@@ -1574,6 +1700,11 @@ fragment_copy_payload_and_send(uint16_t uip_offset, linkaddr_t *dest) {
   /* Restore packetbuf from queuebuf */
   queuebuf_to_packetbuf(q);
   queuebuf_free(q);
+#if PACKETBUF_WITH_POOL
+  /* The MAC may still hold the fragment, only the headers are reused */
+  packetbuf_unshare(packetbuf_hdr_len);
+  packetbuf_ptr = packetbuf_dataptr();
+#endif /* PACKETBUF_WITH_POOL */
 
   /* Check tx result. */
   if((last_tx_status == MAC_TX_COLLISION) ||
@@ -1930,7 +2061,7 @@ void sicslowpan_input(void)
          we should not store more */
       buffer = NULL;
 
-      if(frag_info[frag_context].reassembled_len >= frag_size) {
+      if(frags_complete(&frag_info[frag_context])) {
         last_fragment = 1;
       }
       is_fragment = 1;
@@ -2039,6 +2170,9 @@ void sicslowpan_input(void)
     if(first_fragment != 0) {
       frag_info[frag_context].reassembled_len = uncomp_hdr_len + packetbuf_payload_len;
       frag_info[frag_context].first_frag_len = uncomp_hdr_len + packetbuf_payload_len;
+      set_received(&frag_info[frag_context], 0,
+                   MIN((frag_info[frag_context].first_frag_len + 7) / 8,
+                       SICSLOWPAN_REASS_UNITS));
     }
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
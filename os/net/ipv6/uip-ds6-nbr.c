@@ -54,6 +54,7 @@
 #include "net/ipv6/uip-ds6-nbr.h"
 #include "net/ipv6/uip-nd6.h"
 #include "net/routing/routing.h"
+#include "net/ip/tcpip.h"
 
 #if UIP_DS6_NBR_MULTI_IPV6_ADDRS
 #include "lib/memb.h"
@@ -260,6 +261,9 @@ free_uip_ds6_nbr(uip_ds6_nbr_t *nbr)
   uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
   NETSTACK_ROUTING.neighbor_state_changed(nbr);
+#if TCPIP_NEXTHOP_CACHE
+  tcpip_nexthop_cache_flush();
+#endif /* TCPIP_NEXTHOP_CACHE */
   assert(nbr->nbr_entry != NULL);
   if(nbr->nbr_entry == NULL) {
     LOG_ERR("%s: unexpected error nbr->nbr_entry is NULL\n", __func__);
@@ -306,6 +310,9 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
     uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
     NETSTACK_ROUTING.neighbor_state_changed(nbr);
+#if TCPIP_NEXTHOP_CACHE
+    tcpip_nexthop_cache_flush();
+#endif /* TCPIP_NEXTHOP_CACHE */
     return ds6_neighbors_remove_item(nbr);
   }
   return 0;
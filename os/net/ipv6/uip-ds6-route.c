@@ -91,6 +91,23 @@ MEMB(routememb, uip_ds6_route_t, UIP_DS6_ROUTE_NB);
 static int num_routes = 0;
 static void rm_routelist_callback(nbr_table_item_t *ptr);
 
+#if UIP_DS6_ROUTE_TRIE
+/* Routes are also indexed by a path-compressed binary trie. Every node
+   holds a prefix that extends the prefix of its parent, child[b]
+   continues with bit b after the parent prefix. Nodes without a route
+   always have two children, so the trie holds fewer than two nodes per
+   route. */
+struct route_trie_node {
+  struct route_trie_node *child[2];
+  uip_ds6_route_t *route;
+  uip_ipaddr_t prefix;
+  uint8_t length;
+};
+MEMB(routetriememb, struct route_trie_node, 2 * UIP_DS6_ROUTE_NB);
+static struct route_trie_node *route_trie;
+static uint32_t route_lru_clock;
+#endif /* UIP_DS6_ROUTE_TRIE */
+
 #endif /* (UIP_MAX_ROUTES != 0) */
 
 /* Default routes are held on the defaultrouterlist and their
@@ -145,7 +162,7 @@ call_route_callback(int event, const uip_ipaddr_t *route,
        event == UIP_DS6_NOTIFICATION_DEFRT_RM) {
       num = list_length(defaultrouterlist);
     } else {
-      num = num_routes;
+      num = uip_ds6_route_num_routes();
     }
     n->callback(event, route, nexthop, num);
   }
@@ -167,6 +184,174 @@ uip_ds6_notification_rm(struct uip_ds6_notification *n)
   list_remove(notificationlist, n);
 }
 #endif
+#if (UIP_MAX_ROUTES != 0) && UIP_DS6_ROUTE_TRIE
+/*---------------------------------------------------------------------------*/
+static int
+trie_bit(const uip_ipaddr_t *addr, uint8_t pos)
+{
+  return (addr->u8[pos >> 3] >> (7 - (pos & 7))) & 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Number of leading bits that a and b have in common, at most max */
+static uint8_t
+trie_common_length(const uip_ipaddr_t *a, const uip_ipaddr_t *b, uint8_t max)
+{
+  uint8_t len = 0;
+  uint8_t diff;
+  int i;
+
+  for(i = 0; i < sizeof(uip_ipaddr_t) && len < max; i++) {
+    diff = a->u8[i] ^ b->u8[i];
+    if(diff != 0) {
+      while((diff & 0x80) == 0) {
+        diff <<= 1;
+        len++;
+      }
+      break;
+    }
+    len += 8;
+  }
+  return len < max ? len : max;
+}
+/*---------------------------------------------------------------------------*/
+static int
+trie_prefix_match(const uip_ipaddr_t *addr, const struct route_trie_node *n)
+{
+  uint8_t bytes = n->length >> 3;
+  uint8_t bits = n->length & 7;
+
+  if(memcmp(addr, &n->prefix, bytes) != 0) {
+    return 0;
+  }
+  return bits == 0 ||
+    ((addr->u8[bytes] ^ n->prefix.u8[bytes]) & (0xff00 >> bits) & 0xff) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static struct route_trie_node *
+trie_node_alloc(const uip_ipaddr_t *prefix, uint8_t length,
+                uip_ds6_route_t *route)
+{
+  struct route_trie_node *n = memb_alloc(&routetriememb);
+
+  if(n != NULL) {
+    n->child[0] = n->child[1] = NULL;
+    n->route = route;
+    uip_ipaddr_copy(&n->prefix, prefix);
+    n->length = length;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static int
+trie_insert(uip_ds6_route_t *r)
+{
+  struct route_trie_node **np = &route_trie;
+  struct route_trie_node *n;
+  struct route_trie_node *split;
+  struct route_trie_node *leaf;
+  uint8_t common;
+
+  while((n = *np) != NULL) {
+    common = trie_common_length(&r->ipaddr, &n->prefix,
+                                MIN(r->length, n->length));
+    if(common < n->length) {
+      if(common == r->length) {
+        /* The new route covers n: insert it above n */
+        leaf = trie_node_alloc(&r->ipaddr, r->length, r);
+        if(leaf == NULL) {
+          return 0;
+        }
+        leaf->child[trie_bit(&n->prefix, common)] = n;
+        *np = leaf;
+        return 1;
+      }
+      /* The prefixes diverge: add a branching node above n */
+      split = trie_node_alloc(&r->ipaddr, common, NULL);
+      leaf = trie_node_alloc(&r->ipaddr, r->length, r);
+      if(split == NULL || leaf == NULL) {
+        if(split != NULL) {
+          memb_free(&routetriememb, split);
+        }
+        return 0;
+      }
+      split->child[trie_bit(&n->prefix, common)] = n;
+      split->child[trie_bit(&r->ipaddr, common)] = leaf;
+      *np = split;
+      return 1;
+    }
+    if(n->length == r->length) {
+      /* Same prefix, this is a branching node or a replaced route */
+      n->route = r;
+      return 1;
+    }
+    np = &n->child[trie_bit(&r->ipaddr, n->length)];
+  }
+
+  *np = trie_node_alloc(&r->ipaddr, r->length, r);
+  return *np != NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+trie_remove(uip_ds6_route_t *r)
+{
+  struct route_trie_node **np = &route_trie;
+  struct route_trie_node **pp = NULL;
+  struct route_trie_node *n;
+  struct route_trie_node *parent;
+
+  while((n = *np) != NULL && n->route != r) {
+    if(n->length >= r->length) {
+      return;
+    }
+    pp = np;
+    np = &n->child[trie_bit(&r->ipaddr, n->length)];
+  }
+  if(n == NULL) {
+    return;
+  }
+
+  n->route = NULL;
+  if(n->child[0] != NULL && n->child[1] != NULL) {
+    /* Still needed for branching */
+    return;
+  }
+  if(n->child[0] != NULL || n->child[1] != NULL) {
+    *np = n->child[0] != NULL ? n->child[0] : n->child[1];
+    memb_free(&routetriememb, n);
+    return;
+  }
+
+  *np = NULL;
+  memb_free(&routetriememb, n);
+
+  /* A branching parent left with a single child is no longer needed */
+  if(pp != NULL) {
+    parent = *pp;
+    if(parent->route == NULL) {
+      *pp = parent->child[0] != NULL ? parent->child[0] : parent->child[1];
+      memb_free(&routetriememb, parent);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+trie_lookup(const uip_ipaddr_t *addr)
+{
+  struct route_trie_node *n = route_trie;
+  uip_ds6_route_t *found = NULL;
+
+  while(n != NULL && trie_prefix_match(addr, n)) {
+    if(n->route != NULL) {
+      found = n->route;
+    }
+    if(n->length >= 128) {
+      break;
+    }
+    n = n->child[trie_bit(addr, n->length)];
+  }
+  return found;
+}
+#endif /* (UIP_MAX_ROUTES != 0) && UIP_DS6_ROUTE_TRIE */
 /*---------------------------------------------------------------------------*/
 void
 uip_ds6_route_init(void)
@@ -174,6 +359,10 @@ uip_ds6_route_init(void)
 #if (UIP_MAX_ROUTES != 0)
   memb_init(&routememb);
   list_init(routelist);
+#if UIP_DS6_ROUTE_TRIE
+  memb_init(&routetriememb);
+  route_trie = NULL;
+#endif /* UIP_DS6_ROUTE_TRIE */
   nbr_table_register(nbr_routes,
                      (nbr_table_callback *)rm_routelist_callback);
 #endif /* (UIP_MAX_ROUTES != 0) */
@@ -280,9 +469,11 @@ uip_ds6_route_t *
 uip_ds6_route_lookup(const uip_ipaddr_t *addr)
 {
 #if (UIP_MAX_ROUTES != 0)
-  uip_ds6_route_t *r;
   uip_ds6_route_t *found_route;
+#if !UIP_DS6_ROUTE_TRIE
+  uip_ds6_route_t *r;
   uint8_t longestmatch;
+#endif /* !UIP_DS6_ROUTE_TRIE */
 
   LOG_INFO("Looking up route for ");
   LOG_INFO_6ADDR(addr);
@@ -292,6 +483,9 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
     return NULL;
   }
 
+#if UIP_DS6_ROUTE_TRIE
+  found_route = trie_lookup(addr);
+#else /* UIP_DS6_ROUTE_TRIE */
   found_route = NULL;
   longestmatch = 0;
   for(r = uip_ds6_route_head();
@@ -307,6 +501,7 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
       }
     }
   }
+#endif /* UIP_DS6_ROUTE_TRIE */
 
   if(found_route != NULL) {
     LOG_INFO("Found route: ");
@@ -318,6 +513,11 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
     LOG_WARN("No route found\n");
   }
 
+#if UIP_DS6_ROUTE_TRIE
+  if(found_route != NULL) {
+    found_route->last_used = ++route_lru_clock;
+  }
+#else /* UIP_DS6_ROUTE_TRIE */
   if(found_route != NULL && found_route != list_head(routelist)) {
     /* If we found a route, we put it at the start of the routeslist
        list. The list is ordered by how recently we looked them up:
@@ -327,6 +527,7 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
     list_remove(routelist, found_route);
     list_push(routelist, found_route);
   }
+#endif /* UIP_DS6_ROUTE_TRIE */
 
   return found_route;
 #else /* (UIP_MAX_ROUTES != 0) */
@@ -386,9 +587,19 @@ uip_ds6_route_add(const uip_ipaddr_t *ipaddr, uint8_t length,
       uip_ds6_route_t *oldest;
       oldest = NULL;
 #if UIP_DS6_ROUTE_REMOVE_LEAST_RECENTLY_USED
+#if UIP_DS6_ROUTE_TRIE
+      /* Removing the route entry with the oldest lookup stamp */
+      for(r = list_head(routelist); r != NULL; r = list_item_next(r)) {
+        if(oldest == NULL ||
+           (int32_t)(r->last_used - oldest->last_used) < 0) {
+          oldest = r;
+        }
+      }
+#else /* UIP_DS6_ROUTE_TRIE */
       /* Removing the oldest route entry from the route table. The
          least recently used route is the first route on the list. */
       oldest = list_tail(routelist);
+#endif /* UIP_DS6_ROUTE_TRIE */
 #endif
       if(oldest == NULL) {
         return NULL;
@@ -470,6 +681,14 @@ uip_ds6_route_add(const uip_ipaddr_t *ipaddr, uint8_t length,
   uip_ipaddr_copy(&(r->ipaddr), ipaddr);
   r->length = length;
 
+#if UIP_DS6_ROUTE_TRIE
+  r->last_used = ++route_lru_clock;
+  if(!trie_insert(r)) {
+    /* Cannot happen, the trie has room for two nodes per route */
+    LOG_ERR("Add: could not index route\n");
+  }
+#endif /* UIP_DS6_ROUTE_TRIE */
+
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   memset(&r->state, 0, sizeof(UIP_DS6_ROUTE_STATE_TYPE));
 #endif
@@ -514,6 +733,9 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
 
     /* Remove the route from the route list */
     list_remove(routelist, route);
+#if UIP_DS6_ROUTE_TRIE
+    trie_remove(route);
+#endif /* UIP_DS6_ROUTE_TRIE */
 
     /* Find the corresponding neighbor_route and remove it. */
     for(neighbor_route = list_head(route->neighbor_routes->route_list);
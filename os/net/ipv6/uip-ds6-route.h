@@ -71,7 +71,12 @@
 void uip_ds6_route_init(void);
 
 #ifndef UIP_CONF_UIP_DS6_NOTIFICATIONS
+#ifdef TCPIP_CONF_NEXTHOP_CACHE
+/* The next-hop cache of tcpip.c is flushed by notifications */
+#define UIP_DS6_NOTIFICATIONS ((UIP_MAX_ROUTES != 0) || TCPIP_CONF_NEXTHOP_CACHE)
+#else
 #define UIP_DS6_NOTIFICATIONS (UIP_MAX_ROUTES != 0)
+#endif
 #else
 #define UIP_DS6_NOTIFICATIONS UIP_CONF_UIP_DS6_NOTIFICATIONS
 #endif
@@ -109,6 +114,15 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define UIP_DS6_ROUTE_NB 4
 #endif /* UIP_MAX_ROUTES */
 
+/** \brief Index routes in a path-compressed binary trie for longest
+ *  prefix match, instead of scanning the route list on every lookup.
+ *  Intended for storing-mode roots with large routing tables. */
+#ifdef UIP_DS6_ROUTE_CONF_TRIE
+#define UIP_DS6_ROUTE_TRIE UIP_DS6_ROUTE_CONF_TRIE
+#else /* UIP_DS6_ROUTE_CONF_TRIE */
+#define UIP_DS6_ROUTE_TRIE 0
+#endif /* UIP_DS6_ROUTE_CONF_TRIE */
+
 /** \brief define some additional RPL related route state and
  *  neighbor callback for RPL - if not a DS6_ROUTE_STATE is already set */
 #ifndef UIP_DS6_ROUTE_STATE_TYPE
@@ -178,6 +192,11 @@ typedef struct uip_ds6_route {
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   UIP_DS6_ROUTE_STATE_TYPE state;
 #endif
+#if UIP_DS6_ROUTE_TRIE
+  /* The route list is not reordered on lookup when the trie is used,
+     the least recently used route is found by this stamp instead. */
+  uint32_t last_used;
+#endif /* UIP_DS6_ROUTE_TRIE */
   uint8_t length;
 } uip_ds6_route_t;
 
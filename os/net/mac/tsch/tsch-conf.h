@@ -452,6 +452,15 @@
 #define TSCH_SCHEDULE_POLICY 0
 #endif
 
+/* Keep the links of every slotframe sorted by timeslot, so that
+ * tsch_schedule_get_next_active_link looks up the next link by binary
+ * search instead of checking every link of the schedule */
+#ifdef TSCH_SCHEDULE_CONF_WITH_CALENDAR
+#define TSCH_SCHEDULE_WITH_CALENDAR TSCH_SCHEDULE_CONF_WITH_CALENDAR
+#else
+#define TSCH_SCHEDULE_WITH_CALENDAR 0
+#endif
+
 /******** Configuration: CSMA *******/
 
 /* TSCH CSMA-CA parameters, see IEEE 802.15.4e-2012 */
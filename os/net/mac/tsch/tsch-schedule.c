@@ -99,6 +99,10 @@ tsch_schedule_add_slotframe(tsch_sf_h handle, uint16_t size)
       sf->handle = handle;
       TSCH_ASN_DIVISOR_INIT(sf->size, size);
       LIST_STRUCT_INIT(sf, links_list);
+#if TSCH_SCHEDULE_WITH_CALENDAR
+      sf->calendar_len = 0;
+      sf->escape_links = 0;
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
       /* Add the slotframe to the global list */
       list_add(slotframe_list, sf);
     }
@@ -221,6 +225,75 @@ print_link_type(uint16_t link_type)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if TSCH_SCHEDULE_WITH_CALENDAR
+/* Index of the first calendar entry with a timeslot after the given one */
+static uint16_t
+calendar_search(const struct tsch_slotframe *sf, tsch_slot_offset_t timeslot)
+{
+  uint16_t lo = 0;
+  uint16_t hi = sf->calendar_len;
+
+  while(lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if(sf->calendar[mid]->timeslot <= timeslot) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+/*---------------------------------------------------------------------------*/
+/* Call with the lock taken */
+static void
+calendar_insert(struct tsch_slotframe *sf, struct tsch_link *l)
+{
+  uint16_t i = calendar_search(sf, l->timeslot);
+
+  memmove(&sf->calendar[i + 1], &sf->calendar[i],
+          (sf->calendar_len - i) * sizeof(sf->calendar[0]));
+  sf->calendar[i] = l;
+  sf->calendar_len++;
+  if(l->link_options & LINK_OPTION_TIME_EB_ESCAPE) {
+    sf->escape_links++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Call with the lock taken */
+static void
+calendar_remove(struct tsch_slotframe *sf, struct tsch_link *l)
+{
+  uint16_t i = calendar_search(sf, l->timeslot);
+
+  /* Links at the same timeslot are right before the search result */
+  while(i > 0) {
+    i--;
+    if(sf->calendar[i] == l) {
+      sf->calendar_len--;
+      memmove(&sf->calendar[i], &sf->calendar[i + 1],
+              (sf->calendar_len - i) * sizeof(sf->calendar[0]));
+      if(l->link_options & LINK_OPTION_TIME_EB_ESCAPE) {
+        sf->escape_links--;
+      }
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_slotframe *
+calendar_slotframe(const struct tsch_link *l)
+{
+  struct tsch_slotframe *sf;
+
+  for(sf = list_head(slotframe_list); sf != NULL; sf = list_item_next(sf)) {
+    if(sf->handle == l->slotframe_handle) {
+      return sf;
+    }
+  }
+  return NULL;
+}
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
+/*---------------------------------------------------------------------------*/
 void tsch_schedule_link_addr_aqure(struct tsch_link *l);
 void tsch_schedule_link_addr_release(uint8_t link_options, const linkaddr_t* addr);
 
@@ -269,6 +342,9 @@ tsch_schedule_add_link(struct tsch_slotframe *slotframe,
           address = &linkaddr_null;
         }
         linkaddr_copy(&l->addr, address);
+#if TSCH_SCHEDULE_WITH_CALENDAR
+        calendar_insert(slotframe, l);
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
 
         /* Release the lock before we update the neighbor (will take the lock) */
         tsch_release_lock();
@@ -312,6 +388,17 @@ void tsch_schedule_link_change_option(struct tsch_link *l, uint8_t link_options)
 {
     if (l->link_options == link_options)
         return;
+#if TSCH_SCHEDULE_WITH_CALENDAR
+    if ((l->link_options ^ link_options) & LINK_OPTION_TIME_EB_ESCAPE){
+        struct tsch_slotframe *sf = calendar_slotframe(l);
+        if (sf != NULL){
+            if (link_options & LINK_OPTION_TIME_EB_ESCAPE)
+                sf->escape_links++;
+            else
+                sf->escape_links--;
+        }
+    }
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
     tsch_schedule_link_addr_release(l->link_options, &l->addr);
     l->link_options = link_options;
     tsch_schedule_link_addr_aqure(l);
@@ -342,6 +429,9 @@ tsch_schedule_remove_link(struct tsch_slotframe *slotframe, struct tsch_link *l)
              TSCH_LOG_ID_FROM_LINKADDR(&l->addr));
 
       list_remove(slotframe->links_list, l);
+#if TSCH_SCHEDULE_WITH_CALENDAR
+      calendar_remove(slotframe, l);
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
       memb_free(&link_memb, l);
 
       /* Release the lock before we update the neighbor (will take the lock) */
@@ -476,27 +566,165 @@ default_tsch_link_comparator(struct tsch_link *a, struct tsch_link *b)
 }
 
 /*---------------------------------------------------------------------------*/
-/* Returns the next active link after a given ASN, and a backup link (for the same ASN, with Rx flag) */
-//  \arg time_offset - gives TSCH_DESYNC_THRESHOLD_SLOTS value, used to escape
-//                  timesource EB
 // used by tsch_slot_operation
 struct tsch_link *signaling_link = NULL;
+/*---------------------------------------------------------------------------*/
+/* Selection state of tsch_schedule_get_next_active_link */
+struct link_selection {
+  struct tsch_link *best;
+  struct tsch_link *backup;
+  struct tsch_slotframe *best_frame;
+  tsch_slot_offset_t time_to_best;
+};
+/*---------------------------------------------------------------------------*/
+/* Time from timeslot to the link, returns 0 if the link is not to be planned */
+static int
+link_time_to(struct tsch_slotframe *sf, struct tsch_link *l,
+             tsch_slot_offset_t timeslot, tsch_slot_offset_t *time_offset,
+             tsch_slot_offset_t *time_to_timeslot)
+{
+  tsch_slot_offset_t linktime = l->timeslot;
+
+  // plan point is not avoidable
+  if ((l->link_options & (LINK_OPTION_DISABLE)) != 0)
+      return 0;
+  if (TSCH_SCHEDULE_POLICY & TSCH_SCHEDULE_OMMIT_NOXFER){
+      if ((l->link_options & (LINK_OPTION_RX|LINK_OPTION_TX|LINK_OPTION_PLANPOINT)) == 0)
+      // when link ton transfers, skip it
+        return 0;
+      if ((l->link_options & LINK_OPTION_TIME_EB_ESCAPE) != 0){
+          // TODO use cource calculation to escape use division
+          linktime += *time_offset; //(*time_offset/sf->size.val)*sf->size.val;
+          tsch_slot_offset_t loosetime = sf->size.val*TSCH_TIMESYNC_EB_LOOSES;
+          if (*time_offset > loosetime)
+              linktime -= loosetime;
+      }
+  }//if (TSCH_SCHEDULE_POLICY & TSCH_SCHEDULE_OMMIT_NOXFER)
+  *time_to_timeslot = linktime > timeslot ?
+                      linktime - timeslot :
+                      sf->size.val + linktime - timeslot;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Offers a link to the selection, links must be offered in schedule order */
+static void
+link_select(struct link_selection *s, struct tsch_slotframe *sf,
+            struct tsch_link *l, tsch_slot_offset_t time_to_timeslot)
+{
+  if(s->best == NULL || time_to_timeslot < s->time_to_best) {
+    s->time_to_best = time_to_timeslot;
+    s->best_frame   = sf;
+    s->best = l;
+#ifdef TSCH_CALLBACK_LINK_SIGNAL
+    if ( (l->link_options & (LINK_OPTION_SIGNAL|LINK_OPTION_SIGNAL_ONCE)) != 0) {
+        signaling_link = l;
+    }
+    else
+        signaling_link    = NULL;
+#endif
+    s->backup = NULL;
+  } else if(time_to_timeslot == s->time_to_best) {
+    struct tsch_link *new_best = NULL;
+    /* Two links are overlapping, we need to select one of them.
+     * By standard: prioritize Tx links first, second by lowest handle */
+    if((s->best->link_options & LINK_OPTION_TX) == (l->link_options & LINK_OPTION_TX)) {
+      /* Both or neither links have Tx, select the one with lowest handle */
+      if(l->slotframe_handle != s->best->slotframe_handle) {
+        if(l->slotframe_handle < s->best->slotframe_handle) {
+          new_best = l;
+        }
+      } else {
+        /* compare the link against the current best link and return the newly selected one */
+        new_best = TSCH_LINK_COMPARATOR(s->best, l);
+      }
+    } else {
+      /* Select the link that has the Tx option */
+      if(l->link_options & LINK_OPTION_TX) {
+        new_best = l;
+      }
+    }
+
+    /* Maintain backup_link */
+    /* Check if 'l' best can be used as backup */
+    if(new_best != l && (l->link_options & LINK_OPTION_RX)) { /* Does 'l' have Rx flag? */
+      if(s->backup == NULL || l->slotframe_handle < s->backup->slotframe_handle) {
+        s->backup = l;
+      }
+    }
+    /* Check if curr_best can be used as backup */
+    if(new_best != s->best && (s->best->link_options & LINK_OPTION_RX)) { /* Does curr_best have Rx flag? */
+      if(s->backup == NULL || s->best->slotframe_handle < s->backup->slotframe_handle) {
+        s->backup = s->best;
+      }
+    }
+
+    /* Maintain curr_best */
+    if(new_best != NULL) {
+      s->best = new_best;
+      s->best_frame  = sf;
+    }
+
+#ifdef TSCH_CALLBACK_LINK_SIGNAL
+    if ( (l->link_options & (LINK_OPTION_SIGNAL|LINK_OPTION_SIGNAL_ONCE)) != 0) {
+        signaling_link = l;
+    }
+#endif
 
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if TSCH_SCHEDULE_WITH_CALENDAR
+/* Offers the earliest links of a slotframe to the selection. The calendar is
+ * walked from the current timeslot on, so the time to the links only grows
+ * and the walk stops at the first link later than the best one. Links at the
+ * same time are visited in the order they were added, as with links_list. */
+static void
+calendar_select(struct link_selection *s, struct tsch_slotframe *sf,
+                tsch_slot_offset_t timeslot, tsch_slot_offset_t *time_offset)
+{
+  uint16_t n = sf->calendar_len;
+  uint16_t start = calendar_search(sf, timeslot);
+  uint16_t i;
+  uint16_t j;
+  tsch_slot_offset_t time_to_timeslot;
+
+  for(i = 0; i < n; i++) {
+    j = start + i;
+    if(j >= n) {
+      j -= n;
+    }
+    if(!link_time_to(sf, sf->calendar[j], timeslot, time_offset, &time_to_timeslot)) {
+      continue;
+    }
+    if(s->best != NULL && time_to_timeslot > s->time_to_best) {
+      break;
+    }
+    link_select(s, sf, sf->calendar[j], time_to_timeslot);
+  }
+}
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
+/*---------------------------------------------------------------------------*/
+/* Returns the next active link after a given ASN, and a backup link (for the same ASN, with Rx flag) */
+//  \arg time_offset - gives TSCH_DESYNC_THRESHOLD_SLOTS value, used to escape
+//                  timesource EB
 struct tsch_link *
 tsch_schedule_get_next_active_link(struct tsch_asn_t *asn
     , tsch_slot_offset_t *time_offset,
     struct tsch_link **backup_link)
 {
-  tsch_slot_offset_t time_to_curr_best = 0;
-  struct tsch_slotframe * best_frame = NULL;
-    // signaling link has seen at time_to_curr_best
-    signaling_link                = NULL;
+  struct link_selection s;
 
-  struct tsch_link *curr_best = NULL;
-  struct tsch_link *curr_backup = NULL; /* Keep a back link in case the current link
+  s.best = NULL;
+  /* Keep a back link in case the current link
   turns out useless when the time comes. For instance, for a Tx-only link, if there is
   no outgoing packet in queue. In that case, run the backup link instead. The backup link
   must have Rx flag set. */
+  s.backup = NULL;
+  s.best_frame = NULL;
+  s.time_to_best = 0;
+    // signaling link has seen at time_to_curr_best
+    signaling_link                = NULL;
+
   if(!tsch_is_locked()) {
     struct tsch_slotframe *sf = list_head(slotframe_list);
     /* For each slotframe, look for the earliest occurring link */
@@ -505,125 +733,55 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn
           continue;
       /* Get timeslot from ASN, given the slotframe length */
       tsch_slot_offset_t timeslot = TSCH_ASN_MOD(*asn, sf->size);
+#if TSCH_SCHEDULE_WITH_CALENDAR
+      if (!(TSCH_SCHEDULE_POLICY & TSCH_SCHEDULE_OMMIT_NOXFER)
+          || sf->escape_links == 0) {
+          calendar_select(&s, sf, timeslot, time_offset);
+          continue;
+      }
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
       struct tsch_link *l = list_head(sf->links_list);
       for(; l != NULL; l = list_item_next(l)) {
-          tsch_slot_offset_t linktime = l->timeslot;
-
-          // plan point is not avoidable
-          if ((l->link_options & (LINK_OPTION_DISABLE)) != 0)
-              continue;
-          if (TSCH_SCHEDULE_POLICY & TSCH_SCHEDULE_OMMIT_NOXFER){
-              if ((l->link_options & (LINK_OPTION_RX|LINK_OPTION_TX|LINK_OPTION_PLANPOINT)) == 0)
-              // when link ton transfers, skip it
-                continue;
-              if ((l->link_options & LINK_OPTION_TIME_EB_ESCAPE) != 0){
-                  // TODO use cource calculation to escape use division
-                  linktime += *time_offset; //(*time_offset/sf->size.val)*sf->size.val;
-                  tsch_slot_offset_t loosetime = sf->size.val*TSCH_TIMESYNC_EB_LOOSES;
-                  if (*time_offset > loosetime)
-                      linktime -= loosetime;
-              }
-          }//if (TSCH_SCHEDULE_POLICY & TSCH_SCHEDULE_OMMIT_NOXFER)
-        tsch_slot_offset_t time_to_timeslot =
-                  linktime > timeslot ?
-                  linktime - timeslot :
-                  sf->size.val + linktime - timeslot;
-        if(curr_best == NULL || time_to_timeslot < time_to_curr_best) {
-          time_to_curr_best = time_to_timeslot;
-          best_frame        = sf;
-          curr_best = l;
-#ifdef TSCH_CALLBACK_LINK_SIGNAL
-          if ( (l->link_options & (LINK_OPTION_SIGNAL|LINK_OPTION_SIGNAL_ONCE)) != 0) {
-              signaling_link = l;
-          }
-          else
-              signaling_link    = NULL;
-#endif
-          curr_backup = NULL;
-        } else if(time_to_timeslot == time_to_curr_best) {
-          struct tsch_link *new_best = NULL;
-          /* Two links are overlapping, we need to select one of them.
-           * By standard: prioritize Tx links first, second by lowest handle */
-          if((curr_best->link_options & LINK_OPTION_TX) == (l->link_options & LINK_OPTION_TX)) {
-            /* Both or neither links have Tx, select the one with lowest handle */
-            if(l->slotframe_handle != curr_best->slotframe_handle) {
-              if(l->slotframe_handle < curr_best->slotframe_handle) {
-                new_best = l;
-              }
-            } else {
-              /* compare the link against the current best link and return the newly selected one */
-              new_best = TSCH_LINK_COMPARATOR(curr_best, l);
-            }
-          } else {
-            /* Select the link that has the Tx option */
-            if(l->link_options & LINK_OPTION_TX) {
-              new_best = l;
-            }
-          }
-
-          /* Maintain backup_link */
-          /* Check if 'l' best can be used as backup */
-          if(new_best != l && (l->link_options & LINK_OPTION_RX)) { /* Does 'l' have Rx flag? */
-            if(curr_backup == NULL || l->slotframe_handle < curr_backup->slotframe_handle) {
-              curr_backup = l;
-            }
-          }
-          /* Check if curr_best can be used as backup */
-          if(new_best != curr_best && (curr_best->link_options & LINK_OPTION_RX)) { /* Does curr_best have Rx flag? */
-            if(curr_backup == NULL || curr_best->slotframe_handle < curr_backup->slotframe_handle) {
-              curr_backup = curr_best;
-            }
-          }
-
-          /* Maintain curr_best */
-          if(new_best != NULL) {
-            curr_best = new_best;
-            best_frame  = sf;
-          }
-
-#ifdef TSCH_CALLBACK_LINK_SIGNAL
-          if ( (l->link_options & (LINK_OPTION_SIGNAL|LINK_OPTION_SIGNAL_ONCE)) != 0) {
-              signaling_link = l;
-          }
-#endif
-
+        tsch_slot_offset_t time_to_timeslot;
+        if(link_time_to(sf, l, timeslot, time_offset, &time_to_timeslot)) {
+          link_select(&s, sf, l, time_to_timeslot);
         }
       }//for(; l != NULL
     }//for(;sf != NULL
-    if (curr_best != NULL)
+    if (s.best != NULL)
     if(time_offset != NULL) {
       if (TSCH_SCHEDULE_POLICY & TSCH_SCHEDULE_OMMIT_NOXFER)
       if (*time_offset > 0)
-      if ((curr_best->link_options & LINK_OPTION_TIME_EB_ESCAPE) != 0)
+      if ((s.best->link_options & LINK_OPTION_TIME_EB_ESCAPE) != 0)
       {
           tsch_slot_offset_t timeslot = 0;
-          timeslot = TSCH_ASN_MOD(*asn, best_frame->size);
+          timeslot = TSCH_ASN_MOD(*asn, s.best_frame->size);
           // make fine calculation here using div
-          tsch_slot_offset_t sf_size = best_frame->size.val;
+          tsch_slot_offset_t sf_size = s.best_frame->size.val;
           tsch_slot_offset_t linktime = (*time_offset/sf_size);
           if (linktime >= TSCH_TIMESYNC_EB_LOOSES)
               linktime -= TSCH_TIMESYNC_EB_LOOSES;
           linktime = linktime * sf_size;
-          linktime += curr_best->timeslot;
+          linktime += s.best->timeslot;
           if (timeslot > linktime)
               linktime += sf_size;
-          time_to_curr_best = linktime - timeslot;
+          s.time_to_best = linktime - timeslot;
       }
-      assert(time_to_curr_best >= 0);
-      *time_offset = time_to_curr_best;
+      assert(s.time_to_best >= 0);
+      *time_offset = s.time_to_best;
     }
   }
   if(backup_link != NULL) {
-    *backup_link = curr_backup;
+    *backup_link = s.backup;
   }
 
 #ifdef TSCH_CALLBACK_LINK_SIGNAL
   // since need to signal
   if (signaling_link != NULL)
-      curr_best->link_options |= LINK_OPTION_SIGNAL_ONCE;
+      s.best->link_options |= LINK_OPTION_SIGNAL_ONCE;
 #endif
 
-  return curr_best;
+  return s.best;
 }
 /*---------------------------------------------------------------------------*/
 /* Module initialization, call only once at startup. Returns 1 is success, 0 if failure. */
@@ -102,6 +102,15 @@ typedef struct tsch_slotframe {
   struct tsch_asn_divisor_t size;
   /* List of links belonging to this slotframe */
   LIST_STRUCT(links_list);
+#if TSCH_SCHEDULE_WITH_CALENDAR
+  /* Links sorted by timeslot, links at the same timeslot are kept in
+   * the order they were added */
+  struct tsch_link *calendar[TSCH_SCHEDULE_MAX_LINKS];
+  uint16_t calendar_len;
+  /* Number of links with LINK_OPTION_TIME_EB_ESCAPE, their time depends
+   * on the time offset and is not known from the timeslot alone */
+  uint16_t escape_links;
+#endif /* TSCH_SCHEDULE_WITH_CALENDAR */
 } tsch_slotframe_t;
 
 /** \brief TSCH packet information */
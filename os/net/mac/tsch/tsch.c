@@ -184,9 +184,10 @@ int32_t max_drift_seen;
 
 /* TSCH processes and protothreads */
 PT_THREAD(tsch_scan(struct pt *pt));
-PROCESS(tsch_process, "TSCH: main process");
+PROCESS_PRIO(tsch_process, "TSCH: main process", PROCESS_PRIO_HIGH);
 PROCESS(tsch_send_eb_process, "TSCH: send EB process");
-PROCESS(tsch_pending_events_process, "TSCH: pending events process");
+PROCESS_PRIO(tsch_pending_events_process, "TSCH: pending events process",
+             PROCESS_PRIO_HIGH);
 
 /* Other function prototypes */
 static void packet_input(void);
@@ -89,6 +89,14 @@ static unsigned num_tables;
 MEMB(neighbor_addr_mem, nbr_table_key_t, NBR_TABLE_MAX_NEIGHBORS);
 LIST(nbr_table_keys);
 
+#if NBR_TABLE_HASH_INDEX
+/* Hash index over link-layer addresses: each slot holds a neighbor
+ * index or HASH_EMPTY. Collisions are resolved by linear probing. */
+#define HASH_EMPTY (-1)
+static int16_t hash_slots[NBR_TABLE_HASH_SIZE];
+static uint8_t hash_initialized;
+#endif /* NBR_TABLE_HASH_INDEX */
+
 
 
 #if NBR_CHECK_BOUNDS
@@ -162,17 +170,119 @@ key_from_item(nbr_table_t *table, const nbr_table_item_t *item)
 {
   return key_from_index(index_from_item(table, item));
 }
+#if NBR_TABLE_HASH_INDEX
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_lladdr(const linkaddr_t *lladdr)
+{
+  /* FNV-1a */
+  uint32_t h = 2166136261u;
+  int i;
+
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (h ^ lladdr->u8[i]) * 16777619u;
+  }
+  return h % NBR_TABLE_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_init(void)
+{
+  int i;
+
+  for(i = 0; i < NBR_TABLE_HASH_SIZE; i++) {
+    hash_slots[i] = HASH_EMPTY;
+  }
+  hash_initialized = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_add(const linkaddr_t *lladdr, nbr_idx_t index)
+{
+  unsigned slot;
+
+  if(!hash_initialized) {
+    hash_init();
+  }
+  slot = hash_lladdr(lladdr);
+  while(hash_slots[slot] != HASH_EMPTY) {
+    slot = (slot + 1) % NBR_TABLE_HASH_SIZE;
+  }
+  hash_slots[slot] = index;
+}
+/*---------------------------------------------------------------------------*/
+static nbr_idx_t
+hash_lookup(const linkaddr_t *lladdr)
+{
+  unsigned slot;
+  nbr_idx_t index;
+
+  if(!hash_initialized) {
+    return -1;
+  }
+  slot = hash_lladdr(lladdr);
+  while((index = hash_slots[slot]) != HASH_EMPTY) {
+    if(linkaddr_cmp(lladdr, &key_from_index(index)->lladdr)) {
+      return index;
+    }
+    slot = (slot + 1) % NBR_TABLE_HASH_SIZE;
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(nbr_table_key_t *key)
+{
+  unsigned slot;
+  unsigned next;
+  unsigned home;
+  nbr_idx_t index = index_from_key(key);
+
+  if(!hash_initialized) {
+    return;
+  }
+  slot = hash_lladdr(&key->lladdr);
+  while(hash_slots[slot] != index) {
+    if(hash_slots[slot] == HASH_EMPTY) {
+      return;
+    }
+    slot = (slot + 1) % NBR_TABLE_HASH_SIZE;
+  }
+
+  /* Backward-shift deletion: move later entries of the probe sequence
+   * into the hole so that lookups never need tombstones */
+  hash_slots[slot] = HASH_EMPTY;
+  next = (slot + 1) % NBR_TABLE_HASH_SIZE;
+  while(hash_slots[next] != HASH_EMPTY) {
+    home = hash_lladdr(&key_from_index(hash_slots[next])->lladdr);
+    /* The entry may move to the hole unless its home slot lies
+     * cyclically in (slot, next] */
+    if((slot <= next) ? (home <= slot || home > next)
+                      : (home <= slot && home > next)) {
+      hash_slots[slot] = hash_slots[next];
+      hash_slots[next] = HASH_EMPTY;
+      slot = next;
+    }
+    next = (next + 1) % NBR_TABLE_HASH_SIZE;
+  }
+}
+#endif /* NBR_TABLE_HASH_INDEX */
 /*---------------------------------------------------------------------------*/
 /* Get the index of a neighbor from its link-layer address */
 static nbr_idx_t
 index_from_lladdr(const linkaddr_t *lladdr)
 {
+#if !NBR_TABLE_HASH_INDEX
   nbr_table_key_t *key;
+#endif /* !NBR_TABLE_HASH_INDEX */
   /* Allow lladdr-free insertion, useful e.g. for IPv6 ND.
    * Only one such entry is possible at a time, indexed by linkaddr_null. */
   if(lladdr == NULL) {
     lladdr = &linkaddr_null;
   }
+#if NBR_TABLE_HASH_INDEX
+  return hash_lookup(lladdr);
+#else /* NBR_TABLE_HASH_INDEX */
   key = list_head(nbr_table_keys);
   while(key != NULL) {
     if(lladdr && linkaddr_cmp(lladdr, &key->lladdr)) {
@@ -181,6 +291,7 @@ index_from_lladdr(const linkaddr_t *lladdr)
     key = list_item_next(key);
   }
   return -1;
+#endif /* NBR_TABLE_HASH_INDEX */
 }
 /*---------------------------------------------------------------------------*/
 /* Get bit from "used" or "locked" bitmap */
@@ -248,6 +359,9 @@ remove_key(nbr_table_key_t *key, bool do_free)
   locked_map[index_from_key(key)] = 0;
   /* Remove neighbor from list */
   list_remove(nbr_table_keys, key);
+#if NBR_TABLE_HASH_INDEX
+  hash_remove(key);
+#endif /* NBR_TABLE_HASH_INDEX */
   if(do_free) {
     /* Release the memory */
     memb_free(&neighbor_addr_mem, key);
@@ -522,6 +636,9 @@ nbr_table_add_lladdr(nbr_table_t *table, const linkaddr_t *lladdr, nbr_table_rea
 
     /* Set link-layer address */
     linkaddr_copy(&key->lladdr, lladdr);
+#if NBR_TABLE_HASH_INDEX
+    hash_add(lladdr, index);
+#endif /* NBR_TABLE_HASH_INDEX */
   }
 
   LOG_DBG("set nbr ");
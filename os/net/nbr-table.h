@@ -72,6 +72,26 @@ typedef enum {
 #define NBR_TABLE_CAN_ACCEPT_NEW nbr_table_can_accept_new
 #endif /* NBR_TABLE_CONF_CAN_ACCEPT_NEW */
 
+/* Keep an open-addressing hash index over the link-layer addresses of
+ * all neighbors, so that lookups by address do not walk the key list.
+ * Useful with large NBR_TABLE_MAX_NEIGHBORS. */
+#ifdef NBR_TABLE_CONF_HASH_INDEX
+#define NBR_TABLE_HASH_INDEX NBR_TABLE_CONF_HASH_INDEX
+#else /* NBR_TABLE_CONF_HASH_INDEX */
+#define NBR_TABLE_HASH_INDEX 0
+#endif /* NBR_TABLE_CONF_HASH_INDEX */
+
+/* Number of hash index slots, must exceed NBR_TABLE_MAX_NEIGHBORS */
+#ifdef NBR_TABLE_CONF_HASH_SIZE
+#define NBR_TABLE_HASH_SIZE NBR_TABLE_CONF_HASH_SIZE
+#else /* NBR_TABLE_CONF_HASH_SIZE */
+#define NBR_TABLE_HASH_SIZE (2 * NBR_TABLE_MAX_NEIGHBORS)
+#endif /* NBR_TABLE_CONF_HASH_SIZE */
+
+#if NBR_TABLE_HASH_INDEX && NBR_TABLE_HASH_SIZE <= NBR_TABLE_MAX_NEIGHBORS
+#error "NBR_TABLE_CONF_HASH_SIZE must exceed NBR_TABLE_MAX_NEIGHBORS"
+#endif
+
 const linkaddr_t *NBR_TABLE_GC_GET_WORST(const linkaddr_t *lladdr1, const linkaddr_t *lladdr2);
 bool NBR_TABLE_CAN_ACCEPT_NEW(const linkaddr_t *new, const linkaddr_t *candidate_for_removal,
                               nbr_table_reason_t reason, void *data);
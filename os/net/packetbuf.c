@@ -47,9 +47,15 @@
 #include "contiki-net.h"
 #include "net/packetbuf.h"
 #include "net/rime/rime.h"
+#include "net/queuebuf.h"
 #include "sys/cc.h"
 #include "packetbuf.h"
 
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "Packetbuf"
+#define LOG_LEVEL LOG_LEVEL_MAC
+
 struct packetbuf_attr packetbuf_attrs[PACKETBUF_NUM_ATTRS];
 struct packetbuf_addr packetbuf_addrs[PACKETBUF_NUM_ADDRS];
 
@@ -69,9 +75,46 @@ uint8_t  packetbuf_hlen;
    an even 32-bit boundary. On some platforms (most notably the
    msp430 or OpenRISC), having a potentially misaligned packet buffer may lead to
    problems when accessing words. */
+#if PACKETBUF_WITH_POOL
+/* A pool buffer holds a packet at an offset, leaving headroom in front
+   of it. The packetbuf and the queuebufs holding the same packet share
+   the buffer. */
+struct packetbuf_pool_buf {
+  uint32_t data[(PACKETBUF_POOL_HEADROOM + PACKETBUF_SIZE + 3) / 4];
+  /* The lowest offset of a held packet, headers may be allocated in
+     front of it only */
+  uint16_t low;
+  uint8_t refs;
+};
+
+#ifdef PACKETBUF_CONF_POOL_NUM
+#define PACKETBUF_POOL_NUM PACKETBUF_CONF_POOL_NUM
+#else
+/* Every queuebuf may hold a buffer of its own, plus the packetbuf */
+#define PACKETBUF_POOL_NUM (QUEUEBUF_NUM + 1)
+#endif
+
+/* Nothing handles a pool that runs dry, so it must not */
+#if PACKETBUF_POOL_NUM < QUEUEBUF_NUM + 1
+#error "PACKETBUF_CONF_POOL_NUM must be at least QUEUEBUF_CONF_NUM + 1"
+#endif
+
+#define pool_base(b) ((uint8_t *)(b)->data)
+#define POOL_NO_HOLDER (PACKETBUF_POOL_HEADROOM + PACKETBUF_SIZE)
+
+static struct packetbuf_pool_buf pool[PACKETBUF_POOL_NUM] = {
+  { .low = POOL_NO_HOLDER, .refs = 1 }
+};
+
+/* The buffer used by the packetbuf */
+static struct packetbuf_pool_buf *packetbuf_buf = &pool[0];
+uint8_t *packetbuf_store = (uint8_t *)pool[0].data + PACKETBUF_POOL_HEADROOM;
+#define packetbuf   packetbuf_store
+#else
 uint32_t packetbuf_aligned[(PACKETBUF_SIZE + 3) / 4];
 uint8_t *packetbuf_store = (uint8_t *)packetbuf_aligned;
 #define packetbuf   ((uint8_t *)packetbuf_aligned)
+#endif /* PACKETBUF_WITH_POOL */
 
 uint8_t*      packetbuf_data;
 uint_fast16_t packetbuf_len;
@@ -85,10 +128,123 @@ uint_fast16_t packetbuf_len;
 #define PRINTF(...)
 #endif
 
+#if PACKETBUF_WITH_POOL
+/*---------------------------------------------------------------------------*/
+static struct packetbuf_pool_buf *
+pool_alloc(void)
+{
+  int i;
+
+  for(i = 0; i < PACKETBUF_POOL_NUM; i++) {
+    if(pool[i].refs == 0) {
+      pool[i].refs = 1;
+      pool[i].low = POOL_NO_HOLDER;
+      return &pool[i];
+    }
+  }
+  LOG_ERR("pool is empty\n");
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Copies the first len bytes of the packetbuf to a free buffer, at the
+   same offset, and makes the packetbuf use it */
+static int
+pool_move(uint16_t len)
+{
+  struct packetbuf_pool_buf *b;
+  uint8_t *store;
+
+  b = pool_alloc();
+  if(b == NULL) {
+    return 0;
+  }
+  store = pool_base(b) + (packetbuf_store - pool_base(packetbuf_buf));
+  memcpy(store, packetbuf_store, len);
+  packetbuf_data = store + (packetbuf_data - packetbuf_store);
+  packetbuf_pool_release(packetbuf_buf);
+  packetbuf_buf = b;
+  packetbuf_store = store;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+struct packetbuf_pool_buf *
+packetbuf_pool_hold(uint16_t *offset)
+{
+  packetbuf_compact();
+  *offset = packetbuf_store - pool_base(packetbuf_buf);
+  if(*offset < packetbuf_buf->low) {
+    packetbuf_buf->low = *offset;
+  }
+  packetbuf_buf->refs++;
+  return packetbuf_buf;
+}
+/*---------------------------------------------------------------------------*/
+void
+packetbuf_pool_release(struct packetbuf_pool_buf *b)
+{
+  if(b->refs > 0) {
+    b->refs--;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+packetbuf_pool_attach(struct packetbuf_pool_buf *b, uint16_t offset, uint16_t len)
+{
+  b->refs++;
+  packetbuf_pool_release(packetbuf_buf);
+  packetbuf_buf = b;
+  packetbuf_store = pool_base(b) + offset;
+
+  hdrlen = 0;
+  buflen = len;
+  packetbuf_len = len;
+  packetbuf_data = packetbuf_store;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t *
+packetbuf_pool_ptr(struct packetbuf_pool_buf *b, uint16_t offset)
+{
+  return pool_base(b) + offset;
+}
+/*---------------------------------------------------------------------------*/
+int
+packetbuf_unshare(uint16_t keep)
+{
+  if(packetbuf_buf->refs > 1) {
+    return pool_move(MIN(keep, PACKETBUF_SIZE));
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+packetbuf_pool_numfree(void)
+{
+  int i;
+  int n = 0;
+
+  for(i = 0; i < PACKETBUF_POOL_NUM; i++) {
+    if(pool[i].refs == 0) {
+      n++;
+    }
+  }
+  return n;
+}
+#endif /* PACKETBUF_WITH_POOL */
 /*---------------------------------------------------------------------------*/
 void
 packetbuf_clear(void)
 {
+#if PACKETBUF_WITH_POOL
+  if(packetbuf_buf->refs > 1) {
+    /* The held packet stays as it is, start over in a free buffer */
+    struct packetbuf_pool_buf *b = pool_alloc();
+    if(b != NULL) {
+      packetbuf_pool_release(packetbuf_buf);
+      packetbuf_buf = b;
+    }
+  }
+  packetbuf_store = pool_base(packetbuf_buf) + PACKETBUF_POOL_HEADROOM;
+#endif /* PACKETBUF_WITH_POOL */
   //bufptr = 0;
   hdrlen = 0;
   buflen = 0;
@@ -129,8 +285,32 @@ packetbuf_hdralloc(int size)
     return 0;
   }
 
+#if PACKETBUF_WITH_POOL
+  {
+    uint16_t offset = packetbuf_store - pool_base(packetbuf_buf);
+
+    if(offset >= size
+       && (packetbuf_buf->refs == 1 || packetbuf_buf->low >= offset)) {
+      /* Allocate the header in the headroom, nothing to move */
+      packetbuf_store -= size;
+      hdrlen += size;
+      packetbuf_len += size;
+      return 1;
+    }
+    if(packetbuf_buf->refs > 1 && !pool_move(packetbuf_totlen())) {
+      return 0;
+    }
+    /* Move the packet to the start of the buffer, leaving room for the
+       header in front of it */
+    offset = packetbuf_store - pool_base(packetbuf_buf);
+    memmove(pool_base(packetbuf_buf) + size, packetbuf_store, packetbuf_totlen());
+    packetbuf_data -= offset;
+    packetbuf_store = pool_base(packetbuf_buf);
+  }
+#else
   /* shift data to the right */
   memmove(&packetbuf[size], packetbuf, packetbuf_totlen());
+#endif /* PACKETBUF_WITH_POOL */
   hdrlen += size;
   packetbuf_data += size;
   packetbuf_len += size;
@@ -153,6 +333,11 @@ void packetbuf_compact(void)
 {
   int bufptr = packetbuf_hdrlen() - hdrlen;
   if(bufptr > 0) {
+#if PACKETBUF_WITH_POOL
+    if(packetbuf_buf->refs > 1) {
+      pool_move(packetbuf_totlen());
+    }
+#endif /* PACKETBUF_WITH_POOL */
     /* shift data to the left */
     memmove(&packetbuf[hdrlen], packetbuf_data, buflen);
     packetbuf_data = &packetbuf[hdrlen];
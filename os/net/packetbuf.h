@@ -67,6 +67,32 @@
 #define PACKETBUF_SIZE 128
 #endif
 
+/**
+ * \brief      Keep the packetbuf and queued packets in a pool of
+ *             reference-counted buffers, so that queuing a packet and
+ *             restoring it to the packetbuf do not copy it
+ *
+ *             Code that writes into the packetbuf directly must start
+ *             with packetbuf_clear() or packetbuf_copyfrom(), or call
+ *             packetbuf_unshare(), when the packetbuf may still share
+ *             its buffer with a queuebuf.
+ */
+#ifdef PACKETBUF_CONF_WITH_POOL
+#define PACKETBUF_WITH_POOL PACKETBUF_CONF_WITH_POOL
+#else
+#define PACKETBUF_WITH_POOL 0
+#endif
+
+/**
+ * \brief      The room in front of a packet in a pool buffer, where
+ *             headers are allocated without moving the packet
+ */
+#ifdef PACKETBUF_CONF_POOL_HEADROOM
+#define PACKETBUF_POOL_HEADROOM PACKETBUF_CONF_POOL_HEADROOM
+#else
+#define PACKETBUF_POOL_HEADROOM 32
+#endif
+
 #ifdef PACKETBUF_CONF_WITH_PACKET_TYPE
 #define PACKETBUF_WITH_PACKET_TYPE PACKETBUF_CONF_WITH_PACKET_TYPE
 #else
@@ -114,8 +140,13 @@ void* packetbuf_dataptr(void){
  */
 static inline
 void* packetbuf_hdrptr(void){
+#if PACKETBUF_WITH_POOL
+    extern uint8_t *packetbuf_store;
+    return packetbuf_store;
+#else
     extern uint32_t packetbuf_aligned[];
     return (void*)packetbuf_aligned;
+#endif
 }
 
 /**
@@ -244,6 +275,61 @@ int packetbuf_hdrreduce(int size);
  */
 void packetbuf_compact(void);
 
+#if PACKETBUF_WITH_POOL
+/** \brief A buffer of the packet buffer pool */
+struct packetbuf_pool_buf;
+
+/**
+ * \brief      Take a reference to the buffer holding the packetbuf
+ * \param offset Set to the offset of the packet in the buffer
+ * \return     The buffer, holding packetbuf_totlen() bytes of packet
+ *
+ *             The header and data of the packetbuf are made consecutive
+ *             first. The packetbuf keeps using the buffer until it is
+ *             cleared; it allocates headers in front of the held packet
+ *             and moves to another buffer before modifying it.
+ */
+struct packetbuf_pool_buf *packetbuf_pool_hold(uint16_t *offset);
+
+/**
+ * \brief      Release a reference taken with packetbuf_pool_hold()
+ */
+void packetbuf_pool_release(struct packetbuf_pool_buf *b);
+
+/**
+ * \brief      Make the packetbuf refer to a held packet
+ * \param b    The buffer holding the packet
+ * \param offset The offset of the packet in the buffer
+ * \param len  The length of the packet
+ *
+ *             The result is the same as with packetbuf_copyfrom() but
+ *             the packet is not copied. Packet attributes are not
+ *             changed.
+ */
+void packetbuf_pool_attach(struct packetbuf_pool_buf *b, uint16_t offset, uint16_t len);
+
+/**
+ * \brief      Get a pointer to a held packet
+ */
+uint8_t *packetbuf_pool_ptr(struct packetbuf_pool_buf *b, uint16_t offset);
+
+/**
+ * \brief      Move the packetbuf to a buffer of its own if it shares one
+ * \param keep The number of leading bytes of the packet to keep, the
+ *             rest of the packetbuf content is undefined afterwards
+ * \retval     Non-zero if the packetbuf can be written to
+ *
+ *             Pointers to the packetbuf content must be taken again
+ *             after this call.
+ */
+int packetbuf_unshare(uint16_t keep);
+
+/**
+ * \brief      Get the number of free buffers in the pool
+ */
+int packetbuf_pool_numfree(void);
+#endif /* PACKETBUF_WITH_POOL */
+
 /* Packet attributes stuff below: */
 
 typedef uint16_t packetbuf_attr_t;
@@ -49,8 +49,34 @@
 #include "cfs/cfs.h"
 #endif
 
+#if PACKETBUF_WITH_POOL
+#include "net/mac/llsec802154.h"
+#if WITH_SWAP
+#error "PACKETBUF_CONF_WITH_POOL does not support swapping queuebufs to CFS"
+#endif
+#endif /* PACKETBUF_WITH_POOL */
+
 #include <string.h> /* for memcpy() */
 
+#if PACKETBUF_WITH_POOL
+/* Structure holding a packet in a packetbuf pool buffer, shared with
+   the packetbuf and other queuebufs */
+struct queuebuf {
+#if QUEUEBUF_DEBUG
+  struct queuebuf *next;
+  const char *file;
+  int line;
+  clock_time_t time;
+#endif /* QUEUEBUF_DEBUG */
+  struct packetbuf_pool_buf *pbuf;
+  uint16_t offset;
+  uint16_t len;
+  struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+};
+
+MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
+#else /* PACKETBUF_WITH_POOL */
 /* Structure pointing to a buffer either stored
    in RAM or swapped in CFS */
 struct queuebuf {
@@ -81,6 +107,7 @@ struct queuebuf_data {
 
 MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
 MEMB(buframmem, struct queuebuf_data, QUEUEBUFRAM_NUM);
+#endif /* PACKETBUF_WITH_POOL */
 
 #if WITH_SWAP
 
@@ -269,7 +296,7 @@ queuebuf_load_to_ram(struct queuebuf *b)
     }
   }
 }
-#else /* WITH_SWAP */
+#elif !PACKETBUF_WITH_POOL
 /*---------------------------------------------------------------------------*/
 static struct queuebuf_data *
 queuebuf_load_to_ram(struct queuebuf *b)
@@ -288,7 +315,9 @@ queuebuf_init(void)
     qbuf_renew_file(i);
   }
 #endif
+#if !PACKETBUF_WITH_POOL
   memb_init(&buframmem);
+#endif /* !PACKETBUF_WITH_POOL */
   memb_init(&bufmem);
 #if QUEUEBUF_STATS
   queuebuf_max_len = 0;
@@ -311,7 +340,9 @@ queuebuf_new_from_packetbuf(void)
 {
   struct queuebuf *buf;
 
+#if !PACKETBUF_WITH_POOL
   struct queuebuf_data *buframptr;
+#endif /* !PACKETBUF_WITH_POOL */
   buf = memb_alloc(&bufmem);
   if(buf != NULL) {
 #if QUEUEBUF_DEBUG
@@ -320,6 +351,12 @@ queuebuf_new_from_packetbuf(void)
     buf->line = line;
     buf->time = clock_time();
 #endif /* QUEUEBUF_DEBUG */
+#if PACKETBUF_WITH_POOL
+    /* Share the packet with the packetbuf, copy only its attributes */
+    buf->pbuf = packetbuf_pool_hold(&buf->offset);
+    buf->len = packetbuf_totlen();
+    packetbuf_attr_copyto(buf->attrs, buf->addrs);
+#else /* PACKETBUF_WITH_POOL */
     buf->ram_ptr = memb_alloc(&buframmem);
 #if WITH_SWAP
     /* If the allocation failed, store the qbuf in swap files */
@@ -353,6 +390,7 @@ queuebuf_new_from_packetbuf(void)
       }
     }
 #endif
+#endif /* PACKETBUF_WITH_POOL */
 
 #if QUEUEBUF_STATS
     ++queuebuf_len;
@@ -371,6 +409,9 @@ queuebuf_new_from_packetbuf(void)
 void
 queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
 {
+#if PACKETBUF_WITH_POOL
+  packetbuf_attr_copyto(buf->attrs, buf->addrs);
+#else /* PACKETBUF_WITH_POOL */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
 #if WITH_SWAP
@@ -378,11 +419,18 @@ queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
     queuebuf_flush_tmpdata();
   }
 #endif
+#endif /* PACKETBUF_WITH_POOL */
 }
 /*---------------------------------------------------------------------------*/
 void
 queuebuf_update_from_packetbuf(struct queuebuf *buf)
 {
+#if PACKETBUF_WITH_POOL
+  packetbuf_attr_copyto(buf->attrs, buf->addrs);
+  packetbuf_pool_release(buf->pbuf);
+  buf->pbuf = packetbuf_pool_hold(&buf->offset);
+  buf->len = packetbuf_totlen();
+#else /* PACKETBUF_WITH_POOL */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
   buframptr->len = packetbuf_copyto(buframptr->data);
@@ -391,13 +439,16 @@ queuebuf_update_from_packetbuf(struct queuebuf *buf)
     queuebuf_flush_tmpdata();
   }
 #endif
+#endif /* PACKETBUF_WITH_POOL */
 }
 /*---------------------------------------------------------------------------*/
 void
 queuebuf_free(struct queuebuf *buf)
 {
   if(memb_inmemb(&bufmem, buf)) {
-#if WITH_SWAP
+#if PACKETBUF_WITH_POOL
+    packetbuf_pool_release(buf->pbuf);
+#elif WITH_SWAP
     if(buf->location == IN_RAM) {
       memb_free(&buframmem, buf->ram_ptr);
     } else {
@@ -421,9 +472,18 @@ void
 queuebuf_to_packetbuf(struct queuebuf *b)
 {
   if(memb_inmemb(&bufmem, b)) {
+#if PACKETBUF_WITH_POOL
+    packetbuf_pool_attach(b->pbuf, b->offset, b->len);
+#if LLSEC802154_ENABLED
+    /* The frame is secured in place */
+    packetbuf_unshare(b->len);
+#endif /* LLSEC802154_ENABLED */
+    packetbuf_attr_copyfrom(b->attrs, b->addrs);
+#else /* PACKETBUF_WITH_POOL */
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
     packetbuf_copyfrom(buframptr->data, buframptr->len);
     packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
+#endif /* PACKETBUF_WITH_POOL */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -431,8 +491,12 @@ void *
 queuebuf_dataptr(struct queuebuf *b)
 {
   if(memb_inmemb(&bufmem, b)) {
+#if PACKETBUF_WITH_POOL
+    return packetbuf_pool_ptr(b->pbuf, b->offset);
+#else /* PACKETBUF_WITH_POOL */
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
     return buframptr->data;
+#endif /* PACKETBUF_WITH_POOL */
   }
   return NULL;
 }
@@ -440,22 +504,34 @@ queuebuf_dataptr(struct queuebuf *b)
 int
 queuebuf_datalen(struct queuebuf *b)
 {
+#if PACKETBUF_WITH_POOL
+  return b->len;
+#else /* PACKETBUF_WITH_POOL */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
   return buframptr->len;
+#endif /* PACKETBUF_WITH_POOL */
 }
 /*---------------------------------------------------------------------------*/
 linkaddr_t *
 queuebuf_addr(struct queuebuf *b, uint8_t type)
 {
+#if PACKETBUF_WITH_POOL
+  return &b->addrs[type - PACKETBUF_ADDR_FIRST].addr;
+#else /* PACKETBUF_WITH_POOL */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
   return &buframptr->addrs[type - PACKETBUF_ADDR_FIRST].addr;
+#endif /* PACKETBUF_WITH_POOL */
 }
 /*---------------------------------------------------------------------------*/
 packetbuf_attr_t
 queuebuf_attr(struct queuebuf *b, uint8_t type)
 {
+#if PACKETBUF_WITH_POOL
+  return b->attrs[type].val;
+#else /* PACKETBUF_WITH_POOL */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
   return buframptr->attrs[type].val;
+#endif /* PACKETBUF_WITH_POOL */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -277,18 +277,6 @@ rpl_ext_header_srh_update(void)
 }
 /*---------------------------------------------------------------------------*/
 static int
-count_matching_bytes(const void *p1, const void *p2, size_t n)
-{
-  int i = 0;
-  for(i = 0; i < n; i++) {
-    if(((uint8_t *)p1)[i] != ((uint8_t *)p2)[i]) {
-      return i;
-    }
-  }
-  return n;
-}
-/*---------------------------------------------------------------------------*/
-static int
 insert_srh_header(void)
 {
   /* Implementation of RFC6554 */
@@ -333,38 +321,18 @@ insert_srh_header(void)
     return 0;
   }
 
-  if(!uip_sr_is_addr_reachable(dag, &UIP_IP_BUF->destipaddr)) {
+  /* Compute path length and compression factors (we use cmpri == cmpre) */
+  if(!uip_sr_get_path(dest_node, root_node, &path_len, &cmpri)) {
     LOG_ERR("SRH no path found to destination\n");
     return 0;
   }
+  cmpre = cmpri;
 
-  /* Compute path length and compression factors (we use cmpri == cmpre) */
-  path_len = 0;
-  node = dest_node->parent;
-  /* For simplicity, we use cmpri = cmpre */
-  cmpri = 15;
-  cmpre = 15;
-
-  if(node == root_node) {
+  if(dest_node->parent == root_node) {
     LOG_DBG("SRH no need to insert SRH\n");
     return 1;
   }
 
-  while(node != NULL && node != root_node) {
-
-    NETSTACK_ROUTING.get_sr_node_ipaddr(&node_addr, node);
-
-    /* How many bytes in common between all nodes in the path? */
-    cmpri = MIN(cmpri, count_matching_bytes(&node_addr, &UIP_IP_BUF->destipaddr, 16));
-    cmpre = cmpri;
-
-    LOG_DBG("SRH Hop ");
-    LOG_DBG_6ADDR(&node_addr);
-    LOG_DBG_("\n");
-    node = node->parent;
-    path_len++;
-  }
-
   /* Extension header length: fixed headers + (n-1) * (16-ComprI) + (16-ComprE)*/
   ext_len = RPL_RH_LEN + RPL_SRH_LEN
       + (path_len - 1) * (16 - cmpre)
@@ -411,6 +379,10 @@ insert_srh_header(void)
     hop_ptr -= (16 - cmpri);
     memcpy(hop_ptr, ((uint8_t*)&node_addr) + cmpri, 16 - cmpri);
 
+    LOG_DBG("SRH Hop ");
+    LOG_DBG_6ADDR(&node_addr);
+    LOG_DBG_("\n");
+
     node = node->parent;
   }
 
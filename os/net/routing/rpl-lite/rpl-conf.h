@@ -406,6 +406,26 @@
 #define RPL_LOOP_ERROR_DROP 0
 #endif /* RPL_CONF_LOOP_ERROR_DROP */
 
+/*
+ * Keep the neighbors in a parent candidate set ordered by path cost.
+ * A neighbor is only re-positioned when a DIO or a transmission changes
+ * its rank or link metric, and the best parent selection only evaluates
+ * the head of the set instead of every neighbor.
+ */
+#ifdef RPL_CONF_WITH_PARENT_SET
+#define RPL_WITH_PARENT_SET RPL_CONF_WITH_PARENT_SET
+#else /* RPL_CONF_WITH_PARENT_SET */
+#define RPL_WITH_PARENT_SET 0
+#endif /* RPL_CONF_WITH_PARENT_SET */
+
+/* Count best parent selections and full re-evaluations of all neighbors
+ * in rpl_parent_selection_stats */
+#ifdef RPL_CONF_PARENT_SELECTION_STATS
+#define RPL_PARENT_SELECTION_STATS RPL_CONF_PARENT_SELECTION_STATS
+#else /* RPL_CONF_PARENT_SELECTION_STATS */
+#define RPL_PARENT_SELECTION_STATS 0
+#endif /* RPL_CONF_PARENT_SELECTION_STATS */
+
 /** @} */
 
 #endif /* RPL_CONF_H */
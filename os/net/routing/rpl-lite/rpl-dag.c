@@ -138,6 +138,10 @@ void
 rpl_dag_periodic(unsigned seconds)
 {
   if(curr_instance.used) {
+    /* Catch up with link metrics that changed without a DIO or a
+       transmission, e.g., when link statistics were added or removed */
+    rpl_neighbor_refresh_all();
+
     if(curr_instance.dag.lifetime != RPL_LIFETIME(RPL_INFINITE_LIFETIME)) {
       curr_instance.dag.lifetime =
         curr_instance.dag.lifetime > seconds ? curr_instance.dag.lifetime - seconds : 0;
@@ -393,6 +397,7 @@ update_nbr_from_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 #if RPL_WITH_MC
   memcpy(&nbr->mc, &dio->mc, sizeof(nbr->mc));
 #endif /* RPL_WITH_MC */
+  rpl_neighbor_update(nbr);
 
   return nbr;
 }
@@ -515,6 +520,9 @@ init_dag(uint8_t instance_id, uip_ipaddr_t *dag_id, rpl_ocp_t ocp,
   curr_instance.dag.dao_last_seqno = RPL_LOLLIPOP_INIT;
   memcpy(&curr_instance.dag.dag_id, dag_id, sizeof(curr_instance.dag.dag_id));
 
+  /* The path costs of all neighbors depend on the instance */
+  rpl_neighbor_update_all();
+
   return 1;
 }
 /*---------------------------------------------------------------------------*/
@@ -700,6 +708,7 @@ rpl_process_hbh(rpl_nbr_t *sender, uint16_t sender_rank, int loop_detected, int
      * the sender's rank from ext header */
     if(sender != NULL) {
       sender->rank = sender_rank;
+      rpl_neighbor_update(sender);
       /* Select DAG and preferred parent. In case of a parent switch,
       the new parent will be used to forward the current packet. */
       rpl_dag_update_state();
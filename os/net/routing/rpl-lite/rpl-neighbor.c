@@ -64,6 +64,20 @@ static rpl_nbr_t * best_parent(int fresh_only);
 /* Per-neighbor RPL information */
 NBR_TABLE_GLOBAL(rpl_nbr_t, rpl_neighbors);
 
+#if RPL_WITH_PARENT_SET
+/* All neighbors, in increasing path cost order */
+static rpl_nbr_t *candidates;
+/* Zero when the path costs must all be evaluated again */
+static uint8_t candidates_valid;
+#endif /* RPL_WITH_PARENT_SET */
+
+#if RPL_PARENT_SELECTION_STATS
+rpl_parent_selection_stats_t rpl_parent_selection_stats;
+#define PARENT_STATS_ADD(field, n) rpl_parent_selection_stats.field += (n)
+#else /* RPL_PARENT_SELECTION_STATS */
+#define PARENT_STATS_ADD(field, n)
+#endif /* RPL_PARENT_SELECTION_STATS */
+
 /*---------------------------------------------------------------------------*/
 static int
 max_acceptable_rank(void)
@@ -190,6 +204,96 @@ rpl_get_ds6_nbr(rpl_nbr_t *nbr)
 }
 #endif /* UIP_ND6_SEND_NS */
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_PARENT_SET
+static void
+candidate_remove(rpl_nbr_t *nbr)
+{
+  rpl_nbr_t **p;
+
+  for(p = &candidates; *p != NULL; p = &(*p)->next_candidate) {
+    if(*p == nbr) {
+      *p = nbr->next_candidate;
+      break;
+    }
+  }
+  nbr->next_candidate = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+candidate_insert(rpl_nbr_t *nbr)
+{
+  rpl_nbr_t **p;
+
+  nbr->candidate_cost = curr_instance.of->nbr_path_cost(nbr);
+  for(p = &candidates;
+      *p != NULL && (*p)->candidate_cost <= nbr->candidate_cost;
+      p = &(*p)->next_candidate);
+  nbr->next_candidate = *p;
+  *p = nbr;
+}
+/*---------------------------------------------------------------------------*/
+static void
+candidates_rebuild(void)
+{
+  rpl_nbr_t *nbr;
+
+  candidates = NULL;
+  for(nbr = nbr_table_head(rpl_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    candidate_insert(nbr);
+  }
+  candidates_valid = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+candidates_refresh(void)
+{
+  rpl_nbr_t *nbr;
+
+  /* Re-position only the neighbors whose path cost changed */
+  for(nbr = nbr_table_head(rpl_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    if(nbr->candidate_cost != curr_instance.of->nbr_path_cost(nbr)) {
+      candidate_remove(nbr);
+      candidate_insert(nbr);
+      PARENT_STATS_ADD(updates, 1);
+    }
+  }
+}
+#endif /* RPL_WITH_PARENT_SET */
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update(rpl_nbr_t *nbr)
+{
+#if RPL_WITH_PARENT_SET
+  if(nbr != NULL && curr_instance.used && candidates_valid) {
+    candidate_remove(nbr);
+    candidate_insert(nbr);
+    PARENT_STATS_ADD(updates, 1);
+  }
+#endif /* RPL_WITH_PARENT_SET */
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update_all(void)
+{
+#if RPL_WITH_PARENT_SET
+  candidates_valid = 0;
+#endif /* RPL_WITH_PARENT_SET */
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_refresh_all(void)
+{
+#if RPL_WITH_PARENT_SET
+  if(curr_instance.used && candidates_valid) {
+    candidates_refresh();
+  }
+#endif /* RPL_WITH_PARENT_SET */
+}
+/*---------------------------------------------------------------------------*/
 static void
 remove_neighbor(rpl_nbr_t *nbr)
 {
@@ -205,6 +309,9 @@ remove_neighbor(rpl_nbr_t *nbr)
   if(nbr == curr_instance.dag.unicast_dio_target) {
     curr_instance.dag.unicast_dio_target = NULL;
   }
+#if RPL_WITH_PARENT_SET
+  candidate_remove(nbr);
+#endif /* RPL_WITH_PARENT_SET */
   rpl_neighbors_remove_item(nbr);
   rpl_timers_schedule_state_update(); /* Updating from here is unsafe; postpone */
 }
@@ -336,36 +443,107 @@ rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr)
   return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)lladdr);
 }
 /*---------------------------------------------------------------------------*/
+static int
+is_candidate(rpl_nbr_t *nbr, int fresh_only)
+{
+  if(!acceptable_rank(rpl_neighbor_rank_via_nbr(nbr))
+    || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+    /* Exclude neighbors with a rank that is not acceptable */
+    return 0;
+  }
+
+  if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
+    /* Filter out non-fresh nerighbors if fresh_only is set */
+    return 0;
+  }
+
+#if UIP_ND6_SEND_NS
+  /* Exclude links to a neighbor that is not reachable at a NUD level */
+  if(rpl_get_ds6_nbr(nbr) == NULL) {
+    return 0;
+  }
+#endif /* UIP_ND6_SEND_NS */
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_PARENT_SET
+/*
+ * Only the neighbors at the head of the candidate set can win: the OF
+ * never prefers a neighbor with a higher path cost than both the
+ * preferred parent and the cheapest candidate. The search folds these
+ * through the OF, so the OF still applies its hysteresis.
+ */
 static rpl_nbr_t *
 best_parent(int fresh_only)
 {
   rpl_nbr_t *nbr;
   rpl_nbr_t *best = NULL;
+  rpl_nbr_t *preferred;
+  uint16_t max_cost = 0;
 
   if(curr_instance.used == 0) {
     return NULL;
   }
 
-  /* Search for the best parent according to the OF */
-  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+  PARENT_STATS_ADD(selections, 1);
+  if(!candidates_valid) {
+    candidates_rebuild();
+    PARENT_STATS_ADD(full_evaluations, 1);
+  }
 
-    if(!acceptable_rank(rpl_neighbor_rank_via_nbr(nbr))
-      || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
-      /* Exclude neighbors with a rank that is not acceptable */
-      continue;
+  preferred = curr_instance.dag.preferred_parent;
+  if(preferred != NULL && is_candidate(preferred, fresh_only)) {
+    best = preferred;
+    max_cost = curr_instance.of->nbr_path_cost(preferred);
+  }
+
+  for(nbr = candidates; nbr != NULL; nbr = nbr->next_candidate) {
+    if(best != NULL && nbr->candidate_cost > max_cost) {
+      break;
+    }
+    PARENT_STATS_ADD(evaluated, 1);
+
+    if(nbr->candidate_cost != curr_instance.of->nbr_path_cost(nbr)) {
+      /* A path cost changed without an update: re-position the
+         neighbors whose cost changed and search again */
+      candidates_refresh();
+      return best_parent(fresh_only);
     }
 
-    if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
-      /* Filter out non-fresh nerighbors if fresh_only is set */
+    if(nbr == preferred || !is_candidate(nbr, fresh_only)) {
       continue;
     }
 
-#if UIP_ND6_SEND_NS
-    /* Exclude links to a neighbor that is not reachable at a NUD level */
-    if(rpl_get_ds6_nbr(nbr) == NULL) {
+    if(best == NULL) {
+      max_cost = nbr->candidate_cost;
+    }
+    /* Now we have an acceptable parent, check if it is the new best */
+    best = curr_instance.of->best_parent(best, nbr);
+  }
+
+  return best;
+}
+#else /* RPL_WITH_PARENT_SET */
+static rpl_nbr_t *
+best_parent(int fresh_only)
+{
+  rpl_nbr_t *nbr;
+  rpl_nbr_t *best = NULL;
+
+  if(curr_instance.used == 0) {
+    return NULL;
+  }
+
+  PARENT_STATS_ADD(selections, 1);
+  PARENT_STATS_ADD(full_evaluations, 1);
+
+  /* Search for the best parent according to the OF */
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    PARENT_STATS_ADD(evaluated, 1);
+    if(!is_candidate(nbr, fresh_only)) {
       continue;
     }
-#endif /* UIP_ND6_SEND_NS */
 
     /* Now we have an acceptable parent, check if it is the new best */
     best = curr_instance.of->best_parent(best, nbr);
@@ -373,6 +551,7 @@ best_parent(int fresh_only)
 
   return best;
 }
+#endif /* RPL_WITH_PARENT_SET */
 /*---------------------------------------------------------------------------*/
 rpl_nbr_t *
 rpl_neighbor_select_best(void)
@@ -167,6 +167,38 @@ rpl_nbr_t *rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr);
 */
 int rpl_neighbor_count(void);
 
+/**
+ * Updates the position of a neighbor in the parent candidate set. Must be
+ * called whenever the rank, metric container or link metric of the
+ * neighbor changes.
+ *
+ * \param nbr The neighbor
+*/
+void rpl_neighbor_update(rpl_nbr_t *nbr);
+
+/**
+ * Re-evaluates all neighbors at the next parent selection, when a change
+ * of the instance or the objective function affects all path costs.
+*/
+void rpl_neighbor_update_all(void);
+
+/**
+ * Re-positions the neighbors whose path cost changed without a call to
+ * rpl_neighbor_update, e.g., when their link statistics were removed.
+*/
+void rpl_neighbor_refresh_all(void);
+
+#if RPL_PARENT_SELECTION_STATS
+typedef struct rpl_parent_selection_stats {
+  uint32_t selections;        /* Best parent searches */
+  uint32_t full_evaluations;  /* Searches that evaluated all neighbors */
+  uint32_t evaluated;         /* Neighbors evaluated by all searches */
+  uint32_t updates;           /* Single neighbor updates of the set */
+} rpl_parent_selection_stats_t;
+
+extern rpl_parent_selection_stats_t rpl_parent_selection_stats;
+#endif /* RPL_PARENT_SELECTION_STATS */
+
 /**
  * Prints a summary of all RPL neighbors and their properties
  *
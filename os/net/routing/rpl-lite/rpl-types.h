@@ -142,6 +142,11 @@ struct rpl_nbr {
 #endif /* RPL_WITH_MC */
   rpl_rank_t rank;
   uint8_t dtsn;
+#if RPL_WITH_PARENT_SET
+  struct rpl_nbr *next_candidate; /* The next neighbor in the parent
+  candidate set, which has the same or a higher path cost */
+  uint16_t candidate_cost; /* The path cost when last positioned */
+#endif /* RPL_WITH_PARENT_SET */
 };
 typedef struct rpl_nbr rpl_nbr_t;
 
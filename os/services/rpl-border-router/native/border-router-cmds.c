@@ -170,6 +170,12 @@ border_router_cmd_handler(const uint8_t *data, int len)
                data[2], data[3], data[4]);
         packet_sent(data[2], data[3], data[4]);
         return 1;
+#if BORDER_ROUTER_MAC_TX_WINDOW
+      case 'W':
+        LOG_DBG("Radio transmit window %d\n", data[2]);
+        border_router_mac_set_window(data[2]);
+        return 1;
+#endif /* BORDER_ROUTER_MAC_TX_WINDOW */
       default:
       return 0;
       }
@@ -42,6 +42,7 @@
 #include "net/netstack.h"
 #include "packetutils.h"
 #include "border-router.h"
+#include "sys/ctimer.h"
 #include <string.h>
 
 /*---------------------------------------------------------------------------*/
@@ -51,7 +52,30 @@
 #define LOG_LEVEL LOG_LEVEL_NONE
 
 #define MAX_CALLBACKS 16
+
+/* 3 bytes per packet attribute is required for serialization */
+#define FRAME_SIZE (PACKETBUF_NUM_ATTRS * 3 + PACKETBUF_SIZE + 3)
+
+#if BORDER_ROUTER_MAC_TX_WINDOW
+/* Session ids count up to 255 and map onto the callbacks, so a report
+   for a session that was reaped cannot complete a newer one */
+static uint8_t next_sid;
+/* Callbacks waiting for the window, oldest first */
+static uint8_t release_queue[MAX_CALLBACKS];
+static uint8_t release_head;
+static uint8_t queued;
+static uint8_t in_flight;
+static uint8_t tx_window;
+static struct ctimer reap_timer;
+
+enum {
+  TX_FREE,
+  TX_QUEUED,
+  TX_SENT,
+};
+#else /* BORDER_ROUTER_MAC_TX_WINDOW */
 static int callback_pos;
+#endif /* BORDER_ROUTER_MAC_TX_WINDOW */
 
 /* a structure for calling back when packet data is coming back
    from radio... */
@@ -60,9 +84,24 @@ struct tx_callback {
   void *ptr;
   struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
   struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+#if BORDER_ROUTER_MAC_TX_WINDOW
+  clock_time_t sent_at;
+  uint8_t sid;
+  uint8_t state;
+  uint16_t len;
+  /* The frame as it goes over SLIP, kept until the window lets it out */
+  uint8_t frame[FRAME_SIZE];
+#endif /* BORDER_ROUTER_MAC_TX_WINDOW */
 };
 /*---------------------------------------------------------------------------*/
 static struct tx_callback callbacks[MAX_CALLBACKS];
+
+#if BORDER_ROUTER_MAC_STATS
+border_router_mac_stats_t border_router_mac_stats;
+#define MAC_STATS_ADD(field, n) border_router_mac_stats.field += (n)
+#else
+#define MAC_STATS_ADD(field, n)
+#endif /* BORDER_ROUTER_MAC_STATS */
 /*---------------------------------------------------------------------------*/
 void
 init_sec(void)
@@ -78,6 +117,205 @@ init_sec(void)
 }
 /*---------------------------------------------------------------------------*/
 
+#if BORDER_ROUTER_MAC_TX_WINDOW
+static void reap(void *ptr);
+/*---------------------------------------------------------------------------*/
+/* Send queued frames while the radio has room for them */
+static void
+release_frames(void)
+{
+  struct tx_callback *callback;
+
+  while(queued > 0 && in_flight < tx_window) {
+    callback = &callbacks[release_queue[release_head]];
+    /* Worst case every byte is escaped */
+    if(slip_tx_space() < 2 * callback->len + 1) {
+      break;
+    }
+    release_head = (release_head + 1) % MAX_CALLBACKS;
+    queued--;
+    in_flight++;
+    callback->state = TX_SENT;
+    callback->sent_at = clock_time();
+    /* Frames released together leave in one write to the radio */
+    write_to_slip(callback->frame, callback->len);
+    MAC_STATS_ADD(frames_sent, 1);
+  }
+
+  /* Reports or the reaper let out the rest */
+  if((in_flight > 0 || queued > 0) && ctimer_expired(&reap_timer)) {
+    ctimer_set(&reap_timer, BORDER_ROUTER_MAC_TX_TIMEOUT / 2, reap, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+complete(struct tx_callback *callback, uint8_t status, uint8_t tx)
+{
+  mac_callback_t cback = callback->cback;
+  void *ptr = callback->ptr;
+
+#if BORDER_ROUTER_MAC_STATS
+  {
+    clock_time_t latency = clock_time() - callback->sent_at;
+
+    border_router_mac_stats.latency_total += latency;
+    if(latency > border_router_mac_stats.latency_max) {
+      border_router_mac_stats.latency_max = latency;
+    }
+  }
+#endif /* BORDER_ROUTER_MAC_STATS */
+
+  packetbuf_clear();
+  packetbuf_attr_copyfrom(callback->attrs, callback->addrs);
+  /* The callback may send the next fragment into this slot */
+  callback->state = TX_FREE;
+  in_flight--;
+  mac_call_sent_callback(cback, ptr, status, tx);
+}
+/*---------------------------------------------------------------------------*/
+/* Give up on frames the radio has not reported in time */
+static void
+reap(void *ptr)
+{
+  clock_time_t now = clock_time();
+  int i;
+
+  for(i = 0; i < MAX_CALLBACKS; i++) {
+    if(callbacks[i].state == TX_SENT &&
+       now - callbacks[i].sent_at >= BORDER_ROUTER_MAC_TX_TIMEOUT) {
+      LOG_WARN("no report for sid %u\n", callbacks[i].sid);
+      MAC_STATS_ADD(timeouts, 1);
+      complete(&callbacks[i], MAC_TX_ERR, 1);
+    }
+  }
+  release_frames();
+}
+/*---------------------------------------------------------------------------*/
+void
+border_router_mac_set_window(uint8_t window)
+{
+  LOG_INFO("radio transmit window %u\n", window);
+  if(window > MAX_CALLBACKS) {
+    window = MAX_CALLBACKS;
+  }
+  if(window > 0) {
+    tx_window = window;
+#if BORDER_ROUTER_MAC_STATS
+    border_router_mac_stats.window = window;
+#endif /* BORDER_ROUTER_MAC_STATS */
+    release_frames();
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+packet_sent(uint8_t sessionid, uint8_t status, uint8_t tx)
+{
+  struct tx_callback *callback;
+
+  callback = &callbacks[sessionid % MAX_CALLBACKS];
+  if(callback->state != TX_SENT || callback->sid != sessionid) {
+    LOG_WARN("report for unknown sid %u\n", sessionid);
+    MAC_STATS_ADD(late_reports, 1);
+    return;
+  }
+  MAC_STATS_ADD(reports, 1);
+  complete(callback, status, tx);
+  release_frames();
+}
+/*---------------------------------------------------------------------------*/
+/* Queue the frame in packetbuf, returns the session or NULL if all are busy */
+static struct tx_callback *
+setup_callback(mac_callback_t sent, void *ptr)
+{
+  struct tx_callback *callback;
+  uint8_t slot;
+  int i;
+
+  /* Any free slot will do, a session the radio never reports holds
+     only its own slot until it is reaped */
+  slot = next_sid % MAX_CALLBACKS;
+  for(i = 0; i < MAX_CALLBACKS; i++) {
+    if(callbacks[slot].state == TX_FREE) {
+      break;
+    }
+    slot = (slot + 1) % MAX_CALLBACKS;
+  }
+  if(i == MAX_CALLBACKS) {
+    return NULL;
+  }
+  callback = &callbacks[slot];
+  callback->cback = sent;
+  callback->ptr = ptr;
+  /* Skip ahead to the next session id that maps onto the slot */
+  next_sid += i;
+  callback->sid = next_sid++;
+  callback->state = TX_QUEUED;
+  packetbuf_attr_copyto(callback->attrs, callback->addrs);
+  release_queue[(release_head + queued) % MAX_CALLBACKS] = slot;
+  queued++;
+#if BORDER_ROUTER_MAC_STATS
+  if(queued > border_router_mac_stats.queued_max) {
+    border_router_mac_stats.queued_max = queued;
+  }
+#endif /* BORDER_ROUTER_MAC_STATS */
+  return callback;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_packet(mac_callback_t sent, void *ptr)
+{
+  struct tx_callback *callback;
+  int size;
+
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+
+  /* ack or not ? */
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+
+  /* Will make it send only DATA packets... for now */
+  packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_DATAFRAME);
+
+  LOG_INFO("sending packet (%u bytes)\n", packetbuf_datalen());
+
+  if(NETSTACK_FRAMER.create() < 0) {
+    /* Failed to allocate space for headers */
+    LOG_WARN("send failed, too large header\n");
+    mac_call_sent_callback(sent, ptr, MAC_TX_ERR_FATAL, 1);
+    return;
+  }
+
+  callback = setup_callback(sent, ptr);
+  if(callback == NULL) {
+    LOG_WARN("send failed, all sessions busy\n");
+    MAC_STATS_ADD(queue_full, 1);
+    mac_call_sent_callback(sent, ptr, MAC_TX_QUEUE_FULL, 1);
+    return;
+  }
+
+  /* here we send the data over SLIP to the radio-chip */
+  size = 0;
+#if SERIALIZE_ATTRIBUTES
+  size = packetutils_serialize_atts(&callback->frame[3], FRAME_SIZE - 3);
+#endif
+  if(size < 0 || size + packetbuf_totlen() + 3 > FRAME_SIZE) {
+    LOG_WARN("send failed, too large header\n");
+    /* The session is the newest one and last in the queue, take it back */
+    callback->state = TX_FREE;
+    next_sid--;
+    queued--;
+    mac_call_sent_callback(sent, ptr, MAC_TX_ERR_FATAL, 1);
+    return;
+  }
+
+  callback->frame[0] = '!';
+  callback->frame[1] = 'S';
+  callback->frame[2] = callback->sid;
+  memcpy(&callback->frame[3 + size], packetbuf_hdrptr(), packetbuf_totlen());
+  callback->len = packetbuf_totlen() + size + 3;
+
+  release_frames();
+}
+#else /* BORDER_ROUTER_MAC_TX_WINDOW */
 void
 packet_sent(uint8_t sessionid, uint8_t status, uint8_t tx)
 {
@@ -114,8 +352,7 @@ static void
 send_packet(mac_callback_t sent, void *ptr)
 {
   int size;
-  /* 3 bytes per packet attribute is required for serialization */
-  uint8_t buf[PACKETBUF_NUM_ATTRS * 3 + PACKETBUF_SIZE + 3];
+  uint8_t buf[FRAME_SIZE];
   uint8_t sid;
 
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
@@ -155,6 +392,25 @@ send_packet(mac_callback_t sent, void *ptr)
     }
   }
 }
+#endif /* BORDER_ROUTER_MAC_TX_WINDOW */
+/*---------------------------------------------------------------------------*/
+#if BORDER_ROUTER_MAC_STATS
+void
+border_router_mac_print_stat(void)
+{
+  border_router_mac_stats_t *st = &border_router_mac_stats;
+  unsigned long done = st->reports + st->timeouts;
+
+  printf("frames sent to radio: %lu, window %u, most queued %u\n",
+         st->frames_sent, st->window, st->queued_max);
+  printf("reports: %lu, timeouts: %lu, late reports: %lu, "
+         "sessions busy: %lu\n",
+         st->reports, st->timeouts, st->late_reports, st->queue_full);
+  printf("report latency: %lu ms average, %lu ms max\n",
+         (unsigned long)(done ? st->latency_total * 1000 / CLOCK_SECOND / done : 0),
+         (unsigned long)(st->latency_max * 1000 / CLOCK_SECOND));
+}
+#endif /* BORDER_ROUTER_MAC_STATS */
 /*---------------------------------------------------------------------------*/
 static void
 packet_input(void)
@@ -188,7 +444,20 @@ max_payload()
 static void
 init(void)
 {
+#if BORDER_ROUTER_MAC_TX_WINDOW
+  ctimer_stop(&reap_timer);
+  memset(callbacks, 0, sizeof(callbacks));
+  next_sid = 0;
+  release_head = 0;
+  queued = 0;
+  in_flight = 0;
+  tx_window = BORDER_ROUTER_MAC_TX_WINDOW;
+#if BORDER_ROUTER_MAC_STATS
+  border_router_mac_stats.window = tx_window;
+#endif /* BORDER_ROUTER_MAC_STATS */
+#else /* BORDER_ROUTER_MAC_TX_WINDOW */
   callback_pos = 0;
+#endif /* BORDER_ROUTER_MAC_TX_WINDOW */
 }
 /*---------------------------------------------------------------------------*/
 const struct mac_driver border_router_mac_driver = {
@@ -71,6 +71,10 @@ static void
 request_mac(void)
 {
   write_to_slip((uint8_t *)"?M", 2);
+#if BORDER_ROUTER_MAC_TX_WINDOW
+  /* Radios that do not know the request keep the configured window */
+  write_to_slip((uint8_t *)"?W", 2);
+#endif /* BORDER_ROUTER_MAC_TX_WINDOW */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -94,6 +98,9 @@ border_router_print_stat()
 {
   printf("bytes received over SLIP: %ld\n", slip_received);
   printf("bytes sent over SLIP: %ld\n", slip_sent);
+#if BORDER_ROUTER_MAC_STATS
+  border_router_mac_print_stat();
+#endif /* BORDER_ROUTER_MAC_STATS */
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(border_router_process, ev, data)
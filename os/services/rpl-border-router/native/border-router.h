@@ -42,13 +42,62 @@
 #include <stdio.h>
 #include "slip-config.h"
 
+/* Frames the MAC lets out to the radio before their reports come back,
+   until the radio tells its own window. 0 sends every frame at once
+   without flow control. */
+#ifdef BORDER_ROUTER_MAC_CONF_TX_WINDOW
+#define BORDER_ROUTER_MAC_TX_WINDOW BORDER_ROUTER_MAC_CONF_TX_WINDOW
+#else
+#define BORDER_ROUTER_MAC_TX_WINDOW 0
+#endif
+
+/* How long the MAC waits for the radio to report a frame */
+#ifdef BORDER_ROUTER_MAC_CONF_TX_TIMEOUT
+#define BORDER_ROUTER_MAC_TX_TIMEOUT BORDER_ROUTER_MAC_CONF_TX_TIMEOUT
+#else
+#define BORDER_ROUTER_MAC_TX_TIMEOUT (CLOCK_SECOND * 2)
+#endif
+
+/* Count reports, timeouts and report latency of the transmit window */
+#ifdef BORDER_ROUTER_MAC_CONF_STATS
+#define BORDER_ROUTER_MAC_STATS BORDER_ROUTER_MAC_CONF_STATS
+#else
+#define BORDER_ROUTER_MAC_STATS 0
+#endif
+
+#if BORDER_ROUTER_MAC_STATS
+typedef struct border_router_mac_stats {
+  unsigned long frames_sent;
+  unsigned long reports;
+  unsigned long timeouts;
+  /* Reports for sessions that timed out or are unknown */
+  unsigned long late_reports;
+  /* Frames refused because every session was busy */
+  unsigned long queue_full;
+  /* Time from sending a frame to its report or timeout */
+  clock_time_t latency_total;
+  clock_time_t latency_max;
+  uint8_t window;
+  uint8_t queued_max;
+} border_router_mac_stats_t;
+
+extern border_router_mac_stats_t border_router_mac_stats;
+
+void border_router_mac_print_stat(void);
+#endif /* BORDER_ROUTER_MAC_STATS */
+
 int border_router_cmd_handler(const uint8_t *data, int len);
 void write_to_slip(const uint8_t *buf, int len);
+/* Bytes left in the SLIP output buffer */
+int slip_tx_space(void);
 
 void border_router_set_prefix_64(const uip_ipaddr_t *prefix_64);
 void border_router_set_mac(const uint8_t *data);
 void border_router_set_sensors(const char *data, int len);
 void border_router_print_stat(void);
+#if BORDER_ROUTER_MAC_TX_WINDOW
+void border_router_mac_set_window(uint8_t window);
+#endif /* BORDER_ROUTER_MAC_TX_WINDOW */
 
 void tun_init(void);
 
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Block oriented SLIP encoder and decoder.
+ */
+
+#include "slip-codec.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+/* The next byte at or after p that is either a or b, or end */
+static const unsigned char *
+find_either(const unsigned char *p, const unsigned char *end,
+            const unsigned char **next_a, unsigned char a,
+            const unsigned char **next_b, unsigned char b)
+{
+  /* Each memchr() result stays valid until the scan passes it */
+  if(*next_a == NULL || *next_a < p) {
+    *next_a = memchr(p, a, end - p);
+    if(*next_a == NULL) {
+      *next_a = end;
+    }
+  }
+  if(*next_b == NULL || *next_b < p) {
+    *next_b = memchr(p, b, end - p);
+    if(*next_b == NULL) {
+      *next_b = end;
+    }
+  }
+  return *next_a < *next_b ? *next_a : *next_b;
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_encode(unsigned char *dst, int size, const uint8_t *src, int len)
+{
+  const unsigned char *p = src;
+  const unsigned char *end = src + len;
+  const unsigned char *next_end = NULL;
+  const unsigned char *next_esc = NULL;
+  const unsigned char *special;
+  int n = 0;
+  int run;
+
+  while(p < end) {
+    special = find_either(p, end, &next_end, SLIP_END, &next_esc, SLIP_ESC);
+    run = special - p;
+    if(n + run > size) {
+      return -1;
+    }
+    memcpy(dst + n, p, run);
+    n += run;
+    p = special;
+    if(p == end) {
+      break;
+    }
+    if(n + 2 > size) {
+      return -1;
+    }
+    dst[n++] = SLIP_ESC;
+    dst[n++] = *p == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC;
+    p++;
+  }
+
+  if(n + 1 > size) {
+    return -1;
+  }
+  dst[n++] = SLIP_END;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_decoder_init(struct slip_decoder *d)
+{
+  d->len = 0;
+  d->escaped = 0;
+  d->dropping = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Append bytes to the frame, or start dropping it if they do not fit */
+static void
+append(struct slip_decoder *d, const unsigned char *data, int len)
+{
+  if(d->dropping) {
+    return;
+  }
+  if(d->len + len > (int)sizeof(d->buf)) {
+    fprintf(stderr, "*** dropping large %d byte packet\n", d->len + len);
+    d->dropping = 1;
+    return;
+  }
+  memcpy(d->buf + d->len, data, len);
+  d->len += len;
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_decode(struct slip_decoder *d, const unsigned char *data, int len,
+            slip_frame_handler_t handler)
+{
+  const unsigned char *p = data;
+  const unsigned char *end = data + len;
+  const unsigned char *next_end = NULL;
+  const unsigned char *next_esc = NULL;
+  const unsigned char *special;
+  unsigned char c;
+  int frames = 0;
+
+  while(p < end) {
+    if(d->escaped) {
+      /* An escape split from its byte by the previous read */
+      d->escaped = 0;
+      c = *p++;
+      if(c == SLIP_ESC_END) {
+        c = SLIP_END;
+      } else if(c == SLIP_ESC_ESC) {
+        c = SLIP_ESC;
+      }
+      append(d, &c, 1);
+      continue;
+    }
+
+    special = find_either(p, end, &next_end, SLIP_END, &next_esc, SLIP_ESC);
+    append(d, p, special - p);
+    p = special;
+    if(p == end) {
+      break;
+    }
+
+    if(*p++ == SLIP_ESC) {
+      d->escaped = 1;
+    } else {
+      if(d->len > 0 && !d->dropping) {
+        frames++;
+        handler(d->buf, d->len);
+      }
+      d->len = 0;
+      d->dropping = 0;
+    }
+  }
+  return frames;
+}
+/*---------------------------------------------------------------------------*/
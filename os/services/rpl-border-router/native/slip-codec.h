@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Block oriented SLIP encoder and decoder.
+ *
+ *         Both work on whole buffers: runs of bytes that need no escaping
+ *         are found with memchr() and copied in one go. The decoder keeps
+ *         its state between calls, so a frame may span several reads and
+ *         a read may hold several frames.
+ */
+
+#ifndef SLIP_CODEC_H_
+#define SLIP_CODEC_H_
+
+#include <stdint.h>
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+/* Largest decoded frame */
+#ifdef SLIP_CODEC_CONF_FRAME_SIZE
+#define SLIP_CODEC_FRAME_SIZE SLIP_CODEC_CONF_FRAME_SIZE
+#else
+#define SLIP_CODEC_FRAME_SIZE 2048
+#endif
+
+/* Called for each decoded, non-empty frame */
+typedef void (*slip_frame_handler_t)(unsigned char *frame, int len);
+
+struct slip_decoder {
+  unsigned char buf[SLIP_CODEC_FRAME_SIZE];
+  int len;
+  /* The last byte seen was SLIP_ESC */
+  uint8_t escaped;
+  /* The frame has outgrown buf and is dropped up to its SLIP_END */
+  uint8_t dropping;
+};
+
+/**
+ * \brief Encode a packet as a SLIP frame
+ * \param dst Buffer for the frame
+ * \param size Size of dst
+ * \return The frame length including the trailing SLIP_END, or -1 if
+ *         the frame does not fit in dst
+ */
+int slip_encode(unsigned char *dst, int size, const uint8_t *src, int len);
+
+/**
+ * \brief Clear a decoder
+ */
+void slip_decoder_init(struct slip_decoder *d);
+
+/**
+ * \brief Decode received bytes
+ * \param handler Called for every frame completed by these bytes
+ * \return The number of frames completed
+ *
+ * An escape byte followed by anything other than SLIP_ESC_END or
+ * SLIP_ESC_ESC stands for that byte. Frames longer than
+ * SLIP_CODEC_FRAME_SIZE are dropped.
+ */
+int slip_decode(struct slip_decoder *d, const unsigned char *data, int len,
+                slip_frame_handler_t handler);
+
+#endif /* SLIP_CODEC_H_ */
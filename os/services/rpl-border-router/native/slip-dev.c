@@ -56,6 +56,7 @@
 #include "cmd.h"
 #include "border-router-cmds.h"
 #include "slip-config.h"
+#include "slip-codec.h"
 
 #ifdef SLIP_DEV_CONF_SEND_DELAY
 #define SEND_DELAY SLIP_DEV_CONF_SEND_DELAY
@@ -63,9 +64,27 @@
 #define SEND_DELAY 0
 #endif
 
+/* Read the serial line in blocks with read() and decode them with
+   slip_decode(), instead of a byte at a time through stdio */
+#ifdef SLIP_DEV_CONF_BULK_READ
+#define SLIP_DEV_BULK_READ SLIP_DEV_CONF_BULK_READ
+#else
+#define SLIP_DEV_BULK_READ 0
+#endif
+
+#ifdef SLIP_DEV_CONF_READ_SIZE
+#define SLIP_DEV_READ_SIZE SLIP_DEV_CONF_READ_SIZE
+#else
+#define SLIP_DEV_READ_SIZE 4096
+#endif
+
 int devopen(const char *dev, int flags);
 
+#if SLIP_DEV_BULK_READ
+static struct slip_decoder decoder;
+#else /* SLIP_DEV_BULK_READ */
 static FILE *inslip;
+#endif /* SLIP_DEV_BULK_READ */
 
 /* for statistics */
 long slip_sent = 0;
@@ -75,11 +94,6 @@ int slipfd = 0;
 
 #define PROGRESS(s) do { } while(0)
 
-#define SLIP_END     0300
-#define SLIP_ESC     0333
-#define SLIP_ESC_END 0334
-#define SLIP_ESC_ESC 0335
-
 /*---------------------------------------------------------------------------*/
 static void *
 get_in_addr(struct sockaddr *sa)
@@ -161,6 +175,111 @@ slip_packet_input(unsigned char *data, int len)
   NETSTACK_MAC.input();
 }
 /*---------------------------------------------------------------------------*/
+/* Handle a SLIP frame: a command, a debug line or a packet */
+static void
+slip_frame_input(unsigned char *inbuf, int inbufptr)
+{
+  int i;
+
+  if(inbuf[0] == '!') {
+    command_context = CMD_CONTEXT_RADIO;
+    cmd_input(inbuf, inbufptr);
+  } else if(inbuf[0] == '?') {
+#define DEBUG_LINE_MARKER '\r'
+  } else if(inbuf[0] == DEBUG_LINE_MARKER) {
+    fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
+  } else if(is_sensible_string(inbuf, inbufptr)) {
+    if(slip_config.verbose == 1) {   /* strings already echoed below for verbose>1 */
+      fwrite(inbuf, inbufptr, 1, stdout);
+    }
+  } else {
+    if(slip_config.verbose > 2) {
+      printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
+      if(slip_config.verbose > 4) {
+#if WIRESHARK_IMPORT_FORMAT
+        printf("0000");
+        for(i = 0; i < inbufptr; i++) {
+          printf(" %02x", inbuf[i]);
+        }
+#else
+        printf("         ");
+        for(i = 0; i < inbufptr; i++) {
+          printf("%02x", inbuf[i]);
+          if((i & 3) == 3) {
+            printf(" ");
+          }
+          if((i & 15) == 15) {
+            printf("\n         ");
+          }
+        }
+#endif
+        printf("\n");
+      }
+    }
+    slip_packet_input(inbuf, inbufptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if SLIP_DEV_BULK_READ
+static void
+bulk_frame_input(unsigned char *frame, int len)
+{
+  int i;
+
+  /* The byte at a time reader echoes strings while they arrive; here
+     they are echoed a frame at a time */
+  if(slip_config.verbose == 4) {
+    for(i = 0; i < len; i++) {
+      if(frame[i] == 0 || frame[i] == '\r' || frame[i] == '\n' ||
+         frame[i] == '\t' || (frame[i] >= ' ' && frame[i] <= '~')) {
+        fwrite(&frame[i], 1, 1, stdout);
+      }
+    }
+  } else if(slip_config.verbose >= 2 && frame[0] != DEBUG_LINE_MARKER &&
+            is_sensible_string(frame, len)) {
+    fwrite(frame, len, 1, stdout);
+    return;
+  }
+  slip_frame_input(frame, len);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Read all bytes waiting on the serial line and hand the frames they
+ * complete to slip_frame_input.
+ */
+static void
+serial_read(int fd)
+{
+  static unsigned char buf[SLIP_DEV_READ_SIZE];
+  int first = 1;
+  int n;
+
+  for(;;) {
+    n = read(fd, buf, sizeof(buf));
+    if(n == -1) {
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return;
+      }
+      err(1, "serial_input: read");
+    }
+    if(n == 0) {
+      if(first) {
+        /* Readable but empty: the other end has gone */
+        err(1, "serial_input: read");
+      }
+      return;
+    }
+    first = 0;
+    slip_received += n;
+    slip_decode(&decoder, buf, n, bulk_frame_input);
+    if(n < (int)sizeof(buf)) {
+      /* Drained */
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+#else /* SLIP_DEV_BULK_READ */
 /*
  * Read from serial, when we have a packet call slip_packet_input. No output
  * buffering, input buffered by stdio.
@@ -170,7 +289,7 @@ serial_input(FILE *inslip)
 {
   static unsigned char inbuf[2048];
   static int inbufptr = 0;
-  int ret, i;
+  int ret;
   unsigned char c;
 
 #ifdef linux
@@ -201,43 +320,7 @@ after_fread:
   switch(c) {
   case SLIP_END:
     if(inbufptr > 0) {
-      if(inbuf[0] == '!') {
-        command_context = CMD_CONTEXT_RADIO;
-        cmd_input(inbuf, inbufptr);
-      } else if(inbuf[0] == '?') {
-#define DEBUG_LINE_MARKER '\r'
-      } else if(inbuf[0] == DEBUG_LINE_MARKER) {
-        fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(inbuf, inbufptr)) {
-        if(slip_config.verbose == 1) {   /* strings already echoed below for verbose>1 */
-          fwrite(inbuf, inbufptr, 1, stdout);
-        }
-      } else {
-        if(slip_config.verbose > 2) {
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
-          if(slip_config.verbose > 4) {
-#if WIRESHARK_IMPORT_FORMAT
-            printf("0000");
-            for(i = 0; i < inbufptr; i++) {
-              printf(" %02x", inbuf[i]);
-            }
-#else
-            printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", inbuf[i]);
-              if((i & 3) == 3) {
-                printf(" ");
-              }
-              if((i & 15) == 15) {
-                printf("\n         ");
-              }
-            }
-#endif
-            printf("\n");
-          }
-        }
-        slip_packet_input(inbuf, inbufptr);
-      }
+      slip_frame_input(inbuf, inbufptr);
       inbufptr = 0;
     }
     break;
@@ -279,8 +362,11 @@ after_fread:
 
   goto read_more;
 }
+#endif /* SLIP_DEV_BULK_READ */
 unsigned char slip_buf[2048];
 int slip_end, slip_begin, slip_packet_end, slip_packet_count;
+/* Frames in slip_buf up to slip_packet_end */
+static int slip_packet_frames;
 static struct timer send_delay_timer;
 /* delay between slip packets */
 static clock_time_t send_delay = SEND_DELAY;
@@ -299,11 +385,18 @@ slip_send(int fd, unsigned char c)
     slip_packet_count++;
     if(slip_packet_end == 0) {
       slip_packet_end = slip_end;
+      slip_packet_frames = 1;
     }
   }
 }
 /*---------------------------------------------------------------------------*/
 int
+slip_tx_space(void)
+{
+  return sizeof(slip_buf) - slip_end;
+}
+/*---------------------------------------------------------------------------*/
+int
 slip_empty()
 {
   return slip_packet_end == 0;
@@ -327,7 +420,8 @@ slip_flushbuf(int fd)
   } else {
     slip_begin += n;
     if(slip_begin == slip_packet_end) {
-      slip_packet_count--;
+      slip_packet_count -= slip_packet_frames;
+      slip_packet_frames = 0;
       if(slip_end > slip_packet_end) {
         memmove(slip_buf, slip_buf + slip_packet_end,
                slip_end - slip_packet_end);
@@ -335,12 +429,13 @@ slip_flushbuf(int fd)
       slip_end -= slip_packet_end;
       slip_begin = slip_packet_end = 0;
       if(slip_end > 0) {
+        unsigned char *next;
+
         /* Find end of next slip packet */
-        for(n = 1; n < slip_end; n++) {
-          if(slip_buf[n] == SLIP_END) {
-            slip_packet_end = n + 1;
-            break;
-          }
+        next = memchr(slip_buf + 1, SLIP_END, slip_end - 1);
+        if(next != NULL) {
+          slip_packet_end = next - slip_buf + 1;
+          slip_packet_frames = 1;
         }
         /* a delay between slip packets to avoid losing data */
         if(send_delay > 0) {
@@ -390,22 +485,20 @@ write_to_serial(int outfd, const uint8_t *inbuf, int len)
    */
   /* slip_send(outfd, SLIP_END); */
 
-  for(i = 0; i < len; i++) {
-    switch(p[i]) {
-    case SLIP_END:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_END);
-      break;
-    case SLIP_ESC:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_ESC);
-      break;
-    default:
-      slip_send(outfd, p[i]);
-      break;
-    }
+  i = slip_encode(slip_buf + slip_end, sizeof(slip_buf) - slip_end, p, len);
+  if(i == -1) {
+    err(1, "slip_send overflow");
+  }
+  slip_end += i;
+  slip_sent += i;
+  /* The frame ends with its only SLIP_END */
+  slip_packet_count++;
+  if(slip_packet_end == 0 || send_delay == 0) {
+    /* Without a delay between packets, all complete packets go out in
+       one write */
+    slip_packet_end = slip_end;
+    slip_packet_frames++;
   }
-  slip_send(outfd, SLIP_END);
   PROGRESS("t");
 }
 /*---------------------------------------------------------------------------*/
@@ -485,14 +578,18 @@ set_fd(fd_set *rset, fd_set *wset)
   }
 
   FD_SET(slipfd, rset);	/* Read from slip ASAP! */
-  return 1;
+  return slipfd;
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
   if(FD_ISSET(slipfd, rset)) {
+#if SLIP_DEV_BULK_READ
+    serial_read(slipfd);
+#else /* SLIP_DEV_BULK_READ */
     serial_input(inslip);
+#endif /* SLIP_DEV_BULK_READ */
   }
 
   if(FD_ISSET(slipfd, wset)) {
@@ -553,9 +650,13 @@ slip_init(void)
 
   timer_set(&send_delay_timer, 0);
   slip_send(slipfd, SLIP_END);
+#if SLIP_DEV_BULK_READ
+  slip_decoder_init(&decoder);
+#else /* SLIP_DEV_BULK_READ */
   inslip = fdopen(slipfd, "r");
   if(inslip == NULL) {
     err(1, "slip_init: fdopen");
   }
+#endif /* SLIP_DEV_BULK_READ */
 }
 /*---------------------------------------------------------------------------*/
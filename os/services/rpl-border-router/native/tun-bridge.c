@@ -66,11 +66,13 @@
 #include "net/packetbuf.h"
 #include "cmd.h"
 #include "border-router.h"
+#include "tun-io.h"
 
 extern struct SlipConfig slip_config;
 
 #ifndef __CYGWIN__
 static int tunfd;
+static struct tun_io tun_io;
 
 static int set_fd(fd_set *rset, fd_set *wset);
 static void handle_fd(fd_set *rset, fd_set *wset);
@@ -216,6 +218,8 @@ tun_init()
     err(1, "tun_init: open");
   }
 
+  tun_io_init(&tun_io, tunfd);
+
   select_set_callback(tunfd, &tun_select_callback);
 
   fprintf(stderr, "opened %s device ``/dev/%s''\n",
@@ -232,21 +236,7 @@ static int
 tun_output(uint8_t *data, int len)
 {
   /* fprintf(stderr, "*** Writing to tun...%d\n", len); */
-  if(write(tunfd, data, len) != len) {
-    err(1, "serial_to_tun: write");
-    return -1;
-  }
-  return 0;
-}
-/*---------------------------------------------------------------------------*/
-int
-tun_input(unsigned char *data, int maxlen)
-{
-  int size;
-  if((size = read(tunfd, data, maxlen)) == -1) {
-    err(1, "tun_input: read");
-  }
-  return size;
+  return tun_io_write(&tun_io, data, len);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -274,7 +264,10 @@ static int
 set_fd(fd_set *rset, fd_set *wset)
 {
   FD_SET(tunfd, rset);
-  return 1;
+  if(tun_io_pending(&tun_io)) {
+    FD_SET(tunfd, wset);
+  }
+  return tunfd;
 }
 /*---------------------------------------------------------------------------*/
 
@@ -298,13 +291,13 @@ handle_fd(fd_set *rset, fd_set *wset)
   }
 
   if(delaymsec == 0) {
-    int size;
-
     if(FD_ISSET(tunfd, rset)) {
-      size = tun_input(uip_buf, sizeof(uip_buf));
-      /* printf("TUN data incoming read:%d\n", size); */
-      uip_len = size;
-      tcpip_input();
+      /* The delay is kept between single packets */
+      tun_io_read(&tun_io, slip_config.basedelay ? 1 : TUN_IO_RX_BATCH);
+      while(tun_io_next(&tun_io)) {
+        /* printf("TUN data incoming read:%d\n", uip_len); */
+        tcpip_input();
+      }
 
       if(slip_config.basedelay) {
         struct timeval tv;
@@ -315,6 +308,8 @@ handle_fd(fd_set *rset, fd_set *wset)
       }
     }
   }
+
+  tun_io_flush(&tun_io);
 }
 #endif /*  __CYGWIN_ */
 
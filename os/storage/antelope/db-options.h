@@ -217,6 +217,33 @@
 
 /*----------------------------------------------------------------------------*/
 
+/* Tuple storage options. */
+
+/* The number of tuple file pages kept in an LRU cache shared by all
+   relations. Rows are then read a page at a time, and the row count of
+   each relation is cached. Set to 0 to read every row from the file. */
+#ifndef DB_ROW_CACHE_PAGES
+#define DB_ROW_CACHE_PAGES		0
+#endif /* DB_ROW_CACHE_PAGES */
+
+/* The size of a cached tuple file page. */
+#ifndef DB_ROW_CACHE_PAGE_SIZE
+#define DB_ROW_CACHE_PAGE_SIZE		256
+#endif /* DB_ROW_CACHE_PAGE_SIZE */
+
+/* Count the file accesses made when reading rows. */
+#ifndef DB_STORAGE_STATS
+#define DB_STORAGE_STATS		0
+#endif /* DB_STORAGE_STATS */
+
+/* Count the selections, the rows evaluated and matched by them, and the
+   time spent processing them. */
+#ifndef DB_QUERY_STATS
+#define DB_QUERY_STATS			0
+#endif /* DB_QUERY_STATS */
+
+/*----------------------------------------------------------------------------*/
+
 /* LVM options. */
 
 /* The maximum length of a variable in LVM. This value should preferably
@@ -236,5 +263,12 @@
 #define LVM_USE_FLOATS			DB_FEATURE_FLOATS
 #endif /* LVM_USE_FLOATS */
 
+/* Compile the condition of a selection into a linear stack program
+   once per query, and bind the attributes of the relation to variable
+   slots, so that no variable names are looked up for each row. */
+#ifndef LVM_COMPILE_PREDICATES
+#define LVM_COMPILE_PREDICATES		0
+#endif /* LVM_COMPILE_PREDICATES */
+
 
 #endif /* !DB_OPTIONS_H */
@@ -87,6 +87,34 @@ static variable_t variables[LVM_MAX_VARIABLE_ID];
 /* Range derivations of variables that are used for index searches. */
 static derivation_t derivations[LVM_MAX_VARIABLE_ID];
 
+#if LVM_COMPILE_PREDICATES
+/*
+ * A compiled predicate is a linear program in postfix notation. Operand
+ * instructions push a value on a stack of longs, and operator
+ * instructions replace their arguments on the stack with the result.
+ * Operators keep their operator_t value as the opcode.
+ */
+#define LVM_PUSH_LONG		0
+#define LVM_PUSH_VARIABLE	1
+
+/* Every node in the bytecode takes at least this much space, so the
+   program of a full bytecode buffer fits. */
+#define LVM_PROGRAM_LENGTH \
+  (DB_VM_BYTECODE_SIZE / (sizeof(node_type_t) + sizeof(operator_t)))
+
+struct instruction {
+  unsigned char opcode;
+  operand_value_t value;
+};
+
+static struct instruction program[LVM_PROGRAM_LENGTH];
+static unsigned program_length;
+static long stack[LVM_PROGRAM_LENGTH];
+
+/* The instance whose code is in the program, if any. */
+static lvm_instance_t *compiled;
+#endif /* LVM_COMPILE_PREDICATES */
+
 #if DEBUG
 static void
 print_derivations(derivation_t *d)
@@ -297,9 +325,201 @@ eval_logic(lvm_instance_t *p, operator_t *op)
   return LVM_EXECUTION_ERROR;
 }
 
+#if LVM_COMPILE_PREDICATES
+static lvm_status_t
+emit(unsigned char opcode, long l)
+{
+  if(program_length == LVM_PROGRAM_LENGTH) {
+    return LVM_STACK_OVERFLOW;
+  }
+
+  program[program_length].opcode = opcode;
+  program[program_length].value.l = l;
+  program_length++;
+  return LVM_TRUE;
+}
+
+static lvm_status_t
+compile_operand(lvm_instance_t *p)
+{
+  operand_t operand;
+
+  get_operand(p, &operand);
+  if(operand.type == LVM_VARIABLE) {
+    if(emit(LVM_PUSH_VARIABLE, 0) != LVM_TRUE) {
+      return LVM_STACK_OVERFLOW;
+    }
+    program[program_length - 1].value.id = operand.value.id;
+    return LVM_TRUE;
+  }
+  return emit(LVM_PUSH_LONG, operand_to_long(&operand));
+}
+
+static lvm_status_t
+compile_expr(lvm_instance_t *p, operator_t op)
+{
+  int i;
+  lvm_status_t r;
+
+  for(i = 0; i < 2; i++) {
+    switch(get_type(p)) {
+    case LVM_ARITH_OP:
+      r = compile_expr(p, *get_operator(p));
+      break;
+    case LVM_OPERAND:
+      r = compile_operand(p);
+      break;
+    default:
+      r = LVM_SEMANTIC_ERROR;
+    }
+    if(r != LVM_TRUE) {
+      return r;
+    }
+  }
+
+  switch(op) {
+  case LVM_ADD:
+  case LVM_SUB:
+  case LVM_MUL:
+  case LVM_DIV:
+    return emit(op, 0);
+  default:
+    return LVM_EXECUTION_ERROR;
+  }
+}
+
+static lvm_status_t
+compile_logic(lvm_instance_t *p, operator_t op)
+{
+  int i;
+  unsigned arguments;
+  lvm_status_t r;
+
+  if(IS_CONNECTIVE(op)) {
+    arguments = op == LVM_NOT ? 1 : 2;
+    for(i = 0; i < arguments; i++) {
+      if(get_type(p) != LVM_CMP_OP) {
+        return LVM_SEMANTIC_ERROR;
+      }
+      r = compile_logic(p, *get_operator(p));
+      if(r != LVM_TRUE) {
+        return r;
+      }
+    }
+  } else {
+    for(i = 0; i < 2; i++) {
+      switch(get_type(p)) {
+      case LVM_ARITH_OP:
+        r = compile_expr(p, *get_operator(p));
+        break;
+      case LVM_OPERAND:
+        r = compile_operand(p);
+        break;
+      default:
+        r = LVM_SEMANTIC_ERROR;
+      }
+      if(r != LVM_TRUE) {
+        return r;
+      }
+    }
+  }
+
+  switch(op) {
+  case LVM_EQ:
+  case LVM_NEQ:
+  case LVM_GE:
+  case LVM_GEQ:
+  case LVM_LE:
+  case LVM_LEQ:
+  case LVM_AND:
+  case LVM_OR:
+  case LVM_NOT:
+    return emit(op, 0);
+  default:
+    return LVM_EXECUTION_ERROR;
+  }
+}
+
+/* Both arguments of a connective are evaluated, as in eval_logic(), so
+   that errors in either of them are reported in the same way. */
+static lvm_status_t
+execute_program(void)
+{
+  struct instruction *insn;
+  long *sp;
+
+  sp = stack;
+  for(insn = program; insn < &program[program_length]; insn++) {
+    switch(insn->opcode) {
+    case LVM_PUSH_LONG:
+      *sp++ = insn->value.l;
+      continue;
+    case LVM_PUSH_VARIABLE:
+      *sp++ = variables[insn->value.id].value.l;
+      continue;
+    case LVM_NOT:
+      sp[-1] = !sp[-1];
+      continue;
+    default:
+      break;
+    }
+
+    sp--;
+    switch(insn->opcode) {
+    case LVM_ADD:
+      sp[-1] += sp[0];
+      break;
+    case LVM_SUB:
+      sp[-1] -= sp[0];
+      break;
+    case LVM_MUL:
+      sp[-1] *= sp[0];
+      break;
+    case LVM_DIV:
+      if(sp[0] == 0) {
+        return LVM_MATH_ERROR;
+      }
+      sp[-1] /= sp[0];
+      break;
+    case LVM_EQ:
+      sp[-1] = sp[-1] == sp[0];
+      break;
+    case LVM_NEQ:
+      sp[-1] = sp[-1] != sp[0];
+      break;
+    case LVM_GE:
+      sp[-1] = sp[-1] > sp[0];
+      break;
+    case LVM_GEQ:
+      sp[-1] = sp[-1] >= sp[0];
+      break;
+    case LVM_LE:
+      sp[-1] = sp[-1] < sp[0];
+      break;
+    case LVM_LEQ:
+      sp[-1] = sp[-1] <= sp[0];
+      break;
+    case LVM_AND:
+      sp[-1] = sp[-1] && sp[0];
+      break;
+    case LVM_OR:
+      sp[-1] = sp[-1] || sp[0];
+      break;
+    default:
+      return LVM_EXECUTION_ERROR;
+    }
+  }
+
+  return stack[0] ? LVM_TRUE : LVM_FALSE;
+}
+#endif /* LVM_COMPILE_PREDICATES */
+
 void
 lvm_reset(lvm_instance_t *p, unsigned char *code, lvm_ip_t size)
 {
+#if LVM_COMPILE_PREDICATES
+  compiled = NULL;
+#endif /* LVM_COMPILE_PREDICATES */
   memset(code, 0, size);
   p->code = code;
   p->size = size;
@@ -377,6 +597,12 @@ lvm_execute(lvm_instance_t *p)
   operator_t *operator;
   lvm_status_t status;
 
+#if LVM_COMPILE_PREDICATES
+  if(p == compiled) {
+    return execute_program();
+  }
+#endif /* LVM_COMPILE_PREDICATES */
+
   p->ip = 0;
   status = LVM_EXECUTION_ERROR;
   type = get_type(p);
@@ -400,6 +626,12 @@ lvm_execute(lvm_instance_t *p)
 lvm_status_t
 lvm_set_type(lvm_instance_t *p, node_type_t type)
 {
+#if LVM_COMPILE_PREDICATES
+  if(p == compiled) {
+    compiled = NULL;
+  }
+#endif /* LVM_COMPILE_PREDICATES */
+
   if(p->end + sizeof(node_type_t) >= DB_VM_BYTECODE_SIZE) {
     PRINTF("Error: overflow in lvm_set_type\n");
     return LVM_STACK_OVERFLOW;
@@ -533,6 +765,56 @@ lvm_set_variable(lvm_instance_t *p, char *name)
   return lvm_set_operand(p, &op);
 }
 
+#if LVM_COMPILE_PREDICATES
+lvm_status_t
+lvm_compile(lvm_instance_t *p)
+{
+  node_type_t type;
+  lvm_status_t status;
+
+  compiled = NULL;
+  program_length = 0;
+
+  p->ip = 0;
+  type = get_type(p);
+  if(type != LVM_CMP_OP) {
+    PRINTF("Error: The code must start with a relational operator\n");
+    return LVM_SEMANTIC_ERROR;
+  }
+
+  status = compile_logic(p, *get_operator(p));
+  if(status != LVM_TRUE) {
+    PRINTF("Failed to compile the code: %d\n", (int)status);
+    program_length = 0;
+    return status;
+  }
+
+  PRINTF("Compiled %u instructions\n", program_length);
+  compiled = p;
+  return LVM_TRUE;
+}
+
+variable_id_t
+lvm_get_variable_id(char *name)
+{
+  variable_id_t id;
+
+  id = lookup(name);
+  if(id == LVM_MAX_VARIABLE_ID || variables[id].name[0] == '\0') {
+    return LVM_MAX_VARIABLE_ID;
+  }
+  return id;
+}
+
+void
+lvm_set_variable_slot(variable_id_t id, operand_value_t value)
+{
+  if(id < LVM_MAX_VARIABLE_ID) {
+    variables[id].value = value;
+  }
+}
+#endif /* LVM_COMPILE_PREDICATES */
+
 void
 lvm_clone(lvm_instance_t *dst, lvm_instance_t *src)
 {
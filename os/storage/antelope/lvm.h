@@ -141,4 +141,10 @@ lvm_status_t lvm_set_operand(lvm_instance_t *p, operand_t *op);
 lvm_status_t lvm_set_long(lvm_instance_t *p, long l);
 lvm_status_t lvm_set_variable(lvm_instance_t *p, char *name);
 
+#if LVM_COMPILE_PREDICATES
+lvm_status_t lvm_compile(lvm_instance_t *p);
+variable_id_t lvm_get_variable_id(char *name);
+void lvm_set_variable_slot(variable_id_t id, operand_value_t value);
+#endif /* LVM_COMPILE_PREDICATES */
+
 #endif /* LVM_H */
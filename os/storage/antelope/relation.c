@@ -64,10 +64,25 @@ struct source_dest_map {
   attribute_t *to_attr;
   unsigned from_offset;
   unsigned to_offset;
+#if LVM_COMPILE_PREDICATES
+  variable_id_t variable_id;
+#endif /* LVM_COMPILE_PREDICATES */
 };
 
 static struct source_dest_map attr_map[AQL_ATTRIBUTE_LIMIT];
 
+#if DB_QUERY_STATS
+query_stats_t query_stats;
+static clock_time_t query_start;
+#define QUERY_STATS_ADD(field) query_stats.field++
+#define QUERY_STATS_START() (query_start = clock_time())
+#define QUERY_STATS_STOP() (query_stats.query_time += clock_time() - query_start)
+#else
+#define QUERY_STATS_ADD(field)
+#define QUERY_STATS_START()
+#define QUERY_STATS_STOP()
+#endif /* DB_QUERY_STATS */
+
 #if DB_FEATURE_JOIN
 /*
  * The source_map structure is used for mapping attributes to
@@ -177,6 +192,9 @@ relation_clear(relation_t *rel)
   memset(rel, 0, sizeof(*rel));
   rel->tuple_storage = -1;
   rel->cardinality = INVALID_TUPLE;
+#if DB_ROW_CACHE_PAGES > 0
+  rel->row_amount = INVALID_TUPLE;
+#endif
   rel->dir = DB_STORAGE;
   LIST_STRUCT_INIT(rel, attributes);
 }
@@ -250,7 +268,9 @@ relation_load(char *name)
   list_add(relations, rel);
 
 end:
-  if(rel->dir == DB_STORAGE && DB_ERROR(storage_load(rel))) {
+  /* A relation that is already in use keeps its open tuple file. */
+  if(rel->dir == DB_STORAGE && !RELATION_HAS_TUPLES(rel) &&
+     DB_ERROR(storage_load(rel))) {
     relation_release(rel);
     return NULL;
   }
@@ -677,6 +697,9 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
   relation_t *result_rel;
   unsigned attribute_count;
   attribute_t *attr;
+#if LVM_COMPILE_PREDICATES
+  unsigned i;
+#endif /* LVM_COMPILE_PREDICATES */
 
   result_rel = handle->result_rel;
 
@@ -701,8 +724,29 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
     if(!LVM_ERROR(lvm_derive(adt->lvm_instance))) {
       select_index(handle, adt->lvm_instance);
     }
+
+#if LVM_COMPILE_PREDICATES
+    /* The predicate is interpreted if it cannot be compiled. */
+    if(lvm_compile(adt->lvm_instance) == LVM_TRUE) {
+      QUERY_STATS_ADD(compiled);
+    }
+#endif /* LVM_COMPILE_PREDICATES */
   }
 
+#if LVM_COMPILE_PREDICATES
+  /* Bind the attributes that the predicate refers to to their LVM
+     variables, and skip the others when processing each row. */
+  for(i = 0; i < attribute_count; i++) {
+    attr_map[i].variable_id = LVM_MAX_VARIABLE_ID;
+    if(adt->lvm_instance != NULL) {
+      attr_map[i].variable_id = lvm_get_variable_id(attr_map[i].to_attr->name);
+    }
+  }
+#endif /* LVM_COMPILE_PREDICATES */
+
+  QUERY_STATS_ADD(selects);
+  QUERY_STATS_START();
+
   handle->flags |= DB_HANDLE_FLAG_PROCESSING;
 
   return DB_OK;
@@ -765,6 +809,7 @@ relation_process_select(void *handle_ptr)
         goto end_aggregation;
       }
 
+      QUERY_STATS_STOP();
       return DB_FINISHED;
     }
   }
@@ -780,6 +825,7 @@ relation_process_select(void *handle_ptr)
     if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
       goto end_aggregation;
     }
+    QUERY_STATS_STOP();
     return DB_FINISHED;
   }
 
@@ -789,6 +835,20 @@ relation_process_select(void *handle_ptr)
     result_attr = attr_map_ptr->to_attr;
 
     /* Update the internal state of the PLE. */
+#if LVM_COMPILE_PREDICATES
+    if(attr_map_ptr->variable_id == LVM_MAX_VARIABLE_ID) {
+      /* Not used by the predicate. */
+    } else if(result_attr->domain == DOMAIN_INT) {
+      operand_value.l = from_ptr[0] << 8 | from_ptr[1];
+      lvm_set_variable_slot(attr_map_ptr->variable_id, operand_value);
+    } else if(result_attr->domain == DOMAIN_LONG) {
+      operand_value.l = (uint32_t)from_ptr[0] << 24 |
+                        (uint32_t)from_ptr[1] << 16 |
+                        (uint32_t)from_ptr[2] << 8 |
+                        from_ptr[3];
+      lvm_set_variable_slot(attr_map_ptr->variable_id, operand_value);
+    }
+#else /* LVM_COMPILE_PREDICATES */
     if(result_attr->domain == DOMAIN_INT) {
       operand_value.l = from_ptr[0] << 8 | from_ptr[1];
       lvm_set_variable_value(result_attr->name, operand_value);
@@ -799,6 +859,7 @@ relation_process_select(void *handle_ptr)
                         from_ptr[3];
       lvm_set_variable_value(result_attr->name, operand_value);
     }
+#endif /* LVM_COMPILE_PREDICATES */
 
     if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
       /* The attribute is used just for the predicate,
@@ -819,8 +880,10 @@ relation_process_select(void *handle_ptr)
   }
 
   /* Check whether the given predicate is true for this tuple. */
+  QUERY_STATS_ADD(rows_evaluated);
   if(adt->lvm_instance == NULL ||
      lvm_execute(adt->lvm_instance) == wanted_result) {
+    QUERY_STATS_ADD(rows_matched);
     if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
       for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
         from_ptr = row + attr_map_ptr->from_offset;
@@ -865,6 +928,7 @@ end_aggregation:
 
   handle->current_row = 1;
   AQL_GET_FLAGS(adt) &= ~AQL_FLAG_AGGREGATE; /* Stop the aggregation. */
+  QUERY_STATS_STOP();
 
   return DB_GOT_ROW;
 }
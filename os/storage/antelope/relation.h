@@ -68,6 +68,10 @@ struct relation {
   attribute_id_t attribute_count;
   tuple_id_t cardinality;
   tuple_id_t next_row;
+#if DB_ROW_CACHE_PAGES > 0
+  /* The number of rows in the tuple file, kept by the storage layer. */
+  tuple_id_t row_amount;
+#endif
   db_storage_id_t tuple_storage;
   db_direction_t dir;
   uint8_t references;
@@ -77,6 +81,19 @@ struct relation {
 
 typedef struct relation relation_t;
 
+#if DB_QUERY_STATS
+typedef struct query_stats {
+  unsigned long selects;
+  unsigned long compiled;
+  unsigned long rows_evaluated;
+  unsigned long rows_matched;
+  /* Clock ticks from the start of each selection until its last row. */
+  unsigned long query_time;
+} query_stats_t;
+
+extern query_stats_t query_stats;
+#endif /* DB_QUERY_STATS */
+
 /* API for relations. */
 db_result_t relation_init(void);
 db_result_t relation_process_remove(void *);
@@ -68,6 +68,115 @@ struct index_record {
 
 #define ROW_XOR 0xf6U
 
+#if DB_STORAGE_STATS
+storage_stats_t storage_stats;
+#define STORAGE_STATS_ADD(field) storage_stats.field++
+#else
+#define STORAGE_STATS_ADD(field)
+#endif /* DB_STORAGE_STATS */
+
+#if DB_ROW_CACHE_PAGES > 0
+/* A page of a tuple file. Pages with no valid bytes are unused. */
+struct row_page {
+  db_storage_id_t fd;
+  cfs_offset_t offset;
+  unsigned length;
+  unsigned long last_used;
+  unsigned char data[DB_ROW_CACHE_PAGE_SIZE];
+};
+
+static struct row_page row_pages[DB_ROW_CACHE_PAGES];
+static unsigned long row_page_clock;
+
+static struct row_page *
+row_page_get(db_storage_id_t fd, cfs_offset_t offset)
+{
+  struct row_page *page;
+  struct row_page *victim;
+  int r;
+
+  victim = &row_pages[0];
+  for(page = row_pages; page < &row_pages[DB_ROW_CACHE_PAGES]; page++) {
+    if(page->length > 0 && page->fd == fd && page->offset == offset) {
+      STORAGE_STATS_ADD(page_hits);
+      page->last_used = ++row_page_clock;
+      return page;
+    }
+    if(victim->length > 0 &&
+       (page->length == 0 || page->last_used < victim->last_used)) {
+      victim = page;
+    }
+  }
+
+  STORAGE_STATS_ADD(page_misses);
+  victim->length = 0;
+
+  STORAGE_STATS_ADD(file_seeks);
+  if(cfs_seek(fd, offset, CFS_SEEK_SET) == (cfs_offset_t)-1) {
+    return NULL;
+  }
+
+  STORAGE_STATS_ADD(file_reads);
+  r = cfs_read(fd, victim->data, sizeof(victim->data));
+  if(r <= 0) {
+    PRINTF("DB: Reading a page failed on fd %d\n", fd);
+    return NULL;
+  }
+
+  victim->fd = fd;
+  victim->offset = offset;
+  victim->length = r;
+  victim->last_used = ++row_page_clock;
+  return victim;
+}
+
+/* Drop the cached pages of a file that hold bytes from offset onwards. */
+static void
+row_pages_invalidate(db_storage_id_t fd, cfs_offset_t offset)
+{
+  struct row_page *page;
+
+  for(page = row_pages; page < &row_pages[DB_ROW_CACHE_PAGES]; page++) {
+    if(page->fd == fd && page->offset + DB_ROW_CACHE_PAGE_SIZE > offset) {
+      page->length = 0;
+    }
+  }
+}
+
+static db_result_t
+read_cached_row(relation_t *rel, tuple_id_t tuple_id, storage_row_t row)
+{
+  struct row_page *page;
+  cfs_offset_t offset;
+  unsigned skip;
+  unsigned copied;
+  unsigned len;
+
+  offset = (cfs_offset_t)tuple_id * rel->row_length;
+
+  /* A row can start in one page and end in the next. */
+  for(copied = 0; copied < rel->row_length; copied += len) {
+    skip = (offset + copied) % DB_ROW_CACHE_PAGE_SIZE;
+    page = row_page_get(rel->tuple_storage, offset + copied - skip);
+    if(page == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+
+    len = rel->row_length - copied;
+    if(skip + len > page->length) {
+      if(page->length < DB_ROW_CACHE_PAGE_SIZE) {
+        PRINTF("DB: Incomplete record in relation %s\n", rel->name);
+        return DB_STORAGE_ERROR;
+      }
+      len = page->length - skip;
+    }
+    memcpy(row + copied, page->data + skip, len);
+  }
+
+  return DB_OK;
+}
+#endif /* DB_ROW_CACHE_PAGES > 0 */
+
 static void
 merge_strings(char *dest, char *prefix, char *suffix)
 {
@@ -111,6 +220,11 @@ storage_load(relation_t *rel)
     return DB_STORAGE_ERROR;
   }
 
+#if DB_ROW_CACHE_PAGES > 0
+  row_pages_invalidate(rel->tuple_storage, 0);
+  rel->row_amount = INVALID_TUPLE;
+#endif
+
   return DB_OK;
 }
 
@@ -120,6 +234,11 @@ storage_unload(relation_t *rel)
   if(RELATION_HAS_TUPLES(rel)) {
     PRINTF("DB: Unload tuple file %s\n", rel->tuple_filename);
 
+#if DB_ROW_CACHE_PAGES > 0
+    row_pages_invalidate(rel->tuple_storage, 0);
+    rel->row_amount = INVALID_TUPLE;
+#endif
+
     cfs_close(rel->tuple_storage);
     rel->tuple_storage = -1;
   }
@@ -280,6 +399,10 @@ db_result_t
 storage_drop_relation(relation_t *rel, int remove_tuples)
 {
   if(remove_tuples && RELATION_HAS_TUPLES(rel)) {
+#if DB_ROW_CACHE_PAGES > 0
+    row_pages_invalidate(rel->tuple_storage, 0);
+    rel->row_amount = INVALID_TUPLE;
+#endif
     cfs_remove(rel->tuple_filename);
   }
   return cfs_remove(rel->name) < 0 ? DB_STORAGE_ERROR : DB_OK;
@@ -403,7 +526,9 @@ storage_put_index(index_t *index)
 db_result_t
 storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
 {
+#if DB_ROW_CACHE_PAGES == 0
   int r;
+#endif
   tuple_id_t nrows;
 
   if(DB_ERROR(storage_get_row_amount(rel, &nrows))) {
@@ -414,11 +539,20 @@ storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
     return DB_FINISHED;
   }
 
+  STORAGE_STATS_ADD(rows_read);
+
+#if DB_ROW_CACHE_PAGES > 0
+  if(DB_ERROR(read_cached_row(rel, *tuple_id, row))) {
+    return DB_STORAGE_ERROR;
+  }
+#else
+  STORAGE_STATS_ADD(file_seeks);
   if(cfs_seek(rel->tuple_storage, *tuple_id * rel->row_length, CFS_SEEK_SET) ==
               (cfs_offset_t)-1) {
     return DB_STORAGE_ERROR;
   }
 
+  STORAGE_STATS_ADD(file_reads);
   r = cfs_read(rel->tuple_storage, row, rel->row_length);
   if(r < 0) {
     PRINTF("DB: Reading failed on fd %d\n", rel->tuple_storage);
@@ -429,6 +563,7 @@ storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
     PRINTF("DB: Incomplete record: %d < %d\n", r, rel->row_length);
     return DB_STORAGE_ERROR;
   }
+#endif /* DB_ROW_CACHE_PAGES > 0 */
 
   row[rel->row_length - 1] ^= ROW_XOR;
 
@@ -462,9 +597,16 @@ storage_put_row(relation_t *rel, storage_row_t row)
     if(r != missing_bytes) {
       return DB_STORAGE_ERROR;
     }
+    end += r;
   }
 #endif
 
+#if DB_ROW_CACHE_PAGES > 0
+  /* The page holding the old end of the file is about to change. */
+  row_pages_invalidate(rel->tuple_storage, end);
+  rel->row_amount = INVALID_TUPLE;
+#endif
+
   /* Ensure that last written byte is separated from 0, to make file
      lengths correct in Coffee. */
   last_byte = row + rel->row_length - 1;
@@ -486,6 +628,10 @@ storage_put_row(relation_t *rel, storage_row_t row)
 
   *last_byte ^= ROW_XOR;
 
+#if DB_ROW_CACHE_PAGES > 0
+  rel->row_amount = (tuple_id_t)((end + rel->row_length) / rel->row_length);
+#endif
+
   return DB_OK;
 }
 
@@ -496,13 +642,21 @@ storage_get_row_amount(relation_t *rel, tuple_id_t *amount)
 
   if(rel->row_length == 0) {
     *amount = 0;
+#if DB_ROW_CACHE_PAGES > 0
+  } else if(rel->row_amount != INVALID_TUPLE) {
+    *amount = rel->row_amount;
+#endif
   } else {
+    STORAGE_STATS_ADD(file_seeks);
     offset = cfs_seek(rel->tuple_storage, 0, CFS_SEEK_END);
     if(offset == (cfs_offset_t)-1) {
       return DB_STORAGE_ERROR;
     }
 
     *amount = (tuple_id_t)(offset / rel->row_length);
+#if DB_ROW_CACHE_PAGES > 0
+    rel->row_amount = *amount;
+#endif
   }
 
   return DB_OK;
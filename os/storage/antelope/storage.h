@@ -50,6 +50,18 @@
 
 typedef unsigned char * storage_row_t;
 
+#if DB_STORAGE_STATS
+typedef struct storage_stats {
+  unsigned long rows_read;
+  unsigned long file_seeks;
+  unsigned long file_reads;
+  unsigned long page_hits;
+  unsigned long page_misses;
+} storage_stats_t;
+
+extern storage_stats_t storage_stats;
+#endif /* DB_STORAGE_STATS */
+
 char *storage_generate_file(char *, unsigned long);
 
 db_result_t storage_load(relation_t *);
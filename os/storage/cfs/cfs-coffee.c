@@ -84,6 +84,20 @@
 #define COFFEE_EXTENDED_WEAR_LEVELLING  1
 #endif
 
+/*
+ * The number of files in the RAM name index, which maps name hashes to
+ * file extents so that files can be found without scanning the file
+ * headers. If there are more files than entries, names that are not
+ * indexed are searched for in the storage. Zero disables the index.
+ */
+#ifndef COFFEE_NAME_INDEX_SIZE
+#ifdef COFFEE_CONF_NAME_INDEX_SIZE
+#define COFFEE_NAME_INDEX_SIZE COFFEE_CONF_NAME_INDEX_SIZE
+#else
+#define COFFEE_NAME_INDEX_SIZE 0
+#endif
+#endif
+
 #if COFFEE_START & (COFFEE_SECTOR_SIZE - 1)
 #error COFFEE_START must point to the first byte in a sector.
 #endif
@@ -197,6 +211,20 @@ struct log_param {
   uint16_t size;
 };
 
+#if COFFEE_NAME_INDEX_SIZE > 0
+/* The name index entry of an active file. */
+struct name_index_entry {
+  cfs_offset_t end;
+  coffee_page_t page;
+  uint16_t hash;
+};
+
+/* Name index states. */
+#define NAME_INDEX_UNBUILT  0
+#define NAME_INDEX_COMPLETE 1
+#define NAME_INDEX_PARTIAL  2
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
+
 /*
  * Variables that keep track of opened files and internal
  * optimization information for Coffee.
@@ -205,6 +233,10 @@ static struct file coffee_files[COFFEE_MAX_OPEN_FILES];
 static struct file_desc coffee_fd_set[COFFEE_FD_SET_SIZE];
 static coffee_page_t next_free;
 static char gc_wait;
+#if COFFEE_NAME_INDEX_SIZE > 0
+static struct name_index_entry name_index[COFFEE_NAME_INDEX_SIZE];
+static uint8_t name_index_state;
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
 
 /*---------------------------------------------------------------------------*/
 static void
@@ -413,6 +445,132 @@ next_file(coffee_page_t page, struct file_header *hdr)
   return page + hdr->max_pages;
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_NAME_INDEX_SIZE > 0
+static uint16_t
+name_hash(const char *name)
+{
+  uint32_t hash = 2166136261UL;
+  int i;
+
+  for(i = 0; i < COFFEE_NAME_LENGTH && name[i] != '\0'; i++) {
+    hash = (hash ^ (uint8_t)name[i]) * 16777619UL;
+  }
+  return (uint16_t)(hash ^ (hash >> 16));
+}
+/*---------------------------------------------------------------------------*/
+static struct name_index_entry *
+name_index_entry(coffee_page_t page)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_NAME_INDEX_SIZE; i++) {
+    if(name_index[i].page == page) {
+      return &name_index[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+name_index_insert(const char *name, coffee_page_t page, cfs_offset_t end)
+{
+  struct name_index_entry *entry;
+
+  entry = name_index_entry(INVALID_PAGE);
+  if(entry == NULL) {
+    /* Out of entries, names that are not found must be searched for
+       in the storage from now on. */
+    name_index_state = NAME_INDEX_PARTIAL;
+    return;
+  }
+  entry->page = page;
+  entry->hash = name_hash(name);
+  entry->end = end;
+}
+/*---------------------------------------------------------------------------*/
+static void
+name_index_build(void)
+{
+  struct file_header hdr;
+  coffee_page_t page;
+  int i;
+
+  for(i = 0; i < COFFEE_NAME_INDEX_SIZE; i++) {
+    name_index[i].page = INVALID_PAGE;
+  }
+  name_index_state = NAME_INDEX_COMPLETE;
+
+  for(page = 0; page < COFFEE_PAGE_COUNT; page = next_file(page, &hdr)) {
+    read_header(&hdr, page);
+    if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr)) {
+      name_index_insert(hdr.name, page, UNKNOWN_OFFSET);
+    }
+  }
+  PRINTF("Coffee: Built the name index, %s\n",
+         name_index_state == NAME_INDEX_COMPLETE ? "complete" : "partial");
+}
+/*---------------------------------------------------------------------------*/
+/* Adds a reserved file. A file that is reserved before the index is
+   built gets indexed when the index is built. */
+static void
+name_index_add(const char *name, coffee_page_t page)
+{
+  if(name_index_state != NAME_INDEX_UNBUILT) {
+    name_index_insert(name, page, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+name_index_remove(coffee_page_t page)
+{
+  struct name_index_entry *entry;
+
+  if(name_index_state != NAME_INDEX_UNBUILT) {
+    entry = name_index_entry(page);
+    if(entry != NULL) {
+      entry->page = INVALID_PAGE;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Keeps the known end of a file that leaves the file cache. */
+static void
+name_index_save_end(const struct file *file)
+{
+  struct name_index_entry *entry;
+
+  if(name_index_state != NAME_INDEX_UNBUILT && file->end != UNKNOWN_OFFSET) {
+    entry = name_index_entry(file->page);
+    if(entry != NULL) {
+      entry->end = file->end;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct name_index_entry *
+name_index_find(const char *name, struct file_header *hdr)
+{
+  uint16_t hash;
+  int i;
+
+  if(name_index_state == NAME_INDEX_UNBUILT) {
+    name_index_build();
+  }
+
+  hash = name_hash(name);
+  for(i = 0; i < COFFEE_NAME_INDEX_SIZE; i++) {
+    if(name_index[i].page != INVALID_PAGE && name_index[i].hash == hash) {
+      /* Names may share a hash, the header tells. */
+      read_header(hdr, name_index[i].page);
+      if(HDR_ACTIVE(*hdr) && !HDR_LOG(*hdr) && strcmp(name, hdr->name) == 0) {
+        return &name_index[i];
+      }
+    }
+  }
+  return NULL;
+}
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
 static struct file *
 load_file(coffee_page_t start, struct file_header *hdr)
 {
@@ -436,6 +594,9 @@ load_file(coffee_page_t start, struct file_header *hdr)
   if(free == -1) {
     if(unreferenced != -1) {
       i = unreferenced;
+#if COFFEE_NAME_INDEX_SIZE > 0
+      name_index_save_end(&coffee_files[i]);
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
     } else {
       return NULL;
     }
@@ -458,6 +619,27 @@ find_file(const char *name)
   int i;
   struct file_header hdr;
   coffee_page_t page;
+#if COFFEE_NAME_INDEX_SIZE > 0
+  struct name_index_entry *entry;
+  struct file *file;
+
+  entry = name_index_find(name, &hdr);
+  if(entry != NULL) {
+    for(i = 0; i < COFFEE_MAX_OPEN_FILES; i++) {
+      if(!FILE_FREE(&coffee_files[i]) && coffee_files[i].page == entry->page) {
+        return &coffee_files[i];
+      }
+    }
+    file = load_file(entry->page, &hdr);
+    if(file != NULL) {
+      file->end = entry->end;
+    }
+    return file;
+  }
+  if(name_index_state == NAME_INDEX_COMPLETE) {
+    return NULL;
+  }
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
 
   /* First check if the file metadata is cached. */
   for(i = 0; i < COFFEE_MAX_OPEN_FILES; i++) {
@@ -572,6 +754,9 @@ remove_by_page(coffee_page_t page, int remove_log,
 
   hdr.flags |= HDR_FLAG_OBSOLETE;
   write_header(&hdr, page);
+#if COFFEE_NAME_INDEX_SIZE > 0
+  name_index_remove(page);
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
 
   gc_wait = 0;
 
@@ -636,6 +821,11 @@ reserve(const char *name, coffee_page_t pages,
   hdr.max_pages = pages;
   hdr.flags = HDR_FLAG_ALLOCATED | flags;
   write_header(&hdr, page);
+#if COFFEE_NAME_INDEX_SIZE > 0
+  if(!(flags & HDR_FLAG_LOG)) {
+    name_index_add(hdr.name, page);
+  }
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
 
   PRINTF("Coffee: Reserved %u pages starting from %u for file %s\n",
          (unsigned)pages, (unsigned)page, name);
@@ -1253,9 +1443,30 @@ cfs_readdir(struct cfs_dir *dir, struct cfs_dirent *record)
   while(page < COFFEE_PAGE_COUNT) {
     read_header(&hdr, page);
     if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr)) {
-      memcpy(record->name, hdr.name, sizeof(record->name));
-      record->name[sizeof(record->name) - 1] = '\0';
-      record->size = file_end(page);
+      memcpy(record->name, hdr.name,
+             MIN(sizeof(record->name), sizeof(hdr.name)));
+      record->name[MIN(sizeof(record->name), sizeof(hdr.name)) - 1] = '\0';
+      record->size = UNKNOWN_OFFSET;
+#if COFFEE_NAME_INDEX_SIZE > 0
+      if(name_index_state != NAME_INDEX_UNBUILT) {
+        /* A cached file has the most recent end. */
+        struct name_index_entry *entry = name_index_entry(page);
+        int i;
+
+        if(entry != NULL) {
+          record->size = entry->end;
+        }
+        for(i = 0; i < COFFEE_MAX_OPEN_FILES; i++) {
+          if(!FILE_FREE(&coffee_files[i]) && coffee_files[i].page == page &&
+             coffee_files[i].end != UNKNOWN_OFFSET) {
+            record->size = coffee_files[i].end;
+          }
+        }
+      }
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
+      if(record->size == UNKNOWN_OFFSET) {
+        record->size = file_end(page);
+      }
 
       next_page = next_file(page, &hdr);
       memcpy(dir->state, &next_page, sizeof(coffee_page_t));
@@ -1338,6 +1549,10 @@ cfs_coffee_format(void)
   memset(&coffee_fd_set, 0, sizeof(coffee_fd_set));
   next_free = 0;
   gc_wait = 1;
+#if COFFEE_NAME_INDEX_SIZE > 0
+  /* The storage is empty, so is the index. */
+  name_index_build();
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
 
   PRINTF(" done!\n");
 
@@ -67,6 +67,9 @@ PROCESS_THREAD(ctimer_process, ev, data)
   struct ctimer *c;
   PROCESS_BEGIN();
 
+  /* Only handles its own events, skip broadcasts */
+  process_filter_broadcasts(PROCESS_CURRENT());
+
   for(c = list_head(ctimer_list); c != NULL; c = c->next) {
     etimer_set(&c->etimer, c->etimer.timer.interval);
   }
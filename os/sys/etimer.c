@@ -52,7 +52,42 @@
 
 #include <stdio.h>
 
+#if ETIMER_WHEEL
+/*
+ * Hierarchical timing wheel. Level 0 has one slot per clock tick for the
+ * next WHEEL_SLOTS ticks, every further level covers WHEEL_SLOTS times the
+ * range of the level below it. Timers on higher levels are cascaded down
+ * when the lower level wraps, so each timer is moved at most
+ * ETIMER_WHEEL_LEVELS times during its lifetime.
+ */
+#define WHEEL_SLOTS   (1 << ETIMER_WHEEL_SLOT_BITS)
+#define WHEEL_MASK    (WHEEL_SLOTS - 1)
+#define WHEEL_SHIFT(level) (ETIMER_WHEEL_SLOT_BITS * (level))
+#define WHEEL_SPAN(level)  (1UL << WHEEL_SHIFT(level))
+
+/* Bucket numbers kept in etimer::bucket: the slots of all levels, then
+   the overflow list. Any other number means the timer is not linked. */
+#define WHEEL_BUCKET(level, slot) ((level) * WHEEL_SLOTS + (slot))
+#define WHEEL_FAR     WHEEL_BUCKET(ETIMER_WHEEL_LEVELS, 0)
+#define WHEEL_NONE    0xffff
+
+#if WHEEL_FAR >= WHEEL_NONE
+#error "Too many etimer wheel slots, reduce ETIMER_CONF_WHEEL_SLOT_BITS or ETIMER_CONF_WHEEL_LEVELS"
+#endif
+
+static struct etimer *wheel[ETIMER_WHEEL_LEVELS][WHEEL_SLOTS];
+/* Timers too far in the future for the last level */
+static struct etimer *wheel_far;
+/* Number of timers on the wheel */
+static unsigned wheel_count;
+/* The tick up to which the wheel has been processed */
+static clock_time_t wheel_now;
+/* Cached earliest timer, recomputed lazily when next_dirty is set */
+static struct etimer *next_timer;
+static uint8_t next_dirty;
+#else /* ETIMER_WHEEL */
 static struct etimer *timerlist;
+#endif /* ETIMER_WHEEL */
 static clock_time_t next_expiration;
 
 PROCESS(etimer_process, "Event timer");
@@ -65,6 +100,213 @@ PROCESS(etimer_process, "Event timer");
 #else
 #define PRINTF(...) do {} while(0)
 #endif
+#if ETIMER_WHEEL
+/*---------------------------------------------------------------------------*/
+static struct etimer **
+bucket_head(unsigned bucket)
+{
+  if(bucket == WHEEL_FAR) {
+    return &wheel_far;
+  }
+  return &wheel[bucket / WHEEL_SLOTS][bucket & WHEEL_MASK];
+}
+/*---------------------------------------------------------------------------*/
+static void
+bucket_push(unsigned bucket, struct etimer *et)
+{
+  struct etimer **head = bucket_head(bucket);
+
+  et->next = *head;
+  et->bucket = bucket;
+  *head = et;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Unlinks a timer from the bucket it names. Only the bucket is walked,
+ * never the links of the timer itself, so a timer that was never set
+ * is found to be unlinked whatever its memory holds.
+ */
+static int
+bucket_unlink(struct etimer *et)
+{
+  struct etimer **itr;
+
+  if(et->bucket > WHEEL_FAR) {
+    return 0;
+  }
+  for(itr = bucket_head(et->bucket); *itr != NULL; itr = &(*itr)->next) {
+    if(*itr == et) {
+      *itr = et->next;
+      et->next = NULL;
+      et->bucket = WHEEL_NONE;
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_place(struct etimer *et)
+{
+  clock_time_t expiry = etimer_expiration_time(et);
+  unsigned long delta = (clock_time_t)(expiry - wheel_now);
+  int level;
+
+  for(level = 0; level < ETIMER_WHEEL_LEVELS; level++) {
+    if(delta < WHEEL_SPAN(level + 1)) {
+      bucket_push(WHEEL_BUCKET(level, ((unsigned long)expiry >>
+                                       WHEEL_SHIFT(level)) & WHEEL_MASK), et);
+      return;
+    }
+  }
+  bucket_push(WHEEL_FAR, et);
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_replace(struct etimer **head)
+{
+  struct etimer *t;
+  struct etimer *next;
+
+  t = *head;
+  *head = NULL;
+  for(; t != NULL; t = next) {
+    next = t->next;
+    wheel_place(t);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_cascade(void)
+{
+  unsigned long tick = wheel_now;
+  int level;
+
+  if((tick & (WHEEL_SPAN(ETIMER_WHEEL_LEVELS) - 1)) == 0) {
+    wheel_replace(&wheel_far);
+  }
+  for(level = ETIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+    if((tick & (WHEEL_SPAN(level) - 1)) == 0) {
+      wheel_replace(&wheel[level][(tick >> WHEEL_SHIFT(level)) & WHEEL_MASK]);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct etimer *
+earliest_in(struct etimer *t, struct etimer *best)
+{
+  for(; t != NULL; t = t->next) {
+    if(best == NULL ||
+       (clock_time_t)(etimer_expiration_time(t) - wheel_now) <
+       (clock_time_t)(etimer_expiration_time(best) - wheel_now)) {
+      best = t;
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_next_expiration(void)
+{
+  struct etimer *best = NULL;
+  unsigned long base;
+  int level;
+  int i;
+
+  /* Within one level the first occupied slot holds the earliest timers
+     of that level, but a lower level may still hold an earlier timer
+     than a higher one, so every level is inspected. Slots on levels
+     above 0 that match the current index only hold timers that are one
+     full turn ahead, hence they are visited last. */
+  for(level = 0; level < ETIMER_WHEEL_LEVELS && wheel_count > 0; level++) {
+    base = (unsigned long)wheel_now >> WHEEL_SHIFT(level);
+    for(i = level == 0 ? 0 : 1; i < WHEEL_SLOTS + (level == 0 ? 0 : 1); i++) {
+      if(wheel[level][(base + i) & WHEEL_MASK] != NULL) {
+        best = earliest_in(wheel[level][(base + i) & WHEEL_MASK], best);
+        break;
+      }
+    }
+  }
+  best = earliest_in(wheel_far, best);
+
+  next_timer = best;
+  next_expiration = best != NULL ? etimer_expiration_time(best) : 0;
+  next_dirty = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+post_expiries(void)
+{
+  clock_time_t now = clock_time();
+  struct etimer **slot;
+  struct etimer *t;
+  int ret;
+
+  while(wheel_count > 0) {
+    slot = &wheel[0][wheel_now & WHEEL_MASK];
+    while(*slot != NULL) {
+      t = *slot;
+      ret = process_post(t->p, PROCESS_EVENT_TIMER, t);
+
+      if(ret != PROCESS_ERR_OK) {
+        /* the event queue is full; we will try again later */
+        PRINTF("etimer: PROCESS_ERR %d\n", ret);
+        etimer_request_poll();
+        next_dirty = 1;
+        return;
+      }
+
+      bucket_unlink(t);
+      wheel_count--;
+      t->p = PROCESS_NONE;
+    }
+
+    if(wheel_now == now) {
+      break;
+    }
+    wheel_now++;
+    wheel_cascade();
+  }
+
+  if(wheel_count == 0) {
+    wheel_now = now;
+  }
+  next_dirty = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_from(struct etimer **itr, struct process *p)
+{
+  struct etimer *t;
+
+  while(*itr != NULL) {
+    t = *itr;
+    if(t->p == p) {
+      *itr = t->next;
+      t->next = NULL;
+      t->bucket = WHEEL_NONE;
+      wheel_count--;
+    } else {
+      itr = &t->next;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_process(struct process *p)
+{
+  int level;
+  int i;
+
+  for(level = 0; level < ETIMER_WHEEL_LEVELS && wheel_count > 0; level++) {
+    for(i = 0; i < WHEEL_SLOTS; i++) {
+      remove_from(&wheel[level][i], p);
+    }
+  }
+  remove_from(&wheel_far, p);
+  next_dirty = 1;
+}
+#else /* ETIMER_WHEEL */
 /*---------------------------------------------------------------------------*/
 static void
 update_next_expiration(void)
@@ -124,11 +366,15 @@ remove_process(struct process *p)
     }
   }
 }
+#endif /* ETIMER_WHEEL */
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(etimer_process, ev, data)
 {
   PROCESS_BEGIN();
 
+  /* Only handles its own events, skip broadcasts */
+  process_filter_broadcasts(PROCESS_CURRENT());
+
   while(1) {
     PROCESS_YIELD();
 
@@ -153,8 +399,10 @@ add_timer(struct etimer *timer)
 {
   clock_time_t now = clock_time();
   struct process *proc = PROCESS_CURRENT();
+#if !ETIMER_WHEEL
   struct etimer *t_this;
   struct etimer *t_last;
+#endif /* !ETIMER_WHEEL */
 
   if(proc == PROCESS_NONE) {
     /* don't add an etimer with no process */
@@ -167,6 +415,10 @@ add_timer(struct etimer *timer)
   if(timer->p != PROCESS_NONE) {
     etimer_stop(timer);
   }
+#if ETIMER_WHEEL
+  /* Not linked until wheel_place() below */
+  timer->bucket = WHEEL_NONE;
+#endif /* ETIMER_WHEEL */
 
   // this is protection vs addin alredy expired timers
   if (timer_expired_at(&timer->timer, now)){
@@ -180,6 +432,19 @@ add_timer(struct etimer *timer)
 
   timer->p = proc;
 
+#if ETIMER_WHEEL
+  if(wheel_count == 0) {
+    wheel_now = now;
+  }
+  wheel_place(timer);
+  wheel_count++;
+
+  if(!next_dirty &&
+     (next_timer == NULL || etimer_lt(timer, next_timer, now))) {
+    next_timer = timer;
+    next_expiration = etimer_expiration_time(timer);
+  }
+#else /* ETIMER_WHEEL */
   if(timerlist == NULL || etimer_lte(timer, timerlist, now)) {
     timer->next = timerlist;
     timerlist = timer;
@@ -197,6 +462,7 @@ add_timer(struct etimer *timer)
 
   t_last->next = timer;
   timer->next = t_this;
+#endif /* ETIMER_WHEEL */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -250,24 +516,51 @@ etimer_expiration_time(struct etimer *et)
 int
 etimer_pending(void)
 {
+#if ETIMER_WHEEL
+  return wheel_count > 0;
+#else /* ETIMER_WHEEL */
   return timerlist != NULL;
+#endif /* ETIMER_WHEEL */
 }
 /*---------------------------------------------------------------------------*/
 clock_time_t
 etimer_next_expiration_time(void)
 {
+#if ETIMER_WHEEL
+  if(next_dirty) {
+    update_next_expiration();
+  }
+#endif /* ETIMER_WHEEL */
   return etimer_pending() ? next_expiration : 0;
 }
 /*---------------------------------------------------------------------------*/
 const struct timer *
 etimer_next_to_expire(void)
 {
+#if ETIMER_WHEEL
+  if(next_dirty) {
+    update_next_expiration();
+  }
+  return next_timer ? &(next_timer->timer) : NULL;
+#else /* ETIMER_WHEEL */
   return timerlist ? &(timerlist->timer) : NULL;
+#endif /* ETIMER_WHEEL */
 }
 /*---------------------------------------------------------------------------*/
 void
 etimer_stop(struct etimer *et)
 {
+#if ETIMER_WHEEL
+  /* Expired and stopped timers have no process. Any other timer, even
+     one that was never set, is looked up in the bucket it names. */
+  if(et->p != PROCESS_NONE && bucket_unlink(et)) {
+    wheel_count--;
+    if(et == next_timer) {
+      next_timer = NULL;
+      next_dirty = 1;
+    }
+  }
+#else /* ETIMER_WHEEL */
   struct etimer *t;
 
   /* First check if et is the first event timer on the list. */
@@ -286,9 +579,13 @@ etimer_stop(struct etimer *et)
       t->next = et->next;
     }
   }
+#endif /* ETIMER_WHEEL */
 
   /* Remove the next pointer from the item to be removed. */
   et->next = NULL;
+#if ETIMER_WHEEL
+  et->bucket = WHEEL_NONE;
+#endif /* ETIMER_WHEEL */
   /* Set the timer as expired */
   et->p = PROCESS_NONE;
 }
@@ -67,6 +67,34 @@
 #include "sys/timer.h"
 #include "sys/process.h"
 
+/*
+ * Select the timer store. By default active event timers are kept on a
+ * sorted list, which is compact but costs O(n) per etimer_set(). Setting
+ * ETIMER_CONF_WHEEL to 1 selects a hierarchical timing wheel with O(1)
+ * insert, and a cancel that walks only the slot of the timer, intended
+ * for platforms with many concurrent timers.
+ */
+#ifdef ETIMER_CONF_WHEEL
+#define ETIMER_WHEEL ETIMER_CONF_WHEEL
+#else /* ETIMER_CONF_WHEEL */
+#define ETIMER_WHEEL 0
+#endif /* ETIMER_CONF_WHEEL */
+
+/* Number of slots per wheel level, as a power of two */
+#ifdef ETIMER_CONF_WHEEL_SLOT_BITS
+#define ETIMER_WHEEL_SLOT_BITS ETIMER_CONF_WHEEL_SLOT_BITS
+#else /* ETIMER_CONF_WHEEL_SLOT_BITS */
+#define ETIMER_WHEEL_SLOT_BITS 6
+#endif /* ETIMER_CONF_WHEEL_SLOT_BITS */
+
+/* Number of wheel levels. Timers beyond the range of the last level
+   are kept on an overflow list that is re-sorted when the wheel wraps. */
+#ifdef ETIMER_CONF_WHEEL_LEVELS
+#define ETIMER_WHEEL_LEVELS ETIMER_CONF_WHEEL_LEVELS
+#else /* ETIMER_CONF_WHEEL_LEVELS */
+#define ETIMER_WHEEL_LEVELS 3
+#endif /* ETIMER_CONF_WHEEL_LEVELS */
+
 /**
  * A timer.
  *
@@ -78,6 +106,9 @@
 struct etimer {
   struct timer timer;
   struct etimer *next;
+#if ETIMER_WHEEL
+  uint16_t bucket;
+#endif /* ETIMER_WHEEL */
   struct process *p;
 };
 typedef struct etimer etimer_t;
@@ -44,9 +44,13 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "contiki.h"
 #include "sys/process.h"
+#if PROCESS_SUBSCRIPTIONS
+#include "lib/memb.h"
+#endif /* PROCESS_SUBSCRIPTIONS */
 //#include "sys/arg.h"
 
 /*
@@ -62,17 +66,72 @@ static process_event_t lastevent;
  */
 typedef struct process_event_item  event_data;
 
+#if PROCESS_PRIORITY_QUEUES
+#define NUM_QUEUES PROCESS_PRIO_NUM
+/* Order in which the priority queues are drained */
+static const unsigned char queue_order[NUM_QUEUES] = {
+  PROCESS_PRIO_HIGH, PROCESS_PRIO_NORMAL, PROCESS_PRIO_BACKGROUND
+};
+#else /* PROCESS_PRIORITY_QUEUES */
+#define NUM_QUEUES 1
+#endif /* PROCESS_PRIORITY_QUEUES */
+
+struct event_queue {
+  process_num_events_t nevents, fevent;
+  event_data events[PROCESS_CONF_NUMEVENTS];
+};
+
 #if !PROCESS_CONF_STATS
 #define STATIC_OPEN static
 #else
 #define STATIC_OPEN
 process_num_events_t process_maxevents;
+#if PROCESS_PRIORITY_QUEUES
+process_num_events_t process_maxevents_prio[NUM_QUEUES];
+#endif /* PROCESS_PRIORITY_QUEUES */
 #endif
 
+/* Total number of queued events over all queues */
 STATIC_OPEN
-process_num_events_t nevents, fevent;
+unsigned nevents;
 STATIC_OPEN
-event_data      events[PROCESS_CONF_NUMEVENTS];
+struct event_queue event_queues[NUM_QUEUES];
+
+#if PROCESS_SUBSCRIPTIONS
+/*
+ * Broadcast subscriptions, hashed by event number.
+ */
+#define SUBSCRIPTION_BUCKETS 8
+#define SUBSCRIPTION_BUCKET(ev) ((ev) & (SUBSCRIPTION_BUCKETS - 1))
+
+struct subscription {
+  struct subscription *next;
+  struct process *p;
+  process_event_t ev;
+};
+
+MEMB(subscription_memb, struct subscription, PROCESS_MAX_SUBSCRIPTIONS);
+static struct subscription *subscriptions[SUBSCRIPTION_BUCKETS];
+/* While a broadcast walks a bucket, removed subscriptions are only
+   marked, and freed when the walk is done */
+static uint8_t subscriptions_walking;
+static uint8_t subscriptions_removed;
+/* Running processes that are not filtered and get every broadcast */
+static struct process *bcast_list;
+#endif /* PROCESS_SUBSCRIPTIONS */
+
+#if PROCESS_POLL_INDEX
+/*
+ * Poll table. process_poll() marks the group of eight slots that the
+ * polled process belongs to, do_poll() only visits marked groups.
+ */
+#define POLL_GROUPS (PROCESS_POLL_SLOTS / 8)
+
+static struct process *poll_table[PROCESS_POLL_SLOTS];
+static volatile unsigned char poll_groups[POLL_GROUPS];
+/* Number of running processes that did not get a poll slot */
+static unsigned char poll_unindexed;
+#endif /* PROCESS_POLL_INDEX */
 
 volatile unsigned char process_poll_requested;
 #define poll_requested  process_poll_requested
@@ -98,6 +157,162 @@ process_alloc_event(void)
 {
   return lastevent++;
 }
+#if PROCESS_POLL_INDEX
+/*---------------------------------------------------------------------------*/
+static void
+poll_slot_alloc(struct process *p)
+{
+  unsigned i;
+
+  for(i = 0; i < PROCESS_POLL_SLOTS; i++) {
+    if(poll_table[i] == NULL) {
+      poll_table[i] = p;
+      p->pollslot = i;
+      return;
+    }
+  }
+  p->pollslot = PROCESS_POLL_SLOT_NONE;
+  poll_unindexed++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+poll_slot_free(struct process *p)
+{
+  if(p->pollslot == PROCESS_POLL_SLOT_NONE) {
+    poll_unindexed--;
+  } else {
+    poll_table[p->pollslot] = NULL;
+  }
+}
+#endif /* PROCESS_POLL_INDEX */
+#if PROCESS_SUBSCRIPTIONS
+/*---------------------------------------------------------------------------*/
+static void
+bcast_remove(struct process *p)
+{
+  struct process **pp;
+
+  /* p->bcast_next is kept, so that a broadcast that is being delivered
+     to p can continue with the next process */
+  for(pp = &bcast_list; *pp != NULL; pp = &(*pp)->bcast_next) {
+    if(*pp == p) {
+      *pp = p->bcast_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_filtered(struct process *p)
+{
+  if(!p->filtered) {
+    p->filtered = 1;
+    bcast_remove(p);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+subscription_remove(struct subscription **sp)
+{
+  struct subscription *s = *sp;
+
+  if(subscriptions_walking) {
+    s->p = NULL;
+    subscriptions_removed = 1;
+  } else {
+    *sp = s->next;
+    memb_free(&subscription_memb, s);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+subscriptions_sweep(void)
+{
+  struct subscription **sp;
+  struct subscription *s;
+  int i;
+
+  for(i = 0; i < SUBSCRIPTION_BUCKETS; i++) {
+    for(sp = &subscriptions[i]; *sp != NULL;) {
+      s = *sp;
+      if(s->p == NULL) {
+        *sp = s->next;
+        memb_free(&subscription_memb, s);
+      } else {
+        sp = &s->next;
+      }
+    }
+  }
+  subscriptions_removed = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+process_subscribe(struct process *p, process_event_t ev)
+{
+  struct subscription *s;
+
+  set_filtered(p);
+
+  for(s = subscriptions[SUBSCRIPTION_BUCKET(ev)]; s != NULL; s = s->next) {
+    if(s->p == p && s->ev == ev) {
+      return PROCESS_ERR_OK;
+    }
+  }
+
+  s = memb_alloc(&subscription_memb);
+  if(s == NULL) {
+    PRINTF("process: no free subscription for '%s'\n", PROCESS_NAME_STRING(p));
+    return PROCESS_ERR_FULL;
+  }
+  s->p = p;
+  s->ev = ev;
+  s->next = subscriptions[SUBSCRIPTION_BUCKET(ev)];
+  subscriptions[SUBSCRIPTION_BUCKET(ev)] = s;
+  return PROCESS_ERR_OK;
+}
+/*---------------------------------------------------------------------------*/
+void
+process_unsubscribe(struct process *p, process_event_t ev)
+{
+  struct subscription **sp;
+  struct subscription *s;
+
+  for(sp = &subscriptions[SUBSCRIPTION_BUCKET(ev)]; *sp != NULL; sp = &s->next) {
+    s = *sp;
+    if(s->p == p && s->ev == ev) {
+      subscription_remove(sp);
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+process_filter_broadcasts(struct process *p)
+{
+  set_filtered(p);
+}
+/*---------------------------------------------------------------------------*/
+static void
+unsubscribe_all(struct process *p)
+{
+  struct subscription **sp;
+  struct subscription *s;
+  int i;
+
+  for(i = 0; i < SUBSCRIPTION_BUCKETS; i++) {
+    for(sp = &subscriptions[i]; *sp != NULL;) {
+      s = *sp;
+      if(s->p == p) {
+        subscription_remove(sp);
+      }
+      if(*sp == s) {
+        sp = &s->next;
+      }
+    }
+  }
+  p->filtered = 0;
+}
+#endif /* PROCESS_SUBSCRIPTIONS */
 /*---------------------------------------------------------------------------*/
 void
 process_start(struct process *p, process_data_t data)
@@ -117,6 +332,15 @@ process_start(struct process *p, process_data_t data)
   process_list = p;
   p->state = PROCESS_STATE_RUNNING;
   PT_INIT(&p->pt);
+#if PROCESS_POLL_INDEX
+  poll_slot_alloc(p);
+#endif /* PROCESS_POLL_INDEX */
+#if PROCESS_SUBSCRIPTIONS
+  if(!p->filtered) {
+    p->bcast_next = bcast_list;
+    bcast_list = p;
+  }
+#endif /* PROCESS_SUBSCRIPTIONS */
 
   PRINTF("process: starting '%s'\n", PROCESS_NAME_STRING(p));
 
@@ -162,6 +386,16 @@ exit_process(struct process *p, struct process *fromprocess)
 
   process_current = old_current;
 
+#if PROCESS_POLL_INDEX
+  poll_slot_free(p);
+#endif /* PROCESS_POLL_INDEX */
+#if PROCESS_SUBSCRIPTIONS
+  if(!p->filtered) {
+    bcast_remove(p);
+  }
+  unsubscribe_all(p);
+#endif /* PROCESS_SUBSCRIPTIONS */
+
   if(process_is_running(p)) {
     /* Process was running */
     p->state = PROCESS_STATE_NONE;
@@ -219,12 +453,29 @@ process_init(void)
 {
   lastevent = PROCESS_EVENT_MAX;
 
-  nevents = fevent = 0;
+  nevents = 0;
+  memset(event_queues, 0, sizeof(event_queues));
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
+#if PROCESS_PRIORITY_QUEUES
+  memset(process_maxevents_prio, 0, sizeof(process_maxevents_prio));
+#endif /* PROCESS_PRIORITY_QUEUES */
 #endif /* PROCESS_CONF_STATS */
 
   process_current = process_list = NULL;
+
+#if PROCESS_SUBSCRIPTIONS
+  memb_init(&subscription_memb);
+  memset(subscriptions, 0, sizeof(subscriptions));
+  subscriptions_walking = 0;
+  subscriptions_removed = 0;
+  bcast_list = NULL;
+#endif /* PROCESS_SUBSCRIPTIONS */
+#if PROCESS_POLL_INDEX
+  memset(poll_table, 0, sizeof(poll_table));
+  memset((void *)poll_groups, 0, sizeof(poll_groups));
+  poll_unindexed = 0;
+#endif /* PROCESS_POLL_INDEX */
 }
 /*---------------------------------------------------------------------------*/
 /*
@@ -237,6 +488,32 @@ do_poll(void)
   struct process *p;
 
   poll_requested = 0;
+
+#if PROCESS_POLL_INDEX
+  {
+    unsigned g;
+    unsigned i;
+
+    for(g = 0; g < POLL_GROUPS; g++) {
+      if(poll_groups[g]) {
+        poll_groups[g] = 0;
+        for(i = g * 8; i < g * 8 + 8; i++) {
+          p = poll_table[i];
+          if(p != NULL && p->needspoll) {
+            p->state = PROCESS_STATE_RUNNING;
+            p->needspoll = 0;
+            call_process(p, PROCESS_EVENT_POLL, NULL);
+          }
+        }
+      }
+    }
+  }
+
+  if(poll_unindexed == 0) {
+    return;
+  }
+#endif /* PROCESS_POLL_INDEX */
+
   /* Call the processes that needs to be polled. */
   for(p = process_list; p != NULL; p = p->next) {
     if(p->needspoll) {
@@ -260,14 +537,40 @@ void process_run_poll(struct process *p){
  * listening processes.
  */
 /*---------------------------------------------------------------------------*/
+static struct event_queue *
+queue_of(struct process *p)
+{
+#if PROCESS_PRIORITY_QUEUES
+  if(p == PROCESS_BROADCAST) {
+    return &event_queues[PROCESS_BROADCAST_PRIO];
+  }
+  if(p->priority < NUM_QUEUES) {
+    return &event_queues[p->priority];
+  }
+#endif /* PROCESS_PRIORITY_QUEUES */
+  return &event_queues[0];
+}
+/*---------------------------------------------------------------------------*/
 struct process_event_item* process_get_event(void){
     if(nevents > 0){
+        struct event_queue *q = &event_queues[0];
+#if PROCESS_PRIORITY_QUEUES
+        int i;
+
+        for(i = 0; i < NUM_QUEUES; i++) {
+          q = &event_queues[queue_order[i]];
+          if(q->nevents > 0) {
+            break;
+          }
+        }
+#endif /* PROCESS_PRIORITY_QUEUES */
 
-        struct process_event_item* ev = events  + fevent;
+        struct process_event_item* ev = q->events  + q->fevent;
 
         /* Since we have seen the new event, we move pointer upwards
            and decrease the number of events. */
-        fevent = (fevent + 1) % PROCESS_CONF_NUMEVENTS;
+        q->fevent = (q->fevent + 1) % PROCESS_CONF_NUMEVENTS;
+        --q->nevents;
         --nevents;
 
         return ev;
@@ -303,8 +606,12 @@ do_event(void)
         /* There are events that we should deliver. */
         data = e->data;
 
+#if PROCESS_SUBSCRIPTIONS
+      /* Filtered processes get the event through their subscription */
+      for(p = bcast_list; p != NULL; p = p->bcast_next) {
+#else /* PROCESS_SUBSCRIPTIONS */
       for(p = process_list; p != NULL; p = p->next) {
-
+#endif /* PROCESS_SUBSCRIPTIONS */
         /* If we have been requested to poll a process, we do this in
            between processing the broadcast event. */
         if(poll_requested) {
@@ -312,6 +619,30 @@ do_event(void)
         }
         call_process(p, ev, data);
       }
+
+#if PROCESS_SUBSCRIPTIONS
+      {
+        struct subscription *s;
+
+        /* The receivers may subscribe and unsubscribe: no subscription
+           is freed before the walk is done, and new ones are added in
+           front of it */
+        subscriptions_walking++;
+        for(s = subscriptions[SUBSCRIPTION_BUCKET(ev)]; s != NULL; s = s->next) {
+          if(s->ev == ev && s->p != NULL) {
+            if(poll_requested) {
+              do_poll();
+            }
+            if(s->p != NULL) {
+              call_process(s->p, ev, data);
+            }
+          }
+        }
+        if(--subscriptions_walking == 0 && subscriptions_removed) {
+          subscriptions_sweep();
+        }
+      }
+#endif /* PROCESS_SUBSCRIPTIONS */
     } else {
       /* This is not a broadcast event, so we deliver it to the
          specified process. */
@@ -330,13 +661,17 @@ do_event(void)
 int
 process_run(void)
 {
-  /* Process poll events. */
-  if(poll_requested) {
-    do_poll();
-  }
+  unsigned batch = PROCESS_RUN_BATCH;
+
+  do {
+    /* Process poll events. */
+    if(poll_requested) {
+      do_poll();
+    }
 
-  /* Process one event from the queue */
-  do_event();
+    /* Process one event from the queue */
+    do_event();
+  } while(--batch > 0 && nevents > 0);
 
   return nevents + poll_requested;
 }
@@ -351,6 +686,7 @@ int
 process_post(struct process *p, process_event_t ev, process_data_t data)
 {
   process_num_events_t snum;
+  struct event_queue *q;
 
   if(PROCESS_CURRENT() == NULL) {
     PRINTF("process_post: NULL process posts event %d to process '%s', nevents %d\n",
@@ -361,7 +697,9 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
            p == PROCESS_BROADCAST ? "<broadcast>" : PROCESS_NAME_STRING(p), nevents);
   }
 
-  if(nevents == PROCESS_CONF_NUMEVENTS) {
+  q = queue_of(p);
+
+  if(q->nevents == PROCESS_CONF_NUMEVENTS) {
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
       printf("soft panic: event queue is full when broadcast event %d was posted from %s\n", ev, PROCESS_NAME_STRING(process_current));
@@ -372,16 +710,22 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
     return PROCESS_ERR_FULL;
   }
 
-  snum = (process_num_events_t)(fevent + nevents) % PROCESS_CONF_NUMEVENTS;
-  events[snum].ev = ev;
-  events[snum].data = data;
-  events[snum].p = p;
+  snum = (process_num_events_t)(q->fevent + q->nevents) % PROCESS_CONF_NUMEVENTS;
+  q->events[snum].ev = ev;
+  q->events[snum].data = data;
+  q->events[snum].p = p;
+  ++q->nevents;
   ++nevents;
 
 #if PROCESS_CONF_STATS
   if(nevents > process_maxevents) {
     process_maxevents = nevents;
   }
+#if PROCESS_PRIORITY_QUEUES
+  if(q->nevents > process_maxevents_prio[q - event_queues]) {
+    process_maxevents_prio[q - event_queues] = q->nevents;
+  }
+#endif /* PROCESS_PRIORITY_QUEUES */
 #endif /* PROCESS_CONF_STATS */
 
   return PROCESS_ERR_OK;
@@ -408,7 +752,13 @@ process_poll(struct process *p)
     if(p->state == PROCESS_STATE_RUNNING ||
        p->state == PROCESS_STATE_CALLED) {
       p->needspoll = 1;
+#if PROCESS_POLL_INDEX
+      if(p->pollslot != PROCESS_POLL_SLOT_NONE) {
+        poll_groups[p->pollslot >> 3] = 1;
+      }
+#endif /* PROCESS_POLL_INDEX */
       poll_requested = 1;
+      PROCESS_POLL_NOTIFY();
     }
   }
 }
@@ -88,6 +88,98 @@ typedef unsigned char process_num_events_t;
 #define PROCESS_CONF_NUMEVENTS 32
 #endif /* PROCESS_CONF_NUMEVENTS */
 
+/**
+ * \name Event priorities
+ *
+ * With PROCESS_CONF_PRIORITY_QUEUES enabled, every priority has its own
+ * event queue of PROCESS_CONF_NUMEVENTS entries. Events are queued by
+ * the priority of the receiving process, and process_run() always
+ * delivers from the highest priority queue that is not empty. Processes
+ * declared with PROCESS() have PROCESS_PRIO_NORMAL; use PROCESS_PRIO()
+ * to declare another priority. Without priority queues all events
+ * share a single FIFO queue.
+ * @{
+ */
+#ifdef PROCESS_CONF_PRIORITY_QUEUES
+#define PROCESS_PRIORITY_QUEUES PROCESS_CONF_PRIORITY_QUEUES
+#else /* PROCESS_CONF_PRIORITY_QUEUES */
+#define PROCESS_PRIORITY_QUEUES 0
+#endif /* PROCESS_CONF_PRIORITY_QUEUES */
+
+#define PROCESS_PRIO_NORMAL      0
+#define PROCESS_PRIO_HIGH        1 /* network-critical processes */
+#define PROCESS_PRIO_BACKGROUND  2
+#define PROCESS_PRIO_NUM         3
+
+/* The queue that broadcast events are posted to */
+#ifdef PROCESS_CONF_BROADCAST_PRIO
+#define PROCESS_BROADCAST_PRIO PROCESS_CONF_BROADCAST_PRIO
+#else /* PROCESS_CONF_BROADCAST_PRIO */
+#define PROCESS_BROADCAST_PRIO PROCESS_PRIO_NORMAL
+#endif /* PROCESS_CONF_BROADCAST_PRIO */
+
+/*
+ * Broadcast subscriptions. A process that has subscribed to broadcast
+ * events, or has called process_filter_broadcasts(), only receives the
+ * broadcast events it subscribed to. Other processes keep receiving
+ * every broadcast event. Broadcasts are delivered from the subscription
+ * index and a list of the unfiltered processes, without walking the
+ * process list.
+ */
+#ifdef PROCESS_CONF_SUBSCRIPTIONS
+#define PROCESS_SUBSCRIPTIONS PROCESS_CONF_SUBSCRIPTIONS
+#else /* PROCESS_CONF_SUBSCRIPTIONS */
+#define PROCESS_SUBSCRIPTIONS 0
+#endif /* PROCESS_CONF_SUBSCRIPTIONS */
+
+/* Total number of broadcast subscriptions in the system */
+#ifdef PROCESS_CONF_MAX_SUBSCRIPTIONS
+#define PROCESS_MAX_SUBSCRIPTIONS PROCESS_CONF_MAX_SUBSCRIPTIONS
+#else /* PROCESS_CONF_MAX_SUBSCRIPTIONS */
+#define PROCESS_MAX_SUBSCRIPTIONS 16
+#endif /* PROCESS_CONF_MAX_SUBSCRIPTIONS */
+
+/*
+ * Poll index. Running processes get a slot in a poll table, and
+ * process_poll() marks the slot's group in a pending bitmap so that
+ * the kernel only visits polled processes instead of walking the whole
+ * process list. Processes that do not get a slot are polled by walking
+ * the list as before.
+ */
+#ifdef PROCESS_CONF_POLL_INDEX
+#define PROCESS_POLL_INDEX PROCESS_CONF_POLL_INDEX
+#else /* PROCESS_CONF_POLL_INDEX */
+#define PROCESS_POLL_INDEX 0
+#endif /* PROCESS_CONF_POLL_INDEX */
+
+/* Number of slots in the poll table, a multiple of 8 */
+#ifdef PROCESS_CONF_POLL_SLOTS
+#define PROCESS_POLL_SLOTS PROCESS_CONF_POLL_SLOTS
+#else /* PROCESS_CONF_POLL_SLOTS */
+#define PROCESS_POLL_SLOTS 64
+#endif /* PROCESS_CONF_POLL_SLOTS */
+
+#define PROCESS_POLL_SLOT_NONE 0xff
+
+/*
+ * Hook called by process_poll() once the poll has been requested. A
+ * platform whose main loop sleeps can use it to wake up when a process
+ * is polled from a signal handler or another thread.
+ */
+#ifdef PROCESS_CONF_POLL_NOTIFY
+#define PROCESS_POLL_NOTIFY() PROCESS_CONF_POLL_NOTIFY()
+#else /* PROCESS_CONF_POLL_NOTIFY */
+#define PROCESS_POLL_NOTIFY()
+#endif /* PROCESS_CONF_POLL_NOTIFY */
+
+/* Maximum number of events delivered by one call to process_run() */
+#ifdef PROCESS_CONF_RUN_BATCH
+#define PROCESS_RUN_BATCH PROCESS_CONF_RUN_BATCH
+#else /* PROCESS_CONF_RUN_BATCH */
+#define PROCESS_RUN_BATCH 1
+#endif /* PROCESS_CONF_RUN_BATCH */
+/** @} */
+
 #define PROCESS_EVENT_NONE            0x80
 #define PROCESS_EVENT_INIT            0x81
 #define PROCESS_EVENT_POLL            0x82
@@ -310,6 +402,36 @@ PT_THREAD(process_thread_##name(struct pt *process_pt,	\
                           process_thread_##name }
 #endif
 
+/**
+ * Declare a process with an event priority.
+ *
+ * This macro works like PROCESS(), but also declares the priority of
+ * the event queue that events for this process are posted to. Without
+ * PROCESS_CONF_PRIORITY_QUEUES the priority is ignored.
+ *
+ * \param name The variable name of the process structure.
+ * \param strname The string representation of the process' name.
+ * \param prio One of PROCESS_PRIO_HIGH, PROCESS_PRIO_NORMAL or
+ *             PROCESS_PRIO_BACKGROUND.
+ *
+ * \hideinitializer
+ */
+#if !PROCESS_PRIORITY_QUEUES
+#define PROCESS_PRIO(name, strname, prio) PROCESS(name, strname)
+#elif PROCESS_CONF_NO_PROCESS_NAMES
+#define PROCESS_PRIO(name, strname, prio)		\
+  PROCESS_THREAD(name, ev, data);			\
+  struct process name = { NULL,		        \
+                          process_thread_##name,	\
+                          { 0 }, 0, 0, prio }
+#else
+#define PROCESS_PRIO(name, strname, prio)		\
+  PROCESS_THREAD(name, ev, data);			\
+  struct process name = { NULL, strname,		\
+                          process_thread_##name,	\
+                          { 0 }, 0, 0, prio }
+#endif
+
 /** @} */
 
 struct process {
@@ -323,6 +445,17 @@ struct process {
   PT_THREAD((* thread)(struct pt *, process_event_t, process_data_t));
   struct pt pt;
   unsigned char state, needspoll;
+#if PROCESS_PRIORITY_QUEUES
+  unsigned char priority;
+#endif /* PROCESS_PRIORITY_QUEUES */
+#if PROCESS_SUBSCRIPTIONS
+  unsigned char filtered;
+  /* Next running process that receives every broadcast */
+  struct process *bcast_next;
+#endif /* PROCESS_SUBSCRIPTIONS */
+#if PROCESS_POLL_INDEX
+  unsigned char pollslot;
+#endif /* PROCESS_POLL_INDEX */
 };
 
 /**
@@ -468,6 +601,40 @@ process_current = p
  */
 process_event_t process_alloc_event(void);
 
+#if PROCESS_SUBSCRIPTIONS
+/**
+ * \brief      Subscribe a process to a broadcast event.
+ * \param p    The process.
+ * \param ev   The broadcast event the process is interested in.
+ * \retval PROCESS_ERR_OK The subscription was added.
+ * \retval PROCESS_ERR_FULL No free subscription entries.
+ *
+ *             After the first subscription the process only receives
+ *             broadcast events that it has subscribed to.
+ */
+int process_subscribe(struct process *p, process_event_t ev);
+
+/**
+ * \brief      Remove the subscription of a process to a broadcast event.
+ * \param p    The process.
+ * \param ev   The broadcast event.
+ */
+void process_unsubscribe(struct process *p, process_event_t ev);
+
+/**
+ * \brief      Stop delivering unsubscribed broadcast events to a process.
+ * \param p    The process.
+ *
+ *             Used by processes that do not handle broadcast events at
+ *             all, so that broadcasts skip them.
+ */
+void process_filter_broadcasts(struct process *p);
+#else /* PROCESS_SUBSCRIPTIONS */
+#define process_subscribe(p, ev) PROCESS_ERR_OK
+#define process_unsubscribe(p, ev)
+#define process_filter_broadcasts(p)
+#endif /* PROCESS_SUBSCRIPTIONS */
+
 /** @} */
 
 /**
@@ -505,7 +672,8 @@ void process_init(void);
  *
  * This function should be called repeatedly from the main() program
  * to actually run the Contiki system. It calls the necessary poll
- * handlers, and processes one event. The function returns the number
+ * handlers, and processes one event, or up to PROCESS_RUN_BATCH
+ * events when batching is configured. The function returns the number
  * of events that are waiting in the event queue so that the caller
  * may choose to put the CPU to sleep when there are no pending
  * events.
@@ -569,6 +737,15 @@ void process_run_poll(struct process *p);
 
 extern volatile unsigned char process_poll_requested;
 
+#if PROCESS_CONF_STATS
+/* High-water mark of the total number of queued events */
+extern process_num_events_t process_maxevents;
+#if PROCESS_PRIORITY_QUEUES
+/* High-water mark of every priority queue, indexed by PROCESS_PRIO_* */
+extern process_num_events_t process_maxevents_prio[PROCESS_PRIO_NUM];
+#endif /* PROCESS_PRIORITY_QUEUES */
+#endif /* PROCESS_CONF_STATS */
+
 /** @} */
 
 
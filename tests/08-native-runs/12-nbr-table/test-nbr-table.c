@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Neighbor table tests and lookup microbenchmark.
+ *
+ *         Checks that lookups by link-layer address stay consistent
+ *         with the key list while neighbors are added and evicted, and
+ *         measures the lookup rate of a full table. Build with
+ *         DEFINES=NBR_TABLE_CONF_HASH_INDEX=0 to compare against the
+ *         linear lookup.
+ */
+
+#include "contiki.h"
+#include "net/nbr-table.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "nbr-table test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_ADDRS     (2 * NBR_TABLE_MAX_NEIGHBORS)
+#define BENCH_LOOKUPS 1000000UL
+
+typedef struct {
+  uint16_t id;
+} test_nbr_t;
+
+NBR_TABLE(test_nbr_t, test_nbrs);
+
+/*---------------------------------------------------------------------------*/
+static void
+make_addr(linkaddr_t *addr, uint16_t id)
+{
+  memset(addr, 0, sizeof(*addr));
+  /* Vary both ends of the address like real EUI-64s do */
+  addr->u8[0] = 0x02;
+  addr->u8[1] = (id * 7) & 0xff;
+  addr->u8[LINKADDR_SIZE - 2] = id >> 8;
+  addr->u8[LINKADDR_SIZE - 1] = id & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+static int
+in_key_list(const linkaddr_t *addr)
+{
+  nbr_table_key_t *k;
+
+  for(k = nbr_table_key_head(); k != NULL; k = nbr_table_key_next(k)) {
+    if(linkaddr_cmp(&k->lladdr, addr)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_consistency(uint16_t nids)
+{
+  linkaddr_t addr;
+  test_nbr_t *n;
+  uint16_t id;
+
+  for(id = 0; id < nids; id++) {
+    make_addr(&addr, id);
+    n = nbr_table_get_from_lladdr(test_nbrs, &addr);
+    if((n != NULL) != in_key_list(&addr)) {
+      printf("lookup of %u disagrees with key list\n", id);
+      return 0;
+    }
+    if(n != NULL && n->id != id) {
+      printf("lookup of %u returned neighbor %u\n", id, n->id);
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(nbr_add_lookup, "Neighbor add and lookup");
+UNIT_TEST(nbr_add_lookup)
+{
+  linkaddr_t addr;
+  test_nbr_t *n;
+  uint16_t id;
+
+  UNIT_TEST_BEGIN();
+
+  nbr_table_clear();
+  for(id = 0; id < NBR_TABLE_MAX_NEIGHBORS; id++) {
+    make_addr(&addr, id);
+    n = nbr_table_add_lladdr(test_nbrs, &addr, NBR_TABLE_REASON_UNDEFINED, NULL);
+    UNIT_TEST_ASSERT(n != NULL);
+    n->id = id;
+  }
+  UNIT_TEST_ASSERT(nbr_table_count_entries() == NBR_TABLE_MAX_NEIGHBORS);
+  UNIT_TEST_ASSERT(check_consistency(NUM_ADDRS));
+
+  /* Adding a known address must return the same (reinitialized) entry */
+  make_addr(&addr, 17);
+  n = nbr_table_get_from_lladdr(test_nbrs, &addr);
+  UNIT_TEST_ASSERT(nbr_table_add_lladdr(test_nbrs, &addr,
+                                        NBR_TABLE_REASON_UNDEFINED, NULL) == n);
+  n->id = 17;
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(nbr_evict, "Neighbor eviction keeps lookups consistent");
+UNIT_TEST(nbr_evict)
+{
+  linkaddr_t addr;
+  test_nbr_t *n;
+  uint16_t id;
+
+  UNIT_TEST_BEGIN();
+
+  /* The table is full: every new address evicts an unlocked entry */
+  make_addr(&addr, 3);
+  nbr_table_lock(test_nbrs, nbr_table_get_from_lladdr(test_nbrs, &addr));
+  for(id = NBR_TABLE_MAX_NEIGHBORS; id < NUM_ADDRS; id++) {
+    make_addr(&addr, id);
+    n = nbr_table_add_lladdr(test_nbrs, &addr, NBR_TABLE_REASON_UNDEFINED, NULL);
+    UNIT_TEST_ASSERT(n != NULL);
+    n->id = id;
+    if((id & 31) == 0) {
+      UNIT_TEST_ASSERT(check_consistency(NUM_ADDRS));
+    }
+  }
+  UNIT_TEST_ASSERT(check_consistency(NUM_ADDRS));
+
+  /* The locked entry survived */
+  make_addr(&addr, 3);
+  UNIT_TEST_ASSERT(nbr_table_get_from_lladdr(test_nbrs, &addr) != NULL);
+
+  nbr_table_clear();
+  for(id = 0; id < NUM_ADDRS; id++) {
+    make_addr(&addr, id);
+    UNIT_TEST_ASSERT(nbr_table_get_from_lladdr(test_nbrs, &addr) == NULL);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(nbr_bench, "Neighbor lookup benchmark");
+UNIT_TEST(nbr_bench)
+{
+  static linkaddr_t addrs[NBR_TABLE_MAX_NEIGHBORS];
+  test_nbr_t *n;
+  clock_time_t start;
+  clock_time_t elapsed;
+  unsigned long i;
+  unsigned long found;
+  uint16_t id;
+
+  UNIT_TEST_BEGIN();
+
+  for(id = 0; id < NBR_TABLE_MAX_NEIGHBORS; id++) {
+    make_addr(&addrs[id], id);
+    n = nbr_table_add_lladdr(test_nbrs, &addrs[id],
+                             NBR_TABLE_REASON_UNDEFINED, NULL);
+    UNIT_TEST_ASSERT(n != NULL);
+    n->id = id;
+  }
+
+  found = 0;
+  start = clock_time();
+  for(i = 0; i < BENCH_LOOKUPS; i++) {
+    n = nbr_table_get_from_lladdr(test_nbrs,
+                                  &addrs[(i * 37) % NBR_TABLE_MAX_NEIGHBORS]);
+    found += n != NULL;
+  }
+  elapsed = clock_time() - start;
+  UNIT_TEST_ASSERT(found == BENCH_LOOKUPS);
+
+  printf("nbr-table: %u neighbors, hash index %u, %lu lookups in %lu ms",
+         NBR_TABLE_MAX_NEIGHBORS, NBR_TABLE_HASH_INDEX, BENCH_LOOKUPS,
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND));
+  if(elapsed > 0) {
+    printf(", %lu lookups/s", BENCH_LOOKUPS * CLOCK_SECOND / elapsed);
+  }
+  printf("\n");
+
+  nbr_table_clear();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  nbr_table_register(test_nbrs, NULL);
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(nbr_add_lookup);
+  UNIT_TEST_RUN(nbr_evict);
+  UNIT_TEST_RUN(nbr_bench);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
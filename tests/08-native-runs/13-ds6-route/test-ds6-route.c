@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Routing table tests and forwarding lookup benchmark.
+ *
+ *         Checks uip_ds6_route_lookup() against a linear longest
+ *         prefix match over the route list while routes are added and
+ *         removed, and compares the lookup rate of both strategies on
+ *         a full routing table.
+ */
+
+#include "contiki.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/ipv6/uiplib.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "ds6-route test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_NEXTHOPS  8
+#define NUM_PREFIXES  32
+#define BENCH_LOOKUPS 200000UL
+
+static uip_ipaddr_t nexthops[NUM_NEXTHOPS];
+
+/*---------------------------------------------------------------------------*/
+/* The lookup strategy used without the trie, without reordering */
+static uip_ds6_route_t *
+linear_lookup(const uip_ipaddr_t *addr)
+{
+  uip_ds6_route_t *r;
+  uip_ds6_route_t *found = NULL;
+  uint8_t longestmatch = 0;
+
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    if(r->length >= longestmatch &&
+       uip_ipaddr_prefixcmp(addr, &r->ipaddr, r->length)) {
+      longestmatch = r->length;
+      found = r;
+      if(longestmatch == 128) {
+        break;
+      }
+    }
+  }
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+static void
+host_addr(uip_ipaddr_t *addr, uint16_t prefix, uint16_t host)
+{
+  uip_ip6addr(addr, 0xfd00, prefix, 0, 0, 0, 0, host >> 8, host & 0xff);
+}
+/*---------------------------------------------------------------------------*/
+static void
+random_addr(uip_ipaddr_t *addr)
+{
+  host_addr(addr, random_rand() % (NUM_PREFIXES + 4),
+            random_rand() % (2 * UIP_DS6_ROUTE_NB));
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_lookups(int count)
+{
+  uip_ipaddr_t addr;
+  uip_ds6_route_t *expected;
+  uip_ds6_route_t *found;
+
+  while(count-- > 0) {
+    random_addr(&addr);
+    expected = linear_lookup(&addr);
+    found = uip_ds6_route_lookup(&addr);
+    if(found != expected) {
+      printf("lookup mismatch for ");
+      uiplib_ipaddr_print(&addr);
+      printf(": %u vs %u\n", found ? found->length : 0,
+             expected ? expected->length : 0);
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(route_add_lookup, "Route add and lookup");
+UNIT_TEST(route_add_lookup)
+{
+  uip_lladdr_t lladdr;
+  uip_ipaddr_t addr;
+  uint16_t i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < NUM_NEXTHOPS; i++) {
+    memset(&lladdr, 0, sizeof(lladdr));
+    lladdr.addr[sizeof(lladdr) - 1] = i + 1;
+    uip_ip6addr(&nexthops[i], 0xfe80, 0, 0, 0, 0, 0, 0, i + 1);
+    UNIT_TEST_ASSERT(uip_ds6_nbr_add(&nexthops[i], &lladdr, 1,
+                                     NBR_REACHABLE, NBR_TABLE_REASON_UNDEFINED,
+                                     NULL) != NULL);
+  }
+
+  /* A covering /16, per-prefix /64s and host routes below them */
+  host_addr(&addr, 0, 0);
+  UNIT_TEST_ASSERT(uip_ds6_route_add(&addr, 16, &nexthops[0]) != NULL);
+  for(i = 0; i < NUM_PREFIXES; i++) {
+    host_addr(&addr, i, 0);
+    UNIT_TEST_ASSERT(uip_ds6_route_add(&addr, 64,
+                                       &nexthops[i % NUM_NEXTHOPS]) != NULL);
+  }
+  for(i = 0; uip_ds6_route_num_routes() < UIP_DS6_ROUTE_NB; i++) {
+    host_addr(&addr, i % NUM_PREFIXES, i);
+    UNIT_TEST_ASSERT(uip_ds6_route_add(&addr, 128,
+                                       &nexthops[(i + 1) % NUM_NEXTHOPS]) != NULL);
+  }
+
+  UNIT_TEST_ASSERT(check_lookups(10000));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(route_remove, "Route removal");
+UNIT_TEST(route_remove)
+{
+  uip_ds6_route_t *r;
+  uip_ds6_route_t *next;
+  uip_ipaddr_t addr;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* Drop every other route, including some of the covering prefixes */
+  i = 0;
+  for(r = uip_ds6_route_head(); r != NULL; r = next) {
+    next = uip_ds6_route_next(r);
+    if(i++ & 1) {
+      uip_ds6_route_rm(r);
+    }
+  }
+  UNIT_TEST_ASSERT(check_lookups(10000));
+
+  /* Routes through one next hop go away with it */
+  uip_ds6_route_rm_by_nexthop(&nexthops[3]);
+  UNIT_TEST_ASSERT(check_lookups(10000));
+
+  /* Removed routes are not found any more */
+  host_addr(&addr, 0, 0);
+  r = uip_ds6_route_lookup(&addr);
+  if(r != NULL) {
+    uip_ipaddr_copy(&addr, &r->ipaddr);
+    uip_ds6_route_rm(r);
+    r = uip_ds6_route_lookup(&addr);
+    UNIT_TEST_ASSERT(r == NULL || !uip_ipaddr_cmp(&r->ipaddr, &addr) ||
+                     r->length != 128);
+  }
+  UNIT_TEST_ASSERT(check_lookups(10000));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(route_bench, "Route lookup benchmark");
+UNIT_TEST(route_bench)
+{
+  static uip_ipaddr_t addrs[256];
+  clock_time_t start;
+  clock_time_t linear_time;
+  clock_time_t lookup_time;
+  unsigned long found;
+  unsigned long i;
+  uip_ipaddr_t addr;
+  uint16_t j;
+
+  UNIT_TEST_BEGIN();
+
+  for(j = 0; uip_ds6_route_num_routes() < UIP_DS6_ROUTE_NB; j++) {
+    host_addr(&addr, j % NUM_PREFIXES, j);
+    uip_ds6_route_add(&addr, 128, &nexthops[j % NUM_NEXTHOPS]);
+  }
+  for(j = 0; j < 256; j++) {
+    random_addr(&addrs[j]);
+  }
+
+  found = 0;
+  start = clock_time();
+  for(i = 0; i < BENCH_LOOKUPS; i++) {
+    found += linear_lookup(&addrs[i & 0xff]) != NULL;
+  }
+  linear_time = clock_time() - start;
+
+  start = clock_time();
+  for(i = 0; i < BENCH_LOOKUPS; i++) {
+    found -= uip_ds6_route_lookup(&addrs[i & 0xff]) != NULL;
+  }
+  lookup_time = clock_time() - start;
+  UNIT_TEST_ASSERT(found == 0);
+
+  printf("ds6-route: %u routes, %lu lookups: linear %lu ms, "
+         "uip_ds6_route_lookup (trie %u) %lu ms\n",
+         uip_ds6_route_num_routes(), BENCH_LOOKUPS,
+         (unsigned long)(linear_time * 1000 / CLOCK_SECOND),
+         UIP_DS6_ROUTE_TRIE,
+         (unsigned long)(lookup_time * 1000 / CLOCK_SECOND));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(route_add_lookup);
+  UNIT_TEST_RUN(route_remove);
+  UNIT_TEST_RUN(route_bench);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         6LoWPAN fragment reassembly tests.
+ *
+ *         Feeds FRAG1/FRAGN frames to sicslowpan and checks the
+ *         reassembled packets for in order, out of order, duplicate and
+ *         overlapping fragments, and the per sender reassembly limits.
+ */
+
+#include "contiki.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "sicslowpan fragment test");
+AUTOSTART_PROCESSES(&test_process);
+
+/* A 240 byte packet, sent as a 88 byte first fragment and fragments of
+   80 and 72 bytes at offsets 88 and 168 */
+#define PACKET_LEN   240
+#define FRAG1_LEN    88
+
+static uint8_t packet[PACKET_LEN];
+static uint8_t delivered[PACKET_LEN];
+static int delivered_len;
+static int delivered_count;
+
+/*---------------------------------------------------------------------------*/
+static void
+sniff_input(void)
+{
+  delivered_count++;
+  delivered_len = uip_len;
+  memcpy(delivered, uip_buf, MIN(uip_len, PACKET_LEN));
+}
+/*---------------------------------------------------------------------------*/
+NETSTACK_SNIFFER(sniffer, sniff_input, NULL);
+/*---------------------------------------------------------------------------*/
+static void
+make_packet(uint8_t seed)
+{
+  int i;
+
+  memset(packet, 0, UIP_IPH_LEN);
+  packet[0] = 0x60;
+  packet[4] = (PACKET_LEN - UIP_IPH_LEN) >> 8;
+  packet[5] = (PACKET_LEN - UIP_IPH_LEN) & 0xff;
+  packet[6] = UIP_PROTO_NONE;
+  packet[7] = 64;
+  packet[8] = 0xfe;
+  packet[9] = 0x80;
+  packet[23] = seed;
+  packet[24] = 0xff;
+  packet[25] = 0x02;
+  packet[39] = 0x01;
+  for(i = UIP_IPH_LEN; i < PACKET_LEN; i++) {
+    packet[i] = seed + i;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+input_frame(const uint8_t *frame, int len, uint8_t sender)
+{
+  linkaddr_t addr;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.u8[LINKADDR_SIZE - 1] = sender;
+  packetbuf_copyfrom(frame, len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &addr);
+  sicslowpan_driver.input();
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_frag1(uint16_t tag, uint8_t sender)
+{
+  uint8_t frame[5 + FRAG1_LEN];
+
+  frame[0] = SICSLOWPAN_DISPATCH_FRAG1 | (PACKET_LEN >> 8);
+  frame[1] = PACKET_LEN & 0xff;
+  frame[2] = tag >> 8;
+  frame[3] = tag & 0xff;
+  frame[4] = SICSLOWPAN_DISPATCH_IPV6;
+  memcpy(&frame[5], packet, FRAG1_LEN);
+  input_frame(frame, sizeof(frame), sender);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_fragn(uint16_t tag, uint16_t offset, uint16_t len, uint8_t sender)
+{
+  uint8_t frame[5 + PACKET_LEN];
+
+  frame[0] = SICSLOWPAN_DISPATCH_FRAGN | (PACKET_LEN >> 8);
+  frame[1] = PACKET_LEN & 0xff;
+  frame[2] = tag >> 8;
+  frame[3] = tag & 0xff;
+  frame[4] = offset >> 3;
+  memcpy(&frame[5], packet + offset, len);
+  input_frame(frame, 5 + len, sender);
+}
+/*---------------------------------------------------------------------------*/
+static int
+delivered_ok(void)
+{
+  return delivered_len == PACKET_LEN
+    && memcmp(delivered, packet, PACKET_LEN) == 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(frag_in_order, "Fragments in order");
+UNIT_TEST(frag_in_order)
+{
+  UNIT_TEST_BEGIN();
+
+  make_packet(1);
+  delivered_count = 0;
+  send_frag1(1, 1);
+  send_fragn(1, 88, 80, 1);
+  UNIT_TEST_ASSERT(delivered_count == 0);
+  send_fragn(1, 168, 72, 1);
+  UNIT_TEST_ASSERT(delivered_count == 1);
+  UNIT_TEST_ASSERT(delivered_ok());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(frag_reorder_dup, "Reordered and duplicate fragments");
+UNIT_TEST(frag_reorder_dup)
+{
+  UNIT_TEST_BEGIN();
+
+  make_packet(2);
+  delivered_count = 0;
+  send_frag1(2, 1);
+  send_fragn(2, 168, 72, 1);
+  /* A duplicate must not count towards completion */
+  send_fragn(2, 168, 72, 1);
+  UNIT_TEST_ASSERT(delivered_count == 0);
+  send_fragn(2, 88, 80, 1);
+  UNIT_TEST_ASSERT(delivered_count == 1);
+  UNIT_TEST_ASSERT(delivered_ok());
+
+  /* Interleaved packets from two senders */
+  make_packet(3);
+  delivered_count = 0;
+  send_frag1(3, 1);
+  send_frag1(3, 2);
+  send_fragn(3, 168, 72, 2);
+  send_fragn(3, 88, 80, 1);
+  send_fragn(3, 88, 80, 2);
+  UNIT_TEST_ASSERT(delivered_count == 1);
+  UNIT_TEST_ASSERT(delivered_ok());
+  send_fragn(3, 168, 72, 1);
+  UNIT_TEST_ASSERT(delivered_count == 2);
+  UNIT_TEST_ASSERT(delivered_ok());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(frag_overlap, "Overlapping fragments");
+UNIT_TEST(frag_overlap)
+{
+  UNIT_TEST_BEGIN();
+
+  make_packet(4);
+  delivered_count = 0;
+  send_frag1(4, 1);
+  send_fragn(4, 88, 80, 1);
+  /* Overlaps the previous fragment, the packet is dropped */
+  send_fragn(4, 128, 80, 1);
+  send_fragn(4, 168, 72, 1);
+  UNIT_TEST_ASSERT(delivered_count == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(frag_fairness, "Per sender reassembly limits");
+UNIT_TEST(frag_fairness)
+{
+  UNIT_TEST_BEGIN();
+
+  make_packet(5);
+  delivered_count = 0;
+
+  /* Sender 1 may reassemble two packets and hold two fragments */
+  send_frag1(10, 1);
+  send_frag1(11, 1);
+  send_frag1(12, 1);
+  send_fragn(12, 88, 80, 1);
+  send_fragn(10, 88, 80, 1);
+  send_fragn(11, 88, 80, 1);
+  send_fragn(11, 168, 72, 1);
+  UNIT_TEST_ASSERT(delivered_count == 0);
+
+  /* which leaves room for sender 2 */
+  send_frag1(10, 2);
+  send_fragn(10, 88, 80, 2);
+  send_fragn(10, 168, 72, 2);
+  UNIT_TEST_ASSERT(delivered_count == 1);
+  UNIT_TEST_ASSERT(delivered_ok());
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  netstack_sniffer_add(&sniffer);
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(frag_in_order);
+  UNIT_TEST_RUN(frag_reorder_dup);
+  UNIT_TEST_RUN(frag_overlap);
+  UNIT_TEST_RUN(frag_fairness);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         CoAP transaction table tests.
+ *
+ *         Looks up transactions and observers by MID and token, and
+ *         checks the retransmissions and timeouts of CON messages with
+ *         the statistics. Build with DEFINES=COAP_CONF_INDEX_HASH_SIZE=0
+ *         or DEFINES=COAP_CONF_RETRANSMIT_WHEEL_SLOTS=0 to run the same
+ *         tests on the lists and the per-transaction timers.
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+#include "coap-transactions.h"
+#include "coap-observe.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "CoAP transactions test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_TRANSACTIONS 48
+#define FIRST_MID        1000
+/* collide in the MID buckets */
+#define MID(i)           (FIRST_MID + (i) * 16)
+
+static coap_endpoint_t endpoints[3];
+static int timeouts;
+static int early_timeouts;
+static clock_time_t start;
+static clock_time_t first_timeout;
+static clock_time_t last_timeout;
+
+/*---------------------------------------------------------------------------*/
+static void
+res_get_handler(coap_message_t *request, coap_message_t *response,
+                uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  coap_set_payload(response, "x", 1);
+}
+EVENT_RESOURCE(res_obs, "obs=1", res_get_handler, NULL, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+static void
+init_endpoints(void)
+{
+  static const char *addrs[] = {
+    "coap://[fd00::2]", "coap://[fd00::3]", "coap://[fd00::4]"
+  };
+  int i;
+
+  for(i = 0; i < 3; i++) {
+    coap_endpoint_parse(addrs[i], strlen(addrs[i]), &endpoints[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+timeout_callback(void *data, coap_message_t *response)
+{
+  coap_transaction_t *t;
+  int i;
+
+  /* Only after all its retransmissions, and never before another
+     transaction that is still to be retransmitted */
+  for(i = 0; i < NUM_TRANSACTIONS; i++) {
+    t = coap_get_transaction_by_mid(MID(i));
+    if(t != NULL && t->retrans_counter < COAP_MAX_RETRANSMIT) {
+      early_timeouts++;
+      break;
+    }
+  }
+
+  last_timeout = clock_time() - start;
+  if(timeouts++ == 0) {
+    first_timeout = last_timeout;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static coap_transaction_t *
+send_con(uint16_t mid, const coap_endpoint_t *ep)
+{
+  coap_message_t message[1];
+  coap_transaction_t *t;
+
+  t = coap_new_transaction(mid, ep);
+  if(t == NULL) {
+    return NULL;
+  }
+  coap_init_message(message, COAP_TYPE_CON, COAP_GET, mid);
+  coap_set_header_uri_path(message, "test");
+  t->message_len = coap_serialize_message(message, t->message);
+  t->callback = timeout_callback;
+  t->callback_data = NULL;
+  coap_send_transaction(t);
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_observer(const coap_endpoint_t *ep, uint8_t token)
+{
+  coap_message_t request[1];
+  coap_message_t response[1];
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_token(request, &token, 1);
+  coap_set_header_uri_path(request, "obs");
+  coap_set_header_observe(request, 0);
+  coap_set_src_endpoint(request, ep);
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, 0);
+  coap_observe_handler(&res_obs, request, response);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(transaction_mid, "Transactions by MID");
+UNIT_TEST(transaction_mid)
+{
+  coap_transaction_t *sent[NUM_TRANSACTIONS];
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  start = clock_time();
+  for(i = 0; i < NUM_TRANSACTIONS; i++) {
+    sent[i] = send_con(MID(i), &endpoints[i % 3]);
+    UNIT_TEST_ASSERT(sent[i] != NULL);
+  }
+  UNIT_TEST_ASSERT(coap_transaction_stats.in_flight == NUM_TRANSACTIONS);
+  UNIT_TEST_ASSERT(coap_transaction_stats.sent == NUM_TRANSACTIONS);
+
+  for(i = 0; i < NUM_TRANSACTIONS; i++) {
+    UNIT_TEST_ASSERT(coap_get_transaction_by_mid(MID(i)) == sent[i]);
+  }
+  UNIT_TEST_ASSERT(coap_get_transaction_by_mid(MID(0) + 1) == NULL);
+  UNIT_TEST_ASSERT(coap_get_transaction_by_mid(MID(NUM_TRANSACTIONS)) == NULL);
+
+  /* acknowledged, as the engine does on an ACK */
+  for(i = 1; i < NUM_TRANSACTIONS; i += 2) {
+    coap_clear_transaction(coap_get_transaction_by_mid(MID(i)));
+  }
+  for(i = 0; i < NUM_TRANSACTIONS; i++) {
+    UNIT_TEST_ASSERT(coap_get_transaction_by_mid(MID(i))
+                     == (i % 2 ? NULL : sent[i]));
+  }
+  UNIT_TEST_ASSERT(coap_transaction_stats.in_flight == NUM_TRANSACTIONS / 2);
+  UNIT_TEST_ASSERT(coap_transaction_stats.max_in_flight == NUM_TRANSACTIONS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(transaction_timeout, "Retransmissions and timeouts");
+UNIT_TEST(transaction_timeout)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  printf("retransmitted %lu, timed out %lu, in flight %u\n",
+         (unsigned long)coap_transaction_stats.retransmitted,
+         (unsigned long)coap_transaction_stats.timed_out,
+         coap_transaction_stats.in_flight);
+  printf("timeouts %d, early %d, after %lu-%lu ms\n", timeouts,
+         early_timeouts,
+         (unsigned long)(first_timeout * 1000 / CLOCK_SECOND),
+         (unsigned long)(last_timeout * 1000 / CLOCK_SECOND));
+
+  UNIT_TEST_ASSERT(timeouts == NUM_TRANSACTIONS / 2);
+  UNIT_TEST_ASSERT(early_timeouts == 0);
+  UNIT_TEST_ASSERT(coap_transaction_stats.retransmitted
+                   == NUM_TRANSACTIONS / 2 * COAP_MAX_RETRANSMIT);
+  UNIT_TEST_ASSERT(coap_transaction_stats.timed_out == NUM_TRANSACTIONS / 2);
+  UNIT_TEST_ASSERT(coap_transaction_stats.in_flight == 0);
+  for(i = 0; i < NUM_TRANSACTIONS; i++) {
+    UNIT_TEST_ASSERT(coap_get_transaction_by_mid(MID(i)) == NULL);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(observer_index, "Observers by token and MID");
+UNIT_TEST(observer_index)
+{
+  uint8_t token;
+  uint16_t mid;
+
+  UNIT_TEST_BEGIN();
+
+  add_observer(&endpoints[0], 1);
+  add_observer(&endpoints[1], 2);
+  add_observer(&endpoints[2], 2);
+
+  /* the token must come from the same client */
+  token = 1;
+  UNIT_TEST_ASSERT(coap_remove_observer_by_token(&endpoints[1], &token, 1) == 0);
+  token = 2;
+  UNIT_TEST_ASSERT(coap_remove_observer_by_token(&endpoints[1], &token, 1) == 1);
+  UNIT_TEST_ASSERT(coap_remove_observer_by_token(&endpoints[1], &token, 1) == 0);
+
+  /* notifications to endpoints 0 and 2, in the order they were added */
+  mid = coap_get_mid();
+  coap_notify_observers(&res_obs);
+  UNIT_TEST_ASSERT(coap_remove_observer_by_mid(&endpoints[0], mid + 2) == 0);
+  UNIT_TEST_ASSERT(coap_remove_observer_by_mid(&endpoints[2], mid + 2) == 1);
+  UNIT_TEST_ASSERT(coap_remove_observer_by_mid(&endpoints[0], mid + 1) == 1);
+  UNIT_TEST_ASSERT(coap_remove_observer_by_client(&endpoints[0]) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  init_endpoints();
+  coap_activate_resource(&res_obs, "obs");
+
+  UNIT_TEST_RUN(transaction_mid);
+
+  /* all the remaining transactions time out */
+  etimer_set(&et, 6 * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  UNIT_TEST_RUN(transaction_timeout);
+  UNIT_TEST_RUN(observer_index);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         heapmem allocator tests.
+ *
+ *         Churns through allocations while checking their contents,
+ *         checks that freed small chunks are reused and that memory
+ *         held by the size classes is still available for large
+ *         allocations, and reports the allocation throughput. Build
+ *         with DEFINES=HEAPMEM_CONF_SIZE_CLASSES=0 to run the same
+ *         tests on the single free list.
+ */
+
+#include "contiki.h"
+#include "lib/heapmem.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "heapmem test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_SLOTS      64
+#define NUM_ROUNDS     20000
+#define SMALL_SIZE     24
+#define BENCH_ROUNDS   1000000
+
+static struct {
+  uint8_t *ptr;
+  size_t size;
+  uint8_t fill;
+} slots[NUM_SLOTS];
+
+/*---------------------------------------------------------------------------*/
+/* Checks the first len bytes of the slot */
+static int
+slot_valid(int i, size_t len)
+{
+  size_t j;
+
+  for(j = 0; j < len && j < slots[i].size; j++) {
+    if(slots[i].ptr[j] != slots[i].fill) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+slot_set(int i, uint8_t *ptr, size_t size)
+{
+  slots[i].ptr = ptr;
+  slots[i].size = size;
+  slots[i].fill = i + 1;
+  memset(ptr, slots[i].fill, size);
+}
+/*---------------------------------------------------------------------------*/
+static void
+free_slots(void)
+{
+  int i;
+
+  for(i = 0; i < NUM_SLOTS; i++) {
+    heapmem_free(slots[i].ptr);
+    slots[i].ptr = NULL;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_stats(void)
+{
+  heapmem_stats_t stats;
+#if HEAPMEM_SIZE_CLASSES
+  int i;
+#endif /* HEAPMEM_SIZE_CLASSES */
+
+  heapmem_stats(&stats);
+  printf("allocated %u, available %u, footprint %u, chunks %u, "
+         "largest free %u, fragmentation %u%%\n",
+         (unsigned)stats.allocated, (unsigned)stats.available,
+         (unsigned)stats.footprint, (unsigned)stats.chunks,
+         (unsigned)stats.largest_free, stats.fragmentation);
+#if HEAPMEM_SIZE_CLASSES
+  for(i = 0; i < HEAPMEM_SIZE_CLASSES; i++) {
+    if(stats.classes[i].max_allocated > 0) {
+      printf("  class %d: allocated %u, max %u, cached %u\n", i,
+             (unsigned)stats.classes[i].allocated,
+             (unsigned)stats.classes[i].max_allocated,
+             (unsigned)stats.classes[i].cached);
+    }
+  }
+#endif /* HEAPMEM_SIZE_CLASSES */
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(churn, "Random alloc, realloc and free");
+UNIT_TEST(churn)
+{
+  heapmem_stats_t stats;
+  unsigned long round;
+  unsigned failures;
+  uint8_t *ptr;
+  size_t size;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  failures = 0;
+  for(round = 0; round < NUM_ROUNDS; round++) {
+    i = random_rand() % NUM_SLOTS;
+    UNIT_TEST_ASSERT(slots[i].ptr == NULL || slot_valid(i, slots[i].size));
+
+    /* Mostly small chunks, with a large one now and then */
+    size = random_rand() % 8 == 0 ? 100 + random_rand() % 400 :
+      1 + random_rand() % 64;
+
+    if(slots[i].ptr == NULL) {
+      ptr = heapmem_alloc(size);
+      if(ptr == NULL) {
+        failures++;
+        continue;
+      }
+      slot_set(i, ptr, size);
+    } else if(random_rand() % 4 == 0) {
+      ptr = heapmem_realloc(slots[i].ptr, size);
+      if(ptr == NULL) {
+        failures++;
+        continue;
+      }
+      slots[i].ptr = ptr;
+      UNIT_TEST_ASSERT(slot_valid(i, size));
+      slot_set(i, ptr, size);
+    } else {
+      heapmem_free(slots[i].ptr);
+      slots[i].ptr = NULL;
+    }
+  }
+
+  for(i = 0; i < NUM_SLOTS; i++) {
+    UNIT_TEST_ASSERT(slots[i].ptr == NULL || slot_valid(i, slots[i].size));
+  }
+
+  printf("churn: %u failed allocations\n", failures);
+  print_stats();
+
+  free_slots();
+  heapmem_stats(&stats);
+  UNIT_TEST_ASSERT(stats.allocated == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(reuse, "Same-sized chunks are reused");
+UNIT_TEST(reuse)
+{
+  heapmem_stats_t stats;
+  size_t footprint;
+  unsigned long round;
+  uint8_t *ptr;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < NUM_SLOTS; i++) {
+    ptr = heapmem_alloc(SMALL_SIZE);
+    UNIT_TEST_ASSERT(ptr != NULL);
+    slot_set(i, ptr, SMALL_SIZE);
+  }
+  heapmem_stats(&stats);
+  footprint = stats.footprint;
+
+  /* Freeing and allocating the same size must not grow the heap */
+  for(round = 0; round < NUM_ROUNDS; round++) {
+    i = random_rand() % NUM_SLOTS;
+    UNIT_TEST_ASSERT(slot_valid(i, SMALL_SIZE));
+    heapmem_free(slots[i].ptr);
+    ptr = heapmem_alloc(SMALL_SIZE);
+    UNIT_TEST_ASSERT(ptr != NULL);
+    slot_set(i, ptr, SMALL_SIZE);
+  }
+
+  heapmem_stats(&stats);
+  print_stats();
+  UNIT_TEST_ASSERT(stats.footprint <= footprint);
+  UNIT_TEST_ASSERT(stats.allocated >= NUM_SLOTS * SMALL_SIZE);
+#if HEAPMEM_SIZE_CLASSES
+  i = (SMALL_SIZE - 1) / HEAPMEM_SIZE_CLASS_STEP;
+  UNIT_TEST_ASSERT(stats.classes[i].allocated > 0);
+  UNIT_TEST_ASSERT(stats.classes[i].max_allocated >=
+                   stats.classes[i].allocated);
+#endif /* HEAPMEM_SIZE_CLASSES */
+
+  free_slots();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(large_after_small, "Large chunk after small ones");
+UNIT_TEST(large_after_small)
+{
+  heapmem_stats_t stats;
+  uint8_t *small[HEAPMEM_CONF_ARENA_SIZE / SMALL_SIZE];
+  uint8_t *guard;
+  uint8_t *large;
+  int count;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* The guard chunk keeps the small chunks off the end of the heap */
+  for(count = 0; count < sizeof(small) / sizeof(small[0]); count++) {
+    small[count] = heapmem_alloc(SMALL_SIZE);
+    if(small[count] == NULL) {
+      break;
+    }
+  }
+  UNIT_TEST_ASSERT(count > 2);
+  heapmem_free(small[--count]);
+  guard = heapmem_alloc(1);
+  UNIT_TEST_ASSERT(guard != NULL);
+
+  for(i = 0; i < count; i++) {
+    heapmem_free(small[i]);
+  }
+
+  heapmem_stats(&stats);
+  print_stats();
+
+  /* Most of the heap is free again, split in small chunks */
+  large = heapmem_alloc(HEAPMEM_CONF_ARENA_SIZE / 2);
+  UNIT_TEST_ASSERT(large != NULL);
+  memset(large, 0xaa, HEAPMEM_CONF_ARENA_SIZE / 2);
+  print_stats();
+
+  heapmem_free(large);
+  heapmem_free(guard);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(large_grows, "Large chunk keeps the class caches");
+UNIT_TEST(large_grows)
+{
+  heapmem_stats_t stats;
+  size_t footprint;
+  uint8_t *large;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* Every other chunk freed, so that the free ones stay apart */
+  for(i = 0; i < NUM_SLOTS; i++) {
+    slots[i].ptr = heapmem_alloc(SMALL_SIZE);
+    UNIT_TEST_ASSERT(slots[i].ptr != NULL);
+  }
+  for(i = 0; i < NUM_SLOTS; i += 2) {
+    heapmem_free(slots[i].ptr);
+    slots[i].ptr = NULL;
+  }
+  heapmem_stats(&stats);
+  footprint = stats.footprint;
+#if HEAPMEM_SIZE_CLASSES
+  size_t cached = stats.classes[(SMALL_SIZE - 1) / HEAPMEM_SIZE_CLASS_STEP].cached;
+  UNIT_TEST_ASSERT(cached > 0);
+#endif /* HEAPMEM_SIZE_CLASSES */
+
+  /* Fits in none of the free chunks, the heap grows */
+  large = heapmem_alloc(HEAPMEM_CONF_ARENA_SIZE - footprint - 64);
+  UNIT_TEST_ASSERT(large != NULL);
+  heapmem_stats(&stats);
+  print_stats();
+  UNIT_TEST_ASSERT(stats.footprint > footprint);
+#if HEAPMEM_SIZE_CLASSES
+  UNIT_TEST_ASSERT(stats.classes[(SMALL_SIZE - 1) / HEAPMEM_SIZE_CLASS_STEP].cached
+                   == cached);
+#endif /* HEAPMEM_SIZE_CLASSES */
+
+  heapmem_free(large);
+  free_slots();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(throughput, "Small chunk throughput");
+UNIT_TEST(throughput)
+{
+  static uint8_t *ptrs[NUM_SLOTS];
+  clock_time_t start;
+  clock_time_t elapsed;
+  unsigned long round;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* A large chunk between the small ones to keep some free list */
+  for(i = 0; i < NUM_SLOTS; i++) {
+    ptrs[i] = heapmem_alloc(i % 8 == 0 ? 200 : 8 + (i % 4) * 16);
+    UNIT_TEST_ASSERT(ptrs[i] != NULL);
+  }
+  for(i = 0; i < NUM_SLOTS; i += 2) {
+    heapmem_free(ptrs[i]);
+    ptrs[i] = NULL;
+  }
+
+  start = clock_time();
+  for(round = 0; round < BENCH_ROUNDS; round++) {
+    i = (round * 2) % NUM_SLOTS;
+    ptrs[i] = heapmem_alloc(8 + (round % 4) * 16);
+    heapmem_free(ptrs[i]);
+  }
+  elapsed = clock_time() - start;
+
+  printf("%lu alloc/free pairs: %lu ms, %lu pairs/s\n",
+         (unsigned long)BENCH_ROUNDS,
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+         (unsigned long)(elapsed > 0 ?
+                         (uint64_t)BENCH_ROUNDS * CLOCK_SECOND / elapsed : 0));
+  print_stats();
+
+  for(i = 0; i < NUM_SLOTS; i++) {
+    heapmem_free(ptrs[i]);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("heapmem: %u size classes\n", (unsigned)HEAPMEM_SIZE_CLASSES);
+
+  UNIT_TEST_RUN(churn);
+  UNIT_TEST_RUN(reuse);
+  UNIT_TEST_RUN(large_after_small);
+  UNIT_TEST_RUN(large_grows);
+  UNIT_TEST_RUN(throughput);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         RPL-lite parent selection tests.
+ *
+ *         Feeds rank and link metric changes of many neighbors to the
+ *         parent candidate set and checks the selected parent against
+ *         a search of all neighbors, checks that the MRHOF hysteresis
+ *         still applies, and reports the selection throughput. Build
+ *         with DEFINES=RPL_CONF_WITH_PARENT_SET=0 to run the same
+ *         tests on the search of all neighbors.
+ */
+
+#include "contiki.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/link-stats.h"
+#include "net/mac/mac.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "RPL parent set test");
+AUTOSTART_PROCESSES(&test_process);
+
+extern rpl_of_t rpl_mrhof;
+
+#define NUM_NEIGHBORS  120
+#define NUM_CHANGES    5000
+#define BENCH_ROUNDS   20000
+
+static linkaddr_t lladdrs[NUM_NEIGHBORS];
+
+/*---------------------------------------------------------------------------*/
+static void
+init_instance(void)
+{
+  memset(&curr_instance, 0, sizeof(curr_instance));
+  curr_instance.used = 1;
+  curr_instance.of = &rpl_mrhof;
+  curr_instance.min_hoprankinc = RPL_MIN_HOPRANKINC;
+  curr_instance.max_rankinc = 0;
+  curr_instance.dag.state = DAG_INITIALIZED;
+  curr_instance.dag.rank = RPL_INFINITE_RANK;
+  curr_instance.dag.lowest_rank = RPL_INFINITE_RANK;
+  rpl_neighbor_update_all();
+}
+/*---------------------------------------------------------------------------*/
+static rpl_rank_t
+random_rank(void)
+{
+  return ROOT_RANK + random_rand() % (8 * ROOT_RANK);
+}
+/*---------------------------------------------------------------------------*/
+static rpl_nbr_t *
+add_neighbor(int i)
+{
+  uip_ipaddr_t ipaddr;
+  rpl_nbr_t *nbr;
+
+  memset(&lladdrs[i], 0, sizeof(lladdrs[i]));
+  lladdrs[i].u8[0] = 0x02;
+  lladdrs[i].u8[LINKADDR_SIZE - 2] = i >> 8;
+  lladdrs[i].u8[LINKADDR_SIZE - 1] = i;
+
+  uip_ip6addr(&ipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&ipaddr, (uip_lladdr_t *)&lladdrs[i]);
+  if(uip_ds6_nbr_add(&ipaddr, (uip_lladdr_t *)&lladdrs[i], 0,
+                     NBR_REACHABLE, NBR_TABLE_REASON_RPL_DIO, NULL) == NULL) {
+    return NULL;
+  }
+
+  nbr = nbr_table_add_lladdr(rpl_neighbors, &lladdrs[i],
+                             NBR_TABLE_REASON_RPL_DIO, NULL);
+  if(nbr != NULL) {
+    nbr->rank = random_rank();
+    rpl_neighbor_update(nbr);
+    link_stats_packet_sent(&lladdrs[i], MAC_TX_OK, 1 + random_rand() % 2);
+    rpl_link_callback(&lladdrs[i], MAC_TX_OK, 1);
+  }
+  return nbr;
+}
+/*---------------------------------------------------------------------------*/
+/* Changes the rank as with a DIO, or the link metric as with a packet */
+static void
+change_neighbor(rpl_nbr_t *nbr, const linkaddr_t *lladdr)
+{
+  int status;
+
+  if(random_rand() % 2) {
+    nbr->rank = random_rank();
+    rpl_neighbor_update(nbr);
+  } else {
+    status = random_rand() % 4 == 0 ? MAC_TX_NOACK : MAC_TX_OK;
+    link_stats_packet_sent(lladdr, status, 1 + random_rand() % 3);
+    rpl_link_callback(lladdr, status, 1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The lowest path cost of all acceptable parents, or 0xffff if none */
+static uint16_t
+reference_best_cost(void)
+{
+  rpl_nbr_t *nbr;
+  uint16_t best = 0xffff;
+  rpl_rank_t rank;
+
+  for(nbr = nbr_table_head(rpl_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    rank = rpl_neighbor_rank_via_nbr(nbr);
+    if(rank == RPL_INFINITE_RANK || rank < ROOT_RANK
+       || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+      continue;
+    }
+    if(curr_instance.of->nbr_path_cost(nbr) < best) {
+      best = curr_instance.of->nbr_path_cost(nbr);
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+best_cost(rpl_nbr_t *nbr)
+{
+  return nbr != NULL ? curr_instance.of->nbr_path_cost(nbr) : 0xffff;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_stats(void)
+{
+  printf("selections %lu, full evaluations %lu, neighbors evaluated %lu, "
+         "updates %lu\n",
+         (unsigned long)rpl_parent_selection_stats.selections,
+         (unsigned long)rpl_parent_selection_stats.full_evaluations,
+         (unsigned long)rpl_parent_selection_stats.evaluated,
+         (unsigned long)rpl_parent_selection_stats.updates);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(select_best, "Best parent after neighbor changes");
+UNIT_TEST(select_best)
+{
+  rpl_nbr_t *nbrs[NUM_NEIGHBORS];
+  unsigned long change;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  init_instance();
+  for(i = 0; i < NUM_NEIGHBORS; i++) {
+    nbrs[i] = add_neighbor(i);
+    UNIT_TEST_ASSERT(nbrs[i] != NULL);
+  }
+  UNIT_TEST_ASSERT(rpl_neighbor_count() == NUM_NEIGHBORS);
+
+  /* Without a preferred parent, the lowest path cost wins */
+  for(change = 0; change < NUM_CHANGES; change++) {
+    i = random_rand() % NUM_NEIGHBORS;
+    change_neighbor(nbrs[i], &lladdrs[i]);
+    UNIT_TEST_ASSERT(best_cost(rpl_neighbor_select_best()) ==
+                     reference_best_cost());
+  }
+
+  print_stats();
+  rpl_timers_unschedule_state_update();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(refresh, "Refresh of stale path costs");
+UNIT_TEST(refresh)
+{
+  rpl_nbr_t *nbr;
+  uint32_t full_evaluations;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  rpl_neighbor_select_best();
+  full_evaluations = rpl_parent_selection_stats.full_evaluations;
+
+  /* Change ranks behind the back of the set, then refresh as the
+     periodic DAG timer does */
+  for(i = 0; i < NUM_NEIGHBORS / 4; i++) {
+    nbr = rpl_neighbor_get_from_lladdr(
+      (uip_lladdr_t *)&lladdrs[random_rand() % NUM_NEIGHBORS]);
+    UNIT_TEST_ASSERT(nbr != NULL);
+    nbr->rank = random_rank();
+  }
+  rpl_neighbor_refresh_all();
+  UNIT_TEST_ASSERT(best_cost(rpl_neighbor_select_best()) ==
+                   reference_best_cost());
+
+  /* Stale costs found by the search are refreshed as well */
+  for(i = 0; i < NUM_NEIGHBORS / 4; i++) {
+    nbr = rpl_neighbor_get_from_lladdr(
+      (uip_lladdr_t *)&lladdrs[random_rand() % NUM_NEIGHBORS]);
+    nbr->rank = random_rank();
+  }
+  UNIT_TEST_ASSERT(best_cost(rpl_neighbor_select_best()) ==
+                   reference_best_cost());
+
+  /* Neither keeps the set from being ordered */
+  UNIT_TEST_ASSERT(rpl_parent_selection_stats.full_evaluations ==
+                   full_evaluations);
+
+  print_stats();
+  rpl_timers_unschedule_state_update();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(hysteresis, "MRHOF hysteresis with the parent set");
+UNIT_TEST(hysteresis)
+{
+  rpl_nbr_t *parent;
+  rpl_nbr_t *nbr;
+  uint16_t cost;
+
+  UNIT_TEST_BEGIN();
+
+  parent = rpl_neighbor_select_best();
+  UNIT_TEST_ASSERT(parent != NULL);
+  rpl_neighbor_set_preferred_parent(parent);
+  curr_instance.dag.rank = rpl_neighbor_rank_via_nbr(parent);
+
+  /* Leave room below the parent path cost for the threshold */
+  parent->rank += 1000;
+  rpl_neighbor_update(parent);
+  cost = best_cost(parent);
+
+  /* Move all other neighbors far behind the preferred parent */
+  for(nbr = nbr_table_head(rpl_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    if(nbr != parent) {
+      nbr->rank = cost + 2000;
+      rpl_neighbor_update(nbr);
+    }
+  }
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == parent);
+
+  /* Find another acceptable neighbor and make it slightly better */
+  for(nbr = nbr_table_head(rpl_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    if(nbr != parent && rpl_neighbor_is_acceptable_parent(nbr)) {
+      break;
+    }
+  }
+  UNIT_TEST_ASSERT(nbr != NULL);
+
+  nbr->rank -= best_cost(nbr) - cost + 100;
+  rpl_neighbor_update(nbr);
+  UNIT_TEST_ASSERT(best_cost(nbr) < cost);
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == parent);
+
+  /* Beyond the rank threshold, the neighbor takes over */
+  nbr->rank -= 400;
+  rpl_neighbor_update(nbr);
+  UNIT_TEST_ASSERT(rpl_neighbor_select_best() == nbr);
+
+  rpl_neighbor_set_preferred_parent(NULL);
+  curr_instance.dag.rank = RPL_INFINITE_RANK;
+
+  print_stats();
+  rpl_timers_unschedule_state_update();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(throughput, "Parent selection throughput");
+UNIT_TEST(throughput)
+{
+  clock_time_t start;
+  clock_time_t elapsed;
+  unsigned long round;
+  rpl_nbr_t *nbr;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  memset(&rpl_parent_selection_stats, 0, sizeof(rpl_parent_selection_stats));
+
+  /* One DIO or packet from a single neighbor before each selection */
+  start = clock_time();
+  for(round = 0; round < BENCH_ROUNDS; round++) {
+    i = random_rand() % NUM_NEIGHBORS;
+    nbr = nbr_table_get_from_lladdr(rpl_neighbors, &lladdrs[i]);
+    change_neighbor(nbr, &lladdrs[i]);
+    rpl_neighbor_select_best();
+  }
+  elapsed = clock_time() - start;
+
+  printf("%d neighbors, %lu selections: %lu ms, %lu selections/s\n",
+         NUM_NEIGHBORS, (unsigned long)BENCH_ROUNDS,
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+         (unsigned long)(elapsed > 0 ?
+                         (uint64_t)BENCH_ROUNDS * CLOCK_SECOND / elapsed : 0));
+  print_stats();
+  rpl_timers_unschedule_state_update();
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("RPL parent set: %u\n", RPL_WITH_PARENT_SET);
+
+  UNIT_TEST_RUN(select_best);
+  UNIT_TEST_RUN(refresh);
+  UNIT_TEST_RUN(hysteresis);
+  UNIT_TEST_RUN(throughput);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
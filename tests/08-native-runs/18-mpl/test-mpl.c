@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         MPL seed and buffered message set tests.
+ *
+ *         Feeds MPL data messages from many seeds, out of order and with
+ *         duplicates, and checks which ones the MPL engine accepts. Also
+ *         checks that buffer reclaim frees the lowest sequence number of a
+ *         seed, and reports the data and control message throughput. Build
+ *         with DEFINES=MPL_CONF_SEED_HASH_SIZE=0,MPL_CONF_DOMAIN_HASH_SIZE=0,
+ *         MPL_CONF_SEED_WINDOW_SIZE=0 to run the same tests on the linear
+ *         searches.
+ */
+
+#include "contiki.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/ipv6/multicast/uip-mcast6.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "MPL test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_SEEDS      48
+#define SEED_MESSAGES  8
+#define SEQ_SPREAD     32
+#define RECLAIM_SEED   0x7fff
+#define BENCH_ROUNDS   (NUM_SEEDS * 200)
+#define BENCH_REPEATS  30
+#define CONTROL_ROUNDS 2000
+
+/* MPL hop-by-hop option with a 16 bit seed id (S=1) */
+#define HBHO_LEN       8
+#define MPL_OPT_TYPE   0x6D
+#define PAYLOAD_LEN    16
+
+static uint8_t last_seq[NUM_SEEDS];
+
+/*---------------------------------------------------------------------------*/
+/* Places an MPL data message from a seed in uip_buf and passes it to MPL */
+static uint8_t
+data_in(uint16_t seed, uint8_t seq)
+{
+  uint8_t *hbho;
+  uint8_t *udp;
+
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_HBHO;
+  UIP_IP_BUF->ttl = 64;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfd00, 0, 0, 0, 0, 0, 0, seed + 1);
+  uip_ip6addr(&UIP_IP_BUF->destipaddr, 0xff03, 0, 0, 0, 0, 0, 0, 0xfc);
+
+  hbho = UIP_IP_PAYLOAD(0);
+  hbho[0] = UIP_PROTO_UDP;
+  hbho[1] = 0;
+  hbho[2] = MPL_OPT_TYPE;
+  hbho[3] = 4;
+  hbho[4] = 1 << 6;
+  hbho[5] = seq;
+  hbho[6] = seed >> 8;
+  hbho[7] = seed & 0xff;
+
+  udp = hbho + HBHO_LEN;
+  memset(udp, 0, UIP_UDPH_LEN + PAYLOAD_LEN);
+  udp[5] = UIP_UDPH_LEN + PAYLOAD_LEN;
+  udp[UIP_UDPH_LEN] = seq;
+
+  uip_ext_len = HBHO_LEN;
+  uip_len = UIP_IPH_LEN + HBHO_LEN + UIP_UDPH_LEN + PAYLOAD_LEN;
+  uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
+
+  return UIP_MCAST6.in();
+}
+/*---------------------------------------------------------------------------*/
+/* Passes an MPL control message listing the last messages of all seeds */
+static void
+control_in(void)
+{
+  uint8_t *info;
+  int i;
+
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = 255;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 0x1234);
+  uip_ip6addr(&UIP_IP_BUF->destipaddr, 0xff02, 0, 0, 0, 0, 0, 0, 0xfc);
+  UIP_ICMP_BUF->type = ICMP6_MPL;
+  UIP_ICMP_BUF->icode = 0;
+
+  /* Seed info: min seqno, bm-len and S, seed id, one byte of bit vector */
+  info = UIP_ICMP_PAYLOAD;
+  for(i = 0; i < NUM_SEEDS; i++) {
+    info[0] = last_seq[i] - 7;
+    info[1] = (1 << 2) | 1;
+    info[2] = i >> 8;
+    info[3] = i & 0xff;
+    info[4] = 0xff;
+    info += 5;
+  }
+
+  uip_ext_len = 0;
+  uip_len = info - uip_buf;
+  uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
+
+  uip_icmp6_input(ICMP6_MPL, 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+shuffle(uint8_t *seqs, int count)
+{
+  uint8_t tmp;
+  int i;
+  int j;
+
+  for(i = count - 1; i > 0; i--) {
+    j = random_rand() % (i + 1);
+    tmp = seqs[i];
+    seqs[i] = seqs[j];
+    seqs[j] = tmp;
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(accept_once, "Out of order messages accepted once");
+UNIT_TEST(accept_once)
+{
+  static uint8_t seqs[NUM_SEEDS][SEED_MESSAGES];
+  static uint8_t delivered[NUM_SEEDS][SEED_MESSAGES];
+  int seed;
+  int i;
+  int j;
+  int k;
+
+  UNIT_TEST_BEGIN();
+
+  /* Sequence numbers spread wider than the window, in random order */
+  for(seed = 0; seed < NUM_SEEDS; seed++) {
+    for(i = 0; i < SEED_MESSAGES; i++) {
+      do {
+        seqs[seed][i] = 1 + random_rand() % SEQ_SPREAD;
+        for(j = 0; j < i && seqs[seed][j] != seqs[seed][i]; j++);
+      } while(j < i);
+    }
+    /* The lowest first: older messages of a known seed are dropped */
+    for(i = 1; i < SEED_MESSAGES; i++) {
+      if(seqs[seed][i] < seqs[seed][0]) {
+        k = seqs[seed][0];
+        seqs[seed][0] = seqs[seed][i];
+        seqs[seed][i] = k;
+      }
+    }
+    shuffle(&seqs[seed][1], SEED_MESSAGES - 1);
+    last_seq[seed] = SEQ_SPREAD;
+  }
+  memset(delivered, 0, sizeof(delivered));
+
+  /* Interleave the seeds, repeating earlier messages of each */
+  for(i = 0; i < SEED_MESSAGES; i++) {
+    for(seed = 0; seed < NUM_SEEDS; seed++) {
+      UNIT_TEST_ASSERT(data_in(seed, seqs[seed][i]) == UIP_MCAST6_ACCEPT);
+      delivered[seed][i] = 1;
+      k = random_rand() % (i + 1);
+      UNIT_TEST_ASSERT(data_in(seed, seqs[seed][k]) == UIP_MCAST6_DROP);
+    }
+  }
+
+  /* All messages are now known */
+  for(seed = 0; seed < NUM_SEEDS; seed++) {
+    for(i = 0; i < SEED_MESSAGES; i++) {
+      UNIT_TEST_ASSERT(data_in(seed, seqs[seed][i]) == UIP_MCAST6_DROP);
+    }
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(reclaim, "Buffer reclaim frees the oldest message");
+UNIT_TEST(reclaim)
+{
+  static uint8_t seqs[128];
+  int free_buffers;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* Even sequence numbers, in random order, fill the remaining buffers */
+  free_buffers = MPL_BUFFERED_MESSAGE_SET_SIZE - NUM_SEEDS * SEED_MESSAGES;
+  UNIT_TEST_ASSERT(free_buffers == 128);
+  for(i = 0; i < 128; i++) {
+    seqs[i] = 2 * i;
+  }
+  shuffle(&seqs[1], 127);
+  for(i = 0; i < 128; i++) {
+    UNIT_TEST_ASSERT(data_in(RECLAIM_SEED, seqs[i]) == UIP_MCAST6_ACCEPT);
+  }
+
+  /* A new message reclaims seq 0: the minimum becomes 2 and 1 is too old */
+  UNIT_TEST_ASSERT(data_in(RECLAIM_SEED, 255) == UIP_MCAST6_ACCEPT);
+  UNIT_TEST_ASSERT(data_in(RECLAIM_SEED, 1) == UIP_MCAST6_DROP);
+  UNIT_TEST_ASSERT(data_in(RECLAIM_SEED, 3) == UIP_MCAST6_ACCEPT);
+  for(i = 4; i < 256; i += 2) {
+    UNIT_TEST_ASSERT(data_in(RECLAIM_SEED, i) == UIP_MCAST6_DROP);
+  }
+
+  /* The other seeds kept all their messages */
+  for(i = 0; i < NUM_SEEDS; i++) {
+    UNIT_TEST_ASSERT(data_in(i, last_seq[i] + 1) == UIP_MCAST6_ACCEPT);
+    last_seq[i]++;
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(throughput, "MPL message throughput");
+UNIT_TEST(throughput)
+{
+  clock_time_t start;
+  clock_time_t elapsed;
+  unsigned long round;
+  int seed;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  /* A new message from a seed, then repeats of its recent messages as
+     heard from neighbors. Sequence numbers must not wrap around here. */
+  start = clock_time();
+  for(round = 0; round < BENCH_ROUNDS; round++) {
+    seed = round % NUM_SEEDS;
+    last_seq[seed]++;
+    data_in(seed, last_seq[seed]);
+    for(i = 0; i < BENCH_REPEATS; i++) {
+      data_in(seed, last_seq[seed] - random_rand() % SEED_MESSAGES);
+    }
+  }
+  elapsed = clock_time() - start;
+
+  printf("%d seeds, %lu data messages: %lu ms, %lu messages/s\n",
+         NUM_SEEDS, (unsigned long)BENCH_ROUNDS * (BENCH_REPEATS + 1),
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+         (unsigned long)(elapsed > 0 ?
+                         (uint64_t)BENCH_ROUNDS * (BENCH_REPEATS + 1) *
+                         CLOCK_SECOND / elapsed : 0));
+
+  start = clock_time();
+  for(round = 0; round < CONTROL_ROUNDS; round++) {
+    control_in();
+  }
+  elapsed = clock_time() - start;
+
+  printf("%d seeds, %lu control messages: %lu ms, %lu messages/s\n",
+         NUM_SEEDS, (unsigned long)CONTROL_ROUNDS,
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+         (unsigned long)(elapsed > 0 ?
+                         (uint64_t)CONTROL_ROUNDS * CLOCK_SECOND / elapsed : 0));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("MPL seed hash %u, domain hash %u, seed window %u\n",
+         MPL_SEED_HASH_SIZE, MPL_DOMAIN_HASH_SIZE, MPL_SEED_WINDOW_SIZE);
+
+  UNIT_TEST_RUN(accept_once);
+  UNIT_TEST_RUN(reclaim);
+  UNIT_TEST_RUN(throughput);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
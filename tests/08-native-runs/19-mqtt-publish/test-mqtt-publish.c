@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         MQTT publish throughput tests.
+ *
+ *         Connects the MQTT client to a minimal broker on a TCP socket of
+ *         the same node, so the packets go through the uIP loopback path,
+ *         and publishes a batch of 4 kB sensor payloads, first through the
+ *         output buffer with mqtt_publish() and then as eight 512 byte
+ *         records with mqtt_publish_iov(). Checks that the broker receives
+ *         the same byte stream both ways and reports the throughput and the
+ *         CPU time per kB. Also checks that a segment list the socket
+ *         refuses drops the connection with an error instead of hanging
+ *         the publish. Build with DEFINES=MQTT_CONF_STREAMING_PUBLISH=0
+ *         to run the buffered publish only.
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "mqtt.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+PROCESS(test_process, "MQTT publish test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define BROKER_PORT    1883
+#define TOPIC          "gw/sensors/batch"
+#define NUM_RECORDS    8
+#define RECORD_LEN     512
+#define PAYLOAD_LEN    (NUM_RECORDS * RECORD_LEN)
+#define NUM_MESSAGES   4000
+/* Fixed header, two byte remaining length, topic and payload */
+#define PUBLISH_LEN    (3 + MQTT_STRING_LEN_SIZE + sizeof(TOPIC) - 1 + \
+                        PAYLOAD_LEN)
+
+struct bench {
+  unsigned long messages;
+  unsigned long failed;
+  unsigned long bytes;
+  uint32_t hash;
+  clock_time_t elapsed;
+  clock_t cpu;
+};
+
+static struct mqtt_connection conn;
+static char broker_host[UIPLIB_IPV6_MAX_STR_LEN];
+
+static struct tcp_socket broker;
+static uint8_t broker_in[512];
+static uint8_t broker_out[8];
+static uint8_t broker_connected;
+static struct bench *broker_bench;
+
+static uint8_t records[NUM_RECORDS][RECORD_LEN];
+static uint8_t payload[PAYLOAD_LEN];
+#if MQTT_STREAMING_PUBLISH
+static struct tcp_socket_iov payload_iov[NUM_RECORDS];
+#endif
+
+static struct bench buffered;
+#if MQTT_STREAMING_PUBLISH
+static struct bench streaming;
+#endif
+static uint32_t expected_hash;
+static int mqtt_errors;
+
+/*---------------------------------------------------------------------------*/
+static uint32_t
+hash_bytes(uint32_t hash, const uint8_t *data, int len)
+{
+  int i;
+
+  /* FNV-1a */
+  for(i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * 16777619UL;
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+static int
+broker_input(struct tcp_socket *s, void *ptr,
+             const uint8_t *input_data_ptr, int input_data_len)
+{
+  static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+
+  if(!broker_connected) {
+    /* The CONNECT fits in one segment, accept it */
+    broker_connected = 1;
+    tcp_socket_send(s, connack, sizeof(connack));
+  } else if(broker_bench != NULL) {
+    broker_bench->bytes += input_data_len;
+    broker_bench->hash = hash_bytes(broker_bench->hash,
+                                    input_data_ptr, input_data_len);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+broker_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
+{
+  if(event == TCP_SOCKET_CLOSED || event == TCP_SOCKET_ABORTED ||
+     event == TCP_SOCKET_TIMEDOUT) {
+    broker_connected = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  if(event == MQTT_EVENT_DISCONNECTED) {
+    printf("MQTT disconnected\n");
+  } else if(event == MQTT_EVENT_ERROR) {
+    printf("MQTT error\n");
+    mqtt_errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_payload(void)
+{
+  uint8_t header[PUBLISH_LEN - PAYLOAD_LEN];
+  int i, j;
+
+  for(i = 0; i < NUM_RECORDS; i++) {
+    for(j = 0; j < RECORD_LEN; j++) {
+      records[i][j] = (uint8_t)(i * 31 + j * 7);
+    }
+    memcpy(&payload[i * RECORD_LEN], records[i], RECORD_LEN);
+#if MQTT_STREAMING_PUBLISH
+    payload_iov[i].data = records[i];
+    payload_iov[i].len = RECORD_LEN;
+#endif
+  }
+
+  /* PUBLISH, QoS 0: fixed header, remaining length, topic */
+  header[0] = 0x30;
+  header[1] = ((PUBLISH_LEN - 3) & 0x7f) | 0x80;
+  header[2] = (PUBLISH_LEN - 3) >> 7;
+  header[3] = 0;
+  header[4] = sizeof(TOPIC) - 1;
+  memcpy(&header[5], TOPIC, sizeof(TOPIC) - 1);
+
+  expected_hash = 2166136261UL;
+  for(i = 0; i < NUM_MESSAGES; i++) {
+    expected_hash = hash_bytes(expected_hash, header, sizeof(header));
+    expected_hash = hash_bytes(expected_hash, payload, PAYLOAD_LEN);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_start(struct bench *b)
+{
+  memset(b, 0, sizeof(*b));
+  b->hash = 2166136261UL;
+  broker_bench = b;
+  b->elapsed = clock_time();
+  b->cpu = clock();
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_stop(struct bench *b)
+{
+  b->cpu = clock() - b->cpu;
+  b->elapsed = clock_time() - b->elapsed;
+  broker_bench = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+publish_done(void)
+{
+  return !mqtt_connected(&conn) ||
+    (mqtt_ready(&conn) && tcp_socket_queuelen(&conn.socket) == 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_print(const char *name, const struct bench *b)
+{
+  unsigned long kb = b->bytes / 1024;
+  unsigned long cpu_ns;
+
+  cpu_ns = (unsigned long)((uint64_t)b->cpu * 1000000000 / CLOCKS_PER_SEC);
+  printf("%s: %lu messages, %lu kB in %lu ms, %lu kB/s, %lu.%02lu us CPU/kB\n",
+         name, b->messages, kb, (unsigned long)b->elapsed,
+         b->elapsed > 0 ?
+         (unsigned long)((uint64_t)kb * CLOCK_SECOND / b->elapsed) : 0,
+         kb > 0 ? cpu_ns / kb / 1000 : 0,
+         kb > 0 ? cpu_ns / kb / 10 % 100 : 0);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(buffered_publish, "Publish through the output buffer");
+UNIT_TEST(buffered_publish)
+{
+  UNIT_TEST_BEGIN();
+
+  bench_print("mqtt_publish", &buffered);
+  UNIT_TEST_ASSERT(buffered.messages == NUM_MESSAGES);
+  UNIT_TEST_ASSERT(buffered.failed == 0);
+  UNIT_TEST_ASSERT(buffered.bytes == (unsigned long)NUM_MESSAGES * PUBLISH_LEN);
+  UNIT_TEST_ASSERT(buffered.hash == expected_hash);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+#if MQTT_STREAMING_PUBLISH
+UNIT_TEST_REGISTER(streaming_publish, "Publish from a segment list");
+UNIT_TEST(streaming_publish)
+{
+  UNIT_TEST_BEGIN();
+
+  bench_print("mqtt_publish_iov", &streaming);
+  UNIT_TEST_ASSERT(streaming.messages == NUM_MESSAGES);
+  UNIT_TEST_ASSERT(streaming.failed == 0);
+  UNIT_TEST_ASSERT(streaming.bytes == (unsigned long)NUM_MESSAGES * PUBLISH_LEN);
+  UNIT_TEST_ASSERT(streaming.hash == expected_hash);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(refused_iov, "A refused segment list aborts the publish");
+UNIT_TEST(refused_iov)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(mqtt_errors == 1);
+  UNIT_TEST_ASSERT(!mqtt_connected(&conn));
+
+  UNIT_TEST_END();
+}
+#endif /* MQTT_STREAMING_PUBLISH */
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer et;
+  static int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("MQTT streaming publish %u, output buffer %u, MSS %u\n",
+         MQTT_STREAMING_PUBLISH, MQTT_TCP_OUTPUT_BUFF_SIZE, UIP_TCP_MSS);
+
+  init_payload();
+
+  tcp_socket_register(&broker, NULL, broker_in, sizeof(broker_in),
+                      broker_out, sizeof(broker_out),
+                      broker_input, broker_event);
+  tcp_socket_listen(&broker, BROKER_PORT);
+
+  /* Talk to ourselves, uIP loops packets to its own addresses back */
+  uiplib_ipaddr_snprint(broker_host, sizeof(broker_host),
+                        &uip_ds6_get_global(-1)->ipaddr);
+
+  mqtt_register(&conn, &test_process, "bench", mqtt_event, UIP_TCP_MSS);
+  mqtt_connect(&conn, broker_host, BROKER_PORT, 600, MQTT_CLEAN_SESSION_ON);
+
+  etimer_set(&et, 5 * CLOCK_SECOND);
+  while(!mqtt_ready(&conn) && !etimer_expired(&et)) {
+    PROCESS_WAIT_EVENT();
+  }
+  printf("MQTT %sconnected to [%s]:%u\n",
+         mqtt_ready(&conn) ? "" : "not ", broker_host, BROKER_PORT);
+
+  bench_start(&buffered);
+  for(i = 0; i < NUM_MESSAGES && mqtt_connected(&conn); i++) {
+    if(mqtt_publish(&conn, NULL, TOPIC, payload, PAYLOAD_LEN,
+                    MQTT_QOS_LEVEL_0, MQTT_RETAIN_OFF) == MQTT_STATUS_OK) {
+      buffered.messages++;
+    } else {
+      buffered.failed++;
+    }
+    while(!publish_done()) {
+      PROCESS_PAUSE();
+    }
+  }
+  bench_stop(&buffered);
+
+#if MQTT_STREAMING_PUBLISH
+  bench_start(&streaming);
+  for(i = 0; i < NUM_MESSAGES && mqtt_connected(&conn); i++) {
+    if(mqtt_publish_iov(&conn, NULL, TOPIC, payload_iov, NUM_RECORDS,
+                        MQTT_QOS_LEVEL_0, MQTT_RETAIN_OFF) == MQTT_STATUS_OK) {
+      streaming.messages++;
+    } else {
+      streaming.failed++;
+    }
+    while(!publish_done()) {
+      PROCESS_PAUSE();
+    }
+  }
+  bench_stop(&streaming);
+
+  /*
+   * A list still queued on the socket makes it refuse the next one. Over
+   * the loopback a list is sent as soon as uIP polls, so queue it by hand
+   * without the poll to keep it there until the publish runs.
+   */
+  mqtt_publish_iov(&conn, NULL, TOPIC, payload_iov, NUM_RECORDS,
+                   MQTT_QOS_LEVEL_0, MQTT_RETAIN_OFF);
+  conn.socket.output_iov = payload_iov;
+  conn.socket.output_iov_cnt = 1;
+  conn.socket.output_iov_off = 0;
+  conn.socket.output_iov_send_nxt = 0;
+  conn.socket.output_iov_len = RECORD_LEN;
+  etimer_set(&et, 5 * CLOCK_SECOND);
+  while(mqtt_connected(&conn) && !etimer_expired(&et)) {
+    PROCESS_WAIT_EVENT();
+  }
+#endif /* MQTT_STREAMING_PUBLISH */
+
+  UNIT_TEST_RUN(buffered_publish);
+#if MQTT_STREAMING_PUBLISH
+  UNIT_TEST_RUN(streaming_publish);
+  UNIT_TEST_RUN(refused_iov);
+#endif
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
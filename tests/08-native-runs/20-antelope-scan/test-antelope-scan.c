@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Antelope row scan tests.
+ *
+ *         Fills a relation in a Coffee file system and runs full-table
+ *         selects over it the way the antelope-shell example does, checking
+ *         the returned rows, that rows appended after a scan are seen by the
+ *         next one while the relation stays loaded, and reporting the scan rate and the file accesses per
+ *         scan. Build with DEFINES=DB_ROW_CACHE_PAGES=0 to run the same tests
+ *         with one seek and read per row.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs-coffee.h"
+#include "antelope.h"
+#include "relation.h"
+#include "storage.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "Antelope scan test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_ROWS       3000
+#define EXTRA_ROWS     7
+#define SCAN_ROUNDS    200
+#define QUERY          "SELECT time, temp FROM samples WHERE temp > 30;"
+
+#define ROW_NODE(i)    ((long)(i) * 100003L)
+#define ROW_TEMP(i)    (((i) * 7) % 50)
+#define ROW_HUM(i)     (((i) * 13) % 100)
+
+struct scan {
+  long matching;
+  long processed;
+  long time_sum;
+};
+
+/*---------------------------------------------------------------------------*/
+static db_result_t
+insert_rows(int from, int to)
+{
+  int i;
+
+  for(i = from; i < to; i++) {
+    if(DB_ERROR(db_query(NULL, "INSERT (%d, %ld, %d, %d) INTO samples;",
+                         i, ROW_NODE(i), ROW_TEMP(i), ROW_HUM(i)))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+run_scan(struct scan *scan)
+{
+  static db_handle_t handle;
+  attribute_value_t value;
+  db_result_t result;
+
+  memset(scan, 0, sizeof(*scan));
+
+  result = db_query(&handle, QUERY);
+  if(DB_ERROR(result)) {
+    db_free(&handle);
+    return result;
+  }
+
+  while(db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_GOT_ROW) {
+      scan->matching++;
+      scan->processed++;
+      if(DB_ERROR(db_get_value(&value, &handle, 0))) {
+        result = DB_TYPE_ERROR;
+        break;
+      }
+      scan->time_sum += db_value_to_long(&value);
+    } else if(result == DB_OK) {
+      scan->processed++;
+    } else {
+      break;
+    }
+  }
+  db_free(&handle);
+
+  return result == DB_FINISHED ? DB_OK : result;
+}
+/*---------------------------------------------------------------------------*/
+static void
+expected_scan(struct scan *scan, int rows)
+{
+  int i;
+
+  memset(scan, 0, sizeof(*scan));
+  for(i = 0; i < rows; i++) {
+    scan->processed++;
+    if(ROW_TEMP(i) > 30) {
+      scan->matching++;
+      scan->time_sum += i;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(scan_rows, "Full-table select returns every row");
+UNIT_TEST(scan_rows)
+{
+  struct scan scan;
+  struct scan expected;
+
+  UNIT_TEST_BEGIN();
+
+  expected_scan(&expected, NUM_ROWS);
+  UNIT_TEST_ASSERT(run_scan(&scan) == DB_OK);
+  UNIT_TEST_ASSERT(scan.processed == expected.processed);
+  UNIT_TEST_ASSERT(scan.matching == expected.matching);
+  UNIT_TEST_ASSERT(scan.time_sum == expected.time_sum);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(append_rows, "Rows appended after a scan are read");
+UNIT_TEST(append_rows)
+{
+  struct scan scan;
+  struct scan expected;
+  relation_t *rel;
+
+  UNIT_TEST_BEGIN();
+
+  /* Keep the tuple file open between the queries, so that the cached
+     tail page and row count must be updated by the inserts */
+  rel = relation_load("samples");
+  UNIT_TEST_ASSERT(rel != NULL);
+
+  UNIT_TEST_ASSERT(run_scan(&scan) == DB_OK);
+  UNIT_TEST_ASSERT(insert_rows(NUM_ROWS, NUM_ROWS + EXTRA_ROWS) == DB_OK);
+
+  expected_scan(&expected, NUM_ROWS + EXTRA_ROWS);
+  UNIT_TEST_ASSERT(run_scan(&scan) == DB_OK);
+  relation_release(rel);
+  UNIT_TEST_ASSERT(scan.processed == expected.processed);
+  UNIT_TEST_ASSERT(scan.matching == expected.matching);
+  UNIT_TEST_ASSERT(scan.time_sum == expected.time_sum);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(scan_rate, "Full-table select rate");
+UNIT_TEST(scan_rate)
+{
+  struct scan scan;
+  clock_time_t start;
+  clock_time_t elapsed;
+  unsigned long rows;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  memset(&storage_stats, 0, sizeof(storage_stats));
+  rows = 0;
+  start = clock_time();
+  for(i = 0; i < SCAN_ROUNDS; i++) {
+    UNIT_TEST_ASSERT(run_scan(&scan) == DB_OK);
+    rows += scan.processed;
+  }
+  elapsed = clock_time() - start;
+  if(elapsed == 0) {
+    elapsed = 1;
+  }
+
+  printf("%d scans of %ld rows: %lu ms, %lu rows/s\n",
+         SCAN_ROUNDS, scan.processed, (unsigned long)elapsed,
+         (unsigned long)((uint64_t)rows * CLOCK_SECOND / elapsed));
+  printf("per scan: %lu seeks, %lu reads, %lu page hits, %lu page misses\n",
+         storage_stats.file_seeks / SCAN_ROUNDS,
+         storage_stats.file_reads / SCAN_ROUNDS,
+         storage_stats.page_hits / SCAN_ROUNDS,
+         storage_stats.page_misses / SCAN_ROUNDS);
+  UNIT_TEST_ASSERT(rows == (unsigned long)SCAN_ROUNDS * (NUM_ROWS + EXTRA_ROWS));
+  UNIT_TEST_ASSERT(storage_stats.rows_read == rows);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("Row cache %u pages of %u bytes\n",
+         DB_ROW_CACHE_PAGES, DB_ROW_CACHE_PAGE_SIZE);
+
+  cfs_coffee_format();
+  db_init();
+
+  db_query(NULL, "CREATE RELATION samples;");
+  db_query(NULL, "CREATE ATTRIBUTE time DOMAIN INT IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE node DOMAIN LONG IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE temp DOMAIN INT IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE hum DOMAIN INT IN samples;");
+  if(DB_ERROR(insert_rows(0, NUM_ROWS))) {
+    printf("Failed to insert the rows\n");
+  }
+
+  UNIT_TEST_RUN(scan_rows);
+  UNIT_TEST_RUN(append_rows);
+  UNIT_TEST_RUN(scan_rate);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Antelope predicate evaluation tests.
+ *
+ *         Checks that compiled LVM predicates give the same results as the
+ *         interpreted bytecode, including math errors, that selections with
+ *         compound conditions return the right rows, and reports the
+ *         selection rate and the query counters. Build with
+ *         DEFINES=LVM_COMPILE_PREDICATES=0 to run the selections with the
+ *         bytecode interpreter and name lookups for each row.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs-coffee.h"
+#include "antelope.h"
+#include "aql.h"
+#include "lvm.h"
+#include "relation.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "Antelope LVM test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_ROWS       3000
+#define SELECT_ROUNDS  200
+#define WHERE_AND      "temp > 30 AND hum < 60"
+#define WHERE_ARITH    "temp * 2 > hum + 40 OR time / 100 = 7"
+
+#define ROW_NODE(i)    ((long)(i) * 100003L)
+#define ROW_TEMP(i)    (((i) * 7) % 50)
+#define ROW_HUM(i)     (((i) * 13) % 100)
+
+#define MATCH_AND(i)   (ROW_TEMP(i) > 30 && ROW_HUM(i) < 60)
+#define MATCH_ARITH(i) (ROW_TEMP(i) * 2 > ROW_HUM(i) + 40 || (i) / 100 == 7)
+
+struct selection {
+  long matching;
+  long time_sum;
+};
+
+/*---------------------------------------------------------------------------*/
+static db_result_t
+run_select(const char *where, struct selection *selection)
+{
+  static db_handle_t handle;
+  attribute_value_t value;
+  db_result_t result;
+
+  memset(selection, 0, sizeof(*selection));
+
+  result = db_query(&handle, "SELECT time, temp, hum FROM samples WHERE %s;",
+                    where);
+  if(DB_ERROR(result)) {
+    db_free(&handle);
+    return result;
+  }
+
+  while(db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_GOT_ROW) {
+      selection->matching++;
+      if(DB_ERROR(db_get_value(&value, &handle, 0))) {
+        result = DB_TYPE_ERROR;
+        break;
+      }
+      selection->time_sum += db_value_to_long(&value);
+    } else if(result != DB_OK) {
+      break;
+    }
+  }
+  db_free(&handle);
+
+  return result == DB_FINISHED ? DB_OK : result;
+}
+/*---------------------------------------------------------------------------*/
+#if LVM_COMPILE_PREDICATES
+UNIT_TEST_REGISTER(compiled_program, "Compiled predicates match the bytecode");
+UNIT_TEST(compiled_program)
+{
+  static aql_adt_t adt;
+  char query[AQL_MAX_QUERY_LENGTH];
+  lvm_instance_t *compiled;
+  lvm_instance_t interpreted;
+  variable_id_t a;
+  variable_id_t b;
+  operand_value_t value;
+  long i, j;
+  unsigned matching;
+  unsigned errors;
+  lvm_status_t r;
+
+  UNIT_TEST_BEGIN();
+
+  strcpy(query, "SELECT a FROM r WHERE a / b > 2 AND a - b <= 5 OR a * 3 > 20;");
+  UNIT_TEST_ASSERT(!AQL_ERROR(aql_parse(&adt, query)));
+  compiled = adt.lvm_instance;
+  UNIT_TEST_ASSERT(compiled != NULL);
+
+  /* A copy of the instance is not compiled and runs the bytecode. */
+  lvm_clone(&interpreted, compiled);
+  UNIT_TEST_ASSERT(lvm_compile(compiled) == LVM_TRUE);
+
+  a = lvm_get_variable_id("a");
+  b = lvm_get_variable_id("b");
+  UNIT_TEST_ASSERT(a != LVM_MAX_VARIABLE_ID);
+  UNIT_TEST_ASSERT(b != LVM_MAX_VARIABLE_ID);
+  UNIT_TEST_ASSERT(a != b);
+  UNIT_TEST_ASSERT(lvm_get_variable_id("c") == LVM_MAX_VARIABLE_ID);
+
+  matching = errors = 0;
+  for(i = -20; i <= 20; i++) {
+    for(j = -20; j <= 20; j++) {
+      value.l = i;
+      lvm_set_variable_slot(a, value);
+      value.l = j;
+      lvm_set_variable_slot(b, value);
+      r = lvm_execute(compiled);
+      UNIT_TEST_ASSERT(r == lvm_execute(&interpreted));
+      matching += r == LVM_TRUE;
+      errors += r == LVM_MATH_ERROR;
+    }
+  }
+  UNIT_TEST_ASSERT(matching > 0);
+  UNIT_TEST_ASSERT(errors == 41);
+
+  UNIT_TEST_END();
+}
+#endif /* LVM_COMPILE_PREDICATES */
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(select_rows, "Selections with compound conditions");
+UNIT_TEST(select_rows)
+{
+  struct selection selection;
+  long matching[2];
+  long time_sum[2];
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  memset(matching, 0, sizeof(matching));
+  memset(time_sum, 0, sizeof(time_sum));
+  for(i = 0; i < NUM_ROWS; i++) {
+    if(MATCH_AND(i)) {
+      matching[0]++;
+      time_sum[0] += i;
+    }
+    if(MATCH_ARITH(i)) {
+      matching[1]++;
+      time_sum[1] += i;
+    }
+  }
+
+  UNIT_TEST_ASSERT(run_select(WHERE_AND, &selection) == DB_OK);
+  UNIT_TEST_ASSERT(selection.matching == matching[0]);
+  UNIT_TEST_ASSERT(selection.time_sum == time_sum[0]);
+
+  UNIT_TEST_ASSERT(run_select(WHERE_ARITH, &selection) == DB_OK);
+  UNIT_TEST_ASSERT(selection.matching == matching[1]);
+  UNIT_TEST_ASSERT(selection.time_sum == time_sum[1]);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(select_rate, "Selection rate");
+UNIT_TEST(select_rate)
+{
+  struct selection selection;
+  clock_time_t start;
+  clock_time_t elapsed;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  memset(&query_stats, 0, sizeof(query_stats));
+  start = clock_time();
+  for(i = 0; i < SELECT_ROUNDS; i++) {
+    UNIT_TEST_ASSERT(run_select(WHERE_ARITH, &selection) == DB_OK);
+  }
+  elapsed = clock_time() - start;
+  if(elapsed == 0) {
+    elapsed = 1;
+  }
+
+  printf("%d selections of %d rows: %lu ms, %lu rows/s\n",
+         SELECT_ROUNDS, NUM_ROWS, (unsigned long)elapsed,
+         (unsigned long)((uint64_t)query_stats.rows_evaluated *
+                         CLOCK_SECOND / elapsed));
+  printf("query stats: %lu selects, %lu compiled, %lu rows evaluated, "
+         "%lu matched, %lu ms\n",
+         query_stats.selects, query_stats.compiled,
+         query_stats.rows_evaluated, query_stats.rows_matched,
+         query_stats.query_time * 1000 / CLOCK_SECOND);
+  UNIT_TEST_ASSERT(query_stats.selects == SELECT_ROUNDS);
+  UNIT_TEST_ASSERT(query_stats.compiled ==
+                   (LVM_COMPILE_PREDICATES ? SELECT_ROUNDS : 0));
+  UNIT_TEST_ASSERT(query_stats.rows_evaluated ==
+                   (unsigned long)SELECT_ROUNDS * NUM_ROWS);
+  UNIT_TEST_ASSERT(query_stats.rows_matched ==
+                   (unsigned long)SELECT_ROUNDS * selection.matching);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("Compiled predicates %s\n", LVM_COMPILE_PREDICATES ? "on" : "off");
+
+  cfs_coffee_format();
+  db_init();
+
+  db_query(NULL, "CREATE RELATION samples;");
+  db_query(NULL, "CREATE ATTRIBUTE time DOMAIN INT IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE node DOMAIN LONG IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE temp DOMAIN INT IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE hum DOMAIN INT IN samples;");
+  for(i = 0; i < NUM_ROWS; i++) {
+    if(DB_ERROR(db_query(NULL, "INSERT (%d, %ld, %d, %d) INTO samples;",
+                         i, ROW_NODE(i), ROW_TEMP(i), ROW_HUM(i)))) {
+      printf("Failed to insert the rows\n");
+      break;
+    }
+  }
+
+#if LVM_COMPILE_PREDICATES
+  UNIT_TEST_RUN(compiled_program);
+#endif /* LVM_COMPILE_PREDICATES */
+  UNIT_TEST_RUN(select_rows);
+  UNIT_TEST_RUN(select_rate);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Native main loop tests.
+ *
+ *         Measures how late etimers are delivered, how long a process
+ *         polled from another thread waits before it runs, and how much
+ *         CPU time the loop burns while idle, and checks that a file
+ *         descriptor reopened under the same number is still watched.
+ *         The timings are reported rather than checked, as they depend
+ *         on the load of the host. Build with DEFINES=SELECT_CONF_EPOLL=0
+ *         to measure the select loop.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+PROCESS(test_process, "Native loop test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define TIMER_ROUNDS   10
+#define TIMER_PERIOD   (CLOCK_SECOND / 50)
+#define POLL_ROUNDS    5
+#define POLL_DELAY_US  50000
+#define IDLE_TIME      (CLOCK_SECOND / 2)
+#define REOPEN_TIMEOUT CLOCK_SECOND
+
+struct latency {
+  uint64_t total_us;
+  uint64_t max_us;
+  unsigned count;
+};
+
+static struct latency timer_latency;
+static struct latency poll_latency;
+static uint64_t idle_cpu_us;
+static select_stats_t idle_stats;
+
+static pthread_t poller;
+static volatile uint64_t polled_at_us;
+
+static int pipe_rfd = -1;
+static int pipe_wfd = -1;
+static unsigned pipe_reads[2];
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static uint64_t
+cpu_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+latency_add(struct latency *l, uint64_t us)
+{
+  l->total_us += us;
+  if(us > l->max_us) {
+    l->max_us = us;
+  }
+  l->count++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+latency_print(const char *name, struct latency *l)
+{
+  printf("%s: %u rounds, %lu us average, %lu us max\n", name, l->count,
+         (unsigned long)(l->count ? l->total_us / l->count : 0),
+         (unsigned long)l->max_us);
+}
+/*---------------------------------------------------------------------------*/
+static void *
+poller_thread(void *arg)
+{
+  struct timespec delay = { 0, POLL_DELAY_US * 1000 };
+  int i;
+
+  for(i = 0; i < POLL_ROUNDS; i++) {
+    /* Wait until the previous poll has been handled */
+    while(polled_at_us != 0) {
+      nanosleep(&delay, NULL);
+    }
+    nanosleep(&delay, NULL);
+    polled_at_us = now_us();
+    process_poll(&test_process);
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pipe_set_fd(fd_set *fdr, fd_set *fdw)
+{
+  if(pipe_rfd < 0) {
+    return -1;
+  }
+  FD_SET(pipe_rfd, fdr);
+  return pipe_rfd;
+}
+/*---------------------------------------------------------------------------*/
+static void
+pipe_handle_fd(fd_set *fdr, fd_set *fdw)
+{
+  char c;
+
+  if(pipe_rfd >= 0 && FD_ISSET(pipe_rfd, fdr) &&
+     read(pipe_rfd, &c, 1) == 1) {
+    pipe_reads[c == 'b']++;
+    process_poll(&test_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback pipe_callback = {
+  pipe_set_fd,
+  pipe_handle_fd
+};
+/*---------------------------------------------------------------------------*/
+/* Replaces the pipe with a new one, read under the same fd number */
+static int
+pipe_reopen(void)
+{
+  int fds[2];
+
+  if(pipe(fds) < 0) {
+    return -1;
+  }
+  if(dup2(fds[0], pipe_rfd) < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return -1;
+  }
+  close(fds[0]);
+  close(pipe_wfd);
+  pipe_wfd = fds[1];
+  return select_set_callback(pipe_rfd, &pipe_callback);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(timer_latency, "Etimers are delivered on time");
+UNIT_TEST(timer_latency)
+{
+  UNIT_TEST_BEGIN();
+
+  latency_print("etimer lateness", &timer_latency);
+  UNIT_TEST_ASSERT(timer_latency.count == TIMER_ROUNDS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(poll_latency, "Polls from another thread wake the loop");
+UNIT_TEST(poll_latency)
+{
+  UNIT_TEST_BEGIN();
+
+  latency_print("poll latency", &poll_latency);
+  UNIT_TEST_ASSERT(poll_latency.count == POLL_ROUNDS);
+#if SELECT_EPOLL
+  UNIT_TEST_ASSERT(select_stats.poll_wakeups > 0);
+#endif /* SELECT_EPOLL */
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(idle_loop, "The idle loop sleeps");
+UNIT_TEST(idle_loop)
+{
+  UNIT_TEST_BEGIN();
+
+  printf("idle %lu ms: %lu us CPU, %lu iterations, %lu ms asleep\n",
+         (unsigned long)(IDLE_TIME * 1000 / CLOCK_SECOND),
+         (unsigned long)idle_cpu_us, idle_stats.iterations,
+         (unsigned long)(idle_stats.sleep_us / 1000));
+  printf("loop stats: %lu iterations, %lu fd, %lu poll, %lu timer wakeups, "
+         "%lu timeouts, %lu etimer polls, %lu ms asleep\n",
+         select_stats.iterations, select_stats.fd_wakeups,
+         select_stats.poll_wakeups, select_stats.timer_wakeups,
+         select_stats.timeouts, select_stats.etimer_polls,
+         (unsigned long)(select_stats.sleep_us / 1000));
+  printf("etimer poll lateness: %lu us total, %lu us max\n",
+         (unsigned long)select_stats.timer_late_us,
+         (unsigned long)select_stats.timer_late_max_us);
+#if SELECT_EPOLL
+  /* A busy loop would iterate thousands of times */
+  UNIT_TEST_ASSERT(idle_stats.iterations < 100);
+#endif /* SELECT_EPOLL */
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(fd_reopen, "A reopened fd is still watched");
+UNIT_TEST(fd_reopen)
+{
+  UNIT_TEST_BEGIN();
+
+  printf("pipe reads: %u before, %u after reopening\n",
+         pipe_reads[0], pipe_reads[1]);
+  UNIT_TEST_ASSERT(pipe_reads[0] == 1);
+  UNIT_TEST_ASSERT(pipe_reads[1] == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer et;
+  static clock_time_t deadline;
+  static uint64_t cpu_start;
+  static int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("Main loop %s\n", SELECT_EPOLL ? "epoll" : "select");
+
+  /* Let the start-up settle */
+  etimer_set(&et, CLOCK_SECOND / 10);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  for(i = 0; i < TIMER_ROUNDS; i++) {
+    etimer_set(&et, TIMER_PERIOD);
+    deadline = etimer_expiration_time(&et);
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER && data == &et);
+    latency_add(&timer_latency,
+                now_us() - (uint64_t)deadline * (1000000 / CLOCK_SECOND));
+  }
+
+  polled_at_us = 0;
+  pthread_create(&poller, NULL, poller_thread, NULL);
+  for(i = 0; i < POLL_ROUNDS; i++) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    latency_add(&poll_latency, now_us() - polled_at_us);
+    polled_at_us = 0;
+  }
+  pthread_join(poller, NULL);
+
+  memcpy(&idle_stats, &select_stats, sizeof(idle_stats));
+  cpu_start = cpu_us();
+  etimer_set(&et, IDLE_TIME);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  idle_cpu_us = cpu_us() - cpu_start;
+  idle_stats.iterations = select_stats.iterations - idle_stats.iterations;
+  idle_stats.sleep_us = select_stats.sleep_us - idle_stats.sleep_us;
+
+  {
+    int fds[2];
+
+    if(pipe(fds) == 0) {
+      pipe_rfd = fds[0];
+      pipe_wfd = fds[1];
+      select_set_callback(pipe_rfd, &pipe_callback);
+    }
+  }
+  if(pipe_rfd >= 0 && write(pipe_wfd, "a", 1) == 1) {
+    etimer_set(&et, REOPEN_TIMEOUT);
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || etimer_expired(&et));
+  }
+  if(pipe_rfd >= 0 && pipe_reopen() > 0 && write(pipe_wfd, "b", 1) == 1) {
+    etimer_set(&et, REOPEN_TIMEOUT);
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || etimer_expired(&et));
+  }
+
+  UNIT_TEST_RUN(timer_latency);
+  UNIT_TEST_RUN(poll_latency);
+  UNIT_TEST_RUN(idle_loop);
+  UNIT_TEST_RUN(fd_reopen);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Batched tun I/O tests.
+ *
+ *         Runs the tun I/O helper on a SOCK_SEQPACKET socket pair, which
+ *         keeps packet boundaries like a tun device does. Checks that
+ *         batched reads and queued writes keep packets whole and in
+ *         order, that a full device pushes back on the write queue, and
+ *         measures the packet rate of an echo loop. Build with
+ *         DEFINES=TUN_IO_CONF_RX_BATCH=1,TUN_IO_CONF_TX_QUEUE=0 to test
+ *         unbatched I/O.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "tun-io.h"
+#include <err.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+PROCESS(test_process, "Tun batch test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define RX_PACKETS     40
+#define TX_PACKETS     10
+#define ECHO_PACKETS   100000
+#define ECHO_BURST     32
+#define PACKET_LEN(i)  (40 + ((i) * 37) % 1000)
+
+static struct tun_io tun_io;
+static int fds[2];
+static uint8_t packet[UIP_BUFSIZE];
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+fill_packet(uint8_t *data, int i)
+{
+  int len;
+  int j;
+
+  len = PACKET_LEN(i);
+  for(j = 0; j < len; j++) {
+    data[j] = i + j;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_packet(const uint8_t *data, int len, int i)
+{
+  int j;
+
+  if(len != PACKET_LEN(i)) {
+    return 0;
+  }
+  for(j = 0; j < len; j++) {
+    if(data[j] != (uint8_t)(i + j)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads all packets waiting on the peer, checking them from number first */
+static int
+peer_receive(int first)
+{
+  int len;
+  int n;
+
+  for(n = 0;; n++) {
+    len = recv(fds[1], packet, sizeof(packet), MSG_DONTWAIT);
+    if(len <= 0) {
+      return n;
+    }
+    if(!check_packet(packet, len, first + n)) {
+      printf("packet %d is corrupt\n", first + n);
+      return -1;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* What the main loop pays for each wakeup */
+static void
+wait_readable(void)
+{
+  fd_set rset;
+
+  FD_ZERO(&rset);
+  FD_SET(fds[0], &rset);
+  select(fds[0] + 1, &rset, NULL, NULL, NULL);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(rx_batch, "Batched reads keep packets whole and in order");
+UNIT_TEST(rx_batch)
+{
+  int i, n, reads;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < RX_PACKETS; i++) {
+    fill_packet(packet, i);
+    UNIT_TEST_ASSERT(send(fds[1], packet, PACKET_LEN(i), 0) == PACKET_LEN(i));
+  }
+
+  n = 0;
+  for(reads = 0; n < RX_PACKETS; reads++) {
+    UNIT_TEST_ASSERT(tun_io_read(&tun_io, TUN_IO_RX_BATCH) > 0);
+    while(tun_io_next(&tun_io)) {
+      UNIT_TEST_ASSERT(check_packet(uip_buf, uip_len, n));
+      n++;
+    }
+  }
+  printf("%d packets in %d reads\n", n, reads);
+  UNIT_TEST_ASSERT(n == RX_PACKETS);
+  UNIT_TEST_ASSERT(reads == (RX_PACKETS + TUN_IO_RX_BATCH - 1) / TUN_IO_RX_BATCH);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(tx_queue, "Queued writes go out in order on a flush");
+UNIT_TEST(tx_queue)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < TX_PACKETS; i++) {
+    fill_packet(packet, i);
+    UNIT_TEST_ASSERT(tun_io_write(&tun_io, packet, PACKET_LEN(i)) == 0);
+  }
+#if TUN_IO_TX_QUEUE >= TX_PACKETS
+  UNIT_TEST_ASSERT(tun_io_pending(&tun_io) == TX_PACKETS);
+  UNIT_TEST_ASSERT(peer_receive(0) == 0);
+#endif /* TUN_IO_TX_QUEUE >= TX_PACKETS */
+  tun_io_flush(&tun_io);
+  UNIT_TEST_ASSERT(tun_io_pending(&tun_io) == 0);
+  UNIT_TEST_ASSERT(peer_receive(0) == TX_PACKETS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(tx_full, "A full device holds packets in the queue");
+UNIT_TEST(tx_full)
+{
+  int accepted;
+  int received;
+  int n;
+
+  UNIT_TEST_BEGIN();
+
+#if TUN_IO_TX_QUEUE > 0
+  /* Write until both the socket and the queue are full */
+  for(accepted = 0;; accepted++) {
+    fill_packet(packet, accepted);
+    if(tun_io_write(&tun_io, packet, PACKET_LEN(accepted)) != 0) {
+      break;
+    }
+  }
+  printf("%d packets accepted, %d queued\n", accepted,
+         tun_io_pending(&tun_io));
+  UNIT_TEST_ASSERT(tun_io_pending(&tun_io) == TUN_IO_TX_QUEUE);
+
+  /* Nothing is lost once the peer drains the socket */
+  for(received = 0; received < accepted; received += n) {
+    n = peer_receive(received);
+    UNIT_TEST_ASSERT(n > 0);
+    tun_io_flush(&tun_io);
+  }
+  UNIT_TEST_ASSERT(received == accepted);
+  UNIT_TEST_ASSERT(tun_io_pending(&tun_io) == 0);
+#if TUN_IO_STATS
+  UNIT_TEST_ASSERT(tun_io_stats(&tun_io)->tx_dropped == 1);
+#endif /* TUN_IO_STATS */
+#else /* TUN_IO_TX_QUEUE > 0 */
+  (void)accepted;
+  (void)received;
+  (void)n;
+  printf("no write queue\n");
+#endif /* TUN_IO_TX_QUEUE > 0 */
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(echo_rate, "Echo packet rate");
+UNIT_TEST(echo_rate)
+{
+  static uint8_t out[UIP_BUFSIZE];
+  uint64_t start, us;
+  int sent, echoed, wakeups, n, i;
+
+  UNIT_TEST_BEGIN();
+
+  memset(out, 0xaa, sizeof(out));
+  sent = 0;
+  echoed = 0;
+  wakeups = 0;
+  start = now_us();
+  while(echoed < ECHO_PACKETS) {
+    /* The host sends a burst */
+    for(i = 0; i < ECHO_BURST; i++) {
+      send(fds[1], out, 100, 0);
+    }
+    sent += ECHO_BURST;
+
+    /* One main loop wakeup per read, as in the tun select callback */
+    while(echoed < sent) {
+      wait_readable();
+      wakeups++;
+      tun_io_read(&tun_io, TUN_IO_RX_BATCH);
+      while(tun_io_next(&tun_io)) {
+        tun_io_write(&tun_io, uip_buf, uip_len);
+        echoed++;
+      }
+      tun_io_flush(&tun_io);
+    }
+    for(n = 0; n < ECHO_BURST; n++) {
+      recv(fds[1], packet, sizeof(packet), 0);
+    }
+  }
+  us = now_us() - start;
+
+  printf("echo: %d packets in %d wakeups, %lu ms, %lu packets/s\n", echoed,
+         wakeups, (unsigned long)(us / 1000),
+         (unsigned long)((uint64_t)echoed * 1000000 / (us ? us : 1)));
+#if TUN_IO_STATS
+  {
+    const tun_io_stats_t *s = tun_io_stats(&tun_io);
+    printf("stats: %lu rx, %lu tx, %lu rx batches, %lu largest, "
+           "%lu flushes, %lu deepest queue, %lu dropped, "
+           "%lu rx/s, %lu tx/s\n",
+           s->rx_packets, s->tx_packets, s->rx_batches, s->rx_batch_max,
+           s->tx_flushes, s->tx_queue_max, s->tx_dropped,
+           s->rx_pps, s->tx_pps);
+    UNIT_TEST_ASSERT(s->rx_batch_max <= TUN_IO_RX_BATCH);
+  }
+#endif /* TUN_IO_STATS */
+  UNIT_TEST_ASSERT(echoed == sent);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("Tun I/O: %d packets per read, %d queued writes\n",
+         TUN_IO_RX_BATCH, TUN_IO_TX_QUEUE);
+
+  if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) == -1) {
+    err(1, "socketpair");
+  }
+  tun_io_init(&tun_io, fds[0]);
+
+  UNIT_TEST_RUN(rx_batch);
+  UNIT_TEST_RUN(tx_queue);
+  UNIT_TEST_RUN(tx_full);
+  UNIT_TEST_RUN(echo_rate);
+
+  close(fds[0]);
+  close(fds[1]);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         SLIP codec tests.
+ *
+ *         Compares slip_encode() and slip_decode() with the byte at a
+ *         time encoder and decoder of the native border router, on
+ *         random packets that are rich in SLIP_END and SLIP_ESC bytes and
+ *         on streams cut into reads of random size. Also checks that
+ *         oversized frames are dropped, and measures both codecs.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "slip-codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+PROCESS(test_process, "SLIP codec test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define ROUNDS         2000
+#define MAX_PACKET     1280
+#define STREAM_SIZE    (64 * 1024)
+#define MAX_FRAMES     16384
+#define BENCH_BYTES    (32 * 1024 * 1024)
+
+/* Decoded frames, as offsets into one buffer */
+struct frames {
+  unsigned char data[STREAM_SIZE];
+  int start[MAX_FRAMES];
+  int len[MAX_FRAMES];
+  int count;
+  int used;
+};
+
+static unsigned char packet[MAX_PACKET];
+static unsigned char encoded[2 * MAX_PACKET + 1];
+static unsigned char reference[2 * MAX_PACKET + 1];
+static unsigned char stream[STREAM_SIZE];
+static struct frames expected;
+static struct frames decoded;
+static struct slip_decoder decoder;
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+/* The encoder of write_to_serial() before slip_encode() */
+static int
+reference_encode(unsigned char *dst, const unsigned char *src, int len)
+{
+  int i, n = 0;
+
+  for(i = 0; i < len; i++) {
+    switch(src[i]) {
+    case SLIP_END:
+      dst[n++] = SLIP_ESC;
+      dst[n++] = SLIP_ESC_END;
+      break;
+    case SLIP_ESC:
+      dst[n++] = SLIP_ESC;
+      dst[n++] = SLIP_ESC_ESC;
+      break;
+    default:
+      dst[n++] = src[i];
+      break;
+    }
+  }
+  dst[n++] = SLIP_END;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+frames_add(struct frames *f, const unsigned char *data, int len)
+{
+  if(f->count < MAX_FRAMES && f->used + len <= sizeof(f->data)) {
+    memcpy(f->data + f->used, data, len);
+    f->start[f->count] = f->used;
+    f->len[f->count] = len;
+    f->used += len;
+  }
+  f->count++;
+}
+/*---------------------------------------------------------------------------*/
+/* The decoder of serial_input(), fed one byte at a time */
+static void
+reference_decode(struct frames *f, const unsigned char *data, int len)
+{
+  unsigned char inbuf[SLIP_CODEC_FRAME_SIZE];
+  int inbufptr = 0;
+  unsigned char c;
+  int i;
+
+  for(i = 0; i < len; i++) {
+    c = data[i];
+    switch(c) {
+    case SLIP_END:
+      if(inbufptr > 0) {
+        frames_add(f, inbuf, inbufptr);
+        inbufptr = 0;
+      }
+      break;
+    case SLIP_ESC:
+      if(++i == len) {
+        return;
+      }
+      c = data[i];
+      switch(c) {
+      case SLIP_ESC_END:
+        c = SLIP_END;
+        break;
+      case SLIP_ESC_ESC:
+        c = SLIP_ESC;
+        break;
+      }
+      /* FALLTHROUGH */
+    default:
+      inbuf[inbufptr++] = c;
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+decoded_frame(unsigned char *frame, int len)
+{
+  frames_add(&decoded, frame, len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+frames_equal(const struct frames *a, const struct frames *b)
+{
+  int i;
+
+  if(a->count != b->count) {
+    return 0;
+  }
+  for(i = 0; i < a->count && i < MAX_FRAMES; i++) {
+    if(a->len[i] != b->len[i] ||
+       memcmp(a->data + a->start[i], b->data + b->start[i], a->len[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* A random byte, special SLIP bytes about a third of the time */
+static unsigned char
+random_byte(void)
+{
+  switch(random() % 9) {
+  case 0:
+    return SLIP_END;
+  case 1:
+    return SLIP_ESC;
+  case 2:
+    return random() % 2 ? SLIP_ESC_END : SLIP_ESC_ESC;
+  default:
+    return random();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+random_packet(unsigned char *p, int len)
+{
+  int i;
+
+  for(i = 0; i < len; i++) {
+    p[i] = random_byte();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Decodes a stream in reads of random size */
+static void
+decode_in_chunks(const unsigned char *data, int len, int max_chunk)
+{
+  int chunk;
+  int i;
+
+  memset(&decoded, 0, sizeof(decoded));
+  slip_decoder_init(&decoder);
+  for(i = 0; i < len; i += chunk) {
+    chunk = 1 + random() % max_chunk;
+    if(chunk > len - i) {
+      chunk = len - i;
+    }
+    slip_decode(&decoder, data + i, chunk, decoded_frame);
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(encode, "slip_encode matches the byte encoder");
+UNIT_TEST(encode)
+{
+  int i, len, n;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < ROUNDS; i++) {
+    len = i < 4 ? i : random() % (MAX_PACKET + 1);
+    random_packet(packet, len);
+    n = reference_encode(reference, packet, len);
+    UNIT_TEST_ASSERT(slip_encode(encoded, sizeof(encoded), packet, len) == n);
+    UNIT_TEST_ASSERT(memcmp(encoded, reference, n) == 0);
+    /* One byte short does not fit */
+    UNIT_TEST_ASSERT(slip_encode(encoded, n - 1, packet, len) == -1);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(decode_frames, "slip_decode matches the byte decoder");
+UNIT_TEST(decode_frames)
+{
+  int round, len, n;
+
+  UNIT_TEST_BEGIN();
+
+  for(round = 0; round < 20; round++) {
+    /* Encoded packets, with empty frames in between */
+    for(n = 0;;) {
+      len = random() % 300;
+      if(n + 2 * len + 2 > sizeof(stream)) {
+        break;
+      }
+      random_packet(packet, len);
+      n += reference_encode(stream + n, packet, len);
+      if(random() % 8 == 0) {
+        stream[n++] = SLIP_END;
+      }
+    }
+
+    memset(&expected, 0, sizeof(expected));
+    reference_decode(&expected, stream, n);
+    decode_in_chunks(stream, n, 1 + round * 97);
+    UNIT_TEST_ASSERT(expected.count > 100);
+    UNIT_TEST_ASSERT(frames_equal(&expected, &decoded));
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(decode_noise, "slip_decode matches the byte decoder on noise");
+UNIT_TEST(decode_noise)
+{
+  int round;
+
+  UNIT_TEST_BEGIN();
+
+  /* Random bytes have stray escapes and short frames */
+  for(round = 0; round < 20; round++) {
+    random_packet(stream, sizeof(stream));
+    /* Keep the frames from growing past the decoder */
+    stream[sizeof(stream) - 1] = SLIP_END;
+
+    memset(&expected, 0, sizeof(expected));
+    reference_decode(&expected, stream, sizeof(stream));
+    decode_in_chunks(stream, sizeof(stream), 1 + round * 211);
+    UNIT_TEST_ASSERT(frames_equal(&expected, &decoded));
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(decode_large, "Oversized frames are dropped");
+UNIT_TEST(decode_large)
+{
+  int n;
+
+  UNIT_TEST_BEGIN();
+
+  memset(&decoded, 0, sizeof(decoded));
+  slip_decoder_init(&decoder);
+
+  /* One byte too many, then a frame that fits exactly */
+  memset(stream, 'a', SLIP_CODEC_FRAME_SIZE + 1);
+  stream[SLIP_CODEC_FRAME_SIZE + 1] = SLIP_END;
+  n = slip_decode(&decoder, stream, SLIP_CODEC_FRAME_SIZE + 2, decoded_frame);
+  UNIT_TEST_ASSERT(n == 0);
+  memset(stream, 'b', SLIP_CODEC_FRAME_SIZE);
+  stream[SLIP_CODEC_FRAME_SIZE] = SLIP_END;
+  n = slip_decode(&decoder, stream, SLIP_CODEC_FRAME_SIZE + 1, decoded_frame);
+  UNIT_TEST_ASSERT(n == 1);
+  UNIT_TEST_ASSERT(decoded.count == 1);
+  UNIT_TEST_ASSERT(decoded.len[0] == SLIP_CODEC_FRAME_SIZE);
+  UNIT_TEST_ASSERT(decoded.data[0] == 'b');
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static void
+count_frame(unsigned char *frame, int len)
+{
+  decoded.count++;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(speed, "Codec speed");
+UNIT_TEST(speed)
+{
+  uint64_t t;
+  uint64_t ref_us, bulk_us;
+  int i, n, len, bytes;
+
+  UNIT_TEST_BEGIN();
+
+  /* IPv6 packets: mostly plain bytes with a few to escape */
+  len = MAX_PACKET;
+  for(i = 0; i < len; i++) {
+    packet[i] = random() % 64 ? random() % 0xc0 : SLIP_END;
+  }
+
+  t = now_us();
+  for(bytes = 0; bytes < BENCH_BYTES; bytes += len) {
+    n = reference_encode(reference, packet, len);
+  }
+  ref_us = now_us() - t;
+  t = now_us();
+  for(bytes = 0; bytes < BENCH_BYTES; bytes += len) {
+    n = slip_encode(encoded, sizeof(encoded), packet, len);
+  }
+  bulk_us = now_us() - t;
+  printf("encode: byte encoder %lu MB/s, slip_encode %lu MB/s\n",
+         (unsigned long)(BENCH_BYTES / (ref_us ? ref_us : 1)),
+         (unsigned long)(BENCH_BYTES / (bulk_us ? bulk_us : 1)));
+  UNIT_TEST_ASSERT(memcmp(encoded, reference, n) == 0);
+
+  /* A stream of those frames */
+  for(i = 0; i + n <= sizeof(stream); i += n) {
+    memcpy(stream + i, encoded, n);
+  }
+
+  t = now_us();
+  for(bytes = 0; bytes < BENCH_BYTES; bytes += i) {
+    expected.count = 0;
+    expected.used = 0;
+    reference_decode(&expected, stream, i);
+  }
+  ref_us = now_us() - t;
+  decoded.count = 0;
+  slip_decoder_init(&decoder);
+  t = now_us();
+  for(bytes = 0; bytes < BENCH_BYTES; bytes += i) {
+    slip_decode(&decoder, stream, i, count_frame);
+  }
+  bulk_us = now_us() - t;
+  printf("decode: byte decoder %lu MB/s, slip_decode %lu MB/s\n",
+         (unsigned long)(BENCH_BYTES / (ref_us ? ref_us : 1)),
+         (unsigned long)(BENCH_BYTES / (bulk_us ? bulk_us : 1)));
+  UNIT_TEST_ASSERT(decoded.count == (BENCH_BYTES + i - 1) / i * (i / n));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  srandom(1);
+
+  UNIT_TEST_RUN(encode);
+  UNIT_TEST_RUN(decode_frames);
+  UNIT_TEST_RUN(decode_noise);
+  UNIT_TEST_RUN(decode_large);
+  UNIT_TEST_RUN(speed);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Border router MAC transmit window tests.
+ *
+ *         Runs the border router MAC against a fake radio: frames written
+ *         to SLIP are captured and reports are fed back by session id.
+ *         Checks that no more frames than the window are outstanding,
+ *         that the radio can change the window, that a frame the radio
+ *         never reports does not block the other sessions and is reaped,
+ *         and that a full SLIP buffer holds frames back.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "net/packetbuf.h"
+#include "net/mac/mac.h"
+#include "border-router.h"
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "BR MAC window test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define MAX_FRAMES 64
+
+extern const struct mac_driver border_router_mac_driver;
+void packet_sent(uint8_t sessionid, uint8_t status, uint8_t tx);
+
+/* What went over SLIP */
+static uint8_t frame_sid[MAX_FRAMES];
+static int frames;
+static int slip_space = 2048;
+static int frames_while_full;
+
+/* What came back to the upper layer */
+static int sent_count;
+static int sent_status[MAX_FRAMES];
+static int chain;
+
+/*---------------------------------------------------------------------------*/
+void
+write_to_slip(const uint8_t *buf, int len)
+{
+  if(buf[0] == '!' && buf[1] == 'S' && frames < MAX_FRAMES) {
+    frame_sid[frames++] = buf[2];
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_tx_space(void)
+{
+  return slip_space;
+}
+/*---------------------------------------------------------------------------*/
+static void send(void);
+
+static void
+sent_callback(void *ptr, int status, int transmissions)
+{
+  if(sent_count < MAX_FRAMES) {
+    sent_status[sent_count] = status;
+  }
+  sent_count++;
+  /* Like 6LoWPAN sending the next fragment from the callback */
+  if(chain > 0) {
+    chain--;
+    send();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send(void)
+{
+  static const linkaddr_t dest = { { 1, 2, 3, 4, 5, 6, 7, 9 } };
+  uint8_t payload[60];
+
+  memset(payload, 0xc0, sizeof(payload));
+  packetbuf_clear();
+  packetbuf_copyfrom(payload, sizeof(payload));
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
+  border_router_mac_driver.send(sent_callback, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(void)
+{
+  memset(&border_router_mac_stats, 0, sizeof(border_router_mac_stats));
+  border_router_mac_driver.init();
+  frames = 0;
+  sent_count = 0;
+  chain = 0;
+  slip_space = 2048;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(window, "No more frames than the window are outstanding");
+UNIT_TEST(window)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  reset();
+  for(i = 0; i < 10; i++) {
+    send();
+  }
+  UNIT_TEST_ASSERT(frames == BORDER_ROUTER_MAC_TX_WINDOW);
+  UNIT_TEST_ASSERT(sent_count == 0);
+
+  /* Each report lets one more frame out */
+  packet_sent(frame_sid[1], MAC_TX_OK, 1);
+  UNIT_TEST_ASSERT(frames == BORDER_ROUTER_MAC_TX_WINDOW + 1);
+  UNIT_TEST_ASSERT(sent_count == 1);
+
+  /* The radio tells a larger window */
+  border_router_mac_set_window(8);
+  UNIT_TEST_ASSERT(frames == 9);
+
+  /* Reports in any order complete the right sessions */
+  for(i = frames - 1; i >= 0; i--) {
+    if(i != 1) {
+      packet_sent(frame_sid[i], i == 0 ? MAC_TX_NOACK : MAC_TX_OK, 1);
+    }
+  }
+  UNIT_TEST_ASSERT(frames == 10);
+  packet_sent(frame_sid[9], MAC_TX_OK, 1);
+  UNIT_TEST_ASSERT(sent_count == 10);
+  UNIT_TEST_ASSERT(sent_status[sent_count - 2] == MAC_TX_NOACK);
+  for(i = 0; i < frames; i++) {
+    UNIT_TEST_ASSERT(frame_sid[i] == i);
+  }
+
+  /* A second report for a session is ignored */
+  packet_sent(frame_sid[3], MAC_TX_OK, 1);
+  UNIT_TEST_ASSERT(sent_count == 10);
+  UNIT_TEST_ASSERT(border_router_mac_stats.reports == 10);
+  UNIT_TEST_ASSERT(border_router_mac_stats.late_reports == 1);
+  UNIT_TEST_ASSERT(border_router_mac_stats.queued_max == 10 - BORDER_ROUTER_MAC_TX_WINDOW);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(busy, "Sending with every session busy fails at once");
+UNIT_TEST(busy)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  reset();
+  for(i = 0; i < 17; i++) {
+    send();
+  }
+  UNIT_TEST_ASSERT(sent_count == 1);
+  UNIT_TEST_ASSERT(sent_status[0] == MAC_TX_QUEUE_FULL);
+  UNIT_TEST_ASSERT(border_router_mac_stats.queue_full == 1);
+
+  for(i = 0; i < 16; i++) {
+    packet_sent(frame_sid[i], MAC_TX_OK, 1);
+  }
+  UNIT_TEST_ASSERT(frames == 16);
+  UNIT_TEST_ASSERT(sent_count == 17);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(lost, "A frame never reported blocks only its session");
+UNIT_TEST(lost)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  reset();
+  /* The radio never reports the first frame */
+  send();
+
+  /* More sends than sessions, each reported right away */
+  for(i = 0; i < 40; i++) {
+    send();
+    UNIT_TEST_ASSERT(frames == i + 2);
+    packet_sent(frame_sid[frames - 1], MAC_TX_OK, 1);
+  }
+  UNIT_TEST_ASSERT(sent_count == 40);
+  UNIT_TEST_ASSERT(border_router_mac_stats.queue_full == 0);
+
+  /* The other 15 sessions can all be busy at once */
+  for(i = 0; i < 15; i++) {
+    send();
+  }
+  UNIT_TEST_ASSERT(sent_count == 40);
+  UNIT_TEST_ASSERT(border_router_mac_stats.queue_full == 0);
+  UNIT_TEST_ASSERT(frames == 41 + BORDER_ROUTER_MAC_TX_WINDOW - 1);
+  send();
+  UNIT_TEST_ASSERT(sent_count == 41);
+  UNIT_TEST_ASSERT(sent_status[40] == MAC_TX_QUEUE_FULL);
+
+  /* Queued frames leave in the order they were sent */
+  for(i = 41; i < frames; i++) {
+    packet_sent(frame_sid[i], MAC_TX_OK, 1);
+  }
+  UNIT_TEST_ASSERT(frames == 56);
+  UNIT_TEST_ASSERT(sent_count == 56);
+  for(i = 2; i < frames; i++) {
+    UNIT_TEST_ASSERT(frame_sid[i] % 16 != frame_sid[0] % 16);
+    UNIT_TEST_ASSERT((uint8_t)(frame_sid[i] - frame_sid[i - 1]) < MAX_FRAMES);
+    UNIT_TEST_ASSERT(frame_sid[i] != frame_sid[i - 1]);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(chained, "Frames sent from the sent callback");
+UNIT_TEST(chained)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  reset();
+  chain = 20;
+  send();
+  for(i = 0; i < frames; i++) {
+    packet_sent(frame_sid[i], MAC_TX_OK, 1);
+  }
+  UNIT_TEST_ASSERT(frames == 21);
+  UNIT_TEST_ASSERT(sent_count == 21);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(reaped, "Frames the radio does not report are reaped");
+UNIT_TEST(reaped)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(frames == 6);
+  UNIT_TEST_ASSERT(sent_count == 6);
+  UNIT_TEST_ASSERT(sent_status[0] == MAC_TX_ERR);
+  UNIT_TEST_ASSERT(border_router_mac_stats.timeouts == 6);
+
+  /* Too late */
+  packet_sent(frame_sid[0], MAC_TX_OK, 1);
+  UNIT_TEST_ASSERT(sent_count == 6);
+  UNIT_TEST_ASSERT(border_router_mac_stats.late_reports == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(slip_full, "A full SLIP buffer holds frames back");
+UNIT_TEST(slip_full)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(frames_while_full == 1);
+  UNIT_TEST_ASSERT(frames == 2);
+  UNIT_TEST_ASSERT(sent_count == 2);
+  UNIT_TEST_ASSERT(border_router_mac_stats.timeouts == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer et;
+  static int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("Transmit window %d, timeout %lu ms\n", BORDER_ROUTER_MAC_TX_WINDOW,
+         (unsigned long)(BORDER_ROUTER_MAC_TX_TIMEOUT * 1000 / CLOCK_SECOND));
+
+  UNIT_TEST_RUN(window);
+  UNIT_TEST_RUN(busy);
+  UNIT_TEST_RUN(lost);
+  UNIT_TEST_RUN(chained);
+
+  /* No reports at all: the window fills and is reaped twice */
+  reset();
+  for(i = 0; i < 6; i++) {
+    send();
+  }
+  etimer_set(&et, BORDER_ROUTER_MAC_TX_TIMEOUT * 4);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(reaped);
+
+  /* The SLIP buffer has no room until the second frame is reported */
+  reset();
+  send();
+  slip_space = 0;
+  send();
+  frames_while_full = frames;
+  packet_sent(frame_sid[0], MAC_TX_OK, 1);
+  slip_space = 2048;
+  etimer_set(&et, BORDER_ROUTER_MAC_TX_TIMEOUT);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  packet_sent(frame_sid[1], MAC_TX_OK, 1);
+  UNIT_TEST_RUN(slip_full);
+
+  border_router_mac_print_stat();
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
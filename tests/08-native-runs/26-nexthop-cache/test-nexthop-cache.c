@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Next-hop cache tests and output path benchmark.
+ *
+ *         Sends packets through tcpip_ipv6_output() and records the
+ *         link-layer destination. Checks that cached next hops follow
+ *         route, default route and neighbor changes, and compares the
+ *         output rate with and without cache hits.
+ */
+
+#include "contiki.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/netstack.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "nexthop-cache test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_NEXTHOPS  8
+#define NUM_HOSTS     200
+#define NUM_FLOWS     TCPIP_NEXTHOP_CACHE
+#define BENCH_PACKETS 200000UL
+
+static uip_ipaddr_t nexthops[NUM_NEXTHOPS];
+static int sent;
+static linkaddr_t sent_to;
+
+/*---------------------------------------------------------------------------*/
+/* Record the link-layer destination and drop the packet */
+static enum netstack_ip_action
+capture_output(const linkaddr_t *localdest)
+{
+  sent++;
+  linkaddr_copy(&sent_to, localdest != NULL ? localdest : &linkaddr_null);
+  return NETSTACK_IP_DROP;
+}
+
+static struct netstack_ip_packet_processor capture = {
+  .process_output = capture_output
+};
+/*---------------------------------------------------------------------------*/
+static void
+host_addr(uip_ipaddr_t *addr, uint16_t host)
+{
+  uip_ip6addr(addr, 0xfd01, 0, 0, 0, 0, 0, host >> 8, host & 0xff);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+nexthop_lladdr(int i)
+{
+  return i + 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Send a UDP packet to the address and return the last byte of the
+   link-layer destination, or 0 if nothing was sent */
+static uint8_t
+send_to(const uip_ipaddr_t *dest)
+{
+  int before = sent;
+
+  memset(UIP_IP_BUF, 0, UIP_IPUDPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->ttl = 64;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, dest);
+  uip_len = UIP_IPUDPH_LEN;
+  uipbuf_set_len_field(UIP_IP_BUF, UIP_UDPH_LEN);
+
+  tcpip_ipv6_output();
+
+  if(sent == before) {
+    return 0;
+  }
+  return sent_to.u8[LINKADDR_SIZE - 1];
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(cache_route, "Routed destinations");
+UNIT_TEST(cache_route)
+{
+  uip_lladdr_t lladdr;
+  uip_ipaddr_t addr;
+  unsigned long hits;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  netstack_ip_packet_processor_add(&capture);
+
+  for(i = 0; i < NUM_NEXTHOPS; i++) {
+    memset(&lladdr, 0, sizeof(lladdr));
+    lladdr.addr[sizeof(lladdr) - 1] = nexthop_lladdr(i);
+    uip_ip6addr(&nexthops[i], 0xfe80, 0, 0, 0, 0, 0, 0, nexthop_lladdr(i));
+    UNIT_TEST_ASSERT(uip_ds6_nbr_add(&nexthops[i], &lladdr, 1,
+                                     NBR_REACHABLE, NBR_TABLE_REASON_UNDEFINED,
+                                     NULL) != NULL);
+  }
+  for(i = 0; i < NUM_HOSTS; i++) {
+    host_addr(&addr, i);
+    UNIT_TEST_ASSERT(uip_ds6_route_add(&addr, 128,
+                                       &nexthops[i % NUM_NEXTHOPS]) != NULL);
+  }
+
+  /* The first packet fills the cache, the next ones hit it */
+  host_addr(&addr, 3);
+  memset(&tcpip_nexthop_cache_stats, 0, sizeof(tcpip_nexthop_cache_stats));
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(3));
+  UNIT_TEST_ASSERT(tcpip_nexthop_cache_stats.misses == 1);
+  UNIT_TEST_ASSERT(tcpip_nexthop_cache_stats.hits == 0);
+  for(i = 0; i < 10; i++) {
+    UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(3));
+  }
+  UNIT_TEST_ASSERT(tcpip_nexthop_cache_stats.hits == 10);
+
+  /* A new route for the destination replaces the cached next hop */
+  UNIT_TEST_ASSERT(uip_ds6_route_add(&addr, 128, &nexthops[5]) != NULL);
+  UNIT_TEST_ASSERT(tcpip_nexthop_cache_stats.flushes > 0);
+  hits = tcpip_nexthop_cache_stats.hits;
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(5));
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(5));
+  UNIT_TEST_ASSERT(tcpip_nexthop_cache_stats.hits == hits + 1);
+
+  /* More flows than entries: every destination still gets its route */
+  for(i = 0; i < 4 * NUM_HOSTS; i++) {
+    host_addr(&addr, i % NUM_HOSTS);
+    UNIT_TEST_ASSERT(send_to(&addr) ==
+                     (i % NUM_HOSTS == 3 ? nexthop_lladdr(5) :
+                      nexthop_lladdr(i % NUM_NEXTHOPS)));
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(cache_defrt, "Default route");
+UNIT_TEST(cache_defrt)
+{
+  uip_ipaddr_t addr;
+  uip_ds6_defrt_t *defrt;
+
+  UNIT_TEST_BEGIN();
+
+  /* No route and no default route: nothing is sent */
+  uip_ip6addr(&addr, 0xfd02, 0, 0, 0, 0, 0, 0, 1);
+  UNIT_TEST_ASSERT(send_to(&addr) == 0);
+
+  defrt = uip_ds6_defrt_add(&nexthops[2], 0);
+  UNIT_TEST_ASSERT(defrt != NULL);
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(2));
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(2));
+
+  /* A route added later wins over the cached default route */
+  UNIT_TEST_ASSERT(uip_ds6_route_add(&addr, 64, &nexthops[6]) != NULL);
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(6));
+  uip_ds6_route_rm(uip_ds6_route_lookup(&addr));
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(2));
+
+  /* Removing the default route drops the cached entry */
+  uip_ds6_defrt_rm(defrt);
+  UNIT_TEST_ASSERT(send_to(&addr) == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(cache_nbr, "Neighbor changes");
+UNIT_TEST(cache_nbr)
+{
+  uip_ipaddr_t addr;
+  uip_ds6_nbr_t *nbr;
+
+  UNIT_TEST_BEGIN();
+
+  host_addr(&addr, 1);
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(1));
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(1));
+
+  /* An entry waiting for address resolution is not used */
+  nbr = uip_ds6_nbr_lookup(&nexthops[1]);
+  UNIT_TEST_ASSERT(nbr != NULL);
+  nbr->state = NBR_INCOMPLETE;
+  UNIT_TEST_ASSERT(send_to(&addr) == 0);
+  nbr->state = NBR_REACHABLE;
+  UNIT_TEST_ASSERT(send_to(&addr) == nexthop_lladdr(1));
+
+  /* With the neighbor gone the route is dead and nothing is sent to
+     the old link-layer address */
+  UNIT_TEST_ASSERT(uip_ds6_nbr_rm(nbr));
+  UNIT_TEST_ASSERT(send_to(&addr) == 0);
+  UNIT_TEST_ASSERT(uip_ds6_route_lookup(&addr) == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(cache_bench, "Output benchmark");
+UNIT_TEST(cache_bench)
+{
+  static uip_ipaddr_t flows[NUM_FLOWS];
+  clock_time_t start;
+  clock_time_t miss_time;
+  clock_time_t hit_time;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long i;
+  int j;
+
+  UNIT_TEST_BEGIN();
+
+  /* Spread over the routes, skipping those through the removed neighbor */
+  for(j = 0; j < NUM_FLOWS; j++) {
+    host_addr(&flows[j], (j * 26) % NUM_HOSTS + 2);
+  }
+
+  /* Every packet takes the full lookup path */
+  start = clock_time();
+  for(i = 0; i < BENCH_PACKETS; i++) {
+    tcpip_nexthop_cache_flush();
+    send_to(&flows[i % NUM_FLOWS]);
+  }
+  miss_time = clock_time() - start;
+
+  memset(&tcpip_nexthop_cache_stats, 0, sizeof(tcpip_nexthop_cache_stats));
+  start = clock_time();
+  for(i = 0; i < BENCH_PACKETS; i++) {
+    send_to(&flows[i % NUM_FLOWS]);
+  }
+  hit_time = clock_time() - start;
+  hits = tcpip_nexthop_cache_stats.hits;
+  misses = tcpip_nexthop_cache_stats.misses;
+  UNIT_TEST_ASSERT(hits + misses == BENCH_PACKETS);
+  UNIT_TEST_ASSERT(misses <= NUM_FLOWS);
+
+  printf("nexthop-cache: %u routes, %u flows, %lu packets: "
+         "uncached %lu ms, cached %lu ms, hit rate %lu%%\n",
+         uip_ds6_route_num_routes(), NUM_FLOWS, BENCH_PACKETS,
+         (unsigned long)(miss_time * 1000 / CLOCK_SECOND),
+         (unsigned long)(hit_time * 1000 / CLOCK_SECOND),
+         hits * 100 / (hits + misses));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(cache_route);
+  UNIT_TEST_RUN(cache_defrt);
+  UNIT_TEST_RUN(cache_nbr);
+  UNIT_TEST_RUN(cache_bench);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
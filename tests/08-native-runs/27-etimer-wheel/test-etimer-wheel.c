@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Etimer timing wheel tests.
+ *
+ *         Sets timers that spread over all wheel levels and the overflow
+ *         list, stops some of them, and checks that the others expire
+ *         once each, in deadline order and not early, and that the next
+ *         expiration never lies beyond the earliest pending timer.
+ */
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+PROCESS(test_process, "etimer wheel test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_TIMERS    200
+#define MAX_INTERVAL  (2 * CLOCK_SECOND)
+
+static struct etimer timers[NUM_TIMERS];
+static clock_time_t offset[NUM_TIMERS];
+static uint8_t stopped[NUM_TIMERS];
+static uint8_t fired[NUM_TIMERS];
+static clock_time_t base;
+
+static unsigned expected;
+static unsigned delivered;
+static unsigned early;
+static unsigned out_of_order;
+static unsigned duplicates;
+static unsigned stopped_fired;
+static unsigned next_late;
+static clock_time_t max_late;
+
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(wheel_stop, "Stopping timers");
+UNIT_TEST(wheel_stop)
+{
+  static struct etimer zeroed;
+  struct etimer *et;
+  struct etimer *stale;
+
+  UNIT_TEST_BEGIN();
+
+  /* A zeroed timer that was never set */
+  etimer_stop(&zeroed);
+  UNIT_TEST_ASSERT(etimer_expired(&zeroed));
+
+  et = calloc(1, sizeof(*et));
+  UNIT_TEST_ASSERT(et != NULL);
+  stale = malloc(sizeof(*stale));
+  UNIT_TEST_ASSERT(stale != NULL);
+
+  /* A never-set timer holding garbage, as on the stack */
+  memset(stale, 0xa5, sizeof(*stale));
+  etimer_stop(stale);
+  UNIT_TEST_ASSERT(etimer_expired(stale));
+
+  /* A stale copy of a pending timer leaves the original alone */
+  etimer_set(et, CLOCK_SECOND);
+  memcpy(stale, et, sizeof(*stale));
+  etimer_stop(stale);
+  UNIT_TEST_ASSERT(etimer_expired(stale));
+  UNIT_TEST_ASSERT(!etimer_expired(et));
+  etimer_stop(et);
+  UNIT_TEST_ASSERT(etimer_expired(et));
+
+  /* Set, set again while pending, stop twice */
+  etimer_set(et, CLOCK_SECOND);
+  UNIT_TEST_ASSERT(!etimer_expired(et));
+  etimer_set(et, 2 * CLOCK_SECOND);
+  UNIT_TEST_ASSERT(!etimer_expired(et));
+  etimer_stop(et);
+  UNIT_TEST_ASSERT(etimer_expired(et));
+  etimer_stop(et);
+  UNIT_TEST_ASSERT(etimer_expired(et));
+
+  /* A timer that expires at once is never linked into the wheel */
+  etimer_set(et, 0);
+  etimer_stop(et);
+  UNIT_TEST_ASSERT(etimer_expired(et));
+
+  free(stale);
+  free(et);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(wheel_order, "Timers expire in order");
+UNIT_TEST(wheel_order)
+{
+  UNIT_TEST_BEGIN();
+
+  printf("etimer-wheel: %u of %u timers fired, %u early, %u out of order, "
+         "%u twice, %u stopped, %u next late, %lu ticks max lateness\n",
+         delivered, expected, early, out_of_order, duplicates,
+         stopped_fired, next_late, (unsigned long)max_late);
+
+  UNIT_TEST_ASSERT(delivered == expected);
+  UNIT_TEST_ASSERT(early == 0);
+  UNIT_TEST_ASSERT(out_of_order == 0);
+  UNIT_TEST_ASSERT(duplicates == 0);
+  UNIT_TEST_ASSERT(stopped_fired == 0);
+  UNIT_TEST_ASSERT(next_late == 0);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_timers(void)
+{
+  int i;
+
+  base = clock_time();
+  expected = 0;
+  for(i = 0; i < NUM_TIMERS; i++) {
+    etimer_set(&timers[i], 1 + random_rand() % MAX_INTERVAL);
+    offset[i] = etimer_expiration_time(&timers[i]) - base;
+  }
+  /* Stop every fifth timer, and restart every seventh one */
+  for(i = 0; i < NUM_TIMERS; i++) {
+    if(i % 5 == 0) {
+      etimer_stop(&timers[i]);
+      stopped[i] = 1;
+    } else {
+      if(i % 7 == 0) {
+        etimer_set(&timers[i], 1 + random_rand() % MAX_INTERVAL);
+        offset[i] = etimer_expiration_time(&timers[i]) - base;
+      }
+      expected++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+check_timer(int i, clock_time_t last)
+{
+  clock_time_t now = clock_time() - base;
+  clock_time_t earliest;
+  clock_time_t next;
+  int j;
+
+  if(stopped[i]) {
+    stopped_fired++;
+  }
+  if(fired[i]) {
+    duplicates++;
+  }
+  fired[i] = 1;
+  delivered++;
+
+  if(offset[i] > now) {
+    early++;
+  } else if(now - offset[i] > max_late) {
+    max_late = now - offset[i];
+  }
+  if(offset[i] < last) {
+    out_of_order++;
+  }
+
+  /* Other processes have timers too, so the next expiration may only
+     be earlier than our earliest pending timer. Timers that expired in
+     the same tick are already posted and no longer pending. */
+  earliest = MAX_INTERVAL + 1;
+  for(j = 0; j < NUM_TIMERS; j++) {
+    if(!etimer_expired(&timers[j]) && offset[j] < earliest) {
+      earliest = offset[j];
+    }
+  }
+  next = etimer_next_expiration_time();
+  if(earliest <= MAX_INTERVAL &&
+     (!etimer_pending() || next - base > earliest)) {
+    next_late++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer watchdog;
+  static clock_time_t last;
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(wheel_stop);
+
+  start_timers();
+  etimer_set(&watchdog, MAX_INTERVAL + CLOCK_SECOND);
+  last = 0;
+  while(delivered < expected) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+    if(data == &watchdog) {
+      break;
+    }
+    for(i = 0; i < NUM_TIMERS; i++) {
+      if(data == &timers[i]) {
+        check_timer(i, last);
+        last = offset[i];
+        break;
+      }
+    }
+  }
+  etimer_stop(&watchdog);
+
+  UNIT_TEST_RUN(wheel_order);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Process priority queue tests.
+ *
+ *         Posts interleaved events to a high, a normal and a background
+ *         priority process and checks that they are delivered by
+ *         priority and in FIFO order within a priority, and that a full
+ *         background queue does not block higher priority events.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include <stdint.h>
+#include <stdio.h>
+
+PROCESS(test_process, "process-prio test");
+PROCESS_PRIO(high_process, "high", PROCESS_PRIO_HIGH);
+PROCESS(normal_process, "normal");
+PROCESS_PRIO(background_process, "background", PROCESS_PRIO_BACKGROUND);
+AUTOSTART_PROCESSES(&test_process);
+
+#define ROUNDS     4
+#define LAST_ID    (PROCESS_PRIO_BACKGROUND * 100 + ROUNDS - 1)
+
+static process_event_t test_event;
+static process_event_t fill_event;
+static process_event_t done_event;
+
+static unsigned delivered[3 * ROUNDS];
+static unsigned ndelivered;
+static unsigned filled;
+static unsigned filled_high;
+static int full_ret;
+static int high_ret;
+
+/*---------------------------------------------------------------------------*/
+static void
+record(process_event_t ev, process_data_t data)
+{
+  unsigned id = (uintptr_t)data;
+
+  if(ev == fill_event) {
+    if(PROCESS_CURRENT() == &high_process) {
+      filled_high++;
+    } else if(++filled == PROCESS_CONF_NUMEVENTS) {
+      process_post(&test_process, done_event, NULL);
+    }
+    return;
+  }
+  if(ev != test_event) {
+    return;
+  }
+  if(ndelivered < 3 * ROUNDS) {
+    delivered[ndelivered++] = id;
+  }
+  if(id == LAST_ID) {
+    process_post(&test_process, done_event, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(high_process, ev, data)
+{
+  PROCESS_BEGIN();
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    record(ev, data);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(normal_process, ev, data)
+{
+  PROCESS_BEGIN();
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    record(ev, data);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(background_process, ev, data)
+{
+  PROCESS_BEGIN();
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    record(ev, data);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static struct process *
+process_of(unsigned prio)
+{
+  switch(prio) {
+  case PROCESS_PRIO_HIGH:
+    return &high_process;
+  case PROCESS_PRIO_BACKGROUND:
+    return &background_process;
+  default:
+    return &normal_process;
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(prio_order, "Delivery by priority");
+UNIT_TEST(prio_order)
+{
+  static const unsigned order[3] = {
+    PROCESS_PRIO_HIGH, PROCESS_PRIO_NORMAL, PROCESS_PRIO_BACKGROUND
+  };
+  unsigned i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(ndelivered == 3 * ROUNDS);
+  for(i = 0; i < 3 * ROUNDS; i++) {
+    UNIT_TEST_ASSERT(delivered[i] == order[i / ROUNDS] * 100 + i % ROUNDS);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(prio_full, "A full queue does not block others");
+UNIT_TEST(prio_full)
+{
+  UNIT_TEST_BEGIN();
+
+  printf("process-prio: queue high water marks %u high, %u normal, "
+         "%u background\n",
+         process_maxevents_prio[PROCESS_PRIO_HIGH],
+         process_maxevents_prio[PROCESS_PRIO_NORMAL],
+         process_maxevents_prio[PROCESS_PRIO_BACKGROUND]);
+
+  UNIT_TEST_ASSERT(full_ret == PROCESS_ERR_FULL);
+  UNIT_TEST_ASSERT(high_ret == PROCESS_ERR_OK);
+  UNIT_TEST_ASSERT(filled_high == 1);
+  UNIT_TEST_ASSERT(filled == PROCESS_CONF_NUMEVENTS);
+  UNIT_TEST_ASSERT(process_maxevents_prio[PROCESS_PRIO_BACKGROUND] ==
+                   PROCESS_CONF_NUMEVENTS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static unsigned i;
+  static unsigned prio;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  test_event = process_alloc_event();
+  fill_event = process_alloc_event();
+  done_event = process_alloc_event();
+  process_start(&high_process, NULL);
+  process_start(&normal_process, NULL);
+  process_start(&background_process, NULL);
+
+  /* Post lowest priority first, so that FIFO order would be wrong */
+  for(i = 0; i < ROUNDS; i++) {
+    for(prio = PROCESS_PRIO_NUM; prio-- > 0;) {
+      process_post(process_of(prio), test_event,
+                   (process_data_t)(uintptr_t)(prio * 100 + i));
+    }
+  }
+  PROCESS_WAIT_EVENT_UNTIL(ev == done_event);
+  UNIT_TEST_RUN(prio_order);
+
+  /* Fill the background queue, the high priority queue still accepts.
+     The background process only runs once the other queues are empty,
+     so it reports when it has seen every event. */
+  for(i = 0; i < PROCESS_CONF_NUMEVENTS; i++) {
+    process_post(&background_process, fill_event, NULL);
+  }
+  full_ret = process_post(&background_process, fill_event, NULL);
+  high_ret = process_post(&high_process, fill_event, NULL);
+  PROCESS_WAIT_EVENT_UNTIL(ev == done_event);
+  UNIT_TEST_RUN(prio_full);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+./run-one.sh 29-process-broadcast
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Broadcast subscription and poll index tests.
+ *
+ *         Broadcasts events to processes that never subscribe, that
+ *         subscribe to one event, that filter all broadcasts and that
+ *         filter themselves while a broadcast is delivered, and checks
+ *         who receives what as processes subscribe, unsubscribe, exit
+ *         and restart, also from within the delivery of a broadcast.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "process-broadcast test");
+PROCESS(plain_process, "plain");
+PROCESS(subscriber_process, "subscriber");
+PROCESS(filtered_process, "filtered");
+PROCESS(self_filter_process, "self filter");
+PROCESS(churn_process, "churn");
+PROCESS(churn_peer_process, "churn peer");
+AUTOSTART_PROCESSES(&test_process);
+
+enum {
+  PLAIN,
+  SUBSCRIBER,
+  FILTERED,
+  SELF_FILTER,
+  CHURN,
+  CHURN_PEER,
+  NUM_RECEIVERS
+};
+
+enum {
+  EV_A,
+  EV_B,
+  EV_DIRECT,
+  EV_POLL,
+  EV_C,
+  NUM_EVENTS
+};
+
+static process_event_t ev_a;
+static process_event_t ev_b;
+static process_event_t ev_direct;
+static process_event_t ev_c;
+
+static unsigned counts[NUM_RECEIVERS][NUM_EVENTS];
+
+/*---------------------------------------------------------------------------*/
+static void
+count(int receiver, process_event_t ev)
+{
+  if(ev == ev_a) {
+    counts[receiver][EV_A]++;
+  } else if(ev == ev_b) {
+    counts[receiver][EV_B]++;
+  } else if(ev == ev_direct) {
+    counts[receiver][EV_DIRECT]++;
+  } else if(ev == PROCESS_EVENT_POLL) {
+    counts[receiver][EV_POLL]++;
+  } else if(ev == ev_c) {
+    counts[receiver][EV_C]++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(plain_process, ev, data)
+{
+  PROCESS_BEGIN();
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    count(PLAIN, ev);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(subscriber_process, ev, data)
+{
+  PROCESS_BEGIN();
+  process_subscribe(PROCESS_CURRENT(), ev_a);
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    count(SUBSCRIBER, ev);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(filtered_process, ev, data)
+{
+  PROCESS_BEGIN();
+  process_filter_broadcasts(PROCESS_CURRENT());
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    count(FILTERED, ev);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(self_filter_process, ev, data)
+{
+  PROCESS_BEGIN();
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    count(SELF_FILTER, ev);
+    if(ev == ev_a) {
+      /* Leaves the broadcast list while the broadcast is delivered */
+      process_filter_broadcasts(PROCESS_CURRENT());
+    }
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(churn_process, ev, data)
+{
+  PROCESS_BEGIN();
+  process_subscribe(PROCESS_CURRENT(), ev_c);
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    count(CHURN, ev);
+    if(ev == ev_c && counts[CHURN][EV_C] == 1) {
+      /* Frees the next subscription in the walk and its own, then
+         subscribes the peer again while the broadcast is delivered */
+      process_unsubscribe(&churn_peer_process, ev_c);
+      process_unsubscribe(PROCESS_CURRENT(), ev_c);
+      process_subscribe(&churn_peer_process, ev_c);
+    }
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(churn_peer_process, ev, data)
+{
+  PROCESS_BEGIN();
+  process_subscribe(PROCESS_CURRENT(), ev_c);
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    count(CHURN_PEER, ev);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+counts_are(int receiver, unsigned a, unsigned b, unsigned direct)
+{
+  if(counts[receiver][EV_A] != a || counts[receiver][EV_B] != b ||
+     counts[receiver][EV_DIRECT] != direct) {
+    printf("receiver %d: %u/%u/%u, expected %u/%u/%u\n", receiver,
+           counts[receiver][EV_A], counts[receiver][EV_B],
+           counts[receiver][EV_DIRECT], a, b, direct);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(bcast_first, "Broadcasts by subscription");
+UNIT_TEST(bcast_first)
+{
+  UNIT_TEST_BEGIN();
+
+  /* One ev_a, one ev_b and one directed event to each process */
+  UNIT_TEST_ASSERT(counts_are(PLAIN, 1, 1, 1));
+  UNIT_TEST_ASSERT(counts_are(SUBSCRIBER, 1, 0, 1));
+  UNIT_TEST_ASSERT(counts_are(FILTERED, 0, 0, 1));
+  /* Filtered itself on ev_a, the processes after it still got it */
+  UNIT_TEST_ASSERT(counts_are(SELF_FILTER, 1, 0, 1));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(bcast_changes, "Unsubscribe, exit and restart");
+UNIT_TEST(bcast_changes)
+{
+  UNIT_TEST_BEGIN();
+
+  /* After the subscriber unsubscribed and the plain process exited, a
+     second ev_a and ev_b went out, then the plain process was restarted
+     and a third ev_a went out */
+  UNIT_TEST_ASSERT(counts_are(PLAIN, 2, 1, 1));
+  UNIT_TEST_ASSERT(counts_are(SUBSCRIBER, 1, 0, 1));
+  UNIT_TEST_ASSERT(counts_are(FILTERED, 0, 0, 1));
+  UNIT_TEST_ASSERT(counts_are(SELF_FILTER, 1, 0, 1));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(poll_index, "Polls through the poll index");
+UNIT_TEST(poll_index)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(counts[PLAIN][EV_POLL] == 1);
+  UNIT_TEST_ASSERT(counts[SUBSCRIBER][EV_POLL] == 0);
+  UNIT_TEST_ASSERT(counts[FILTERED][EV_POLL] == 2);
+  UNIT_TEST_ASSERT(counts[SELF_FILTER][EV_POLL] == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(bcast_churn, "Subscriptions change during a broadcast");
+UNIT_TEST(bcast_churn)
+{
+  UNIT_TEST_BEGIN();
+
+  printf("ev_c: churn %u, peer %u\n", counts[CHURN][EV_C],
+         counts[CHURN_PEER][EV_C]);
+
+  /* The first ev_c reached the churn process only, the peer was
+     subscribed again after it started; the second reached the peer */
+  UNIT_TEST_ASSERT(counts[CHURN][EV_C] == 1);
+  UNIT_TEST_ASSERT(counts[CHURN_PEER][EV_C] == 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  /* Only the events posted to it */
+  process_filter_broadcasts(PROCESS_CURRENT());
+
+  ev_a = process_alloc_event();
+  ev_b = process_alloc_event();
+  ev_direct = process_alloc_event();
+  process_start(&plain_process, NULL);
+  process_start(&subscriber_process, NULL);
+  process_start(&filtered_process, NULL);
+  process_start(&self_filter_process, NULL);
+
+  process_post(PROCESS_BROADCAST, ev_a, NULL);
+  process_post(PROCESS_BROADCAST, ev_b, NULL);
+  process_post(&plain_process, ev_direct, NULL);
+  process_post(&subscriber_process, ev_direct, NULL);
+  process_post(&filtered_process, ev_direct, NULL);
+  process_post(&self_filter_process, ev_direct, NULL);
+  /* Events are delivered in FIFO order, so the broadcasts are done
+     when this process continues */
+  PROCESS_PAUSE();
+  UNIT_TEST_RUN(bcast_first);
+
+  process_unsubscribe(&subscriber_process, ev_a);
+  process_post(&plain_process, PROCESS_EVENT_EXIT, NULL);
+  process_post(PROCESS_BROADCAST, ev_a, NULL);
+  process_post(PROCESS_BROADCAST, ev_b, NULL);
+  PROCESS_PAUSE();
+  process_start(&plain_process, NULL);
+  process_post(PROCESS_BROADCAST, ev_a, NULL);
+  PROCESS_PAUSE();
+  UNIT_TEST_RUN(bcast_changes);
+
+  process_poll(&plain_process);
+  process_poll(&filtered_process);
+  process_poll(&self_filter_process);
+  PROCESS_PAUSE();
+  process_poll(&filtered_process);
+  PROCESS_PAUSE();
+  UNIT_TEST_RUN(poll_index);
+
+  /* The churn process subscribes last and is delivered first */
+  ev_c = process_alloc_event();
+  process_start(&churn_peer_process, NULL);
+  process_start(&churn_process, NULL);
+  process_post(PROCESS_BROADCAST, ev_c, NULL);
+  PROCESS_PAUSE();
+  process_post(PROCESS_BROADCAST, ev_c, NULL);
+  PROCESS_PAUSE();
+  UNIT_TEST_RUN(bcast_churn);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
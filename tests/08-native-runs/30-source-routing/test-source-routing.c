@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Source routing node index and path cache tests.
+ *
+ *         Builds a random graph at the root, then changes parents,
+ *         attempts loops, expires and re-adds nodes, and after every
+ *         change compares node lookups and the source routes from
+ *         uip_sr_get_path() with a walk over a copy of the graph.
+ */
+
+#include "contiki.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/ipv6/uip-sr.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "source routing test");
+AUTOSTART_PROCESSES(&test_process);
+
+/* Node 0 is the root */
+#define NUM_NODES     60
+#define NUM_CHANGES   2000
+#define NUM_EXPIRES   200
+
+static void *graph;
+static uip_ipaddr_t addrs[NUM_NODES];
+static int parent_of[NUM_NODES];
+static int present[NUM_NODES];
+
+/*---------------------------------------------------------------------------*/
+static void
+init_addresses(void)
+{
+  int i;
+
+  memset(&curr_instance, 0, sizeof(curr_instance));
+  curr_instance.used = 1;
+  uip_ip6addr(&curr_instance.dag.dag_id, 0xfd00, 0, 0, 0, 0x0212, 0x4b00, 0, 1);
+  graph = &curr_instance.dag;
+
+  /* Identifiers share a varying number of leading bytes, so that the
+     address compression differs between paths */
+  uip_ipaddr_copy(&addrs[0], &curr_instance.dag.dag_id);
+  for(i = 1; i < NUM_NODES; i++) {
+    uip_ip6addr(&addrs[i], 0xfd00, 0, 0, 0, 0x0212, 0x4b00,
+                (i % 3) << 8 | (i % 5), 0x100 + i);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+matching_bytes(const uip_ipaddr_t *a, const uip_ipaddr_t *b)
+{
+  uint8_t n;
+
+  for(n = 0; n < 16 && a->u8[n] == b->u8[n]; n++);
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* The source route to node i from the copy of the graph */
+static int
+reference_path(int i, uint8_t *path_len, uint8_t *cmpr)
+{
+  int hop = i;
+  int depth = 0;
+
+  *path_len = 0;
+  *cmpr = 15;
+  while(hop != 0) {
+    hop = parent_of[hop];
+    if(hop < 0 || !present[hop] || ++depth > NUM_NODES) {
+      return 0;
+    }
+    if(hop != 0) {
+      *cmpr = MIN(*cmpr, matching_bytes(&addrs[hop], &addrs[i]));
+      (*path_len)++;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_descendant(int i, int ancestor)
+{
+  while(i > 0) {
+    if(i == ancestor) {
+      return 1;
+    }
+    i = parent_of[i];
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_node(int i)
+{
+  uip_sr_node_t *node;
+  uip_sr_node_t *root_node;
+  uint8_t path_len;
+  uint8_t cmpr;
+  uint8_t ref_len;
+  uint8_t ref_cmpr;
+  int reachable;
+
+  node = uip_sr_get_node(graph, &addrs[i]);
+  if(!present[i]) {
+    return node == NULL;
+  }
+  if(node == NULL ||
+     node->parent != uip_sr_get_node(graph, &addrs[parent_of[i]])) {
+    printf("node %d: wrong node or parent\n", i);
+    return 0;
+  }
+
+  root_node = uip_sr_get_node(graph, &addrs[0]);
+  reachable = uip_sr_get_path(node, root_node, &path_len, &cmpr);
+  if(reachable != reference_path(i, &ref_len, &ref_cmpr) ||
+     (reachable && (path_len != ref_len || cmpr != ref_cmpr))) {
+    printf("node %d: path %d/%u/%u, expected %u/%u\n", i,
+           reachable, path_len, cmpr, ref_len, ref_cmpr);
+    return 0;
+  }
+  return uip_sr_is_addr_reachable(graph, &addrs[i]) == reachable;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_all(void)
+{
+  int i;
+
+  for(i = 1; i < NUM_NODES; i++) {
+    if(!check_node(i)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+random_present_node(void)
+{
+  int i;
+
+  do {
+    i = 1 + random_rand() % (NUM_NODES - 1);
+  } while(!present[i]);
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+static int
+has_children(int i)
+{
+  int j;
+
+  for(j = 1; j < NUM_NODES; j++) {
+    if(present[j] && parent_of[j] == i) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(sr_build, "Node lookups and paths");
+UNIT_TEST(sr_build)
+{
+  uip_ipaddr_t other;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  init_addresses();
+  uip_sr_init();
+
+  UNIT_TEST_ASSERT(uip_sr_update_node(graph, &addrs[0], NULL,
+                                      UIP_SR_INFINITE_LIFETIME) != NULL);
+  parent_of[0] = -1;
+  present[0] = 1;
+  for(i = 1; i < NUM_NODES; i++) {
+    parent_of[i] = random_rand() % i;
+    present[i] = 1;
+    UNIT_TEST_ASSERT(uip_sr_update_node(graph, &addrs[i],
+                                        &addrs[parent_of[i]],
+                                        UIP_SR_INFINITE_LIFETIME) != NULL);
+    /* Paths are cached here, and must be dropped by the next insertion */
+    UNIT_TEST_ASSERT(check_all());
+  }
+  UNIT_TEST_ASSERT(uip_sr_num_nodes() == NUM_NODES);
+
+  /* Same identifier with another prefix, or in another graph */
+  uip_ipaddr_copy(&other, &addrs[5]);
+  other.u8[1] ^= 1;
+  UNIT_TEST_ASSERT(uip_sr_get_node(graph, &other) == NULL);
+  UNIT_TEST_ASSERT(uip_sr_get_node(&other, &addrs[5]) == NULL);
+  UNIT_TEST_ASSERT(uip_sr_get_node(graph, NULL) == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(sr_changes, "Parent changes and loops");
+UNIT_TEST(sr_changes)
+{
+  unsigned change;
+  unsigned loops;
+  int child;
+  int parent;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  loops = 0;
+  for(change = 0; change < NUM_CHANGES; change++) {
+    child = random_present_node();
+    parent = random_rand() % NUM_NODES;
+    if(parent == child || parent_of[child] == parent) {
+      continue;
+    }
+    uip_sr_update_node(graph, &addrs[child], &addrs[parent],
+                       UIP_SR_INFINITE_LIFETIME);
+    if(is_descendant(parent, child)) {
+      /* The loop is refused and the old parent kept */
+      loops++;
+    } else {
+      parent_of[child] = parent;
+    }
+    /* A few nodes with paths cached before the next change */
+    for(i = 0; i < 4; i++) {
+      UNIT_TEST_ASSERT(check_node(random_present_node()));
+    }
+    if(change % 100 == 0) {
+      UNIT_TEST_ASSERT(check_all());
+    }
+  }
+  UNIT_TEST_ASSERT(check_all());
+  UNIT_TEST_ASSERT(loops > 0);
+  printf("%u parent changes, %u loops refused\n", NUM_CHANGES, loops);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(sr_expire, "Expiry and re-adding of nodes");
+UNIT_TEST(sr_expire)
+{
+  unsigned round;
+  int num_present;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  num_present = NUM_NODES;
+  for(round = 0; round < NUM_EXPIRES; round++) {
+    i = random_present_node();
+    if(!has_children(i) && num_present > NUM_NODES / 2) {
+      /* Expire a leaf, it is removed after the removal delay */
+      uip_sr_expire_parent(graph, &addrs[i], &addrs[parent_of[i]]);
+      uip_sr_periodic(UIP_SR_REMOVAL_DELAY);
+      UNIT_TEST_ASSERT(check_node(i));
+      uip_sr_periodic(1);
+      present[i] = 0;
+      num_present--;
+    } else {
+      /* Re-add a removed node under a random present node */
+      for(i = 1; i < NUM_NODES && present[i]; i++);
+      if(i == NUM_NODES) {
+        continue;
+      }
+      do {
+        parent_of[i] = random_rand() % NUM_NODES;
+      } while(!present[parent_of[i]]);
+      UNIT_TEST_ASSERT(uip_sr_update_node(graph, &addrs[i],
+                                          &addrs[parent_of[i]],
+                                          UIP_SR_INFINITE_LIFETIME) != NULL);
+      present[i] = 1;
+      num_present++;
+    }
+    UNIT_TEST_ASSERT(uip_sr_num_nodes() == num_present);
+    UNIT_TEST_ASSERT(check_all());
+  }
+
+  uip_sr_free_all();
+  UNIT_TEST_ASSERT(uip_sr_num_nodes() == 0);
+  for(i = 0; i < NUM_NODES; i++) {
+    UNIT_TEST_ASSERT(uip_sr_get_node(graph, &addrs[i]) == NULL);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(sr_build);
+  UNIT_TEST_RUN(sr_changes);
+  UNIT_TEST_RUN(sr_expire);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         TSCH link calendar tests.
+ *
+ *         Fills 4 slotframes with about 1000 random links, with several
+ *         links per timeslot, and checks that the link and backup link
+ *         picked by tsch_schedule_get_next_active_link() from the
+ *         calendar are those of a scan of the link lists, at random ASNs
+ *         and while links are disabled, removed and added.
+ */
+
+#include "contiki.h"
+#include "net/mac/tsch/tsch.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <stdio.h>
+
+PROCESS(test_process, "TSCH calendar test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_SLOTFRAMES  TSCH_SCHEDULE_MAX_SLOTFRAMES
+#define NUM_LINKS       1000
+#define NUM_QUERIES     20000
+#define NUM_CHANGES     2000
+
+static const uint16_t sf_sizes[NUM_SLOTFRAMES] = { 7, 31, 101, 397 };
+static struct tsch_slotframe *sfs[NUM_SLOTFRAMES];
+static struct tsch_link *links[NUM_LINKS];
+
+/* Only the scheduler is built, stand in for the rest of TSCH */
+const linkaddr_t tsch_broadcast_address = { { 0xff, 0xff } };
+struct tsch_link *current_link;
+
+bool
+tsch_get_lock(void)
+{
+  return 1;
+}
+bool
+tsch_is_locked(void)
+{
+  return 0;
+}
+void
+tsch_release_lock(void)
+{
+}
+struct tsch_neighbor *
+tsch_queue_add_nbr(const linkaddr_t *addr)
+{
+  return NULL;
+}
+struct tsch_neighbor *
+tsch_queue_get_nbr(const linkaddr_t *addr)
+{
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Selection of the link list scan, with empty neighbor queues */
+struct reference {
+  struct tsch_link *best;
+  struct tsch_link *backup;
+  tsch_slot_offset_t time_to_best;
+};
+/*---------------------------------------------------------------------------*/
+static void
+reference_offer(struct reference *r, struct tsch_link *l, tsch_slot_offset_t t)
+{
+  struct tsch_link *new_best = NULL;
+
+  if(r->best == NULL || t < r->time_to_best) {
+    r->best = l;
+    r->backup = NULL;
+    r->time_to_best = t;
+    return;
+  }
+  if(t > r->time_to_best) {
+    return;
+  }
+
+  /* Tx first, then the lowest slotframe handle, then the first link */
+  if((r->best->link_options & LINK_OPTION_TX) == (l->link_options & LINK_OPTION_TX)) {
+    if(l->slotframe_handle < r->best->slotframe_handle) {
+      new_best = l;
+    } else if(l->slotframe_handle == r->best->slotframe_handle) {
+      new_best = r->best;
+    }
+  } else if(l->link_options & LINK_OPTION_TX) {
+    new_best = l;
+  }
+
+  if(new_best != l && (l->link_options & LINK_OPTION_RX)) {
+    if(r->backup == NULL || l->slotframe_handle < r->backup->slotframe_handle) {
+      r->backup = l;
+    }
+  }
+  if(new_best != r->best && (r->best->link_options & LINK_OPTION_RX)) {
+    if(r->backup == NULL || r->best->slotframe_handle < r->backup->slotframe_handle) {
+      r->backup = r->best;
+    }
+  }
+  if(new_best != NULL) {
+    r->best = new_best;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+reference_next_link(struct tsch_asn_t *asn, struct reference *r)
+{
+  struct tsch_slotframe *sf;
+  struct tsch_link *l;
+  tsch_slot_offset_t timeslot;
+
+  r->best = NULL;
+  r->backup = NULL;
+  r->time_to_best = 0;
+  for(sf = tsch_schedule_slotframe_head(); sf != NULL;
+      sf = tsch_schedule_slotframe_next(sf)) {
+    timeslot = TSCH_ASN_MOD(*asn, sf->size);
+    for(l = list_head(sf->links_list); l != NULL; l = list_item_next(l)) {
+      if(l->link_options & LINK_OPTION_DISABLE) {
+        continue;
+      }
+      reference_offer(r, l, l->timeslot > timeslot ?
+                      l->timeslot - timeslot :
+                      sf->size.val + l->timeslot - timeslot);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_query(void)
+{
+  struct tsch_asn_t asn;
+  struct reference r;
+  struct tsch_link *best;
+  struct tsch_link *backup;
+  tsch_slot_offset_t time_offset = 0;
+
+  asn.ls4b = random_rand() | (uint32_t)random_rand() << 16;
+  asn.ms1b = random_rand() % 4;
+
+  best = tsch_schedule_get_next_active_link(&asn, &time_offset, &backup);
+  reference_next_link(&asn, &r);
+  if(best != r.best || backup != r.backup ||
+     (best != NULL && time_offset != r.time_to_best)) {
+    printf("asn %02x.%08lx: link %d backup %d in %u, expected %d %d in %u\n",
+           asn.ms1b, (unsigned long)asn.ls4b,
+           best ? best->handle : -1, backup ? backup->handle : -1,
+           (unsigned)time_offset, r.best ? r.best->handle : -1,
+           r.backup ? r.backup->handle : -1, (unsigned)r.time_to_best);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+random_options(void)
+{
+  static const uint8_t options[] = {
+    LINK_OPTION_TX,
+    LINK_OPTION_RX,
+    LINK_OPTION_TX | LINK_OPTION_RX | LINK_OPTION_SHARED,
+    LINK_OPTION_TX | LINK_OPTION_SHARED,
+    LINK_OPTION_RX | LINK_OPTION_TIME_KEEPING,
+  };
+
+  return options[random_rand() % sizeof(options)];
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+add_random_link(void)
+{
+  struct tsch_slotframe *sf = sfs[random_rand() % NUM_SLOTFRAMES];
+  linkaddr_t addr = linkaddr_null;
+
+  addr.u8[LINKADDR_SIZE - 1] = 1 + random_rand() % 8;
+  return tsch_schedule_add_link(sf, random_options(), LINK_TYPE_NORMAL,
+                                &addr, random_rand() % sf->size.val, 0, 0);
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_slotframe *
+slotframe_of(const struct tsch_link *l)
+{
+  return tsch_schedule_get_slotframe_by_handle(l->slotframe_handle);
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(calendar_lookup, "Next link from the calendar");
+UNIT_TEST(calendar_lookup)
+{
+  unsigned long query;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  tsch_schedule_init();
+  /* Added in reverse handle order, the list order is not the handle order */
+  for(i = NUM_SLOTFRAMES - 1; i >= 0; i--) {
+    sfs[i] = tsch_schedule_add_slotframe(i, sf_sizes[i]);
+    UNIT_TEST_ASSERT(sfs[i] != NULL);
+  }
+  UNIT_TEST_ASSERT(check_query());
+
+  for(i = 0; i < NUM_LINKS; i++) {
+    links[i] = add_random_link();
+    UNIT_TEST_ASSERT(links[i] != NULL);
+    UNIT_TEST_ASSERT(check_query());
+  }
+
+  for(query = 0; query < NUM_QUERIES; query++) {
+    UNIT_TEST_ASSERT(check_query());
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(calendar_changes, "Calendar after link changes");
+UNIT_TEST(calendar_changes)
+{
+  unsigned long change;
+  struct tsch_link *l;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  for(i = 0; i < NUM_LINKS; i++) {
+    UNIT_TEST_ASSERT(links[i] != NULL);
+  }
+
+  for(change = 0; change < NUM_CHANGES; change++) {
+    i = random_rand() % NUM_LINKS;
+    l = links[i];
+    switch(random_rand() % 3) {
+    case 0:
+      /* Disabled in place, as done by the slot operation */
+      tsch_schedule_link_change_option(l, l->link_options ^ LINK_OPTION_DISABLE);
+      break;
+    case 1:
+      UNIT_TEST_ASSERT(tsch_schedule_remove_link(slotframe_of(l), l));
+      links[i] = add_random_link();
+      UNIT_TEST_ASSERT(links[i] != NULL);
+      break;
+    default:
+      tsch_schedule_remove_link_by_timeslot(slotframe_of(l), l->timeslot, 0);
+      /* Replace the removed links once all are known, their memory is
+         reused by the new ones */
+      for(i = 0; i < NUM_LINKS; i++) {
+        if(tsch_schedule_get_link_by_handle(links[i]->handle) == NULL) {
+          links[i] = NULL;
+        }
+      }
+      for(i = 0; i < NUM_LINKS; i++) {
+        if(links[i] == NULL) {
+          links[i] = add_random_link();
+          UNIT_TEST_ASSERT(links[i] != NULL);
+        }
+      }
+      break;
+    }
+    for(i = 0; i < 8; i++) {
+      UNIT_TEST_ASSERT(check_query());
+    }
+  }
+
+  tsch_schedule_remove_all_slotframes();
+  UNIT_TEST_ASSERT(tsch_schedule_get_next_active_link(&(struct tsch_asn_t){ 0, 0 },
+                                                      NULL, NULL) == NULL);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(calendar_lookup);
+  UNIT_TEST_RUN(calendar_changes);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Packet buffer pool tests.
+ *
+ *         Queues, restores, updates and frees packets in random order,
+ *         adding headers and writing to the packetbuf in between, and
+ *         checks every queued packet against a copy after each step.
+ *         The same test runs without the pool, with
+ *         DEFINES=PACKETBUF_CONF_WITH_POOL=0.
+ */
+
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "lib/random.h"
+#include "unit-test.h"
+#include <stdio.h>
+#include <string.h>
+
+PROCESS(test_process, "packetbuf pool test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_STEPS     20000
+#define MAX_HDR       40
+
+struct reference {
+  struct queuebuf *q;
+  uint16_t len;
+  uint8_t frame[PACKETBUF_SIZE];
+  packetbuf_attr_t seqno;
+};
+
+static struct reference refs[QUEUEBUF_NUM];
+static uint16_t next_seqno;
+
+/*---------------------------------------------------------------------------*/
+static void
+random_fill(uint8_t *p, int len)
+{
+  while(len-- > 0) {
+    *p++ = random_rand();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Prepends a random header, as a layer on the way down would */
+static void
+add_header(void)
+{
+  int size = random_rand() % MAX_HDR;
+
+  if(packetbuf_totlen() + size <= PACKETBUF_SIZE && packetbuf_hdralloc(size)) {
+    random_fill(packetbuf_hdrptr(), size);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+new_packet(void)
+{
+  uint8_t payload[PACKETBUF_SIZE];
+  int len = 1 + random_rand() % (PACKETBUF_SIZE - MAX_HDR);
+
+  random_fill(payload, len);
+  packetbuf_clear();
+  packetbuf_copyfrom(payload, len);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, ++next_seqno);
+  add_header();
+}
+/*---------------------------------------------------------------------------*/
+static void
+save(struct reference *r)
+{
+  r->len = packetbuf_totlen();
+  memcpy(r->frame, packetbuf_hdrptr(), packetbuf_hdrlen());
+  memcpy(r->frame + packetbuf_hdrlen(), packetbuf_dataptr(), packetbuf_datalen());
+  r->seqno = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+}
+/*---------------------------------------------------------------------------*/
+static int
+packetbuf_matches(const struct reference *r)
+{
+  return packetbuf_totlen() == r->len
+    && packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO) == r->seqno
+    && memcmp(packetbuf_hdrptr(), r->frame, packetbuf_hdrlen()) == 0
+    && memcmp(packetbuf_dataptr(), r->frame + packetbuf_hdrlen(),
+              packetbuf_datalen()) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_queued(void)
+{
+  int i;
+
+  for(i = 0; i < QUEUEBUF_NUM; i++) {
+    if(refs[i].q == NULL) {
+      continue;
+    }
+    if(queuebuf_datalen(refs[i].q) != refs[i].len
+       || queuebuf_attr(refs[i].q, PACKETBUF_ATTR_MAC_SEQNO) != refs[i].seqno
+       || memcmp(queuebuf_dataptr(refs[i].q), refs[i].frame, refs[i].len) != 0) {
+      printf("queued packet %d changed\n", i);
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static struct reference *
+random_queued(void)
+{
+  int i = random_rand() % QUEUEBUF_NUM;
+  int n;
+
+  for(n = 0; n < QUEUEBUF_NUM; n++, i = (i + 1) % QUEUEBUF_NUM) {
+    if(refs[i].q != NULL) {
+      return &refs[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct reference *
+free_slot(void)
+{
+  int i;
+
+  for(i = 0; i < QUEUEBUF_NUM; i++) {
+    if(refs[i].q == NULL) {
+      return &refs[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(pool_basic, "Queued packets are shared and kept");
+UNIT_TEST(pool_basic)
+{
+  struct reference r;
+  struct queuebuf *q;
+  int numfree;
+
+  UNIT_TEST_BEGIN();
+
+  packetbuf_clear();
+  numfree = queuebuf_numfree();
+#if PACKETBUF_WITH_POOL
+  int poolfree = packetbuf_pool_numfree();
+#endif /* PACKETBUF_WITH_POOL */
+
+  new_packet();
+  save(&r);
+  q = queuebuf_new_from_packetbuf();
+  UNIT_TEST_ASSERT(q != NULL);
+  UNIT_TEST_ASSERT(queuebuf_numfree() == numfree - 1);
+#if PACKETBUF_WITH_POOL
+  /* Shared with the packetbuf, not copied */
+  UNIT_TEST_ASSERT(packetbuf_pool_numfree() == poolfree);
+  UNIT_TEST_ASSERT(queuebuf_dataptr(q) == packetbuf_hdrptr());
+#endif /* PACKETBUF_WITH_POOL */
+
+  /* A header in front of the shared packet leaves it as it is */
+  packetbuf_hdralloc(8);
+  memset(packetbuf_hdrptr(), 0xaa, 8);
+  UNIT_TEST_ASSERT(memcmp(queuebuf_dataptr(q), r.frame, r.len) == 0);
+
+  /* A new packet in the packetbuf too */
+  new_packet();
+  UNIT_TEST_ASSERT(memcmp(queuebuf_dataptr(q), r.frame, r.len) == 0);
+  UNIT_TEST_ASSERT(queuebuf_attr(q, PACKETBUF_ATTR_MAC_SEQNO) == r.seqno);
+
+  queuebuf_to_packetbuf(q);
+  UNIT_TEST_ASSERT(packetbuf_matches(&r));
+#if PACKETBUF_WITH_POOL
+  /* Written to after unsharing */
+  UNIT_TEST_ASSERT(packetbuf_unshare(packetbuf_totlen()));
+  UNIT_TEST_ASSERT(packetbuf_matches(&r));
+  memset(packetbuf_dataptr(), 0x55, packetbuf_datalen());
+  UNIT_TEST_ASSERT(memcmp(queuebuf_dataptr(q), r.frame, r.len) == 0);
+#endif /* PACKETBUF_WITH_POOL */
+
+  queuebuf_free(q);
+  packetbuf_clear();
+  UNIT_TEST_ASSERT(queuebuf_numfree() == numfree);
+#if PACKETBUF_WITH_POOL
+  UNIT_TEST_ASSERT(packetbuf_pool_numfree() == poolfree);
+#endif /* PACKETBUF_WITH_POOL */
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(pool_random, "Random queue operations");
+UNIT_TEST(pool_random)
+{
+  struct reference *r;
+  struct reference *other;
+  unsigned long step;
+  int numfree;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  packetbuf_clear();
+  numfree = queuebuf_numfree();
+#if PACKETBUF_WITH_POOL
+  int poolfree = packetbuf_pool_numfree();
+#endif /* PACKETBUF_WITH_POOL */
+
+  for(step = 0; step < NUM_STEPS; step++) {
+    switch(random_rand() % 6) {
+    case 0:
+    case 1:
+      /* Queue a new packet, as a MAC does before sending */
+      r = free_slot();
+      if(r != NULL) {
+        new_packet();
+        r->q = queuebuf_new_from_packetbuf();
+        UNIT_TEST_ASSERT(r->q != NULL);
+        save(r);
+      }
+      break;
+    case 2:
+      /* Restore a packet to send it, with the MAC header added */
+      r = random_queued();
+      if(r != NULL) {
+        queuebuf_to_packetbuf(r->q);
+        UNIT_TEST_ASSERT(packetbuf_matches(r));
+        add_header();
+      }
+      break;
+    case 3:
+      /* Replace a queued packet with another one and new headers */
+      r = random_queued();
+      other = random_queued();
+      if(r != NULL) {
+        queuebuf_to_packetbuf(other->q);
+        add_header();
+        queuebuf_update_from_packetbuf(r->q);
+        save(r);
+      }
+      break;
+    case 4:
+      r = random_queued();
+      if(r != NULL) {
+        queuebuf_free(r->q);
+        r->q = NULL;
+      }
+      break;
+    default:
+      /* Overwrite whatever the packetbuf holds */
+#if PACKETBUF_WITH_POOL
+      UNIT_TEST_ASSERT(packetbuf_unshare(packetbuf_totlen()));
+#endif /* PACKETBUF_WITH_POOL */
+      random_fill(packetbuf_dataptr(), packetbuf_datalen());
+      break;
+    }
+    UNIT_TEST_ASSERT(check_queued());
+  }
+
+  for(i = 0; i < QUEUEBUF_NUM; i++) {
+    if(refs[i].q != NULL) {
+      queuebuf_free(refs[i].q);
+      refs[i].q = NULL;
+    }
+  }
+  packetbuf_clear();
+  UNIT_TEST_ASSERT(queuebuf_numfree() == numfree);
+#if PACKETBUF_WITH_POOL
+  /* No buffer is leaked */
+  UNIT_TEST_ASSERT(packetbuf_pool_numfree() == poolfree);
+#endif /* PACKETBUF_WITH_POOL */
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("packetbuf pool: %u\n", PACKETBUF_WITH_POOL);
+
+  UNIT_TEST_RUN(pool_basic);
+  UNIT_TEST_RUN(pool_random);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
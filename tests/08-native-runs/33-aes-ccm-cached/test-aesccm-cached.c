@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         AES-128 key cache and T-table tests.
+ *
+ *         Checks AES-128 against FIPS-197 and CCM* against a test vector
+ *         while keys alternate, more keys than the cache holds, and
+ *         prints the CCM* throughput with one key and with a key per
+ *         frame. Build with DEFINES=AES_128_CONF_KEY_CACHE_SIZE=0 or
+ *         DEFINES=AES_128_CONF_TTABLES=0 to compare.
+ */
+
+#include "contiki.h"
+#include "unit-test.h"
+#include "lib/ccm-star.h"
+#include "lib/aes-128.h"
+#include "lib/hexconv.h"
+#include <string.h>
+#include <stdio.h>
+
+#define MICLEN 8
+
+PROCESS(test_process, "test");
+AUTOSTART_PROCESSES(&test_process);
+
+/* FIPS-197 appendix C.1 */
+static const char *fips_key = "000102030405060708090a0b0c0d0e0f";
+static const char *fips_plaintext = "00112233445566778899aabbccddeeff";
+static const char *fips_ciphertext = "69c4e0d86a7b0430d8cdb78070b4c55a";
+
+/* A CCM* vector of 11-aes-ccm, without header */
+static const char *ccm_key = "4044e65bf1ba4f8c4db767fa6c63e327";
+static const char *ccm_nonce = "cb72d71df3c953aaec3ca4d75b";
+static const char *ccm_cleartext = "f99169738527f695b21f54c4e405cc9c78e6e498";
+static const char *ccm_ciphertext =
+  "1d9b721b1b4803193752412bf4722670203723fb8740969f75768d86";
+
+#define BENCH_KEYS      4
+#define BENCH_FRAMES    20000
+#define BENCH_FRAME_LEN 100
+
+static uint8_t fips_key_bytes[16];
+static uint8_t fips_plaintext_bytes[16];
+static uint8_t fips_ciphertext_bytes[16];
+static uint8_t ccm_key_bytes[16];
+static uint8_t ccm_nonce_bytes[13];
+
+/*---------------------------------------------------------------------------*/
+static void
+init_vectors(void)
+{
+  hexconv_unhexlify(fips_key, strlen(fips_key),
+                    fips_key_bytes, sizeof(fips_key_bytes));
+  hexconv_unhexlify(fips_plaintext, strlen(fips_plaintext),
+                    fips_plaintext_bytes, sizeof(fips_plaintext_bytes));
+  hexconv_unhexlify(fips_ciphertext, strlen(fips_ciphertext),
+                    fips_ciphertext_bytes, sizeof(fips_ciphertext_bytes));
+  hexconv_unhexlify(ccm_key, strlen(ccm_key),
+                    ccm_key_bytes, sizeof(ccm_key_bytes));
+  hexconv_unhexlify(ccm_nonce, strlen(ccm_nonce),
+                    ccm_nonce_bytes, sizeof(ccm_nonce_bytes));
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(aes_fips, "AES-128 FIPS-197 vector");
+UNIT_TEST(aes_fips)
+{
+  uint8_t block[AES_128_BLOCK_SIZE];
+
+  UNIT_TEST_BEGIN();
+
+  AES_128.set_key(fips_key_bytes);
+  memcpy(block, fips_plaintext_bytes, sizeof(block));
+  AES_128.encrypt(block);
+  UNIT_TEST_ASSERT(!memcmp(block, fips_ciphertext_bytes, sizeof(block)));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(aes_key_switch, "AES-128 with alternating keys");
+UNIT_TEST(aes_key_switch)
+{
+  static uint8_t ciphertext_bytes[64];
+  static uint8_t buffer[64];
+  uint8_t block[AES_128_BLOCK_SIZE];
+  uint8_t other_key[16];
+  size_t m_len;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  m_len = strlen(ccm_cleartext) / 2;
+  hexconv_unhexlify(ccm_ciphertext, strlen(ccm_ciphertext),
+                    ciphertext_bytes, sizeof(ciphertext_bytes));
+
+  /* More distinct keys than cache slots, so that entries get evicted */
+  for(i = 0; i < 64; i++) {
+    memcpy(other_key, fips_key_bytes, sizeof(other_key));
+    other_key[0] = i % 7;
+    AES_128.set_key(other_key);
+    memcpy(block, fips_plaintext_bytes, sizeof(block));
+    AES_128.encrypt(block);
+
+    AES_128.set_key(fips_key_bytes);
+    memcpy(block, fips_plaintext_bytes, sizeof(block));
+    AES_128.encrypt(block);
+    UNIT_TEST_ASSERT(!memcmp(block, fips_ciphertext_bytes, sizeof(block)));
+
+    hexconv_unhexlify(ccm_cleartext, strlen(ccm_cleartext),
+                      buffer, sizeof(buffer));
+    CCM_STAR.set_key(ccm_key_bytes);
+    CCM_STAR.aead(ccm_nonce_bytes, buffer, m_len, NULL, 0,
+                  buffer + m_len, MICLEN, 1);
+    UNIT_TEST_ASSERT(!memcmp(buffer, ciphertext_bytes, m_len + MICLEN));
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+/* Encrypts BENCH_FRAMES frames, switching between nkeys keys */
+static clock_time_t
+ccm_bench(unsigned nkeys)
+{
+  static uint8_t keys[BENCH_KEYS][16];
+  static uint8_t frame[BENCH_FRAME_LEN];
+  uint8_t mic[MICLEN];
+  clock_time_t start;
+  unsigned long i;
+
+  for(i = 0; i < BENCH_KEYS; i++) {
+    memset(keys[i], 0x11 * (i + 1), sizeof(keys[i]));
+  }
+  memset(frame, 0x5a, sizeof(frame));
+
+  start = clock_time();
+  for(i = 0; i < BENCH_FRAMES; i++) {
+    CCM_STAR.set_key(keys[i % nkeys]);
+    CCM_STAR.aead(ccm_nonce_bytes, frame + 16, sizeof(frame) - 16, frame, 16,
+                  mic, MICLEN, 1);
+  }
+  return clock_time() - start;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_bench(const char *name, clock_time_t elapsed)
+{
+  printf("%s: %u frames of %u bytes in %lu ms, %lu frames/s, %lu KB/s\n",
+         name, BENCH_FRAMES, BENCH_FRAME_LEN,
+         (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+         (unsigned long)(elapsed > 0 ?
+                         (uint64_t)BENCH_FRAMES * CLOCK_SECOND / elapsed : 0),
+         (unsigned long)(elapsed > 0 ?
+                         (uint64_t)BENCH_FRAMES * BENCH_FRAME_LEN * CLOCK_SECOND
+                         / elapsed / 1024 : 0));
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(ccm_throughput, "CCM* throughput");
+UNIT_TEST(ccm_throughput)
+{
+  UNIT_TEST_BEGIN();
+
+  /* Timings depend on the host, they are reported only */
+  print_bench("CCM* one key", ccm_bench(1));
+  /* One key per frame, as with frames from several neighbors */
+  print_bench("CCM* key per frame", ccm_bench(BENCH_KEYS));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  printf("AES-128 key cache: %u, T-tables: %u\n",
+         AES_128_KEY_CACHE_SIZE, AES_128_TTABLES);
+
+  init_vectors();
+
+  UNIT_TEST_RUN(aes_fips);
+  UNIT_TEST_RUN(aes_key_switch);
+  UNIT_TEST_RUN(ccm_throughput);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2026, alexrayne <alexraynepe196@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         CoAP observe notifications rendered once.
+ *
+ *         Notifies several observers from one rendering of a resource,
+ *         checks that every confirmable notification carries the same
+ *         payload with the token of its observer, that the shared
+ *         payload is freed once all notifications are acknowledged or
+ *         timed out, and that a notification that cannot be serialized
+ *         leaves neither a transaction nor a payload behind.
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+#include "coap-transactions.h"
+#include "coap-observe.h"
+#include "unit-test.h"
+#include <string.h>
+#include <stdio.h>
+
+PROCESS(test_process, "CoAP observe shared payload test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define NUM_OBSERVERS 8
+
+static coap_endpoint_t endpoints[NUM_OBSERVERS];
+static unsigned renders;
+static char rendered[32];
+static uint16_t first_mid;
+static coap_shared_payload_t *shared;
+
+/*---------------------------------------------------------------------------*/
+static void
+res_get_handler(coap_message_t *request, coap_message_t *response,
+                uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  int len;
+
+  renders++;
+  len = snprintf((char *)buffer, preferred_size, "rendered %u", renders);
+  memcpy(rendered, buffer, len + 1);
+  coap_set_payload(response, buffer, len);
+}
+EVENT_RESOURCE(res_obs, "obs=1", res_get_handler, NULL, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+/* Sets an option too long for COAP_MAX_HEADER_SIZE */
+static void
+res_long_handler(coap_message_t *request, coap_message_t *response,
+                 uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  static char path[2 * COAP_MAX_HEADER_SIZE];
+
+  renders++;
+  memset(path, 'a', sizeof(path) - 1);
+  path[sizeof(path) - 1] = '\0';
+  coap_set_header_location_path(response, path);
+  coap_set_payload(response, "x", 1);
+}
+EVENT_RESOURCE(res_long, "obs=1", res_long_handler, NULL, NULL, NULL, NULL);
+/*---------------------------------------------------------------------------*/
+static void
+init_endpoints(void)
+{
+  char addr[32];
+  int i;
+
+  for(i = 0; i < NUM_OBSERVERS; i++) {
+    snprintf(addr, sizeof(addr), "coap://[fd00::%x]", i + 2);
+    coap_endpoint_parse(addr, strlen(addr), &endpoints[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_observer(coap_resource_t *resource, const char *uri,
+             const coap_endpoint_t *ep, uint8_t token)
+{
+  coap_message_t request[1];
+  coap_message_t response[1];
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_token(request, &token, 1);
+  coap_set_header_uri_path(request, uri);
+  coap_set_header_observe(request, 0);
+  coap_set_src_endpoint(request, ep);
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, 0);
+  coap_observe_handler(resource, request, response);
+}
+/*---------------------------------------------------------------------------*/
+/* The number of shared payloads that can still be allocated */
+static int
+free_payloads(void)
+{
+  coap_shared_payload_t *payloads[COAP_MAX_SHARED_PAYLOADS];
+  int n;
+  int i;
+
+  for(n = 0; n < COAP_MAX_SHARED_PAYLOADS; n++) {
+    payloads[n] = coap_shared_payload_new();
+    if(payloads[n] == NULL) {
+      break;
+    }
+  }
+  for(i = 0; i < n; i++) {
+    coap_shared_payload_release(payloads[i]);
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* Puts the message of a transaction together, as it is sent */
+static int
+parse_transaction(coap_transaction_t *t, coap_message_t *message,
+                  uint8_t *buffer)
+{
+  uint16_t len = t->message_len;
+
+  memcpy(buffer, t->message, len);
+  if(t->shared->len > 0) {
+    buffer[len++] = 0xFF;
+    memcpy(&buffer[len], t->shared->data, t->shared->len);
+    len += t->shared->len;
+  }
+  return coap_parse_message(message, buffer, len) == NO_ERROR;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(render_once, "One rendering for all observers");
+UNIT_TEST(render_once)
+{
+  static uint8_t buffer[COAP_MAX_PACKET_SIZE + 1];
+  coap_message_t message[1];
+  coap_transaction_t *t;
+  uint32_t observe;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(renders == 1);
+
+  shared = NULL;
+  for(i = 0; i < NUM_OBSERVERS; i++) {
+    t = coap_get_transaction_by_mid(first_mid + i);
+    UNIT_TEST_ASSERT(t != NULL);
+    UNIT_TEST_ASSERT(t->shared != NULL);
+    if(shared == NULL) {
+      shared = t->shared;
+    }
+    UNIT_TEST_ASSERT(t->shared == shared);
+
+    UNIT_TEST_ASSERT(parse_transaction(t, message, buffer));
+    UNIT_TEST_ASSERT(message->type == COAP_TYPE_CON);
+    UNIT_TEST_ASSERT(message->mid == first_mid + i);
+    UNIT_TEST_ASSERT(message->token_len == 1);
+    UNIT_TEST_ASSERT(message->token[0] == i + 1);
+    UNIT_TEST_ASSERT(coap_get_header_observe(message, &observe));
+    UNIT_TEST_ASSERT(message->payload_len == strlen(rendered));
+    UNIT_TEST_ASSERT(memcmp(message->payload, rendered,
+                            message->payload_len) == 0);
+  }
+
+  /* Held by the transactions only */
+  UNIT_TEST_ASSERT(shared->refs == NUM_OBSERVERS);
+  UNIT_TEST_ASSERT(free_payloads() == COAP_MAX_SHARED_PAYLOADS - 1);
+
+  /* Acknowledged, as the engine does on an ACK */
+  for(i = 0; i < NUM_OBSERVERS; i += 2) {
+    coap_clear_transaction(coap_get_transaction_by_mid(first_mid + i));
+  }
+  UNIT_TEST_ASSERT(shared->refs == NUM_OBSERVERS / 2);
+  UNIT_TEST_ASSERT(free_payloads() == COAP_MAX_SHARED_PAYLOADS - 1);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(release, "The payload is freed after the timeouts");
+UNIT_TEST(release)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  printf("retransmitted %lu, timed out %lu, in flight %u\n",
+         (unsigned long)coap_transaction_stats.retransmitted,
+         (unsigned long)coap_transaction_stats.timed_out,
+         coap_transaction_stats.in_flight);
+
+  UNIT_TEST_ASSERT(coap_transaction_stats.timed_out == NUM_OBSERVERS / 2);
+  UNIT_TEST_ASSERT(coap_transaction_stats.in_flight == 0);
+  for(i = 0; i < NUM_OBSERVERS; i++) {
+    UNIT_TEST_ASSERT(coap_get_transaction_by_mid(first_mid + i) == NULL);
+  }
+  UNIT_TEST_ASSERT(free_payloads() == COAP_MAX_SHARED_PAYLOADS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(serialize_failure, "A notification too long to serialize");
+UNIT_TEST(serialize_failure)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(renders == 1);
+  UNIT_TEST_ASSERT(coap_get_transaction_by_mid(first_mid) == NULL);
+  UNIT_TEST_ASSERT(coap_transaction_stats.in_flight == 0);
+  UNIT_TEST_ASSERT(free_payloads() == COAP_MAX_SHARED_PAYLOADS);
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer et;
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  init_endpoints();
+  coap_activate_resource(&res_obs, "obs");
+  coap_activate_resource(&res_long, "long");
+
+  for(i = 0; i < NUM_OBSERVERS; i++) {
+    add_observer(&res_obs, "obs", &endpoints[i], i + 1);
+  }
+  renders = 0;
+  first_mid = coap_get_mid() + 1;
+  coap_notify_observers(&res_obs);
+  UNIT_TEST_RUN(render_once);
+
+  /* The notifications that were not acknowledged time out */
+  etimer_set(&et, 6 * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  UNIT_TEST_RUN(release);
+
+  add_observer(&res_long, "long", &endpoints[0], 1);
+  renders = 0;
+  first_mid = coap_get_mid() + 1;
+  coap_notify_observers(&res_long);
+  UNIT_TEST_RUN(serialize_failure);
+
+  printf("=check-me= DONE\n");
+  printf("---\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/